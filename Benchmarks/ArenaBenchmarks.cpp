@@ -0,0 +1,59 @@
+#include "Arena.hpp"
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Random access over a large arena backed by normal 4 KiB pages against one backed by 2 MiB huge
+// pages. Every access depends on the previous one, so TLB misses are not hidden by the out of
+// order core. The arenas are larger than the TLBs cover with 4 KiB pages but not with huge pages.
+
+namespace
+{
+constexpr size_t arena_size   = 256 * 1024 * 1024;
+constexpr size_t line_size    = 64;
+constexpr size_t line_count   = arena_size / line_size;
+constexpr uint64_t step_count = 10000000;
+constexpr int repeats         = 3;
+
+// Links every cache line of the arena into one random cycle and returns the first line
+uint64_t* linkLines(Arena& arena, const std::vector<uint64_t>& order)
+{
+  auto* lines = static_cast<uint64_t*>(arena.allocate(arena_size, line_size));
+  for (size_t i = 0; i < line_count; i++)
+  {
+    size_t next                       = order[(i + 1) % line_count];
+    lines[order[i] * (line_size / 8)] = next * (line_size / 8);
+  }
+  return lines;
+}
+
+void chase(bool huge_pages, const std::vector<uint64_t>& order)
+{
+  Arena arena(arena_size, huge_pages);
+  uint64_t* lines     = linkLines(arena, order);
+  const char* backing = Arena::backingName(arena.backing());
+  char name[96];
+  std::snprintf(name, sizeof(name), "Arena random access, %s", backing);
+  benchmark(name, step_count, repeats, [&] {
+    uint64_t index = order[0] * (line_size / 8);
+    for (uint64_t i = 0; i < step_count; i++)
+      index = lines[index];
+    doNotOptimize(index);
+  });
+}
+}
+
+int main()
+{
+  std::vector<uint64_t> order(line_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), std::mt19937_64(42));
+
+  chase(false, order);
+  chase(true, order);
+  return 0;
+}
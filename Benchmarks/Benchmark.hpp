@@ -0,0 +1,41 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Runs body repeats times and prints the fastest run in nanoseconds per operation, body performs
+// operations operations per run. The fastest run is the one least disturbed by the rest of the
+// system.
+template <typename Body>
+double benchmark(const char* name, uint64_t operations, int repeats, Body&& body)
+{
+  double best = 0.0;
+  for (int i = 0; i < repeats; i++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto end      = std::chrono::steady_clock::now();
+    double ns     = std::chrono::duration<double, std::nano>(end - start).count();
+    double per_op = ns / static_cast<double>(operations);
+    best          = i == 0 ? per_op : std::min(best, per_op);
+  }
+  std::printf("%-48s %10.2f ns/op\n", name, best);
+  return best;
+}
+
+// Keeps the compiler from optimizing away a value only computed for the benchmark
+template <typename T>
+void doNotOptimize(const T& value)
+{
+#ifdef _MSC_VER
+  static const void* volatile sink;
+  sink = &value;
+#else
+  asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "Benchmark.hpp"
+#include "Broadphase.hpp"
+#include "Scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Sweep and prune against testing every pair of bodies, over scenes of moving bodies at about the
+// density the engine's sprites have. Times are per frame, brute force is only run where it finishes
+// in reasonable time.
+
+namespace
+{
+constexpr uint32_t brute_force_limit = 20000;
+constexpr int frame_count            = 10;
+
+struct Scene
+{
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> velocity_x;
+  std::vector<float> velocity_y;
+  std::vector<float> extent;
+
+  explicit Scene(uint32_t count)
+  {
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float world = std::sqrt(static_cast<float>(count)) * 40.0f;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      this->x.push_back(unit(random) * world);
+      this->y.push_back(unit(random) * world);
+      this->velocity_x.push_back(unit(random) * 4.0f - 2.0f);
+      this->velocity_y.push_back(unit(random) * 4.0f - 2.0f);
+      this->extent.push_back(4.0f + unit(random) * 8.0f);
+    }
+  }
+
+  void step()
+  {
+    for (size_t i = 0; i < this->x.size(); i++)
+    {
+      this->x[i] += this->velocity_x[i];
+      this->y[i] += this->velocity_y[i];
+    }
+  }
+};
+
+size_t bruteForcePairs(const Scene& scene)
+{
+  size_t pairs = 0;
+  for (size_t a = 0; a < scene.x.size(); a++)
+  {
+    for (size_t b = a + 1; b < scene.x.size(); b++)
+    {
+      float reach = scene.extent[a] + scene.extent[b];
+      pairs += std::abs(scene.x[a] - scene.x[b]) <= reach &&
+               std::abs(scene.y[a] - scene.y[b]) <= reach;
+    }
+  }
+  return pairs;
+}
+}
+
+int main()
+{
+  Scheduler scheduler(std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+  for (uint32_t count : { 1000u, 10000u, 100000u, 1000000u })
+  {
+    char name[64];
+    Scene scene(count);
+    Broadphase broadphase;
+    broadphase.resize(count);
+    std::vector<Broadphase::Pair> pairs;
+    std::snprintf(name, sizeof(name), "Sweep and prune, %u bodies", count);
+    benchmark(name, frame_count, 1, [&] {
+      for (int frame = 0; frame < frame_count; frame++)
+      {
+        scene.step();
+        for (uint32_t i = 0; i < count; i++)
+        {
+          float extent = scene.extent[i];
+          broadphase.setBounds(i,
+                               scene.x[i] - extent,
+                               scene.y[i] - extent,
+                               scene.x[i] + extent,
+                               scene.y[i] + extent);
+        }
+        broadphase.findPairs(scheduler, pairs);
+      }
+    });
+
+    if (count > brute_force_limit)
+      continue;
+    std::snprintf(name, sizeof(name), "Brute force, %u bodies", count);
+    benchmark(name, frame_count, 1, [&] {
+      for (int frame = 0; frame < frame_count; frame++)
+      {
+        scene.step();
+        doNotOptimize(bruteForcePairs(scene));
+      }
+    });
+  }
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include "Benchmark.hpp"
+#include "MpmcQueue.hpp"
+#include "MpscQueue.hpp"
+#include "SpscQueue.hpp"
+
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Throughput of the lock-free queues with producers and consumers on separate threads, against a
+// std::deque behind a std::mutex as the obvious alternative. Threads yield while the queue is full
+// or empty so that the numbers stay meaningful with fewer cores than threads.
+
+namespace
+{
+constexpr uint64_t element_count = 1000000;
+constexpr int repeats            = 5;
+
+// The baseline, with the same try interface as the lock-free rings
+class MutexQueue
+{
+private:
+  std::mutex mutex_;
+  std::deque<uint64_t> elements_;
+
+public:
+  bool tryPush(uint64_t value)
+  {
+    std::lock_guard lock(this->mutex_);
+    this->elements_.push_back(value);
+    return true;
+  }
+
+  bool tryPop(uint64_t& value)
+  {
+    std::lock_guard lock(this->mutex_);
+    if (this->elements_.empty())
+      return false;
+    value = this->elements_.front();
+    this->elements_.pop_front();
+    return true;
+  }
+};
+
+// Moves element_count elements from producers to consumers through queue
+template <typename Queue>
+void transfer(Queue& queue, int producers, int consumers)
+{
+  uint64_t per_producer = element_count / producers;
+  uint64_t per_consumer = element_count / consumers;
+
+  std::vector<std::thread> threads;
+  for (int producer = 0; producer < producers; producer++)
+  {
+    threads.emplace_back([&queue, per_producer] {
+      for (uint64_t i = 0; i < per_producer; i++)
+      {
+        while (!queue.tryPush(i))
+          std::this_thread::yield();
+      }
+    });
+  }
+  for (int consumer = 0; consumer < consumers; consumer++)
+  {
+    threads.emplace_back([&queue, per_consumer] {
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < per_consumer; i++)
+      {
+        uint64_t value;
+        while (!queue.tryPop(value))
+          std::this_thread::yield();
+        sum += value;
+      }
+      doNotOptimize(sum);
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+struct Node : MpscNode
+{
+  uint64_t value = 0;
+};
+
+void transferMpsc(MpscQueue<Node>& queue, std::vector<Node>& nodes, int producers)
+{
+  uint64_t per_producer = element_count / producers;
+
+  std::vector<std::thread> threads;
+  for (int producer = 0; producer < producers; producer++)
+  {
+    threads.emplace_back([&queue, &nodes, per_producer, producer] {
+      for (uint64_t i = 0; i < per_producer; i++)
+        queue.push(&nodes[producer * per_producer + i]);
+    });
+  }
+  uint64_t popped = 0;
+  while (popped < per_producer * producers)
+  {
+    if (queue.pop())
+      popped++;
+    else
+      std::this_thread::yield();
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+}
+}
+
+int main()
+{
+  {
+    auto queue = std::make_unique<SpscQueue<uint64_t, 1024>>();
+    benchmark("SpscQueue 1 producer 1 consumer", element_count, repeats, [&] {
+      transfer(*queue, 1, 1);
+    });
+  }
+  {
+    MutexQueue queue;
+    benchmark("Mutex queue 1 producer 1 consumer", element_count, repeats, [&] {
+      transfer(queue, 1, 1);
+    });
+  }
+
+  for (int threads : { 1, 2, 4 })
+  {
+    char name[64];
+    auto queue = std::make_unique<MpmcQueue<uint64_t, 1024>>();
+    std::snprintf(name, sizeof(name), "MpmcQueue %d producers %d consumers", threads, threads);
+    benchmark(name, element_count, repeats, [&] {
+      transfer(*queue, threads, threads);
+    });
+
+    MutexQueue mutex_queue;
+    std::snprintf(name, sizeof(name), "Mutex queue %d producers %d consumers", threads, threads);
+    benchmark(name, element_count, repeats, [&] {
+      transfer(mutex_queue, threads, threads);
+    });
+  }
+
+  for (int producers : { 1, 2, 4 })
+  {
+    char name[64];
+    MpscQueue<Node> queue;
+    std::vector<Node> nodes(element_count);
+    std::snprintf(name, sizeof(name), "MpscQueue %d producers 1 consumer", producers);
+    benchmark(name, element_count, repeats, [&] {
+      transferMpsc(queue, nodes, producers);
+    });
+
+    MutexQueue mutex_queue;
+    std::snprintf(name, sizeof(name), "Mutex queue %d producers 1 consumer", producers);
+    benchmark(name, element_count, repeats, [&] {
+      transfer(mutex_queue, producers, 1);
+    });
+  }
+  return 0;
+}
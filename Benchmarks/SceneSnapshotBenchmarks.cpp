@@ -0,0 +1,80 @@
+#include "Benchmark.hpp"
+#include "SceneSnapshot.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// Loading a scene of 1M sprites from a mapped snapshot against parsing the same sprites from a
+// text file with iostreams, one sprite per line. Both files are in the page cache after the first
+// run, so this compares the work of loading rather than the disk.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr uint32_t sprite_count = 1000000;
+constexpr int repeats           = 5;
+
+void writeText(const fs::path& file, const std::vector<SceneSprite>& sprites)
+{
+  std::ofstream stream(file, std::ios::trunc);
+  stream << sprites.size() << '\n';
+  for (const SceneSprite& sprite : sprites)
+  {
+    stream << sprite.sprite << ' ' << sprite.position[0] << ' ' << sprite.position[1] << ' '
+           << sprite.velocity[0] << ' ' << sprite.velocity[1] << ' ' << sprite.size << ' '
+           << sprite.rotation << ' ' << sprite.angular_velocity << ' ' << sprite.color << '\n';
+  }
+}
+
+std::vector<SceneSprite> readText(const fs::path& file)
+{
+  std::ifstream stream(file);
+  size_t count = 0;
+  stream >> count;
+  std::vector<SceneSprite> sprites(count);
+  for (SceneSprite& sprite : sprites)
+  {
+    stream >> sprite.sprite >> sprite.position[0] >> sprite.position[1] >> sprite.velocity[0] >>
+        sprite.velocity[1] >> sprite.size >> sprite.rotation >> sprite.angular_velocity >>
+        sprite.color;
+  }
+  return sprites;
+}
+}
+
+int main()
+{
+  std::vector<SceneSprite> sprites(sprite_count);
+  for (uint32_t i = 0; i < sprite_count; i++)
+  {
+    float f    = static_cast<float>(i);
+    sprites[i] = { 0, { f * 0.5f, f * 0.25f }, { 1.5f, -2.5f }, 16.0f, f * 0.001f, 1.0f, i };
+  }
+
+  fs::path snapshot_file = fs::temp_directory_path() / "scene-benchmark.scene";
+  fs::path text_file     = fs::temp_directory_path() / "scene-benchmark.txt";
+  writeSceneSnapshot(snapshot_file, 0, { StringId("sprite") }, {}, sprites);
+  writeText(text_file, sprites);
+
+  // Every sprite is read once after loading, as the simulation does when it resumes
+  benchmark("Scene snapshot load per sprite", sprite_count, repeats, [&] {
+    SceneSnapshot snapshot(snapshot_file);
+    float sum = 0.0f;
+    for (const SceneSprite& sprite : snapshot.root().sprites)
+      sum += sprite.position[0];
+    doNotOptimize(sum);
+  });
+  benchmark("Text scene load per sprite", sprite_count, repeats, [&] {
+    std::vector<SceneSprite> loaded = readText(text_file);
+    float sum                       = 0.0f;
+    for (const SceneSprite& sprite : loaded)
+      sum += sprite.position[0];
+    doNotOptimize(sum);
+  });
+
+  fs::remove(snapshot_file);
+  fs::remove(text_file);
+  return 0;
+}
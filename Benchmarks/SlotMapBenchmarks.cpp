@@ -0,0 +1,97 @@
+#include "Benchmark.hpp"
+#include "SlotMap.hpp"
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// SlotMap lookup and iteration against std::unordered_map keyed by an integer id, the container
+// engine resources would otherwise live in. Both hold the same elements after the same churn of
+// erases and inserts.
+
+namespace
+{
+constexpr uint32_t element_count = 100000;
+constexpr uint32_t lookup_count  = 1000000;
+constexpr int repeats            = 5;
+
+// About the size of a sprite or transform component
+struct Element
+{
+  float position[2];
+  float velocity[2];
+  float scale[2];
+  uint32_t texture;
+  uint32_t flags;
+};
+}
+
+int main()
+{
+  std::mt19937 random(42);
+
+  SlotMap<Element> slot_map;
+  std::unordered_map<uint32_t, Element> unordered_map;
+  std::vector<Handle<Element>> handles;
+  std::vector<uint32_t> keys;
+  for (uint32_t i = 0; i < element_count; i++)
+  {
+    Element element = { { static_cast<float>(i), 0.0f }, { 1.0f, 1.0f }, { 1.0f, 1.0f }, i, 0 };
+    handles.push_back(slot_map.insert(element));
+    unordered_map.emplace(i, element);
+    keys.push_back(i);
+  }
+
+  // Erase and reinsert a quarter of the elements, so that slots are reused and the hash map's
+  // nodes are no longer allocated in key order
+  std::vector<uint32_t> churn(element_count);
+  for (uint32_t i = 0; i < element_count; i++)
+    churn[i] = i;
+  std::shuffle(churn.begin(), churn.end(), random);
+  churn.resize(element_count / 4);
+  for (uint32_t i : churn)
+  {
+    slot_map.erase(handles[i]);
+    unordered_map.erase(keys[i]);
+  }
+  for (uint32_t i : churn)
+  {
+    Element element = { { static_cast<float>(i), 0.0f }, { 1.0f, 1.0f }, { 1.0f, 1.0f }, i, 0 };
+    handles[i]      = slot_map.insert(element);
+    keys[i]         = element_count + i;
+    unordered_map.emplace(keys[i], element);
+  }
+
+  std::vector<uint32_t> lookups(lookup_count);
+  std::uniform_int_distribution<uint32_t> pick(0, element_count - 1);
+  for (uint32_t& lookup : lookups)
+    lookup = pick(random);
+
+  benchmark("SlotMap random lookup", lookup_count, repeats, [&] {
+    uint32_t sum = 0;
+    for (uint32_t i : lookups)
+      sum += slot_map.get(handles[i])->texture;
+    doNotOptimize(sum);
+  });
+  benchmark("std::unordered_map random lookup", lookup_count, repeats, [&] {
+    uint32_t sum = 0;
+    for (uint32_t i : lookups)
+      sum += unordered_map.find(keys[i])->second.texture;
+    doNotOptimize(sum);
+  });
+
+  benchmark("SlotMap iteration", element_count, repeats, [&] {
+    float sum = 0.0f;
+    for (const Element& element : slot_map)
+      sum += element.position[0];
+    doNotOptimize(sum);
+  });
+  benchmark("std::unordered_map iteration", element_count, repeats, [&] {
+    float sum = 0.0f;
+    for (const auto& [key, element] : unordered_map)
+      sum += element.position[0];
+    doNotOptimize(sum);
+  });
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include "Benchmark.hpp"
+#include "SpriteBatch.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Batching of 100k sprites that use 64 images spread over several atlas pages. Reports the draw
+// calls the batches take against one draw per sprite and one draw per change of atlas page in
+// instance order, and the CPU time buildSpriteBatches spends per sprite.
+
+namespace
+{
+constexpr size_t sprite_count = 100000;
+constexpr uint32_t page_size  = 512;
+constexpr int image_count     = 64;
+constexpr int repeats         = 10;
+}
+
+int main()
+{
+  std::mt19937 random(42);
+  std::uniform_int_distribution<uint32_t> image_size(16, 96);
+
+  SpriteAtlas atlas(page_size);
+  std::vector<SpriteHandle> sprites;
+  for (int i = 0; i < image_count; i++)
+  {
+    uint32_t width  = image_size(random);
+    uint32_t height = image_size(random);
+    std::vector<uint32_t> texels(size_t(width) * height, 0xffffffff);
+    sprites.push_back(atlas.add(width, height, texels.data()));
+  }
+
+  std::uniform_int_distribution<size_t> pick(0, sprites.size() - 1);
+  std::uniform_real_distribution<float> coordinate(0.0f, 1000.0f);
+  std::vector<SpriteInstance> instances(sprite_count);
+  for (SpriteInstance& instance : instances)
+  {
+    instance.sprite      = sprites[pick(random)];
+    instance.position[0] = coordinate(random);
+    instance.position[1] = coordinate(random);
+    instance.size[0]     = 32.0f;
+    instance.size[1]     = 32.0f;
+    instance.rotation    = coordinate(random);
+    instance.color       = 0xffffffff;
+  }
+
+  auto vertices = std::make_unique<SpriteVertex[]>(sprite_count * 4);
+  std::vector<SpriteBatch> batches;
+  benchmark("buildSpriteBatches per sprite", sprite_count, repeats, [&] {
+    size_t quads = buildSpriteBatches(atlas, instances, vertices.get(), sprite_count, batches);
+    doNotOptimize(quads);
+  });
+
+  size_t page_changes = 0;
+  uint32_t page       = UINT32_MAX;
+  for (const SpriteInstance& instance : instances)
+  {
+    uint32_t sprite_page = atlas.get(instance.sprite)->page;
+    page_changes += sprite_page != page;
+    page = sprite_page;
+  }
+  std::printf("Draw calls for %zu sprites on %zu atlas pages: %zu batched, %zu one per sprite, %zu "
+              "one per page change\n",
+              sprite_count,
+              atlas.pageCount(),
+              batches.size(),
+              sprite_count,
+              page_changes);
+  return 0;
+}
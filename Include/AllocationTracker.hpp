@@ -0,0 +1,69 @@
+#ifndef ALLOCATION_TRACKER_HPP
+#define ALLOCATION_TRACKER_HPP
+
+#include <cstdint>
+
+// Heap allocations made through operator new. The engine replaces the global operator new and
+// delete to count them per thread when built with ENGINE_ALLOCATION_TRACKING, otherwise every
+// count stays zero. Allocations made with malloc directly, such as those of SDL or the Vulkan
+// loader, are not counted.
+struct AllocationCounts
+{
+  uint64_t count = 0;
+  uint64_t bytes = 0;
+
+  AllocationCounts operator-(const AllocationCounts& other) const
+  {
+    return { this->count - other.count, this->bytes - other.bytes };
+  }
+
+  AllocationCounts& operator+=(const AllocationCounts& other)
+  {
+    this->count += other.count;
+    this->bytes += other.bytes;
+    return *this;
+  }
+};
+
+// Returns the allocations the calling thread made since it started, the difference of two calls
+// is what the thread allocated in between
+AllocationCounts threadAllocations();
+
+// Returns the number of allocations made inside a NoAllocationScope on any thread
+uint64_t allocationViolations();
+
+// NoAllocationScope marks code that must not allocate, such as steady state frames. Allocations
+// the constructing thread makes while the scope is active are counted as violations and, in debug
+// builds, the first few are written to stderr with their call stack. Scopes nest.
+class NoAllocationScope
+{
+private:
+  bool active_;
+
+public:
+  explicit NoAllocationScope(bool active = true);
+
+  NoAllocationScope(const NoAllocationScope&) = delete;
+  NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+
+  ~NoAllocationScope();
+};
+
+// AllowAllocationScope lifts the enclosing NoAllocationScopes of the constructing thread while it
+// is active, for work that is known to allocate such as swapchain recreation
+class AllowAllocationScope
+{
+private:
+  bool active_;
+  uint32_t saved_depth_ = 0;
+
+public:
+  explicit AllowAllocationScope(bool active = true);
+
+  AllowAllocationScope(const AllowAllocationScope&) = delete;
+  AllowAllocationScope& operator=(const AllowAllocationScope&) = delete;
+
+  ~AllowAllocationScope();
+};
+
+#endif
@@ -1,10 +1,107 @@
 #ifndef APPLICATION_HPP
 #define APPLICATION_HPP
 
+#include "AllocationTracker.hpp"
+#include "Arena.hpp"
+#include "AudioSystem.hpp"
+#include "Broadphase.hpp"
+#include "CommandRecorder.hpp"
+#include "Config.hpp"
+#include "CpuTopology.hpp"
+#include "DescriptorBinder.hpp"
+#include "FormatPolicy.hpp"
+#include "FrameCapture.hpp"
+#include "GpuProfiler.hpp"
+#include "GraphicsPipeline.hpp"
+#include "MetricsExporter.hpp"
+#include "OcclusionCuller.hpp"
+#include "Presenter.hpp"
+#include "RenderSnapshot.hpp"
+#include "Resources.hpp"
+#include "Result.hpp"
+#include "Scheduler.hpp"
+#include "SlotMap.hpp"
+#include "SpriteBatch.hpp"
+#include "StringId.hpp"
+#include "StutterMonitor.hpp"
+#include "Task.hpp"
+#include "TextRenderer.hpp"
+#include "UiLayer.hpp"
+
 #include <SDL2/SDL.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vulkan/vulkan.hpp>
 
+// Settings chosen on the command line
+struct ApplicationOptions
+{
+  // Number of bouncing sprites simulated and drawn every frame
+  uint32_t sprite_count = 1000;
+
+  // TrueType font used to draw text, text is disabled without one
+  std::string font_file;
+
+  // Sprites bounce off each other when enabled, otherwise only off the window's edges
+  bool collisions = true;
+
+  // Presents in HDR when the display supports it, as HDR10 or FP16 scRGB, whichever takes less
+  // bandwidth, otherwise in 8-bit sRGB
+  bool hdr = false;
+
+  // Presents one frame per vertical blank in FIFO order, otherwise in mailbox or immediate mode
+  // where the display supports them. Toggled at runtime with V.
+  bool vsync = false;
+
+  // Presents on a thread of its own, so the render thread never blocks in vkQueuePresentKHR and
+  // starts recording the next frame right after submitting one. Needs a second present queue.
+  bool present_thread = false;
+
+  // Triangle draws hidden in recent frames are skipped, with conditional rendering when the device
+  // has it. Off by default: the main pass has no depth buffer, so only draws off screen are ever
+  // found hidden and the queries and proxy draws cost more than they save.
+  bool occlusion_culling = false;
+
+  // Plays sounds when enabled, music_file is a WAVE file streamed in a loop if not empty
+  bool audio = true;
+  std::string music_file;
+
+  // Scene file the simulation starts from instead of a generated one, and the file the simulation
+  // is saved to on exit, unused if empty
+  std::string load_scene_file;
+  std::string save_scene_file;
+
+  // File frame captures are written to, the number of consecutive frames a capture holds and the
+  // frame, counted from one, at which a capture starts by itself. Zero only captures on F12.
+  std::string capture_file     = "frame.capture";
+  uint32_t capture_frames      = 1;
+  uint32_t capture_start_frame = 0;
+
+  // File metrics are written to in the Prometheus text format and the seconds between writes,
+  // metrics are disabled if the file is empty
+  std::string metrics_file;
+  uint32_t metrics_interval = 5;
+
+  // Frames longer than this multiple of the median frame time are stutters, the profiled zones of
+  // the seconds before each are written to <stutter_trace_prefix>-<frame>.json. Zero disables it.
+  float stutter_threshold          = 2.0f;
+  std::string stutter_trace_prefix = "stutter";
+
+  // Pins threads and sets their priorities based on the CPU topology, in builds with
+  // ENGINE_THREAD_PINNING. Disabled to compare frame pacing with the threads left to the OS.
+  bool thread_placement = true;
+
+  // Exits after drawing this many frames, following a warm-up, and logs their average CPU frame
+  // time and its standard deviation to compare builds and options. Zero runs until closed.
+  uint32_t benchmark_frames = 0;
+};
+
 class Application
 {
 private:
@@ -14,10 +111,69 @@ private:
   std::vector<const char*> required_device_layers_       = {};
   std::vector<const char*> required_device_extensions_   = { "VK_KHR_swapchain" };
 
+  // Device extensions that are enabled when the physical device supports them
+  std::vector<const char*> optional_device_extensions_ = { "VK_KHR_push_descriptor",
+                                                           "VK_EXT_memory_budget",
+                                                           "VK_EXT_conditional_rendering" };
+
+  // Device extensions enabled on the logical device, required and supported optional ones
+  std::vector<const char*> enabled_device_extensions_;
+
+  // Whether the conditional rendering feature was enabled on the logical device
+  bool conditional_rendering_ = false;
+
+  // Whether the swapchain maintenance feature was enabled on the logical device. The swapchain
+  // then switches between compatible present modes without being recreated, and presents signal
+  // fences.
+  bool swapchain_maintenance_ = false;
+
+  // Number of frames that can be recorded while previous frames are still executing
+  static constexpr uint32_t max_frames_in_flight_ = 2;
+
+  // Number of draws each frame's uniform buffer has room for
+  static constexpr uint32_t max_draws_per_frame_ = 1024;
+
+  // Number of sprites each frame's vertex buffer has room for
+  static constexpr uint32_t max_sprites_per_frame_ = 128 * 1024;
+
+  // Width and height of a sprite atlas page in texels
+  static constexpr uint32_t sprite_atlas_page_size_ = 2048;
+
+  // Number of glyphs each frame's vertex buffer has room for, they share the sprite index buffer
+  static constexpr uint32_t max_glyphs_per_frame_ = 16 * 1024;
+  static_assert(max_glyphs_per_frame_ <= max_sprites_per_frame_);
+
+  // Size and number of the glyph atlas layers, and the most glyphs copied into it per frame
+  static constexpr uint32_t glyph_atlas_page_size_       = 1024;
+  static constexpr uint32_t glyph_atlas_page_count_      = 4;
+  static constexpr uint32_t max_glyph_uploads_per_frame_ = 32;
+
+  // Number of rectangles and glyphs each frame's UI vertex buffers have room for
+  static constexpr uint32_t max_ui_quads_per_frame_ = 4096;
+  static_assert(max_ui_quads_per_frame_ <= max_sprites_per_frame_);
+
+  // Number of frames between dashboard refreshes
+  static constexpr uint32_t dashboard_interval_ = 30;
+
+  // Size of the arena holding the simulation state
+  static constexpr size_t world_arena_size_ = 64 * 1024 * 1024;
+
+  // Number of frames between frame statistics reports
+  static constexpr uint32_t frame_stats_interval_ = 1000;
+
+  // Frames drawn before a benchmark starts counting, they load assets and fill caches
+  static constexpr uint32_t benchmark_warmup_frames_ = 100;
+
+  // Frames drawn before the render thread must stop allocating. Earlier frames grow the storage
+  // later ones reuse, and the first statistics report registers the render thread with the logger.
+  static constexpr uint64_t allocation_free_after_frames_ = frame_stats_interval_;
+
   // Window dimensions
   const uint32_t window_width_  = 800;
   const uint32_t window_height_ = 600;
 
+  ApplicationOptions options_;
+
   // SDL window handle
   SDL_Window* window_;
 
@@ -33,12 +189,254 @@ private:
   // Vulkan surface
   vk::SurfaceKHR surface_;
 
-  // Vulkan swapchain
+  // Engine resources, referenced by handle
+  SlotMap<Buffer> buffers_;
+  SlotMap<Image> images_;
+  SlotMap<Pipeline> pipelines_;
+  SlotMap<Mesh> meshes_;
+
+  // Processor topology and the CPUs chosen for each engine thread
+  CpuTopology cpu_topology_;
+  ThreadPlacement thread_placement_;
+
+  // Worker, I/O and main thread coroutine scheduler
+  std::unique_ptr<Scheduler> scheduler_;
+
+  // Mixes sounds on the audio device, null when audio is disabled or there is no device
+  std::unique_ptr<AudioSystem> audio_;
+  AudioClipHandle bounce_clip_;
+
+  // Vulkan swapchain. Images that can be held acquired at once, an acquire with more may wait on
+  // a present.
   vk::SwapchainKHR swapchain_;
-  std::vector<vk::Image> swapchain_images_;
-  std::vector<vk::ImageView> swapchain_image_views_;
+  uint32_t swapchain_acquire_limit_ = 1;
+  std::vector<ImageHandle> swapchain_images_;
   vk::Format swapchain_format_;
+  vk::ColorSpaceKHR swapchain_color_space_;
   vk::Extent2D swapchain_extent_;
+  std::vector<vk::Framebuffer> swapchain_framebuffers_;
+
+  // Present mode frames are presented in, the vsync setting it was chosen for and the modes the
+  // swapchain can present in without being recreated. Render thread only after initialisation.
+  bool present_vsync_;
+  vk::PresentModeKHR present_mode_;
+  std::vector<vk::PresentModeKHR> swapchain_present_modes_;
+
+  // Render pass and the descriptor state shared by the draw pipelines
+  RenderPassDesc render_pass_desc_;
+  vk::RenderPass render_pass_;
+  std::unique_ptr<DescriptorBinder> draw_descriptors_;
+
+  // Pipelines and meshes registered under a name, looked up by hashed id
+  std::unordered_map<StringId, PipelineHandle> named_pipelines_;
+  std::unordered_map<StringId, MeshHandle> named_meshes_;
+
+  // Pipelines of the main pass drawn every frame, resolved once when they are created so that
+  // recording never hashes or looks up their names. The text pipeline is null without a font.
+  PipelineHandle sprite_pipeline_;
+  PipelineHandle text_pipeline_;
+  PipelineHandle ui_pipeline_;
+
+  // Descs of the live pipelines by handle value, kept to describe them in frame captures
+  std::unordered_map<uint32_t, GraphicsPipelineDesc> pipeline_descs_;
+  std::unordered_map<uint32_t, vk::RenderPass> pipeline_render_passes_;
+
+  // Pipelines drawing the same geometry without colour writes by the handle value of the pipeline
+  // they stand in for. Draws are occlusion tested only if their pipeline has a proxy.
+  std::unordered_map<uint32_t, PipelineHandle> occlusion_proxies_;
+
+  // Sprite images packed into atlas pages, the GPU image of every page and the state used to draw
+  // them. The atlas is only modified during initialisation, the render thread reads it freely.
+  SpriteAtlas sprite_atlas_ { sprite_atlas_page_size_ };
+  std::unordered_map<StringId, SpriteHandle> named_sprites_;
+  std::vector<ImageHandle> sprite_atlas_images_;
+  vk::SamplerCreateInfo sprite_sampler_ci_;
+  vk::Sampler sprite_sampler_;
+  std::unique_ptr<DescriptorBinder> sprite_descriptors_;
+
+  // Indices of max_sprites_per_frame_ quads, shared by sprites and text
+  BufferHandle quad_index_buffer_;
+
+  // Lays out text and manages the glyph cache on the main thread, null when text is disabled
+  std::unique_ptr<TextRenderer> text_renderer_;
+
+  // Glyph distance fields, a layer per cache page, and the state used to draw text from them
+  ImageHandle glyph_atlas_image_;
+  std::unique_ptr<DescriptorBinder> text_descriptors_;
+
+  // Copies of the frame being recorded, kept to reuse their storage. Render thread only.
+  std::vector<vk::BufferImageCopy> glyph_copy_regions_;
+
+  // Widgets of the UI, owned by the main thread
+  std::unique_ptr<UiLayer> ui_layer_;
+
+  // The UI is rendered into a layer the size of the swapchain, only where it changed, and the layer
+  // is composited over every frame. Recreating the swapchain loses the layer's contents, the main
+  // thread then redraws the whole UI. The layer has the cheapest format the format policy finds,
+  // the sprite and text pipelines drawing into it are the main pass's unless its format differs
+  // from the swapchain's or the main pass encodes its output.
+  RenderPassDesc ui_render_pass_desc_;
+  vk::RenderPass ui_render_pass_;
+  vk::Format ui_layer_format_;
+  PipelineHandle ui_sprite_pipeline_;
+  PipelineHandle ui_text_pipeline_;
+  ImageHandle ui_layer_image_;
+  vk::Framebuffer ui_framebuffer_;
+  std::unique_ptr<DescriptorBinder> ui_descriptors_;
+  std::atomic<bool> ui_layer_lost_ { false };
+
+  // Widgets showing statistics in the corner of the window and the time since their last refresh
+  struct Dashboard
+  {
+    UiWidgetHandle frame_time_label;
+    UiWidgetHandle frame_time_bar;
+    UiWidgetHandle sprite_label;
+    UiWidgetHandle glyph_label;
+    float elapsed_time   = 0.0f;
+    uint32_t frame_count = 0;
+  } dashboard_;
+
+  // Batches of the frame being recorded, kept to reuse their storage. Render thread only.
+  std::vector<SpriteBatch> sprite_batches_;
+
+  // Frame capture in progress, null while there is none, and a capture requested from the main
+  // thread. Captures start between frames, counted by drawn_frames_. Render thread only.
+  std::unique_ptr<FrameCapture> capture_;
+  std::atomic<bool> capture_requested_ { false };
+  uint64_t drawn_frames_ = 0;
+
+  // Vsync setting toggled on the main thread, the render thread switches present modes to match
+  std::atomic<bool> vsync_;
+
+  // Writes metrics to options_.metrics_file, null when metrics are disabled
+  std::unique_ptr<MetricsExporter> metrics_;
+
+  // Times GPU zones of each frame, and writes traces of stutters, null when they are disabled.
+  // Render thread only.
+  std::unique_ptr<GpuProfiler> gpu_profiler_;
+  std::unique_ptr<StutterMonitor> stutter_monitor_;
+
+  // Skips hidden draws, null when occlusion culling is disabled, and the predicates it writes when
+  // it uses conditional rendering. Render thread only.
+  std::unique_ptr<OcclusionCuller> occlusion_culler_;
+  BufferHandle occlusion_predicates_;
+
+  // Presents frames the render thread queues, null when frames are presented on the render thread.
+  // Only created with a present queue apart from the graphics queue, of another family or the
+  // graphics family's second queue. Families with a single queue present on the render thread.
+  std::unique_ptr<Presenter> presenter_;
+  bool dedicated_present_queue_ = false;
+
+  // Command pool for the graphics queue
+  vk::CommandPool command_pool_;
+
+  // Per-draw data read by the vertex shader, offset.xy, scale and rotation
+  struct DrawUniforms
+  {
+    float transform[4];
+  };
+
+  // Stride between DrawUniforms in the uniform buffer, respecting the device offset alignment
+  vk::DeviceSize draw_uniforms_stride_;
+
+  // Resources owned by each frame in flight
+  struct Frame
+  {
+    vk::CommandBuffer command_buffer;
+    vk::Semaphore image_available;
+    vk::Semaphore render_finished;
+    vk::Fence in_flight;
+    // Signalled by the frame's last present with swapchain maintenance, once render_finished can
+    // be signalled again
+    vk::Fence present_fence;
+    // Present thread request that acquires the frame's next image with image_available, if any
+    std::optional<uint64_t> acquire_request;
+    BufferHandle uniform_buffer;
+    BufferHandle sprite_vertex_buffer;
+    BufferHandle text_vertex_buffer;
+    BufferHandle glyph_staging_buffer;
+    BufferHandle ui_sprite_vertex_buffer;
+    BufferHandle ui_text_vertex_buffer;
+  };
+  std::array<Frame, max_frames_in_flight_> frames_;
+  uint32_t current_frame_ = 0;
+
+  // Simulated object, extracted into a DrawItem every frame
+  struct Entity
+  {
+    PipelineHandle pipeline;
+    MeshHandle mesh;
+    float position[2];
+    float scale;
+    float rotation;
+    float angular_velocity;
+  };
+
+  // Simulation state, owned by the main thread and kept in a huge page backed arena
+  Arena world_arena_ { world_arena_size_, ENGINE_HUGE_PAGES };
+  std::vector<Entity, ArenaAllocator<Entity>> entities_ { ArenaAllocator<Entity>(world_arena_) };
+
+  // Sprite bouncing around the window, position and velocity are in pixels
+  struct SpriteEntity
+  {
+    SpriteHandle sprite;
+    float position[2];
+    float velocity[2];
+    float size;
+    float rotation;
+    float angular_velocity;
+    uint32_t color;
+  };
+  std::vector<SpriteEntity, ArenaAllocator<SpriteEntity>> sprite_entities_ {
+    ArenaAllocator<SpriteEntity>(world_arena_)
+  };
+  uint64_t simulation_frame_ = 0;
+
+  // Finds the sprites whose bounds overlap, and the pairs it found this frame
+  Broadphase sprite_broadphase_;
+  std::vector<Broadphase::Pair> sprite_contacts_;
+
+  // Snapshots passed from the main thread to the render thread, which owns everything used to
+  // record and present frames while it runs
+  RenderSnapshotExchange render_snapshots_;
+  std::thread render_thread_;
+
+  // CPU time spent in drawFrame, recording command buffers and simulating since the last report
+  struct FrameStats
+  {
+    uint32_t frame_count = 0;
+    std::chrono::steady_clock::duration frame_time {};
+    double frame_time_squared = 0.0;
+    std::chrono::steady_clock::duration record_time {};
+    std::chrono::steady_clock::duration simulation_time {};
+    uint64_t sprite_count        = 0;
+    uint64_t sprite_batch_count  = 0;
+    uint64_t skipped_draw_count  = 0;
+    uint64_t render_target_bytes = 0;
+    int64_t present_latency      = 0;
+    uint64_t present_count       = 0;
+    AllocationCounts render_allocations {};
+    AllocationCounts simulation_allocations {};
+  } frame_stats_;
+
+  // CPU frame times and present latencies of a benchmark run after its warm-up, logged when it
+  // ends to compare presenting on the present thread with presenting inline. Render thread only
+  // until it is joined.
+  struct BenchmarkStats
+  {
+    uint64_t frame_count      = 0;
+    double frame_time         = 0.0;
+    double frame_time_squared = 0.0;
+    int64_t present_latency   = 0;
+    uint64_t present_count    = 0;
+  } benchmark_stats_;
+
+  // How vulkan.hpp reports errors in this build, included in frame statistics
+#ifdef VULKAN_HPP_NO_EXCEPTIONS
+  static constexpr const char* vulkan_error_mode_ = "results";
+#else
+  static constexpr const char* vulkan_error_mode_ = "exceptions";
+#endif
 
   struct QueueFamilyIndices
   {
@@ -63,9 +461,6 @@ private:
     std::vector<vk::PresentModeKHR> present_modes;
   } swapchain_support_details_;
 
-  // readFile reads an entire file and returns it as a vector of chars
-  std::vector<char> readFile(const std::string& file) const;
-
   // isDeviceSuitable takes a physical device and returns true if it is a suitable device, it will
   // return false if the device is not suitable.
   bool isDeviceSuitable(const vk::PhysicalDevice& phys_dev) const;
@@ -76,16 +471,170 @@ private:
   // Queries a physical device for swapchain support details with a surface
   SwapchainSupportDetails querySwapchainSupportDetails(const vk::PhysicalDevice& phys_dev) const;
 
-  vk::SurfaceFormatKHR
-  chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& available_formats) const;
+  // Returns FIFO with vsync, otherwise mailbox or immediate mode if available
+  vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& present_modes,
+                                           bool vsync) const;
 
-  vk::PresentModeKHR
-  chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& available_present_modes) const;
+  // Queries the present modes a swapchain created with present_mode can switch to, present_mode
+  // included. Needs surface maintenance.
+  std::vector<vk::PresentModeKHR>
+  queryCompatiblePresentModes(vk::PresentModeKHR present_mode) const;
 
   vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) const;
 
   vk::ShaderModule createShaderModule(const std::vector<char>& shader_code);
 
+  // Reads a SPIR-V file on the I/O thread and creates a shader module from it on a worker
+  Task<vk::ShaderModule> loadShaderModule(std::string file_name);
+
+  // Reads a TrueType font on the I/O thread and parses it on a worker
+  Task<TrueTypeFont> loadFont(std::string file_name);
+
+  // Streams a WAVE file in a loop, logs when no voice was free
+  Task<void> playMusic(std::string file_name);
+
+  // Returns true if the device extension was enabled on the logical device
+  bool isDeviceExtensionEnabled(const char* extension) const;
+
+  // Returns the index of a memory type allowed by type_bits that has all the requested properties
+  uint32_t findMemoryType(uint32_t type_bits, vk::MemoryPropertyFlags properties) const;
+
+  // Creates a buffer backed by newly allocated memory, host visible buffers are left mapped
+  BufferHandle createBuffer(vk::DeviceSize size,
+                            vk::BufferUsageFlags usage,
+                            vk::MemoryPropertyFlags properties);
+
+  // Creates a 2D device local image and a view of it, with several layers for array views
+  ImageHandle createImage(vk::Extent2D extent,
+                          vk::Format format,
+                          vk::ImageUsageFlags usage,
+                          uint32_t layer_count        = 1,
+                          vk::ImageViewType view_type = vk::ImageViewType::e2D);
+
+  // Allocates and begins a command buffer for initialisation work
+  vk::CommandBuffer beginOneTimeCommands();
+
+  // Ends and submits a command buffer from beginOneTimeCommands, waits for it and frees it
+  void submitOneTimeCommands(vk::CommandBuffer command_buffer);
+
+  // Destroys a buffer and frees its memory
+  void destroyBuffer(BufferHandle handle);
+
+  // Destroys an image, its view and, unless owned by the swapchain, its memory
+  void destroyImage(ImageHandle handle);
+
+  // Destroys a pipeline and its layout
+  void destroyPipeline(PipelineHandle handle);
+
+  // Returns the pipeline or mesh registered under a name, or a null handle
+  PipelineHandle findPipeline(StringId name) const;
+  MeshHandle findMesh(StringId name) const;
+
+  // Returns the push descriptor limit, zero if push descriptors are disabled or unsupported
+  uint32_t queryMaxPushDescriptors() const;
+
+  // Creates a pipeline drawing into render_pass, render_pass_ if it is null, with a layout made of
+  // the desc's set layouts and push constant ranges
+  PipelineHandle createGraphicsPipeline(const GraphicsPipelineDesc& desc,
+                                        vk::RenderPass render_pass = {});
+
+  // Writes sprites into a vertex buffer with room for max_quads of them and records one draw per
+  // atlas page, inside a render pass
+  Result<void> recordSprites(CommandRecorder& command_buffer,
+                             PipelineHandle pipeline_handle,
+                             const std::vector<SpriteInstance>& sprites,
+                             BufferHandle vertex_buffer,
+                             size_t max_quads);
+
+  // Copies the glyphs added to the cache for a snapshot into the glyph atlas, outside the render
+  // pass
+  void recordGlyphUploads(Frame& frame,
+                          CommandRecorder& command_buffer,
+                          const RenderSnapshot& snapshot);
+
+  // Writes glyphs into a vertex buffer with room for max_quads of them and draws them all at once,
+  // inside a render pass
+  Result<void> recordText(CommandRecorder& command_buffer,
+                          PipelineHandle pipeline_handle,
+                          const std::vector<GlyphQuad>& glyphs,
+                          BufferHandle vertex_buffer,
+                          size_t max_quads);
+
+  // Redraws the region of the UI layer that changed in a snapshot, outside the render pass
+  Result<void>
+  recordUiLayer(Frame& frame, CommandRecorder& command_buffer, const RenderSnapshot& snapshot);
+
+  // Records the draws of a snapshot into the frame's command buffer
+  Result<void> recordCommandBuffer(Frame& frame,
+                                   CommandRecorder& command_buffer,
+                                   uint32_t image_index,
+                                   const RenderSnapshot& snapshot);
+
+  // Copies a device local buffer, or every layer of an image in layout, into host memory. Waits
+  // for the copy.
+  std::vector<std::byte> readBackBuffer(const Buffer& buffer);
+  std::vector<std::byte> readBackImage(const Image& image, vk::ImageLayout layout);
+
+  // Starts capturing options_.capture_frames frames into options_.capture_file, waiting for the
+  // device to be idle. Failures are logged and leave no capture in progress.
+  void beginCapture();
+
+  // Adds the frame just recorded to the capture and writes the capture once it is complete
+  void captureFrame(std::chrono::nanoseconds record_time);
+
+  // Renders and presents a single snapshot. An out of date or suboptimal swapchain is recreated
+  // and is not an error.
+  Result<void> drawFrame(const RenderSnapshot& snapshot);
+
+  // Advances the simulation by delta_time seconds
+  void simulate(float delta_time);
+
+  // Bounces sprites that touch off each other
+  void collideSprites();
+
+  // Refreshes the dashboard widgets every dashboard_interval_ frames
+  void updateDashboard(float delta_time);
+
+  // Copies the simulation state needed for rendering into a snapshot, lays out its text and
+  // fills in its UI update
+  void extractRenderSnapshot(RenderSnapshot& snapshot);
+
+  // Render thread loop, draws snapshots until the exchange is closed or a frame fails
+  void renderLoop();
+
+  // Destroys the swapchain and everything created from it
+  void cleanupSwapchain();
+
+  // Takes the images the present thread acquired ahead for the frames, once it is done with the
+  // swapchain, and waits on their image_available semaphores so that they are unsignalled again.
+  // Render thread only, or once it has been joined.
+  Result<void> discardAcquiredImages();
+
+  // Waits on a frame's image_available semaphore on the graphics queue and until the wait is done,
+  // using the frame's fence, which must be signalled and not in use
+  Result<void> consumeImageAvailable(Frame& frame);
+
+  // Waits until every present issued with a present fence is done with its swapchain image and
+  // semaphore. The device being idle does not cover presents. No-op without swapchain maintenance.
+  Result<void> waitForPresents();
+
+  // Recreates the swapchain after it became out of date. Render thread only, failures are returned
+  // for the frame loop to end on.
+  Result<void> recreateSwapchain();
+
+  // Presents in the mode chosen for vsync from the next frame on, recreating the swapchain only if
+  // it cannot switch to that mode
+  Result<void> switchPresentMode(bool vsync);
+
+  // Restricts a thread to cpus, unless empty, and sets its priority. Failures are logged.
+  void placeThread(const char* name,
+                   std::thread::native_handle_type thread,
+                   const std::vector<uint32_t>& cpus,
+                   ThreadPriority priority);
+
+  // Detects the CPU topology and starts the scheduler's worker and I/O threads on it
+  void initScheduler();
+
   // Initialises the SDL library and a native window
   void initSDL();
 
@@ -101,17 +650,75 @@ private:
   // Initialises the logical device and queues
   void initDevice();
 
+  // Initialises the metrics exporter if a metrics file was given
+  void initMetrics();
+
+  // Initialises GPU zone timing and the stutter monitor if a stutter threshold was given
+  void initProfiler();
+
+  // Starts the present thread if one was asked for and there is a queue for it
+  void initPresenter();
+
   // Initialises the swapchain
   void initSwapchain();
 
   // Initialises the swapchain image views
   void initSwapchainImageViews();
 
+  // Initialises the render pass
+  void initRenderPass();
+
   // Initialises the graphics pipeline
   void initGraphicsPipeline();
 
+  // Initialises a framebuffer for each swapchain image view
+  void initFramebuffers();
+
+  // Initialises the command pool and per-frame command buffers
+  void initCommandBuffers();
+
+  // Initialises the per-frame semaphores and fences
+  void initSyncObjects();
+
+  // Initialises the per-frame uniform buffers
+  void initUniformBuffers();
+
+  // Initialises the occlusion culler and its predicates if occlusion culling is enabled
+  void initOcclusionCulling();
+
+  // Packs the sprite images into the atlas
+  void initSpriteImages();
+
+  // Uploads the atlas pages and initialises the sprite pipeline, index and vertex buffers
+  void initSpriteRenderer();
+
+  // Loads the font and initialises the glyph atlas, text pipeline and buffers, if a font was given
+  void initTextRenderer();
+
+  // Initialises the UI render pass, composite pipeline and vertex buffers
+  void initUiRenderer();
+
+  // Initialises the UI layer image and framebuffer for the current swapchain, cleared
+  void initUiLayerImage();
+
+  // Initialises the UI widgets
+  void initUi();
+
+  // Opens the audio device and creates the sound clips, audio is disabled if it fails
+  void initAudio();
+
+  // Initialises the simulated entities, from the scene file if one was given
+  void initEntities();
+
+  // Replaces the simulated entities with those of a scene file, throws std::runtime_error if it
+  // cannot be read or refers to resources that do not exist
+  void loadScene(const std::string& file);
+
+  // Writes the simulated entities to a scene file, throws std::runtime_error if it cannot
+  void saveScene(const std::string& file) const;
+
 public:
-  Application();
+  explicit Application(const ApplicationOptions& options = {});
 
   void run();
 
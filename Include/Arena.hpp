@@ -0,0 +1,104 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Arena is a bump allocator over one large reservation for long-lived engine data. On Linux the
+// reservation is backed by huge pages when it can be: explicit 2 MiB pages from the hugetlbfs pool
+// first, then transparent huge pages, then normal pages. Huge pages cover a large working set with
+// far fewer TLB entries, which matters for random access over big scenes. Individual allocations
+// are never freed, the arena is rewound as a whole with reset.
+class Arena
+{
+public:
+  enum class Backing
+  {
+    Normal,
+    TransparentHugePages,
+    ExplicitHugePages
+  };
+
+  static constexpr size_t huge_page_size_ = 2 * 1024 * 1024;
+
+private:
+  std::byte* base_ = nullptr;
+  size_t capacity_ = 0;
+  size_t offset_   = 0;
+  Backing backing_ = Backing::Normal;
+
+public:
+  // Reserves capacity bytes, rounded up to a whole number of huge pages. huge_pages false always
+  // uses normal pages.
+  Arena(size_t capacity, bool huge_pages);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Returns size bytes aligned to alignment, throwing std::bad_alloc when the arena is full
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  // Constructs a T in the arena. Its destructor is never run, so T should be trivially
+  // destructible or own nothing outside the arena.
+  template <typename T, typename... Args>
+  T* create(Args&&... args)
+  {
+    return new (this->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  // Rewinds the arena, invalidating every allocation made from it
+  void reset();
+
+  size_t used() const;
+  size_t capacity() const;
+  Backing backing() const;
+
+  // Returns a readable name for a backing, used in logs
+  static const char* backingName(Backing backing);
+
+  ~Arena();
+};
+
+// ArenaAllocator lets standard containers allocate from an Arena. Deallocation is a no-op, so it
+// suits containers that are reserved once and then only grow within their reservation.
+template <typename T>
+class ArenaAllocator
+{
+private:
+  Arena* arena_;
+
+  template <typename U>
+  friend class ArenaAllocator;
+
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena& arena) : arena_(&arena) { }
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_)
+  {
+  }
+
+  T* allocate(size_t count)
+  {
+    return static_cast<T*>(this->arena_->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, size_t) { }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const
+  {
+    return this->arena_ == other.arena_;
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const
+  {
+    return this->arena_ != other.arena_;
+  }
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef ASSET_COOKER_HPP
+#define ASSET_COOKER_HPP
+
+#include "AssetDatabase.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Converts one kind of source asset, defined in AssetCooker.cpp
+struct AssetConverter;
+
+// Runtime formats written by the asset cooker, all little endian
+
+// Texture: TextureFileHeader followed by width * height RGBA8 texels
+struct TextureFileHeader
+{
+  char magic[4] = { 'T', 'E', 'X', '1' };
+  uint32_t width;
+  uint32_t height;
+};
+
+// Mesh: MeshFileHeader, vertex_count MeshVertex, then index_count uint32_t triangle list indices
+struct MeshFileHeader
+{
+  char magic[4] = { 'M', 'S', 'H', '1' };
+  uint32_t vertex_count;
+  uint32_t index_count;
+};
+
+struct MeshVertex
+{
+  float position[3];
+  float normal[3];
+  float uv[2];
+};
+
+struct CookOptions
+{
+  // Paths in the database and in outputs are relative to source_root
+  std::filesystem::path source_root;
+  std::filesystem::path output_root;
+
+  // Directories under source_root scanned for source assets
+  std::vector<std::filesystem::path> directories;
+
+  // GLSL compiler used for shaders
+  std::string glslc = "glslc";
+
+  uint32_t thread_count = 1;
+
+  // Rebuild every output regardless of the database
+  bool force = false;
+};
+
+struct CookStats
+{
+  uint32_t cooked     = 0;
+  uint32_t up_to_date = 0;
+  uint32_t failed     = 0;
+};
+
+// AssetCooker converts source assets into the engine's runtime formats. GLSL shaders become
+// SPIR-V, glTF meshes become MSH1 files and PNG images become TEX1 files. An output is only
+// rebuilt when the content of one of its dependencies, such as a shader include or a glTF buffer,
+// or its converter changed. Conversions run in parallel.
+class AssetCooker
+{
+public:
+  // A source asset and the converter that handles it
+  struct Job
+  {
+    const AssetConverter* converter;
+    std::string source;
+    std::string output;
+  };
+
+private:
+  CookOptions options_;
+  AssetDatabase database_;
+
+  std::atomic<uint32_t> cooked_ { 0 };
+  std::atomic<uint32_t> up_to_date_ { 0 };
+  std::atomic<uint32_t> failed_ { 0 };
+
+  // Finds every source asset with a converter in the configured directories
+  std::vector<Job> findJobs() const;
+
+  // Cooks one asset if it is out of date, errors are logged and counted
+  void runJob(const Job& job);
+
+  // Returns true if the recorded output is still valid for its dependencies
+  bool isUpToDate(const Job& job, const AssetDatabase::OutputRecord& record);
+
+  // Combines the converter version with the path and content hash of every dependency
+  uint64_t hashInputs(const Job& job, const std::vector<std::string>& dependencies);
+
+public:
+  explicit AssetCooker(CookOptions options);
+
+  // Cooks everything that is out of date and saves the database
+  CookStats cook();
+};
+
+#endif
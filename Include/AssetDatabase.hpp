@@ -0,0 +1,68 @@
+#ifndef ASSET_DATABASE_HPP
+#define ASSET_DATABASE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// AssetDatabase is the asset cooker's record of what it has built. It caches a content hash for
+// every source file, keyed by its size and modification time so unchanged files are never read
+// again, and remembers the inputs and their combined hash for every output. Paths are relative to
+// the source root. All methods are safe to call from several cooking threads.
+class AssetDatabase
+{
+public:
+  struct FileRecord
+  {
+    uint64_t hash;
+    uint64_t size;
+    int64_t modified;
+  };
+
+  struct OutputRecord
+  {
+    // Bumped by a converter when its output format changes
+    uint32_t converter_version;
+
+    // Combined hash of the converter version and every dependency's path and content
+    uint64_t input_hash;
+
+    // Every source file the output was built from, the primary source first
+    std::vector<std::string> dependencies;
+  };
+
+private:
+  std::filesystem::path source_root_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, FileRecord> files_;
+  std::unordered_map<std::string, OutputRecord> outputs_;
+
+  // Returns the current size and modification time of a source file
+  std::optional<FileRecord> statFile(const std::string& path) const;
+
+public:
+  explicit AssetDatabase(std::filesystem::path source_root);
+
+  // Loads a database written by save, a missing or unreadable file leaves the database empty
+  void load(const std::filesystem::path& file);
+
+  // Writes the database, sorted so that it diffs cleanly
+  void save(const std::filesystem::path& file) const;
+
+  // Returns the content hash of a source file, only reading it if it changed since it was last
+  // hashed. Throws if the file cannot be read.
+  uint64_t hashFile(const std::string& path);
+
+  // Returns true if the file's size and modification time match the last time it was hashed
+  bool isFileUnchanged(const std::string& path) const;
+
+  std::optional<OutputRecord> findOutput(const std::string& output) const;
+  void recordOutput(const std::string& output, OutputRecord record);
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef ATLAS_PACKER_HPP
+#define ATLAS_PACKER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+struct AtlasRect
+{
+  uint32_t x;
+  uint32_t y;
+  uint32_t width;
+  uint32_t height;
+};
+
+// SkylinePacker places rectangles into a fixed size area using the skyline bottom-left heuristic.
+// It tracks only the top edge of the packed area, so packing is fast and rectangles of similar
+// heights pack tightly. Rectangles cannot be removed individually.
+class SkylinePacker
+{
+private:
+  // A horizontal run of the skyline, the area below it is taken
+  struct Segment
+  {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+  };
+
+  uint32_t width_;
+  uint32_t height_;
+  std::vector<Segment> skyline_;
+  uint64_t used_area_ = 0;
+
+  // Returns the lowest y a rectangle starting at the segment can be placed at, or nullopt if it
+  // does not fit there
+  std::optional<uint32_t> fitAt(size_t index, uint32_t width, uint32_t height) const;
+
+public:
+  SkylinePacker(uint32_t width, uint32_t height);
+
+  // Returns where the rectangle was placed, or nullopt if there is no room for it
+  std::optional<AtlasRect> pack(uint32_t width, uint32_t height);
+
+  // Removes every rectangle
+  void reset();
+
+  // Returns the fraction of the area covered by rectangles
+  float occupancy() const;
+};
+
+#endif
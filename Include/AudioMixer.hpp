@@ -0,0 +1,170 @@
+#ifndef AUDIO_MIXER_HPP
+#define AUDIO_MIXER_HPP
+
+#include "CacheLine.hpp"
+#include "SlotMap.hpp"
+#include "SpscQueue.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A sound decoded into memory, samples holds frame_count samples of each channel in turn
+struct AudioClip
+{
+  uint32_t sample_rate = 0;
+  uint32_t channels    = 0;
+  uint32_t frame_count = 0;
+  std::vector<float> samples;
+};
+
+using AudioClipHandle = Handle<AudioClip>;
+
+// AudioStreamBuffer is a lock-free ring of stereo frames at the mixer's sample rate, filled by one
+// decoding thread and drained by the mixer
+class AudioStreamBuffer
+{
+public:
+  static constexpr uint32_t capacity_ = 1 << 16;
+
+private:
+  static constexpr uint32_t mask_ = capacity_ - 1;
+
+  std::unique_ptr<float[]> left_;
+  std::unique_ptr<float[]> right_;
+
+  alignas(cache_line_size) std::atomic<uint64_t> write_ { 0 };
+  alignas(cache_line_size) std::atomic<uint64_t> read_ { 0 };
+
+public:
+  AudioStreamBuffer();
+
+  AudioStreamBuffer(const AudioStreamBuffer&) = delete;
+  AudioStreamBuffer& operator=(const AudioStreamBuffer&) = delete;
+
+  // Number of frames that can be written without overwriting unread ones. Producer only.
+  uint32_t writable() const;
+
+  // Appends count frames, at most writable() of them. Producer only.
+  void write(const float* left, const float* right, uint32_t count);
+
+  // Moves up to count frames into left and right and returns how many there were. Mixer only.
+  uint32_t read(float* left, float* right, uint32_t count);
+};
+
+// What a voice plays, one of a clip's samples or a stream
+struct AudioSource
+{
+  const float* samples = nullptr;
+  uint32_t sample_rate = 0;
+  uint32_t channels    = 0;
+  uint32_t frame_count = 0;
+
+  // Streams are played at the mixer's rate whatever the pitch, finished is set by the producer
+  // after its last write
+  AudioStreamBuffer* stream                = nullptr;
+  const std::atomic<bool>* stream_finished = nullptr;
+};
+
+// Request from the game thread to the mixer, voice is an index below AudioMixer::max_voices_
+struct AudioCommand
+{
+  enum class Type : uint8_t
+  {
+    Play,
+    Stop,
+    SetGain,
+    SetPitch
+  };
+
+  Type type;
+  uint32_t voice;
+  AudioSource source;
+  float gain  = 1.0f;
+  float pan   = 0.0f;
+  float pitch = 1.0f;
+  bool loop   = false;
+};
+
+// AudioMixer mixes up to max_voices_ voices into interleaved stereo float frames. Voices are
+// resampled with linear interpolation, their gains ramp across a block so changes do not click,
+// and the inner loops work on four frames at a time with SSE2 when available. The game thread
+// controls it only through commands and learns which voices finished, so mix never blocks,
+// allocates or frees memory.
+class AudioMixer
+{
+public:
+  static constexpr uint32_t max_voices_   = 256;
+  static constexpr uint32_t block_frames_ = 256;
+
+private:
+  struct Voice
+  {
+    AudioSource source;
+
+    // Position in the source and the step per output frame, 32.32 fixed point
+    uint64_t position;
+    uint64_t step;
+
+    // Left and right gains now and to ramp towards by the end of the next block, stopped voices
+    // ramp to silence before they end
+    float gain[2];
+    float target_gain[2];
+    bool loop;
+    bool stopping;
+    bool active = false;
+  };
+
+  uint32_t sample_rate_;
+  std::array<Voice, max_voices_> voices_;
+
+  // Indices of the active voices, in no particular order
+  std::array<uint32_t, max_voices_> active_;
+  uint32_t active_count_ = 0;
+
+  SpscQueue<AudioCommand, 1024> commands_;
+  SpscQueue<uint32_t, max_voices_> finished_;
+
+  // Mixed block and per voice scratch, a multiple of four floats each
+  alignas(16) float left_[block_frames_];
+  alignas(16) float right_[block_frames_];
+  alignas(16) float scratch_[2][block_frames_];
+
+  std::atomic<uint32_t> active_voice_count_ { 0 };
+  std::atomic<uint64_t> stream_underruns_ { 0 };
+
+  void applyCommands();
+
+  // Accumulates a voice into the block, returns false once it ended
+  bool mixClip(Voice& voice, uint32_t frames);
+  bool mixStream(Voice& voice, uint32_t frames);
+
+  // Ends a voice and reports it to the game thread
+  void finish(uint32_t active_index);
+
+public:
+  explicit AudioMixer(uint32_t sample_rate);
+
+  AudioMixer(const AudioMixer&) = delete;
+  AudioMixer& operator=(const AudioMixer&) = delete;
+
+  // Queues a command, returns false if the queue is full. Game thread only.
+  bool pushCommand(const AudioCommand& command);
+
+  // Takes the index of a voice that finished or was stopped, returns false if there is none. A
+  // voice index is only reused by the game thread after it was returned here. Game thread only.
+  bool popFinished(uint32_t& voice);
+
+  // Applies pending commands and writes frames of interleaved stereo. Audio thread only.
+  void mix(float* output, uint32_t frames);
+
+  uint32_t sampleRate() const;
+
+  // Number of voices playing after the last mix, and mixes that ran out of stream data
+  uint32_t activeVoiceCount() const;
+  uint64_t streamUnderruns() const;
+};
+
+#endif
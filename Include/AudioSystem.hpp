@@ -0,0 +1,135 @@
+#ifndef AUDIO_SYSTEM_HPP
+#define AUDIO_SYSTEM_HPP
+
+#include "AudioMixer.hpp"
+#include "Scheduler.hpp"
+#include "SlotMap.hpp"
+#include "Task.hpp"
+#include "Wav.hpp"
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A mixer voice as seen by the main thread, handles to it go stale once it finished
+struct AudioVoice
+{
+  uint32_t generation = 1;
+  bool playing        = false;
+};
+
+using AudioVoiceHandle = Handle<AudioVoice>;
+
+// AudioSystem plays clips and streamed WAVE files on an SDL audio device. The device's callback
+// runs the mixer on SDL's audio thread, the main thread controls it through the mixer's command
+// queue and streams are decoded and resampled on workers a chunk at a time. Everything but the
+// callback is main thread only.
+class AudioSystem
+{
+private:
+  // A WAVE file held in memory and decoded into a ring at the mixer's rate. Decoding is set while
+  // a worker fills the ring, the stream is only destroyed once it is clear.
+  struct AudioStream
+  {
+    std::vector<char> data;
+    WavFormat format;
+    double position = 0.0;
+    bool loop       = false;
+    std::atomic<bool> finished { false };
+    std::atomic<bool> decoding { false };
+    AudioStreamBuffer buffer;
+  };
+
+  // Frames decoded per chunk, a stream is refilled whenever a whole chunk fits into its ring
+  static constexpr uint32_t stream_chunk_frames_ = 8192;
+
+  // Share of a device buffer's duration the callback may take before it counts as over budget
+  static constexpr double callback_budget_ = 0.25;
+
+  // Seconds between statistics reports
+  static constexpr double stats_interval_ = 10.0;
+
+  Scheduler& scheduler_;
+  SDL_AudioDeviceID device_ = 0;
+  std::unique_ptr<AudioMixer> mixer_;
+
+  SlotMap<AudioClip> clips_;
+
+  // Voices by mixer index, the indices not playing and the stream each stream voice plays
+  std::array<AudioVoice, AudioMixer::max_voices_> voices_;
+  std::vector<uint32_t> free_voices_;
+  std::array<std::unique_ptr<AudioStream>, AudioMixer::max_voices_> voice_streams_;
+
+  // Streams whose voice finished while a worker was still decoding them
+  std::vector<std::unique_ptr<AudioStream>> retired_streams_;
+
+  // Callback timings, written by the audio thread and reported by update
+  uint64_t callback_budget_ns_ = 0;
+  std::atomic<uint64_t> callback_count_ { 0 };
+  std::atomic<uint64_t> callback_total_ns_ { 0 };
+  std::atomic<uint64_t> callback_max_ns_ { 0 };
+  std::atomic<uint64_t> callback_over_budget_ { 0 };
+  uint64_t reported_underruns_ = 0;
+  std::chrono::steady_clock::time_point last_report_;
+
+  static void SDLCALL audioCallback(void* user_data, Uint8* stream, int length);
+
+  // Mixes a device buffer and records how long it took. Audio thread only.
+  void mixCallback(float* output, uint32_t frames);
+
+  // Takes a free voice index, returns a null handle if all voices are playing
+  AudioVoiceHandle allocateVoice();
+
+  // Returns the voice a handle refers to or nullptr if it finished
+  AudioVoice* findVoice(AudioVoiceHandle handle);
+
+  // Frees a voice the mixer reported as finished
+  void releaseVoice(uint32_t index);
+
+  // Sends a command to the mixer, logging instead of blocking when its queue is full
+  bool sendCommand(const AudioCommand& command);
+
+  // Decodes and resamples up to a chunk of the stream into its ring
+  static void decodeChunk(AudioStream& stream, uint32_t sample_rate);
+
+  // Decodes a chunk on a worker and clears the stream's decoding flag
+  Task<void> refillStream(AudioStream& stream);
+
+public:
+  // Opens the default audio device, throws std::runtime_error if there is none
+  explicit AudioSystem(Scheduler& scheduler);
+
+  AudioSystem(const AudioSystem&) = delete;
+  AudioSystem& operator=(const AudioSystem&) = delete;
+
+  // Keeps a clip in memory for the lifetime of the system, throws std::invalid_argument if it is
+  // empty
+  AudioClipHandle addClip(AudioClip clip);
+
+  // Plays a clip, gain scales it, pan goes from -1 (left) to 1 (right) and pitch scales its speed.
+  // Returns a null handle when no voice is free, the sound is then dropped.
+  AudioVoiceHandle
+  play(AudioClipHandle clip, float gain, float pan = 0.0f, float pitch = 1.0f, bool loop = false);
+
+  // Reads a WAVE file on the I/O thread and starts playing it once its first chunk is decoded,
+  // returns a null handle when no voice is free. Throws if the file cannot be read or parsed.
+  Task<AudioVoiceHandle> playStream(std::string file_name, float gain, bool loop = false);
+
+  // Stop fades the voice out, changes to finished voices are ignored
+  void stop(AudioVoiceHandle voice);
+  void setGain(AudioVoiceHandle voice, float gain, float pan = 0.0f);
+  void setPitch(AudioVoiceHandle voice, float pitch);
+
+  // Frees finished voices, refills streams and reports statistics, called once per frame
+  void update();
+
+  uint32_t sampleRate() const;
+
+  ~AudioSystem();
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef BLOB_HPP
+#define BLOB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// OffsetPtr points to an object in the same blob by its distance from the pointer itself, so a
+// blob written to disk stays valid wherever it is mapped and needs no fixup when loaded. An
+// offset of zero is the null pointer. A copy outside the blob points elsewhere, so OffsetPtrs are
+// only read in place.
+template <typename T>
+class OffsetPtr
+{
+private:
+  int64_t offset_ = 0;
+
+public:
+  const T* get() const
+  {
+    if (this->offset_ == 0)
+      return nullptr;
+    return reinterpret_cast<const T*>(reinterpret_cast<const std::byte*>(this) + this->offset_);
+  }
+
+  explicit operator bool() const
+  {
+    return this->offset_ != 0;
+  }
+
+  int64_t offset() const
+  {
+    return this->offset_;
+  }
+
+  void setOffset(int64_t offset)
+  {
+    this->offset_ = offset;
+  }
+
+  // Returns true if count objects starting at the target lie within [first, last) and the target
+  // is correctly aligned, used to validate a blob before it is read
+  bool within(const std::byte* first, const std::byte* last, uint64_t count = 1) const
+  {
+    if (count == 0)
+      return true;
+    auto pointer = reinterpret_cast<uintptr_t>(this) + static_cast<uintptr_t>(this->offset_);
+    auto begin   = reinterpret_cast<uintptr_t>(first);
+    auto end     = reinterpret_cast<uintptr_t>(last);
+    return this->offset_ != 0 && pointer >= begin && pointer < end &&
+           pointer % alignof(T) == 0 && count <= (end - pointer) / sizeof(T);
+  }
+};
+
+// OffsetArray is a count and an OffsetPtr to that many consecutive elements
+template <typename T>
+struct OffsetArray
+{
+  OffsetPtr<T> data;
+  uint64_t count = 0;
+
+  const T& operator[](size_t index) const
+  {
+    return this->data.get()[index];
+  }
+
+  const T* begin() const
+  {
+    return this->data.get();
+  }
+
+  const T* end() const
+  {
+    return this->data.get() + this->count;
+  }
+
+  size_t size() const
+  {
+    return this->count;
+  }
+
+  // Returns true if every element lies within [first, last) and is correctly aligned
+  bool within(const std::byte* first, const std::byte* last) const
+  {
+    return this->data.within(first, last, this->count);
+  }
+};
+
+// BlobBuilder lays out trivially copyable objects in one growing buffer and links OffsetPtrs
+// between them. Objects are addressed by their byte offset, as the buffer may move while it
+// grows.
+class BlobBuilder
+{
+private:
+  std::vector<std::byte> data_;
+
+public:
+  // Appends count zeroed objects aligned for T and returns the offset of the first one
+  template <typename T>
+  size_t allocate(size_t count = 1)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    size_t offset = (this->data_.size() + alignof(T) - 1) & ~(alignof(T) - 1);
+    this->data_.resize(offset + sizeof(T) * count);
+    return offset;
+  }
+
+  // Appends copies of count objects and returns the offset of the first one
+  template <typename T>
+  size_t append(const T* objects, size_t count)
+  {
+    size_t offset = this->allocate<T>(count);
+    if (count > 0)
+      std::memcpy(this->data_.data() + offset, objects, sizeof(T) * count);
+    return offset;
+  }
+
+  // Appends count zeroed objects, points the OffsetArray at array_offset to them and returns the
+  // offset of the first one
+  template <typename T>
+  size_t allocateArray(size_t array_offset, size_t count)
+  {
+    size_t data_offset = this->allocate<T>(count);
+    this->link<T>(array_offset + offsetof(OffsetArray<T>, data), data_offset);
+    this->at<OffsetArray<T>>(array_offset)->count = count;
+    return data_offset;
+  }
+
+  // Returns the object at an offset, valid until the next allocation
+  template <typename T>
+  T* at(size_t offset)
+  {
+    return reinterpret_cast<T*>(this->data_.data() + offset);
+  }
+
+  // Points the OffsetPtr at pointer_offset to the object at target_offset
+  template <typename T>
+  void link(size_t pointer_offset, size_t target_offset)
+  {
+    this->at<OffsetPtr<T>>(pointer_offset)
+        ->setOffset(static_cast<int64_t>(target_offset) - static_cast<int64_t>(pointer_offset));
+  }
+
+  // Copies count objects into the blob and points the OffsetArray at array_offset to them
+  template <typename T>
+  void fill(size_t array_offset, const T* objects, size_t count)
+  {
+    size_t data_offset = this->allocateArray<T>(array_offset, count);
+    if (count > 0)
+      std::memcpy(this->data_.data() + data_offset, objects, sizeof(T) * count);
+  }
+
+  const std::vector<std::byte>& data() const
+  {
+    return this->data_;
+  }
+};
+
+#endif
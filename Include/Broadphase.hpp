@@ -0,0 +1,128 @@
+#ifndef BROADPHASE_HPP
+#define BROADPHASE_HPP
+
+#include "Scheduler.hpp"
+#include "Task.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <latch>
+#include <vector>
+
+// Broadphase finds the pairs of bodies whose axis aligned bounding boxes overlap by sweep and
+// prune. Bodies are kept sorted by their minimum along the axis their centres spread most on,
+// which changes little between frames, so the order is repaired by insertion sort. The other
+// axis is cut into bands that are swept separately, which keeps the candidates of a body few as
+// scenes grow, and each body is compared with four candidates at a time. Large scenes are swept
+// on worker threads. Bounds are stored as one array per coordinate.
+class Broadphase
+{
+public:
+  // Bodies with overlapping bounds, a < b
+  struct Pair
+  {
+    uint32_t a;
+    uint32_t b;
+  };
+
+private:
+  // Fewer bodies are swept on the calling thread only, more are split into ranges for workers
+  static constexpr uint32_t parallel_threshold_ = 8192;
+  static constexpr uint32_t range_size_         = 2048;
+
+  // Bands hold about this many bodies each, as long as they stay twice as wide as the bodies
+  static constexpr uint32_t bodies_per_band_ = 512;
+  static constexpr uint32_t max_bands_       = 4096;
+
+  // Sorting falls back from insertion sort to a full sort after this many moves per body
+  static constexpr uint32_t max_moves_per_body_ = 8;
+
+  // Bands are padded so the sweep can read four bodies past the last one
+  static constexpr uint32_t padding_ = 4;
+
+  // Bounds by body
+  std::array<std::vector<float>, 2> min_;
+  std::array<std::vector<float>, 2> max_;
+
+  // Bodies with their minimum on the sweep axis, kept in sweep order between frames
+  struct SortEntry
+  {
+    float key;
+    uint32_t body;
+  };
+  uint32_t sweep_axis_ = 0;
+  std::vector<SortEntry> entries_;
+
+  // Bounds and bands of the bodies in sweep order, first > last for bodies in no band
+  struct BandSpan
+  {
+    uint32_t first;
+    uint32_t last;
+  };
+  std::array<std::vector<float>, 2> sorted_min_;
+  std::array<std::vector<float>, 2> sorted_max_;
+  std::vector<BandSpan> sorted_bands_;
+
+  // Bands cut the other axis into band_count_ equal parts starting at band_origin_. A body is in
+  // every band it overlaps, the bodies and bounds of band i start at band_offsets_[i] in sweep
+  // order and are followed by padding.
+  uint32_t band_count_ = 1;
+  float band_origin_   = 0.0f;
+  float band_scale_    = 0.0f;
+  std::vector<uint32_t> band_offsets_;
+  std::vector<uint32_t> band_bodies_;
+  std::array<std::vector<float>, 2> band_min_;
+  std::array<std::vector<float>, 2> band_max_;
+
+  // Part of a band swept as one unit of work, and the pairs it found. Pairs are concatenated in
+  // range order so results do not depend on which thread swept which range.
+  struct SweepRange
+  {
+    uint32_t band;
+    uint32_t begin;
+    uint32_t end;
+  };
+  std::vector<SweepRange> ranges_;
+  std::vector<std::vector<Pair>> range_pairs_;
+
+  uint64_t full_sorts_ = 0;
+
+  // Picks the sweep axis and the bands and sorts the bodies along the sweep axis
+  void sort();
+
+  // Copies the bodies into the bands they overlap and splits the bands into ranges
+  void fillBands();
+
+  // Returns the band containing a coordinate on the band axis
+  uint32_t bandOf(float coordinate) const;
+
+  // Appends the pairs of the bodies in a range with later bodies of its band
+  void sweep(const SweepRange& range, std::vector<Pair>& pairs) const;
+
+  // Sweeps ranges taken from next until none are left
+  void sweepRanges(std::atomic<uint32_t>& next);
+
+  // Sweeps ranges on a worker and counts down done when there are none left
+  Task<void> sweepOnWorker(Scheduler& scheduler, std::atomic<uint32_t>& next, std::latch& done);
+
+public:
+  // Sets the number of bodies, new bodies have empty bounds until they are set
+  void resize(uint32_t count);
+
+  uint32_t size() const;
+
+  void setBounds(uint32_t body, float min_x, float min_y, float max_x, float max_y);
+
+  // Replaces pairs with those of the bodies whose bounds overlap, touching bounds included. The
+  // calling thread sweeps alongside the scheduler's workers and blocks until they are done.
+  void findPairs(Scheduler& scheduler, std::vector<Pair>& pairs);
+
+  // Number of bands the last search used
+  uint32_t bandCount() const;
+
+  // Number of times the order was sorted from scratch rather than repaired
+  uint64_t fullSortCount() const;
+};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef CACHE_LINE_HPP
+#define CACHE_LINE_HPP
+
+#include <cstddef>
+
+// Size of a cache line on the platforms the engine targets. Data written by different threads is
+// aligned to this to keep it on separate lines and avoid false sharing.
+inline constexpr size_t cache_line_size = 64;
+
+#endif
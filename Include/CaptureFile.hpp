@@ -0,0 +1,224 @@
+#ifndef CAPTURE_FILE_HPP
+#define CAPTURE_FILE_HPP
+
+#include "Blob.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <vulkan/vulkan.hpp>
+
+// A capture file holds the commands the engine recorded for consecutive frames and everything
+// needed to issue them again without the engine: the resources they use with their contents,
+// render passes, framebuffers, pipelines with their SPIR-V and descriptor set layouts. Like a scene
+// file it is a relocatable blob, with a CaptureHeader at offset zero. Records refer to each other
+// by index into the arrays of CaptureRoot, Vulkan enums and flags are stored as their values.
+
+// Commands are a stream of 32-bit words. A command starts with a word holding its CaptureOp in the
+// low byte and the number of words that follow above it. 64-bit values take two words, low word
+// first, and floats are stored bitwise.
+enum class CaptureOp : uint32_t
+{
+  // render pass, framebuffer, area x, y, width, height, clear count, four floats per clear colour
+  BeginRenderPass,
+  EndRenderPass,
+  // x, y, width, height, min depth, max depth
+  SetViewport,
+  // x, y, width, height
+  SetScissor,
+  // aspect, attachment, four floats of colour, rect x, y, width, height, base layer, layer count
+  ClearAttachment,
+  // pipeline
+  BindPipeline,
+  // pipeline, stages, offset, size in bytes, the values padded to whole words
+  PushConstants,
+  // binding, buffer, 64-bit offset
+  BindVertexBuffer,
+  // buffer, 64-bit offset, index type
+  BindIndexBuffer,
+  // binder, then per binding of the binder either buffer, 64-bit offset and 64-bit range, or
+  // sampler, image and layout
+  BindDescriptors,
+  // vertex count, instance count, first vertex, first instance
+  Draw,
+  // index count, instance count, first index, vertex offset, first instance
+  DrawIndexed,
+  // src stages, dst stages, src access, dst access, old layout, new layout, image, aspect, base
+  // level, level count, base layer, layer count
+  ImageBarrier,
+  // buffer, image, layout, region count, then per region 64-bit buffer offset, row length, image
+  // height, aspect, level, base layer, layer count, x, y, z, width, height, depth
+  CopyBufferToImage,
+};
+
+constexpr uint32_t capture_op_count = static_cast<uint32_t>(CaptureOp::CopyBufferToImage) + 1;
+
+// Index stored for an absent reference, such as the sampler of a sampled image descriptor
+constexpr uint32_t capture_no_index = UINT32_MAX;
+
+struct CaptureBuffer
+{
+  uint64_t size;
+  uint32_t usage;
+  // Host visible buffers are written by the CPU every frame, their contents are in the frames
+  uint32_t host_visible;
+  // Contents of other buffers when the capture started
+  OffsetArray<std::byte> contents;
+};
+
+struct CaptureImage
+{
+  uint32_t format;
+  uint32_t usage;
+  uint32_t width;
+  uint32_t height;
+  uint32_t layer_count;
+  uint32_t view_type;
+  // Layout when the capture started, to which the replay brings its copy before the first frame
+  uint32_t layout;
+  // Swapchain images are replaced by images the replay renders into, they have no contents
+  uint32_t swapchain;
+  // Texels of every layer when the capture started, tightly packed, empty if undefined
+  OffsetArray<std::byte> contents;
+};
+
+struct CaptureSampler
+{
+  uint32_t mag_filter;
+  uint32_t min_filter;
+  uint32_t mipmap_mode;
+  uint32_t address_mode_u;
+  uint32_t address_mode_v;
+  uint32_t address_mode_w;
+  float max_lod;
+  uint32_t padding;
+};
+
+// Render pass with a single subpass writing its only colour attachment
+struct CaptureRenderPass
+{
+  VkAttachmentDescription color_attachment;
+  uint32_t padding;
+  OffsetArray<VkSubpassDependency> dependencies;
+};
+
+struct CaptureFramebuffer
+{
+  uint32_t render_pass;
+  uint32_t image;
+  uint32_t width;
+  uint32_t height;
+};
+
+struct CaptureDescriptorBinding
+{
+  uint32_t binding;
+  uint32_t type;
+  uint32_t count;
+  uint32_t stages;
+};
+
+// Descriptor set layout bound through a DescriptorBinder, for the set at set_index of the layout
+// of pipeline
+struct CaptureBinder
+{
+  uint32_t pipeline;
+  uint32_t set_index;
+  OffsetArray<CaptureDescriptorBinding> bindings;
+};
+
+struct CapturePipeline
+{
+  uint32_t render_pass;
+  uint32_t cull_mode;
+  uint32_t alpha_blend;
+  uint32_t premultiplied_alpha;
+  uint32_t color_write;
+  uint32_t pq_output;
+  OffsetArray<uint32_t> vertex_shader;
+  OffsetArray<uint32_t> fragment_shader;
+  OffsetArray<VkVertexInputBindingDescription> vertex_bindings;
+  OffsetArray<VkVertexInputAttributeDescription> vertex_attributes;
+  // Binders whose set layouts make up the pipeline layout, in set order
+  OffsetArray<uint32_t> set_layouts;
+  OffsetArray<VkPushConstantRange> push_constant_ranges;
+};
+
+// Contents of a host visible buffer as the GPU read it in a frame
+struct CaptureBufferWrite
+{
+  uint32_t buffer;
+  uint32_t padding;
+  OffsetArray<std::byte> contents;
+};
+
+struct CaptureFrame
+{
+  // CPU time the engine spent recording the frame, for comparison with the replay. It includes
+  // adding the frame to the capture, so it overstates recording a little.
+  uint64_t record_ns;
+  OffsetArray<CaptureBufferWrite> buffer_writes;
+  OffsetArray<uint32_t> commands;
+};
+
+struct CaptureRoot
+{
+  char device_name[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+  // Whether the engine pushed descriptors, the replay does the same if its device allows
+  uint32_t push_descriptors;
+  uint32_t padding;
+  OffsetArray<CaptureBuffer> buffers;
+  OffsetArray<CaptureImage> images;
+  OffsetArray<CaptureSampler> samplers;
+  OffsetArray<CaptureRenderPass> render_passes;
+  OffsetArray<CaptureFramebuffer> framebuffers;
+  OffsetArray<CaptureBinder> binders;
+  OffsetArray<CapturePipeline> pipelines;
+  OffsetArray<CaptureFrame> frames;
+};
+
+struct CaptureHeader
+{
+  // Bumped whenever a record or command changes, files of other versions are rejected
+  static constexpr uint32_t current_version_ = 3;
+
+  // Written as a native integer, reads back differently on a machine of the other byte order
+  static constexpr uint32_t byte_order_mark_ = 0x01020304;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t size;
+  OffsetPtr<CaptureRoot> root;
+};
+
+// Returns the first word of a command with word_count words following it
+constexpr uint32_t captureCommandWord(CaptureOp op, uint32_t word_count)
+{
+  return static_cast<uint32_t>(op) | (word_count << 8);
+}
+
+// Returns true if descriptors of a type are recorded as a buffer range rather than an image
+constexpr bool captureDescriptorIsBuffer(vk::DescriptorType type)
+{
+  return type == vk::DescriptorType::eUniformBuffer || type == vk::DescriptorType::eStorageBuffer ||
+         type == vk::DescriptorType::eUniformBufferDynamic ||
+         type == vk::DescriptorType::eStorageBufferDynamic;
+}
+
+// CaptureFile maps a capture file and checks that its arrays lie within it, the indices and
+// commands in it are checked by the code replaying them
+class CaptureFile
+{
+private:
+  MappedFile file_;
+  const CaptureRoot* root_ = nullptr;
+
+public:
+  // Throws std::runtime_error if the file cannot be mapped or is not a valid capture
+  explicit CaptureFile(const std::filesystem::path& file);
+
+  const CaptureRoot& root() const;
+};
+
+#endif
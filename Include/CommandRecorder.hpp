@@ -0,0 +1,78 @@
+#ifndef COMMAND_RECORDER_HPP
+#define COMMAND_RECORDER_HPP
+
+#include "DescriptorBinder.hpp"
+#include "FrameCapture.hpp"
+#include "Resources.hpp"
+#include "Result.hpp"
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// CommandRecorder records the commands the engine uses into a command buffer and, while a frame is
+// being captured, into the capture as well. Only commands that can be captured are offered, so
+// nothing the engine records is missing from a replay.
+class CommandRecorder
+{
+private:
+  vk::CommandBuffer command_buffer_;
+  FrameCapture* capture_;
+
+  uint32_t draw_count_          = 0;
+  uint32_t pipeline_bind_count_ = 0;
+
+public:
+  // Records into command_buffer, and into capture unless it is null
+  explicit CommandRecorder(vk::CommandBuffer command_buffer, FrameCapture* capture = nullptr);
+
+  vk::CommandBuffer commandBuffer() const;
+
+  // Number of draws and pipeline binds recorded so far
+  uint32_t drawCount() const;
+  uint32_t pipelineBindCount() const;
+
+  // Begins a render pass with inline contents
+  void beginRenderPass(const vk::RenderPassBeginInfo& begin_info);
+  void endRenderPass();
+
+  void setViewport(const vk::Viewport& viewport);
+  void setScissor(const vk::Rect2D& scissor);
+
+  // Clears a colour attachment of the current subpass
+  void clearAttachment(const vk::ClearAttachment& attachment, const vk::ClearRect& rect);
+
+  void bindPipeline(const Pipeline& pipeline);
+  void pushConstants(const Pipeline& pipeline,
+                     vk::ShaderStageFlags stages,
+                     uint32_t offset,
+                     uint32_t size,
+                     const void* values);
+
+  void bindVertexBuffer(uint32_t binding, const Buffer& buffer, vk::DeviceSize offset);
+  void bindIndexBuffer(const Buffer& buffer, vk::DeviceSize offset, vk::IndexType index_type);
+
+  // Binds one DescriptorInfo per binding of the binder, see DescriptorBinder::bind
+  Result<void> bindDescriptors(DescriptorBinder& binder, const DescriptorInfo* infos);
+
+  void draw(uint32_t vertex_count,
+            uint32_t instance_count,
+            uint32_t first_vertex,
+            uint32_t first_instance);
+  void drawIndexed(uint32_t index_count,
+                   uint32_t instance_count,
+                   uint32_t first_index,
+                   int32_t vertex_offset,
+                   uint32_t first_instance);
+
+  // Records a pipeline barrier holding a single image memory barrier
+  void imageBarrier(vk::PipelineStageFlags src_stages,
+                    vk::PipelineStageFlags dst_stages,
+                    const vk::ImageMemoryBarrier& barrier);
+
+  void copyBufferToImage(const Buffer& buffer,
+                         const Image& image,
+                         vk::ImageLayout layout,
+                         const std::vector<vk::BufferImageCopy>& regions);
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CPU_TOPOLOGY_HPP
+#define CPU_TOPOLOGY_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A logical CPU as the operating system numbers it
+struct LogicalCpu
+{
+  uint32_t id;
+
+  // Logical CPUs with the same package and core id are SMT siblings on one physical core
+  uint32_t package_id;
+  uint32_t core_id;
+
+  // Logical CPUs with the same id share a last level cache, -1 if unknown
+  int32_t l3_id;
+
+  // Relative performance, 1024 on the fastest cores
+  uint32_t capacity;
+
+  // True for the efficiency cores of a hybrid processor
+  bool efficiency;
+};
+
+// Logical CPUs chosen for each engine thread. An empty optional or list leaves that thread to the
+// operating system.
+struct ThreadPlacement
+{
+  std::optional<uint32_t> main_cpu;
+  std::optional<uint32_t> render_cpu;
+  std::vector<uint32_t> worker_cpus;
+  std::vector<uint32_t> io_cpus;
+};
+
+enum class ThreadPriority
+{
+  Low,
+  Normal,
+  High
+};
+
+// CpuTopology describes the physical cores, SMT siblings, L3 domains and hybrid core types of the
+// machine. On Linux it is read from /sys, elsewhere every logical CPU is treated as its own core.
+class CpuTopology
+{
+private:
+  std::vector<LogicalCpu> cpus_;
+
+  // Returns true if both logical CPUs are on the same physical core
+  static bool sameCore(const LogicalCpu& a, const LogicalCpu& b);
+
+public:
+  // Detects the topology of the machine
+  static CpuTopology detect();
+
+  // Parses a /sys CPU list such as "0-3,8,10-11"
+  static std::vector<uint32_t> parseCpuList(const std::string& list);
+
+  const std::vector<LogicalCpu>& cpus() const;
+
+  // Returns the logical CPUs sharing a physical core with cpu, cpu included
+  std::vector<uint32_t> siblings(uint32_t cpu) const;
+
+  uint32_t physicalCoreCount() const;
+  uint32_t l3DomainCount() const;
+  uint32_t efficiencyCpuCount() const;
+
+  // Places the latency critical main and render threads on separate performance cores in the
+  // same L3 domain, keeps the workers off both cores and their SMT siblings, and moves the I/O
+  // thread to efficiency cores when there are any. Machines with fewer than three performance
+  // cores get no dedicated cores.
+  ThreadPlacement placeThreads() const;
+};
+
+// Returns the native handle of the calling thread
+std::thread::native_handle_type currentThreadHandle();
+
+// Restricts a thread to the given logical CPUs, returns false if the platform refused
+bool setThreadAffinity(std::thread::native_handle_type thread, const std::vector<uint32_t>& cpus);
+
+// Changes a thread's scheduling priority, returns false if the platform refused. High priority
+// usually needs elevated privileges.
+bool setThreadPriority(std::thread::native_handle_type thread, ThreadPriority priority);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef DESCRIPTOR_BINDER_HPP
+#define DESCRIPTOR_BINDER_HPP
+
+#include "Result.hpp"
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// DescriptorInfo is a single entry of the data handed to DescriptorBinder::bind, one per binding
+union DescriptorInfo
+{
+  vk::DescriptorBufferInfo buffer;
+  vk::DescriptorImageInfo image;
+
+  DescriptorInfo(const vk::DescriptorBufferInfo& buffer_info) : buffer(buffer_info) { }
+  DescriptorInfo(const vk::DescriptorImageInfo& image_info) : image(image_info) { }
+};
+
+// DescriptorBinder owns one descriptor set layout of a pipeline layout and binds descriptors for it
+// while recording. Small sets are pushed straight into the command buffer with
+// VK_KHR_push_descriptor when the device supports it, larger sets (or all sets without the
+// extension) are allocated from a per-frame pool. Both paths write through an update template.
+class DescriptorBinder
+{
+private:
+  // Sets with more bindings than this are always allocated from a pool
+  static constexpr uint32_t max_push_bindings_ = 4;
+
+  // Number of sets each per-frame pool can allocate before it is reset
+  static constexpr uint32_t sets_per_frame_ = 1024;
+
+  vk::Device device_;
+  vk::PipelineBindPoint bind_point_;
+  std::vector<vk::DescriptorSetLayoutBinding> bindings_;
+  bool use_push_descriptors_;
+
+  vk::DescriptorSetLayout set_layout_;
+  vk::PipelineLayout pipeline_layout_;
+  uint32_t set_index_ = 0;
+  vk::DescriptorUpdateTemplate update_template_;
+
+  // One pool per frame in flight, only created for the pooled path
+  std::vector<vk::DescriptorPool> pools_;
+  uint32_t frame_index_ = 0;
+
+  // Initialises the descriptor set layout for the bindings
+  void initSetLayout();
+
+  // Initialises a descriptor pool for each frame in flight
+  void initPools(uint32_t frame_count);
+
+public:
+  DescriptorBinder(vk::Device device,
+                   vk::PipelineBindPoint bind_point,
+                   const std::vector<vk::DescriptorSetLayoutBinding>& bindings,
+                   uint32_t max_push_descriptors,
+                   uint32_t frame_count);
+
+  DescriptorBinder(const DescriptorBinder&) = delete;
+  DescriptorBinder& operator=(const DescriptorBinder&) = delete;
+
+  // Returns the layout to be used when creating the pipeline layout
+  vk::DescriptorSetLayout getSetLayout() const;
+
+  // Returns true if descriptors are pushed rather than allocated
+  bool usesPushDescriptors() const;
+
+  // Returns the bindings of the set, in the order bind expects their DescriptorInfos
+  const std::vector<vk::DescriptorSetLayoutBinding>& bindings() const;
+
+  // Returns the pipeline layout and set index given to setPipelineLayout
+  vk::PipelineLayout pipelineLayout() const;
+  uint32_t setIndex() const;
+
+  // Creates the update template for the set at set_index of pipeline_layout. Must be called once
+  // the pipeline layout has been created and before the first call to bind.
+  void setPipelineLayout(vk::PipelineLayout pipeline_layout, uint32_t set_index);
+
+  // Starts a new frame, resetting the pool that was used the last time frame_index was in flight
+  Result<void> beginFrame(uint32_t frame_index);
+
+  // Binds one DescriptorInfo per binding, in binding order, to the command buffer
+  Result<void> bind(vk::CommandBuffer command_buffer, const DescriptorInfo* infos);
+
+  ~DescriptorBinder();
+};
+
+#endif
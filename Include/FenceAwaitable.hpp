@@ -0,0 +1,35 @@
+#ifndef FENCE_AWAITABLE_HPP
+#define FENCE_AWAITABLE_HPP
+
+#include "Result.hpp"
+#include "Scheduler.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+// Awaitable that resumes the coroutine on the main thread once a fence is signalled. The fence is
+// polled from pumpMainThread, so waiting never blocks the main thread:
+//
+//   co_await FenceAwaitable(scheduler, device, upload_fence);
+//
+// Errors such as a lost device also resume the coroutine, its next Vulkan call reports them.
+struct FenceAwaitable : Scheduler::MainThreadAwaitable
+{
+  vk::Device device;
+  vk::Fence fence;
+
+  FenceAwaitable(Scheduler& scheduler, vk::Device device, vk::Fence fence) :
+    MainThreadAwaitable(&scheduler, &FenceAwaitable::signalled),
+    device(device),
+    fence(fence)
+  {
+  }
+
+  static bool signalled(const Scheduler::MainThreadAwaitable& awaitable)
+  {
+    const FenceAwaitable& self = static_cast<const FenceAwaitable&>(awaitable);
+    Result<void> status        = VULKAN_CALL(self.device.getFenceStatus(self.fence));
+    return status.code() != vk::Result::eNotReady;
+  }
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef FORMAT_POLICY_HPP
+#define FORMAT_POLICY_HPP
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// The format policy picks the swapchain and intermediate render target formats that cost the
+// least memory bandwidth for what they have to hold. Render targets are written and read at least
+// once per pixel per frame, so their bytes per pixel are a direct multiple of a frame's traffic.
+
+// What an intermediate render target has to hold and allow
+struct IntermediateFormatDesc
+{
+  // At least 8 bits of alpha, e.g. for layers composited with premultiplied alpha
+  bool alpha = false;
+  // Values above 1.0, otherwise colour is stored with 8 bits per channel in sRGB encoding
+  bool high_dynamic_range = false;
+  // Alpha blending into the target, besides rendering to it and sampling it
+  bool blend = false;
+};
+
+// Bytes a pixel of a colour format takes, 0 for formats the policy does not know
+uint32_t formatBytesPerPixel(vk::Format format);
+
+// Picks the cheapest surface format the shaders' linear output can be presented in. SDR output is
+// 8-bit sRGB. HDR output is 10-bit HDR10, encoded by the shaders with the PQ curve, or FP16 scRGB,
+// and falls back to SDR when the surface offers neither. Surfaces offering none of these are
+// presented in their first format.
+vk::SurfaceFormatKHR chooseSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& formats,
+                                         bool hdr);
+
+// Whether a surface format is presented with the PQ curve, which the shaders then have to encode
+bool isPqColorSpace(vk::ColorSpaceKHR color_space);
+
+// Picks the cheapest format holding desc that the device supports with optimal tiling. preferred
+// is taken when it is as cheap as the cheapest, so e.g. a layer can share the swapchain's
+// pipelines. Throws std::runtime_error if no candidate is supported.
+vk::Format chooseIntermediateFormat(vk::PhysicalDevice physical_device,
+                                    const IntermediateFormatDesc& desc,
+                                    vk::Format preferred = vk::Format::eUndefined);
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include "CaptureFile.hpp"
+#include "DescriptorBinder.hpp"
+#include "GraphicsPipeline.hpp"
+#include "Resources.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// FrameCapture collects the commands of consecutive frames into a capture file. The resources,
+// render passes, framebuffers, binders and pipelines the frames may use are added first, commands
+// then refer to them by the index they were given. A command referring to anything that was not
+// added fails the capture rather than the frame. Render thread only.
+class FrameCapture
+{
+private:
+  struct BufferRecord
+  {
+    Buffer buffer;
+    std::vector<std::byte> contents;
+  };
+
+  struct ImageRecord
+  {
+    Image image;
+    vk::ImageLayout layout;
+    std::vector<std::byte> contents;
+  };
+
+  struct FramebufferRecord
+  {
+    uint32_t render_pass;
+    uint32_t image;
+    vk::Extent2D extent;
+  };
+
+  // Binders and pipelines refer to each other, they are matched up by layout when writing
+  struct BinderRecord
+  {
+    const DescriptorBinder* binder;
+  };
+
+  struct PipelineRecord
+  {
+    Pipeline pipeline;
+    uint32_t render_pass;
+    GraphicsPipelineDesc desc;
+    std::vector<uint32_t> vertex_shader;
+    std::vector<uint32_t> fragment_shader;
+  };
+
+  struct FrameRecord
+  {
+    std::chrono::nanoseconds record_time;
+    std::vector<std::pair<uint32_t, std::vector<std::byte>>> buffer_writes;
+    std::vector<uint32_t> commands;
+  };
+
+  std::filesystem::path file_;
+  uint32_t frame_count_;
+  std::string device_name_;
+  bool push_descriptors_;
+
+  std::vector<BufferRecord> buffers_;
+  std::vector<ImageRecord> images_;
+  std::vector<vk::SamplerCreateInfo> samplers_;
+  std::vector<RenderPassDesc> render_passes_;
+  std::vector<FramebufferRecord> framebuffers_;
+  std::vector<BinderRecord> binders_;
+  std::vector<PipelineRecord> pipelines_;
+
+  // Indices by Vulkan handle value, images are found by their view as well
+  std::unordered_map<uint64_t, uint32_t> buffer_indices_;
+  std::unordered_map<uint64_t, uint32_t> image_indices_;
+  std::unordered_map<uint64_t, uint32_t> view_indices_;
+  std::unordered_map<uint64_t, uint32_t> sampler_indices_;
+  std::unordered_map<uint64_t, uint32_t> render_pass_indices_;
+  std::unordered_map<uint64_t, uint32_t> framebuffer_indices_;
+  std::unordered_map<uint64_t, uint32_t> pipeline_indices_;
+  std::unordered_map<const DescriptorBinder*, uint32_t> binder_indices_;
+
+  // Finished frames, then the commands and buffers used by the frame being recorded
+  std::vector<FrameRecord> frames_;
+  std::vector<uint32_t> commands_;
+  size_t command_start_ = 0;
+  std::vector<bool> buffers_used_;
+  std::string error_;
+
+  template <typename VulkanHandle>
+  static uint64_t key(VulkanHandle handle)
+  {
+    return reinterpret_cast<uint64_t>(static_cast<typename VulkanHandle::CType>(handle));
+  }
+
+  // Returns the index of a handle, fails the capture if it was not added
+  uint32_t find(const std::unordered_map<uint64_t, uint32_t>& indices,
+                uint64_t key,
+                const char* kind);
+
+public:
+  // Captures frame_count frames into file, device_name and push_descriptors describe the engine's
+  // device for the replay
+  FrameCapture(std::filesystem::path file,
+               uint32_t frame_count,
+               std::string device_name,
+               bool push_descriptors);
+
+  // Adds a buffer, contents holds the data of buffers that are not host visible
+  void addBuffer(const Buffer& buffer, std::vector<std::byte> contents);
+
+  // Adds an image in layout, contents holds its texels unless it is undefined. Images without
+  // memory of their own are taken to belong to the swapchain.
+  void addImage(const Image& image, vk::ImageLayout layout, std::vector<std::byte> contents);
+
+  void addSampler(vk::Sampler sampler, const vk::SamplerCreateInfo& create_info);
+  void addRenderPass(vk::RenderPass render_pass, const RenderPassDesc& desc);
+
+  // Adds a framebuffer whose only attachment is a view of an image added before
+  void addFramebuffer(vk::Framebuffer framebuffer,
+                      vk::RenderPass render_pass,
+                      const Image& attachment,
+                      vk::Extent2D extent);
+
+  // Adds a binder, its pipeline layout must be that of a pipeline added before the capture is
+  // written. The binder must outlive the capture.
+  void addBinder(const DescriptorBinder& binder);
+
+  // Adds a pipeline created from desc for render_pass, reading the SPIR-V the desc names. Throws
+  // std::runtime_error if a shader cannot be read.
+  void addPipeline(const Pipeline& pipeline,
+                   vk::RenderPass render_pass,
+                   const GraphicsPipelineDesc& desc);
+
+  // Index of an added object, recorded in place of the handle
+  uint32_t bufferIndex(vk::Buffer buffer);
+  uint32_t imageIndex(vk::Image image);
+  uint32_t viewIndex(vk::ImageView view);
+  uint32_t samplerIndex(vk::Sampler sampler);
+  uint32_t renderPassIndex(vk::RenderPass render_pass);
+  uint32_t framebufferIndex(vk::Framebuffer framebuffer);
+  uint32_t pipelineIndex(vk::Pipeline pipeline);
+  uint32_t binderIndex(const DescriptorBinder& binder);
+
+  // Starts a command, its words are added with put until endCommand
+  void beginCommand(CaptureOp op);
+  void put(uint32_t word);
+  void put(int32_t word);
+  void put(uint64_t words);
+  void put(float word);
+  void endCommand();
+
+  // Adds a command with a fixed list of words
+  template <typename... Words>
+  void command(CaptureOp op, Words... words)
+  {
+    this->beginCommand(op);
+    (this->put(words), ...);
+    this->endCommand();
+  }
+
+  // Ends the frame whose commands were added since the last one, copying the host visible
+  // buffers it used as they are now
+  void endFrame(std::chrono::nanoseconds record_time);
+
+  // Returns true once every frame has been captured
+  bool complete() const;
+
+  // Returns the reason the capture failed, empty while it has not
+  const std::string& error() const;
+
+  // Writes the capture file, throws std::runtime_error if it cannot be written
+  void write() const;
+};
+
+#endif
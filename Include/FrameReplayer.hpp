@@ -0,0 +1,132 @@
+#ifndef FRAME_REPLAYER_HPP
+#define FRAME_REPLAYER_HPP
+
+#include "CaptureFile.hpp"
+#include "DescriptorBinder.hpp"
+#include "Resources.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// Settings of a replay chosen on the command line
+struct ReplayOptions
+{
+  std::filesystem::path capture_file;
+
+  // Index of the physical device to replay on, the first one with a graphics queue if not set
+  std::optional<uint32_t> device_index;
+
+  // Number of times every captured frame is replayed
+  uint32_t repeat_count = 100;
+
+  // Enables the validation layer, which makes recording slower
+  bool validation = false;
+
+  // Pushes descriptors like the engine did if the device allows, otherwise sets are pooled
+  bool push_descriptors = true;
+};
+
+// Timings of a captured frame over all its replays
+struct ReplayFrameStats
+{
+  // CPU time the engine spent recording the frame when it was captured
+  std::chrono::nanoseconds captured_record_time {};
+
+  // CPU time spent recording the frame, on average and at best
+  std::chrono::nanoseconds record_time {};
+  std::chrono::nanoseconds min_record_time {};
+
+  // GPU time between the start and end of the frame on average, zero without timestamps
+  std::chrono::nanoseconds gpu_time {};
+
+  // CPU time spent copying the frame's host visible buffer contents on average
+  std::chrono::nanoseconds upload_time {};
+};
+
+// FrameReplayer recreates the objects of a capture file on a headless device and records and
+// submits the captured frames again, so that recording and GPU time can be measured without the
+// engine, its window or its simulation. Swapchain images are replaced by offscreen images.
+class FrameReplayer
+{
+private:
+  ReplayOptions options_;
+  CaptureFile capture_;
+
+  vk::Instance instance_;
+  vk::PhysicalDevice physical_device_;
+  vk::Device device_;
+  uint32_t queue_family_ = 0;
+  vk::Queue queue_;
+  uint32_t max_push_descriptors_ = 0;
+
+  vk::CommandPool command_pool_;
+  vk::CommandBuffer command_buffer_;
+  vk::Fence fence_;
+
+  // Two timestamps around each frame, null if the queue has no timestamps
+  vk::QueryPool query_pool_;
+  double timestamp_period_ = 0.0;
+
+  // Objects of the capture by their index in it
+  std::vector<Buffer> buffers_;
+  std::vector<Image> images_;
+  std::vector<vk::Sampler> samplers_;
+  std::vector<vk::RenderPass> render_passes_;
+  std::vector<vk::Framebuffer> framebuffers_;
+  std::vector<std::unique_ptr<DescriptorBinder>> binders_;
+  std::vector<Pipeline> pipelines_;
+
+  // Storage for decoding commands, kept to reuse it between frames
+  std::vector<vk::ClearValue> clear_values_;
+  std::vector<DescriptorInfo> descriptor_infos_;
+  std::vector<vk::BufferImageCopy> copy_regions_;
+
+  uint32_t findMemoryType(uint32_t type_bits, vk::MemoryPropertyFlags properties) const;
+
+  // Creates a buffer, host visible ones stay mapped
+  Buffer createBuffer(vk::DeviceSize size,
+                      vk::BufferUsageFlags usage,
+                      vk::MemoryPropertyFlags properties);
+  void destroyBuffer(const Buffer& buffer);
+
+  // Submits one-time commands recorded by record and waits for them
+  template <typename Record>
+  void submitNow(Record record);
+
+  // Initialises the instance, device, queue and command buffer
+  void initInstance();
+  void initDevice();
+  void initCommands();
+
+  // Initialises the objects of the capture and uploads the contents it holds
+  void initBuffers();
+  void initImages();
+  void initSamplers();
+  void initRenderPasses();
+  void initFramebuffers();
+  void initPipelines();
+
+  // Records the commands of a frame, throws std::runtime_error if they are malformed or refer to
+  // objects the capture does not hold
+  void recordFrame(const CaptureFrame& frame);
+
+public:
+  // Maps the capture and recreates its objects, throws std::runtime_error if it cannot
+  explicit FrameReplayer(const ReplayOptions& options);
+
+  FrameReplayer(const FrameReplayer&) = delete;
+  FrameReplayer& operator=(const FrameReplayer&) = delete;
+
+  // Replays every frame options_.repeat_count times in capture order, waiting for each, and
+  // returns the timings of each frame. Throws std::runtime_error if a frame cannot be replayed.
+  std::vector<ReplayFrameStats> replay();
+
+  ~FrameReplayer();
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef GLYPH_CACHE_HPP
+#define GLYPH_CACHE_HPP
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Texel position of a cached glyph's cell, page is the layer of the glyph atlas
+struct GlyphSlot
+{
+  uint32_t page;
+  uint32_t x;
+  uint32_t y;
+};
+
+// GlyphCache assigns glyphs to equally sized cells of a fixed number of atlas pages. Glyphs are
+// added to one page until it is full, then the least recently used page is emptied as a whole and
+// filled next. Evicting whole pages keeps bookkeeping per page rather than per glyph, text tends
+// to use glyphs cached around the same time together.
+class GlyphCache
+{
+private:
+  struct Page
+  {
+    // Last frame a glyph on the page was looked up or added
+    uint64_t last_used = 0;
+    std::vector<uint32_t> glyphs;
+  };
+
+  uint32_t cell_size_;
+  uint32_t cells_per_row_;
+  uint32_t cells_per_page_;
+  std::vector<Page> pages_;
+  std::unordered_map<uint32_t, GlyphSlot> slots_;
+  uint32_t fill_page_      = 0;
+  uint64_t eviction_count_ = 0;
+
+public:
+  GlyphCache(uint32_t page_size, uint32_t cell_size, uint32_t page_count);
+
+  // Returns the slot of a cached glyph and marks its page used in frame, or nullptr
+  const GlyphSlot* find(uint32_t glyph, uint64_t frame);
+
+  // Allocates a cell for a glyph. When the cache is full, the least recently used page is evicted
+  // if it was last used before evict_before, otherwise nullopt is returned.
+  std::optional<GlyphSlot> insert(uint32_t glyph, uint64_t frame, uint64_t evict_before);
+
+  size_t size() const;
+  uint64_t evictionCount() const;
+};
+
+#endif
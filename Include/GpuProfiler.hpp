@@ -0,0 +1,73 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// GpuProfiler measures zones of each frame on the GPU with timestamp queries and adds them to the
+// Profiler's GPU ring once the frame's fence has signalled. The GPU and CPU clocks are not
+// calibrated against each other, a frame's first timestamp is placed at its submission or at the
+// end of the previous frame on the GPU if that is later, so durations are exact and placement is
+// approximate. Timestamps are written around CommandRecorder and are not part of captures. Every
+// call is a no-op if the queue has no timestamps. Render thread only.
+class GpuProfiler
+{
+public:
+  // Returned by beginZone when a frame has no room for another zone
+  static constexpr uint32_t no_zone_ = UINT32_MAX;
+
+private:
+  static constexpr uint32_t max_zones_per_frame_ = 8;
+
+  vk::Device device_;
+  vk::QueryPool query_pool_;
+  double timestamp_period_ = 0.0;
+  uint64_t timestamp_mask_ = 0;
+
+  // Zones of a frame slot, and the time the frame was submitted, zero until it is
+  struct FrameZones
+  {
+    std::array<const char*, max_zones_per_frame_> names {};
+    uint32_t count      = 0;
+    int64_t submit_time = 0;
+  };
+  std::vector<FrameZones> frames_;
+
+  // End of the last zone collected, in CPU time
+  int64_t last_end_ = 0;
+
+public:
+  // Creates queries for frame_count frames in flight on a queue of queue_family. Throws
+  // std::runtime_error if they cannot be created.
+  GpuProfiler(vk::PhysicalDevice physical_device,
+              vk::Device device,
+              uint32_t queue_family,
+              uint32_t frame_count);
+
+  GpuProfiler(const GpuProfiler&) = delete;
+  GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+  bool enabled() const;
+
+  // Adds the zones of the frame last submitted in a slot to the Profiler, once its fence has
+  // signalled
+  void collect(uint32_t frame);
+
+  // Starts the zones of a frame, outside a render pass as it resets the frame's queries
+  void beginFrame(vk::CommandBuffer command_buffer, uint32_t frame);
+
+  // Writes the first timestamp of a zone and returns it, or no_zone_ if the frame is full
+  uint32_t beginZone(vk::CommandBuffer command_buffer, uint32_t frame, const char* name);
+
+  // Writes the last timestamp of a zone, ignoring no_zone_
+  void endZone(vk::CommandBuffer command_buffer, uint32_t frame, uint32_t zone);
+
+  // Records when a frame was submitted, its zones are collected after that
+  void submitted(uint32_t frame, int64_t submit_time);
+
+  ~GpuProfiler();
+};
+
+#endif
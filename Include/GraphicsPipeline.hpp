@@ -0,0 +1,49 @@
+#ifndef GRAPHICS_PIPELINE_HPP
+#define GRAPHICS_PIPELINE_HPP
+
+#include "Resources.hpp"
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// Render pass with a single subpass writing one colour attachment, the only kind the engine uses
+struct RenderPassDesc
+{
+  vk::AttachmentDescription color_attachment;
+  std::vector<vk::SubpassDependency> dependencies;
+};
+
+// Fixed function and shader state of a graphics pipeline, everything else is shared by all
+// pipelines. Viewport and scissor are dynamic so that pipelines survive swapchain recreation.
+struct GraphicsPipelineDesc
+{
+  std::string vertex_shader;
+  std::string fragment_shader;
+  std::vector<vk::VertexInputBindingDescription> vertex_bindings;
+  std::vector<vk::VertexInputAttributeDescription> vertex_attributes;
+  std::vector<vk::DescriptorSetLayout> set_layouts;
+  std::vector<vk::PushConstantRange> push_constant_ranges;
+  vk::CullModeFlags cull_mode = vk::CullModeFlagBits::eBack;
+  bool alpha_blend            = false;
+  // The fragment shader outputs colour already multiplied by alpha, as read from a cached layer
+  bool premultiplied_alpha = false;
+  // Pipelines without colour writes only rasterize, e.g. to measure coverage with occlusion queries
+  bool color_write = true;
+  // The fragment shader encodes its output with the PQ curve, for HDR10 swapchains
+  bool pq_output = false;
+};
+
+// Creates a render pass from its desc
+vk::RenderPass buildRenderPass(vk::Device device, const RenderPassDesc& desc);
+
+// Creates a pipeline drawing into subpass 0 of render_pass, with a layout made of the desc's set
+// layouts and push constant ranges. The shader file names of the desc are not used, the modules
+// are passed in and can be destroyed afterwards.
+Pipeline buildGraphicsPipeline(vk::Device device,
+                               vk::RenderPass render_pass,
+                               const GraphicsPipelineDesc& desc,
+                               vk::ShaderModule vertex_shader,
+                               vk::ShaderModule fragment_shader);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// JsonValue is a small JSON document model, enough to read glTF files in the asset cooker. Parse
+// errors and type mismatches throw std::runtime_error.
+class JsonValue
+{
+public:
+  enum class Type
+  {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object
+  };
+
+private:
+  Type type_     = Type::Null;
+  bool boolean_  = false;
+  double number_ = 0.0;
+  std::string string_;
+  std::vector<JsonValue> array_;
+  std::vector<std::pair<std::string, JsonValue>> object_;
+
+  friend class JsonParser;
+
+public:
+  // Parses a complete JSON document
+  static JsonValue parse(std::string_view text);
+
+  Type type() const;
+
+  bool asBoolean() const;
+  double asNumber() const;
+  const std::string& asString() const;
+
+  // Array elements and object members, in document order
+  const std::vector<JsonValue>& asArray() const;
+  const std::vector<std::pair<std::string, JsonValue>>& asObject() const;
+
+  // Returns the member with the given key, or nullptr if this is not an object or has no such key
+  const JsonValue* find(std::string_view key) const;
+
+  // Returns the member with the given key, throwing if it is missing
+  const JsonValue& at(std::string_view key) const;
+
+  // Returns the array element at index, throwing if it is out of range
+  const JsonValue& at(size_t index) const;
+
+  // Returns a numeric member, or fallback if it is missing
+  double numberOr(std::string_view key, double fallback) const;
+};
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include "Config.hpp"
+#include "SpscQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : uint8_t
+{
+  Trace,
+  Debug,
+  Info,
+  Warning,
+  Error
+};
+
+// Logger is an asynchronous logger. Each thread writes unformatted records (a format string and its
+// arguments) into its own lock-free ring buffer and a background thread formats and writes them
+// out, so logging never blocks on I/O or on other threads. Format strings use {} placeholders and
+// must outlive the logger, which in practice means string literals.
+class Logger
+{
+public:
+  // Maximum number of arguments a single record can carry
+  static constexpr size_t max_arguments_ = 8;
+
+  // Bytes available per record for copies of string arguments
+  static constexpr size_t string_capacity_ = 192;
+
+  // Number of records in each thread's ring buffer
+  static constexpr size_t buffer_capacity_ = 256;
+
+  struct Argument
+  {
+    enum class Type : uint8_t
+    {
+      Signed,
+      Unsigned,
+      Floating,
+      String
+    } type;
+
+    union
+    {
+      int64_t signed_value;
+      uint64_t unsigned_value;
+      double floating_value;
+      struct
+      {
+        uint16_t offset;
+        uint16_t size;
+      } string_value;
+    };
+  };
+
+  struct Record
+  {
+    uint64_t timestamp;
+    const char* format;
+    uint32_t thread_index;
+    LogLevel level;
+    uint8_t argument_count;
+    uint16_t string_size;
+    std::array<Argument, max_arguments_> arguments;
+    std::array<char, string_capacity_> strings;
+
+    // Appends an argument to the record, string arguments are truncated to the space left
+    template <typename T>
+    void pushArgument(const T& value);
+  };
+
+private:
+  // Ring of records written by one thread and read by the background thread. It is retired when
+  // its thread exits and freed by the background thread once it has been drained.
+  struct ThreadBuffer
+  {
+    uint32_t thread_index;
+    std::atomic<bool> retired { false };
+    SpscQueue<Record, buffer_capacity_> records;
+  };
+
+  // Buffers of the threads that logged and have not been freed yet, guarded by buffers_mutex_ as
+  // threads register lazily. Thread indices are not reused.
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  uint32_t next_thread_index_ = 0;
+  std::mutex buffers_mutex_;
+
+  // Copy of buffers_ the background thread drains without holding buffers_mutex_
+  std::vector<ThreadBuffer*> draining_;
+
+  // Records popped by the background thread, sorted before they are written
+  std::vector<Record> pending_;
+
+  // Binary output file, when set records are written raw instead of formatted text. Guarded by
+  // output_mutex_, which is held while records are written.
+  std::FILE* binary_file_ = nullptr;
+  std::mutex output_mutex_;
+
+  std::chrono::steady_clock::time_point start_time_;
+  std::atomic<bool> running_ { true };
+  std::thread thread_;
+
+  Logger();
+
+  // Returns the ring buffer of the calling thread, registering one on first use
+  ThreadBuffer& threadBuffer();
+
+  // Background thread loop
+  void process();
+
+  // Formats or writes all pending records of every thread, returns false if there were none
+  bool drain();
+
+  // Formats a record into text and writes it to stdout or stderr
+  void writeText(const Record& record) const;
+
+  // Writes a record in the binary log format
+  void writeBinary(const Record& record) const;
+
+public:
+  // Returns the process wide logger, starting its background thread on first use
+  static Logger& instance();
+
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  // Switches output to a binary log file. Records are written as a little-endian header
+  // (timestamp, thread index, level, argument count), the format string and tagged arguments.
+  void openBinaryFile(const char* file_name);
+
+  // Captures a record into the calling thread's buffer, waiting only if the buffer is full
+  template <typename... Args>
+  void write(LogLevel level, const char* format, const Args&... args);
+
+  ~Logger();
+};
+
+template <typename T>
+void Logger::Record::pushArgument(const T& value)
+{
+  if (this->argument_count == max_arguments_)
+    return;
+  Argument& argument = this->arguments[this->argument_count++];
+
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    argument.type           = Argument::Type::Unsigned;
+    argument.unsigned_value = value;
+  } else if constexpr (std::is_enum_v<T>)
+  {
+    argument.type         = Argument::Type::Signed;
+    argument.signed_value = static_cast<int64_t>(value);
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+  {
+    argument.type         = Argument::Type::Signed;
+    argument.signed_value = value;
+  } else if constexpr (std::is_integral_v<T>)
+  {
+    argument.type           = Argument::Type::Unsigned;
+    argument.unsigned_value = value;
+  } else if constexpr (std::is_floating_point_v<T>)
+  {
+    argument.type           = Argument::Type::Floating;
+    argument.floating_value = value;
+  } else
+  {
+    static_assert(std::is_convertible_v<const T&, std::string_view>,
+                  "Unsupported log argument type");
+    // Copy the string into the record, it may not outlive the call
+    std::string_view string = value;
+    size_t size = std::min(string.size(), string_capacity_ - this->string_size);
+    string.copy(this->strings.data() + this->string_size, size);
+    argument.type                = Argument::Type::String;
+    argument.string_value.offset = this->string_size;
+    argument.string_value.size   = static_cast<uint16_t>(size);
+    this->string_size += static_cast<uint16_t>(size);
+  }
+}
+
+template <typename... Args>
+void Logger::write(LogLevel level, const char* format, const Args&... args)
+{
+  static_assert(sizeof...(Args) <= max_arguments_, "Too many log arguments");
+
+  ThreadBuffer& buffer = this->threadBuffer();
+
+  Record record;
+  record.timestamp      = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - this->start_time_)
+                         .count();
+  record.format         = format;
+  record.thread_index   = buffer.thread_index;
+  record.level          = level;
+  record.argument_count = 0;
+  record.string_size    = 0;
+  (record.pushArgument(args), ...);
+
+  // Publish the record, waiting for the background thread to free a slot if the buffer is full
+  while (!buffer.records.tryPush(record))
+    std::this_thread::yield();
+}
+
+// Logging macros, levels below ENGINE_LOG_LEVEL are compiled out along with their arguments
+#define LOG(level, ...)                                                                          \
+  do                                                                                             \
+  {                                                                                              \
+    if constexpr (LogLevel::level >= static_cast<LogLevel>(ENGINE_LOG_LEVEL))                    \
+      Logger::instance().write(LogLevel::level, __VA_ARGS__);                                    \
+  } while (false)
+
+#define LOG_TRACE(...)   LOG(Trace, __VA_ARGS__)
+#define LOG_DEBUG(...)   LOG(Debug, __VA_ARGS__)
+#define LOG_INFO(...)    LOG(Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG(Warning, __VA_ARGS__)
+#define LOG_ERROR(...)   LOG(Error, __VA_ARGS__)
+
+#endif
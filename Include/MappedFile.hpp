@@ -0,0 +1,28 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+
+// MappedFile maps a whole file read-only into memory. Pages are only read from disk when first
+// touched, so opening even a large file is immediate. Without mmap the file is read instead.
+class MappedFile
+{
+private:
+  std::byte* data_ = nullptr;
+  size_t size_     = 0;
+
+public:
+  // Maps a file, throws std::runtime_error if it cannot be opened
+  explicit MappedFile(const std::filesystem::path& file);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const std::byte* data() const;
+  size_t size() const;
+
+  ~MappedFile();
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef METRICS_EXPORTER_HPP
+#define METRICS_EXPORTER_HPP
+
+#include "SpscQueue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// Measurements of one drawn frame
+struct FrameMetrics
+{
+  std::chrono::nanoseconds frame_time {};
+  std::chrono::nanoseconds record_time {};
+  std::chrono::nanoseconds simulation_time {};
+  uint64_t draw_count             = 0;
+  uint64_t pipeline_bind_count    = 0;
+  uint64_t sprite_count           = 0;
+  uint64_t skipped_draw_count     = 0;
+  uint64_t render_target_bytes    = 0;
+  uint64_t render_allocations     = 0;
+  uint64_t simulation_allocations = 0;
+};
+
+// MetricsExporter periodically writes frame, memory and pipeline statistics to a file in the
+// Prometheus text exposition format, for the textfile collector of a node exporter. The render
+// thread hands each frame's measurements over through a lock-free queue, and the exporter's own
+// thread aggregates them, samples process and device memory and writes the file. The file is
+// replaced by renaming a complete temporary file, so it is never read half written.
+class MetricsExporter
+{
+private:
+  // Frames the exporter may fall behind by before their measurements are dropped
+  static constexpr size_t queue_capacity_ = 4096;
+
+  // Period at which the exporter thread drains the queue
+  static constexpr std::chrono::milliseconds drain_interval_ { 100 };
+
+  std::filesystem::path file_;
+  std::filesystem::path temporary_file_;
+  std::chrono::milliseconds interval_;
+
+  // Queried for the device memory heaps, and their budgets when memory_budget_ is set
+  vk::PhysicalDevice physical_device_;
+  bool memory_budget_;
+
+  SpscQueue<FrameMetrics, queue_capacity_> frames_;
+  std::atomic<uint64_t> dropped_frames_ { 0 };
+
+  std::atomic<uint32_t> pipeline_count_ { 0 };
+  std::atomic<uint64_t> pipeline_creation_ns_ { 0 };
+
+  // Exporter thread only. Frame times since the last write, for the percentiles, and totals
+  // since the exporter started.
+  std::vector<double> frame_times_;
+  uint64_t frame_count_ = 0;
+  FrameMetrics totals_;
+  double frame_time_sum_ = 0.0;
+  bool write_failed_     = false;
+
+  std::atomic<bool> running_ { true };
+  std::thread thread_;
+
+  // Drains the queue every drain_interval_ and writes the file every interval_ until stopped
+  void process();
+
+  // Moves queued frame measurements into the totals and frame times
+  void drain();
+
+  // Writes the metrics to the temporary file and renames it over the file, returns false if it
+  // could not
+  bool write();
+
+public:
+  // Starts the exporter thread, which writes file every interval. memory_budget is set if
+  // VK_EXT_memory_budget is enabled on the device.
+  MetricsExporter(std::filesystem::path file,
+                  std::chrono::milliseconds interval,
+                  vk::PhysicalDevice physical_device,
+                  bool memory_budget);
+
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  // Hands the measurements of a frame to the exporter. Never blocks or allocates, the frame is
+  // dropped if the exporter fell behind. Render thread only.
+  void recordFrame(const FrameMetrics& frame);
+
+  // Counts a pipeline and the CPU time spent creating it
+  void recordPipelineCreation(std::chrono::nanoseconds creation_time);
+
+  // Stops the exporter thread after writing the file one last time
+  ~MetricsExporter();
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef MPMC_QUEUE_HPP
+#define MPMC_QUEUE_HPP
+
+#include "CacheLine.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// MpmcQueue is a bounded lock-free ring for any number of producer and consumer threads. Every
+// cell carries a sequence number that tells producers and consumers whether it is free or full
+// for the current lap of the ring, so the only contended operation is a CAS on the head or tail.
+template <typename T, size_t Capacity>
+class MpmcQueue
+{
+  static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+                "MpmcQueue capacity must be a power of two");
+
+private:
+  static constexpr size_t mask_ = Capacity - 1;
+
+  // Cells are padded so that neighbouring producers and consumers do not share a line
+  struct alignas(cache_line_size) Cell
+  {
+    std::atomic<size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  alignas(cache_line_size) std::atomic<size_t> enqueue_position_ { 0 };
+  alignas(cache_line_size) std::atomic<size_t> dequeue_position_ { 0 };
+  alignas(cache_line_size) std::array<Cell, Capacity> cells_;
+
+  static T* element(Cell& cell)
+  {
+    return std::launder(reinterpret_cast<T*>(cell.storage));
+  }
+
+public:
+  MpmcQueue()
+  {
+    for (size_t i = 0; i < Capacity; i++)
+      this->cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  // Constructs an element at the back of the queue, returns false if the queue is full
+  template <typename... Args>
+  bool tryEmplace(Args&&... args)
+  {
+    size_t position = this->enqueue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+      cell            = &this->cells_[position & mask_];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t difference =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (difference == 0)
+      {
+        // The cell is free for this lap, claim it
+        if (this->enqueue_position_.compare_exchange_weak(position,
+                                                          position + 1,
+                                                          std::memory_order_relaxed))
+          break;
+      } else if (difference < 0)
+      {
+        // The cell still holds an element from the previous lap
+        return false;
+      } else
+      {
+        position = this->enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    new (cell->storage) T(std::forward<Args>(args)...);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPush(const T& value)
+  {
+    return this->tryEmplace(value);
+  }
+
+  bool tryPush(T&& value)
+  {
+    return this->tryEmplace(std::move(value));
+  }
+
+  // Moves the front element into value, returns false if the queue is empty
+  bool tryPop(T& value)
+  {
+    size_t position = this->dequeue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+      cell            = &this->cells_[position & mask_];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t difference =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+      if (difference == 0)
+      {
+        // The cell holds an element for this lap, claim it
+        if (this->dequeue_position_.compare_exchange_weak(position,
+                                                          position + 1,
+                                                          std::memory_order_relaxed))
+          break;
+      } else if (difference < 0)
+      {
+        // The cell has not been written yet
+        return false;
+      } else
+      {
+        position = this->dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    T* stored = element(*cell);
+    value     = std::move(*stored);
+    stored->~T();
+    // Mark the cell free for the producer of the next lap
+    cell->sequence.store(position + Capacity, std::memory_order_release);
+    return true;
+  }
+
+  ~MpmcQueue()
+  {
+    T value;
+    while (this->tryPop(value)) { }
+  }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include "CacheLine.hpp"
+
+#include <atomic>
+#include <type_traits>
+
+// MpscNode is embedded in (inherited by) every element of an MpscQueue
+struct MpscNode
+{
+  std::atomic<MpscNode*> next { nullptr };
+};
+
+// MpscQueue is an unbounded intrusive queue for any number of producer threads and one consumer
+// thread. Pushing is a single atomic exchange and never allocates, elements are owned by the
+// caller and must stay alive until they have been popped.
+template <typename T>
+class MpscQueue
+{
+  static_assert(std::is_base_of_v<MpscNode, T>, "MpscQueue elements must derive from MpscNode");
+
+private:
+  // Most recently pushed node, producers swap themselves in here
+  alignas(cache_line_size) std::atomic<MpscNode*> head_;
+
+  // Oldest node not yet popped, consumer only
+  alignas(cache_line_size) MpscNode* tail_;
+
+  // Placeholder node that keeps the list non-empty
+  MpscNode stub_;
+
+  void pushNode(MpscNode* node)
+  {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    MpscNode* previous = this->head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+public:
+  MpscQueue() : head_(&this->stub_), tail_(&this->stub_) { }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Appends an element, safe to call from any thread
+  void push(T* element)
+  {
+    this->pushNode(element);
+  }
+
+  // Removes the oldest element, returns nullptr if the queue is empty or if the oldest element
+  // is still being linked in by its producer. Consumer thread only.
+  T* pop()
+  {
+    MpscNode* tail = this->tail_;
+    MpscNode* next = tail->next.load(std::memory_order_acquire);
+
+    // Skip over the stub node
+    if (tail == &this->stub_)
+    {
+      if (!next)
+        return nullptr;
+      this->tail_ = next;
+      tail        = next;
+      next        = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next)
+    {
+      this->tail_ = next;
+      return static_cast<T*>(tail);
+    }
+
+    // A producer has swapped in a new head but not linked it yet
+    if (tail != this->head_.load(std::memory_order_acquire))
+      return nullptr;
+
+    // tail is the last node, put the stub behind it so that it can be unlinked
+    this->pushNode(&this->stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next)
+    {
+      this->tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+  // Returns true if there is nothing to pop. Consumer thread only.
+  bool empty() const
+  {
+    return this->tail_ == &this->stub_ && !this->stub_.next.load(std::memory_order_acquire);
+  }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef MSDF_HPP
+#define MSDF_HPP
+
+#include "TrueTypeFont.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Maps outline points to texels of a distance field, texel = point * scale + offset with y flipped
+// so that rows run downwards
+struct MsdfTransform
+{
+  float scale;
+  float offset_x;
+  float offset_y;
+};
+
+// Renders a multi-channel signed distance field of an outline into width by height RGBA8 texels.
+// Edges are split into three colour channels at corners, so the median of red, green and blue
+// keeps corners sharp when the field is magnified, and alpha holds the true signed distance.
+// Distances are stored as 0.5 + distance / range, inside is above 0.5, range is in texels.
+std::vector<uint32_t> generateMsdf(const std::vector<OutlineContour>& contours,
+                                   const MsdfTransform& transform,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   float range);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef OCCLUSION_CULLER_HPP
+#define OCCLUSION_CULLER_HPP
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// OcclusionCuller skips draws that were hidden when last measured. Each tested draw is wrapped in
+// an occlusion query, and in the same query either the draw itself if it was visible, or a proxy
+// that only rasterizes if it was hidden, so a hidden draw is drawn again as soon as its proxy
+// covers a sample. Each tested draw names a slot, below max_queries, that must be the same for
+// the same draw from frame to frame, and its results are kept under that slot. Draws may be
+// recorded in any order and skipped in some frames, slots not measured last frame are visible.
+//
+// With conditional rendering, each frame's results are copied into a predicate buffer on the GPU
+// and the next frame picks between draw and proxy there, without waiting for the CPU. Otherwise
+// results are read back once a frame's fence has signalled, and the frames recorded after that
+// pick on the CPU, max_frames_in_flight_ frames late. Render thread only.
+class OcclusionCuller
+{
+public:
+  // Returned by beginQuery when a frame has no room for another query
+  static constexpr uint32_t no_query_ = UINT32_MAX;
+
+private:
+  vk::Device device_;
+  vk::QueryPool query_pool_;
+  uint32_t max_queries_;
+
+  // Results of the last frame written on the GPU, one word per slot, null without conditional
+  // rendering
+  vk::Buffer predicates_;
+
+  // Queries recorded in each frame in flight until it is collected, and the slot of each query
+  std::vector<uint32_t> query_counts_;
+  std::vector<uint32_t> query_slots_;
+
+  // Results of the last frame collected by query and by slot, and the draws they found hidden
+  std::vector<uint32_t> query_results_;
+  std::vector<uint32_t> results_;
+  uint32_t skipped_draws_ = 0;
+
+public:
+  // Creates max_queries queries for each of frame_count frames in flight. predicates must hold
+  // max_queries words set to non-zero, and is used for conditional rendering unless it is null.
+  // Throws std::runtime_error if the queries cannot be created.
+  OcclusionCuller(vk::Device device,
+                  uint32_t frame_count,
+                  uint32_t max_queries,
+                  vk::Buffer predicates = {});
+
+  OcclusionCuller(const OcclusionCuller&) = delete;
+  OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+  // Whether draws are picked on the GPU, otherwise they are picked with visible
+  bool conditionalRendering() const;
+
+  // Reads the results of the frame last submitted in a slot, once its fence has signalled
+  void collect(uint32_t frame);
+
+  // Draws the last collected frame found hidden. The frame after it skips them with conditional
+  // rendering, and the frame recorded next without.
+  uint32_t skippedDraws() const;
+
+  // Starts the queries of a frame, outside a render pass as it resets them
+  void beginFrame(vk::CommandBuffer command_buffer, uint32_t frame);
+
+  // Begins the query of the draw in slot and returns it, or no_query_ if the frame is full or the
+  // slot out of range. A slot is tested at most once a frame.
+  uint32_t beginQuery(vk::CommandBuffer command_buffer, uint32_t frame, uint32_t slot);
+  void endQuery(vk::CommandBuffer command_buffer, uint32_t frame, uint32_t query);
+
+  // Whether the draw in slot was visible the last time it was collected, draws not measured in
+  // that frame are visible. Only meaningful without conditional rendering.
+  bool visible(uint32_t slot) const;
+
+  // Makes the following commands conditional on the draw in slot having been visible in the last
+  // frame, or hidden if inverted. No-ops without conditional rendering.
+  void beginConditional(vk::CommandBuffer command_buffer, uint32_t slot, bool inverted);
+  void endConditional(vk::CommandBuffer command_buffer);
+
+  // Ends the queries of a frame, outside a render pass as it copies their results into the
+  // predicates of their slots
+  void endFrame(vk::CommandBuffer command_buffer, uint32_t frame);
+
+  ~OcclusionCuller();
+};
+
+#endif
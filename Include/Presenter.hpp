@@ -0,0 +1,121 @@
+#ifndef PRESENTER_HPP
+#define PRESENTER_HPP
+
+#include "Result.hpp"
+#include "SpscQueue.hpp"
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <semaphore>
+#include <thread>
+#include <vulkan/vulkan.hpp>
+
+// Presenter presents swapchain images on a thread of its own, so that the render thread does not
+// block in vkQueuePresentKHR, which can wait for a vertical blank in FIFO mode. The render thread
+// queues a present after submitting each frame and goes on to record the next one. The queue is
+// used by the presenter alone while it runs, it must not be the one frames are submitted to.
+//
+// The swapchain is externally synchronised, so while presents are queued the presenter also
+// acquires the swapchain's images: after each present it acquires the image of the frame that
+// reuses the presented frame's semaphore, which the render thread takes with takeAcquired. The
+// render thread then only waits for the acquire, never for a later present that blocks. The
+// swapchain must have enough images for an acquire never to wait on a queued present.
+class Presenter
+{
+public:
+  // A present of one swapchain image, fence and present_mode are only used with swapchain
+  // maintenance and ignored if fence is null
+  struct Request
+  {
+    vk::SwapchainKHR swapchain;
+    uint32_t image_index;
+    vk::Semaphore wait_semaphore;
+    vk::Fence fence;
+    vk::PresentModeKHR present_mode;
+    // Profiler time the frame started at, latency is measured from it to the present returning
+    int64_t frame_start;
+    // After presenting, the next image is acquired with acquire_semaphore once acquire_fence has
+    // signalled, i.e. once the last submit waiting on the semaphore is done. Null to not acquire.
+    vk::Semaphore acquire_semaphore;
+    vk::Fence acquire_fence;
+  };
+
+  // Latency of the presents that returned since it was last taken
+  struct Latency
+  {
+    int64_t total  = 0;
+    uint64_t count = 0;
+  };
+
+private:
+  static constexpr size_t capacity_ = 4;
+
+  vk::Device device_;
+  vk::Queue queue_;
+
+  SpscQueue<Request, capacity_> requests_;
+  std::counting_semaphore<> request_count_ { 0 };
+
+  // Requests queued by the render thread, requests whose present returned, and requests that are
+  // done with the swapchain, their acquire included
+  uint64_t queued_ = 0;
+  std::atomic<uint64_t> presented_ { 0 };
+  std::atomic<uint64_t> processed_ { 0 };
+
+  // Outcome of each request's acquire by request number, until capacity_ requests later
+  struct Acquired
+  {
+    vk::Result result;
+    uint32_t image_index;
+  };
+  std::array<Acquired, capacity_> acquired_ {};
+
+  // First result of a present that was not eSuccess since it was last taken
+  std::atomic<vk::Result> result_ { vk::Result::eSuccess };
+
+  std::atomic<int64_t> latency_total_ { 0 };
+  std::atomic<uint64_t> latency_count_ { 0 };
+
+  std::thread thread_;
+
+  // Presents queued requests in order until stopped
+  void process();
+
+public:
+  Presenter(vk::Device device, vk::Queue queue);
+
+  Presenter(const Presenter&) = delete;
+  Presenter& operator=(const Presenter&) = delete;
+
+  // Presents a request on queue right away, as the present thread does with each queued one
+  static Result<void> presentNow(vk::Queue queue, const Request& request);
+
+  // Queues a present and returns its request number. Only blocks if the presenter is capacity_
+  // presents behind. Render thread only.
+  uint64_t present(const Request& request);
+
+  // Blocks until at most pending queued presents have not returned yet, e.g. before the semaphore
+  // a queued present waits on is signalled again. Render thread only.
+  void wait(uint64_t pending = 0);
+
+  // Blocks until every queued request is done with the swapchain, after which the render thread
+  // may use the swapchain itself, e.g. to acquire, release or destroy it. Render thread only.
+  void drain();
+
+  // Waits for the acquire of a request and returns the image it acquired, like
+  // acquireNextImageKHR would. Only valid until capacity_ more requests are queued. Render thread
+  // only.
+  Result<uint32_t> takeAcquired(uint64_t request);
+
+  // Returns and clears the first result of a present that was not eSuccess, e.g. eSuboptimalKHR or
+  // eErrorOutOfDateKHR when the swapchain has to be recreated
+  vk::Result takeResult();
+
+  Latency takeLatency();
+
+  // Presents the requests still queued, then stops the thread
+  ~Presenter();
+};
+
+#endif
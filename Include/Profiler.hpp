@@ -0,0 +1,126 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Profiler keeps the most recent zones, named spans of time, of every thread that records them in
+// a ring per thread, plus a ring of GPU zones. Rings are overwritten as they wrap, so recording is
+// always on and costs two clock reads and a few stores per zone, and the last seconds before an
+// event can be written as a trace when the event happens. Zone names must outlive the profiler,
+// which in practice means string literals.
+class Profiler
+{
+public:
+  // Zones each ring holds, a few seconds worth of frames at a few thousand zones per second
+  static constexpr size_t ring_capacity_ = 32768;
+
+  struct Zone
+  {
+    const char* name;
+    int64_t begin;
+    int64_t end;
+  };
+
+private:
+  // Ring written by one thread and read while traces are written. Slots are atomics so that a
+  // reader racing with the writer reads torn zones it can discard rather than undefined values.
+  // started counts the zones the writer began writing, written those it finished.
+  struct Ring
+  {
+    struct Slot
+    {
+      std::atomic<const char*> name { nullptr };
+      std::atomic<int64_t> begin { 0 };
+      std::atomic<int64_t> end { 0 };
+    };
+
+    uint32_t index;
+    std::atomic<const char*> name { nullptr };
+    std::atomic<uint64_t> started { 0 };
+    std::atomic<uint64_t> written { 0 };
+    std::array<Slot, ring_capacity_> slots;
+
+    void push(const char* zone_name, int64_t begin, int64_t end);
+
+    // Appends the zones ending within [first, last] that were not overwritten while copying
+    void copy(int64_t first, int64_t last, std::vector<Zone>& zones) const;
+  };
+
+  // Every ring ever registered, guarded by rings_mutex_ as threads register lazily
+  std::vector<std::unique_ptr<Ring>> rings_;
+  mutable std::mutex rings_mutex_;
+
+  Ring gpu_ring_;
+
+  Profiler();
+
+  // Returns the ring of the calling thread, registering one on first use
+  Ring& threadRing();
+
+public:
+  // Returns the process wide profiler
+  static Profiler& instance();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // Returns a time point in the time zones are measured in, nanoseconds of the steady clock
+  static int64_t time(std::chrono::steady_clock::time_point time_point)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time_point.time_since_epoch())
+        .count();
+  }
+
+  static int64_t now()
+  {
+    return time(std::chrono::steady_clock::now());
+  }
+
+  // Names the calling thread in traces
+  void setThreadName(const char* name);
+
+  // Adds a zone of the calling thread
+  void record(const char* name, int64_t begin, int64_t end);
+
+  // Adds a zone that ran on the GPU, with times converted to the CPU clock. One thread only.
+  void recordGpu(const char* name, int64_t begin, int64_t end);
+
+  // Writes the zones of every thread and the GPU ending within [first, last] to a file in the
+  // Chrome trace event format, which chrome://tracing and Perfetto open. Throws
+  // std::runtime_error if the file cannot be written.
+  void writeTrace(const std::filesystem::path& file, int64_t first, int64_t last) const;
+};
+
+// ProfileZone records the time between its construction and destruction as a zone of the calling
+// thread
+class ProfileZone
+{
+private:
+  const char* name_;
+  int64_t begin_;
+
+public:
+  explicit ProfileZone(const char* name) : name_(name), begin_(Profiler::now()) { }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+  ~ProfileZone()
+  {
+    Profiler::instance().record(this->name_, this->begin_, Profiler::now());
+  }
+};
+
+// Records the rest of the enclosing scope as a zone
+#define PROFILE_ZONE_CONCAT_(a, b) a##b
+#define PROFILE_ZONE_NAME_(line)   PROFILE_ZONE_CONCAT_(profile_zone_, line)
+#define PROFILE_ZONE(name)         ProfileZone PROFILE_ZONE_NAME_(__LINE__)(name)
+
+#endif
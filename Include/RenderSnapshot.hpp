@@ -0,0 +1,93 @@
+#ifndef RENDER_SNAPSHOT_HPP
+#define RENDER_SNAPSHOT_HPP
+
+#include "AllocationTracker.hpp"
+#include "Resources.hpp"
+#include "SpriteBatch.hpp"
+#include "SpscQueue.hpp"
+#include "TextRenderer.hpp"
+#include "UiLayer.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <semaphore>
+#include <vector>
+
+// A single draw extracted from the simulation, transform is offset.xy, scale and rotation
+struct DrawItem
+{
+  PipelineHandle pipeline;
+  MeshHandle mesh;
+  float transform[4];
+};
+
+// Everything the render thread needs to draw one frame. It is written by the simulation thread,
+// published, and never modified again until the render thread hands it back.
+struct RenderSnapshot
+{
+  uint64_t frame_number = 0;
+
+  // CPU time the simulation thread spent simulating and extracting this frame
+  std::chrono::steady_clock::duration simulation_time {};
+
+  // Heap allocations the simulation thread made while simulating and extracting this frame
+  AllocationCounts simulation_allocations {};
+
+  std::vector<DrawItem> draws;
+  std::vector<SpriteInstance> sprites;
+
+  // Text laid out by the simulation thread, and the glyphs it added to the cache which must be
+  // uploaded before the text is drawn
+  std::vector<GlyphQuad> glyphs;
+  std::vector<GlyphUpload> glyph_uploads;
+
+  // Changes to the cached UI layer, drawn after the glyph uploads
+  UiUpdate ui;
+};
+
+// RenderSnapshotExchange double buffers RenderSnapshots between one simulation thread and one
+// render thread. The simulation thread fills a snapshot while the render thread records the
+// previous one, and blocks only when it gets a full frame ahead.
+class RenderSnapshotExchange
+{
+private:
+  static constexpr size_t snapshot_count_ = 2;
+
+  std::array<RenderSnapshot, snapshot_count_> snapshots_;
+
+  // Snapshots that may be written and snapshots waiting to be drawn, the semaphores count them
+  SpscQueue<RenderSnapshot*, snapshot_count_> free_;
+  SpscQueue<RenderSnapshot*, snapshot_count_> ready_;
+  std::counting_semaphore<> free_count_ { snapshot_count_ };
+  std::counting_semaphore<> ready_count_ { 0 };
+
+  std::atomic<bool> closed_ { false };
+
+public:
+  RenderSnapshotExchange();
+
+  RenderSnapshotExchange(const RenderSnapshotExchange&) = delete;
+  RenderSnapshotExchange& operator=(const RenderSnapshotExchange&) = delete;
+
+  // Returns a snapshot to fill, blocking while both are in use. Returns nullptr once closed.
+  // Simulation thread only.
+  RenderSnapshot* acquireWrite();
+
+  // Hands a filled snapshot to the render thread. Simulation thread only.
+  void publish(RenderSnapshot* snapshot);
+
+  // Returns the oldest published snapshot, blocking until there is one. Returns nullptr once
+  // closed. Render thread only.
+  RenderSnapshot* acquireRead();
+
+  // Returns a drawn snapshot to the simulation thread. Render thread only.
+  void release(RenderSnapshot* snapshot);
+
+  // Wakes both threads and makes their acquires return nullptr, callable from either thread. Each
+  // thread must stop acquiring after it first sees nullptr.
+  void close();
+};
+
+#endif
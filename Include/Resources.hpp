@@ -0,0 +1,54 @@
+#ifndef RESOURCES_HPP
+#define RESOURCES_HPP
+
+#include "SlotMap.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+// Engine level GPU resources. Each is owned by a SlotMap in Application and referred to
+// everywhere else by its handle.
+
+struct Buffer
+{
+  vk::Buffer buffer;
+  vk::DeviceMemory memory;
+  vk::DeviceSize size = 0;
+  vk::BufferUsageFlags usage;
+  // Host address of the buffer if it is persistently mapped
+  void* mapped = nullptr;
+};
+
+struct Image
+{
+  vk::Image image;
+  vk::ImageView view;
+  // Null for images owned by the swapchain
+  vk::DeviceMemory memory;
+  vk::Format format = vk::Format::eUndefined;
+  vk::Extent2D extent;
+  vk::ImageUsageFlags usage;
+  uint32_t layer_count        = 1;
+  vk::ImageViewType view_type = vk::ImageViewType::e2D;
+};
+
+struct Pipeline
+{
+  vk::Pipeline pipeline;
+  vk::PipelineLayout layout;
+  vk::PipelineBindPoint bind_point = vk::PipelineBindPoint::eGraphics;
+};
+
+using BufferHandle   = Handle<Buffer>;
+using ImageHandle    = Handle<Image>;
+using PipelineHandle = Handle<Pipeline>;
+
+struct Mesh
+{
+  // Null for meshes generated entirely in the vertex shader
+  BufferHandle vertex_buffer;
+  uint32_t vertex_count = 0;
+};
+
+using MeshHandle = Handle<Mesh>;
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef RESULT_HPP
+#define RESULT_HPP
+
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vulkan/vulkan.hpp>
+
+// VulkanError is thrown by Result::value, it carries the code of the operation that failed
+class VulkanError : public std::runtime_error
+{
+private:
+  vk::Result code_;
+
+public:
+  explicit VulkanError(vk::Result code) : std::runtime_error(vk::to_string(code)), code_(code) { }
+
+  vk::Result code() const
+  {
+    return this->code_;
+  }
+};
+
+// Result holds the vk::Result of an operation and, on success, its value. Success codes such as
+// eSuboptimalKHR are kept so that callers can react to them without an exception being involved.
+template <typename T>
+class [[nodiscard]] Result
+{
+private:
+  vk::Result code_;
+  std::optional<T> value_;
+
+public:
+  Result(vk::Result code) : code_(code) { }
+  Result(vk::Result code, T value) : code_(code), value_(std::move(value)) { }
+
+  // Returns true if the operation succeeded, success codes other than eSuccess included
+  explicit operator bool() const
+  {
+    return static_cast<int32_t>(this->code_) >= 0;
+  }
+
+  vk::Result code() const
+  {
+    return this->code_;
+  }
+
+  // Returns the value, throwing if the operation failed. Meant for initialisation paths where
+  // failure is fatal, per-frame code should check the result instead.
+  T& value()
+  {
+    if (!*this)
+      throw VulkanError(this->code_);
+    return *this->value_;
+  }
+};
+
+template <>
+class [[nodiscard]] Result<void>
+{
+private:
+  vk::Result code_;
+
+public:
+  Result(vk::Result code) : code_(code) { }
+
+  explicit operator bool() const
+  {
+    return static_cast<int32_t>(this->code_) >= 0;
+  }
+
+  vk::Result code() const
+  {
+    return this->code_;
+  }
+
+  // Throws if the operation failed
+  void value() const
+  {
+    if (!*this)
+      throw VulkanError(this->code_);
+  }
+};
+
+// ResultFor maps the return type of a vulkan.hpp call, in either exception mode, to a Result
+template <typename T>
+struct ResultFor
+{
+  using type = Result<T>;
+};
+
+template <>
+struct ResultFor<void>
+{
+  using type = Result<void>;
+};
+
+template <>
+struct ResultFor<vk::Result>
+{
+  using type = Result<void>;
+};
+
+template <typename T>
+struct ResultFor<vk::ResultValue<T>>
+{
+  using type = Result<T>;
+};
+
+// Invokes a vulkan.hpp call and returns its outcome as a Result. With VULKAN_HPP_NO_EXCEPTIONS the
+// call already returns a result which is passed through, otherwise vk::SystemError is caught.
+template <typename F>
+typename ResultFor<std::invoke_result_t<F>>::type vulkanCall(F&& call)
+{
+  using Return = std::invoke_result_t<F>;
+#ifndef VULKAN_HPP_NO_EXCEPTIONS
+  try
+  {
+#endif
+    if constexpr (std::is_void_v<Return>)
+    {
+      call();
+      return Result<void>(vk::Result::eSuccess);
+    } else if constexpr (std::is_same_v<Return, vk::Result>)
+    {
+      return Result<void>(call());
+    } else if constexpr (std::is_same_v<typename ResultFor<Return>::type, Result<Return>>)
+    {
+      return Result<Return>(vk::Result::eSuccess, call());
+    } else
+    {
+      auto result_value = call();
+      return { result_value.result, std::move(result_value.value) };
+    }
+#ifndef VULKAN_HPP_NO_EXCEPTIONS
+  } catch (const vk::SystemError& error)
+  {
+    return static_cast<vk::Result>(error.code().value());
+  }
+#endif
+}
+
+// Wraps a vulkan.hpp expression in vulkanCall
+#define VULKAN_CALL(...) vulkanCall([&]() { return __VA_ARGS__; })
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef SCENE_SNAPSHOT_HPP
+#define SCENE_SNAPSHOT_HPP
+
+#include "Blob.hpp"
+#include "MappedFile.hpp"
+#include "StringId.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// A scene file is a relocatable blob: a SceneHeader at offset zero followed by records that refer
+// to each other with OffsetPtrs. Loading maps the file and validates the header and array bounds,
+// the records are then read in place. Resources are referenced by the index of their name in
+// SceneRoot::names, which the loader resolves to handles once per name.
+
+// Spinning triangle, pipeline and mesh are name indices
+struct SceneEntity
+{
+  uint32_t pipeline;
+  uint32_t mesh;
+  float position[2];
+  float scale;
+  float rotation;
+  float angular_velocity;
+};
+
+// Bouncing sprite, sprite is a name index
+struct SceneSprite
+{
+  uint32_t sprite;
+  float position[2];
+  float velocity[2];
+  float size;
+  float rotation;
+  float angular_velocity;
+  uint32_t color;
+};
+
+// Everything the simulation needs to resume
+struct SceneRoot
+{
+  uint64_t simulation_frame;
+  OffsetArray<StringId> names;
+  OffsetArray<SceneEntity> entities;
+  OffsetArray<SceneSprite> sprites;
+};
+
+struct SceneHeader
+{
+  // Bumped whenever a record's layout changes, files of other versions are rejected
+  static constexpr uint32_t current_version_ = 1;
+
+  // Written as a native integer, reads back differently on a machine of the other byte order
+  static constexpr uint32_t byte_order_mark_ = 0x01020304;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t size;
+  OffsetPtr<SceneRoot> root;
+};
+
+// The file format depends on these layouts, changing them requires a new version
+static_assert(sizeof(StringId) == 8 && std::is_trivially_copyable_v<StringId>);
+static_assert(sizeof(SceneEntity) == 28 && sizeof(SceneSprite) == 36);
+static_assert(sizeof(SceneRoot) == 56 && sizeof(SceneHeader) == 32);
+
+// Writes a scene file, through a temporary file so an interrupted save never leaves a truncated
+// scene. Throws std::runtime_error if it cannot be written.
+void writeSceneSnapshot(const std::filesystem::path& file,
+                        uint64_t simulation_frame,
+                        const std::vector<StringId>& names,
+                        const std::vector<SceneEntity>& entities,
+                        const std::vector<SceneSprite>& sprites);
+
+// SceneSnapshot maps a scene file and checks that it is well formed, name indices are checked by
+// the code resolving them
+class SceneSnapshot
+{
+private:
+  MappedFile file_;
+  const SceneRoot* root_ = nullptr;
+
+public:
+  // Throws std::runtime_error if the file cannot be mapped or is not a valid scene
+  explicit SceneSnapshot(const std::filesystem::path& file);
+
+  const SceneRoot& root() const;
+};
+
+#endif
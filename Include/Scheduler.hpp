@@ -0,0 +1,191 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include "MpmcQueue.hpp"
+#include "MpscQueue.hpp"
+#include "Task.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Scheduler resumes coroutines on worker threads, on a dedicated I/O thread for file reads, or on
+// the main thread when it calls pumpMainThread. Coroutines move between them with co_await:
+//
+//   std::vector<char> data = co_await scheduler.readFile("texture.bin"); // read on I/O thread
+//   co_await scheduler.schedule();                                      // on a worker
+//   co_await scheduler.resumeOnMainThread();                            // on the main thread
+//
+// Main thread waits can be polled, e.g. FenceAwaitable resumes once a Vulkan fence is signalled.
+class Scheduler
+{
+public:
+  // Awaitable that resumes the coroutine on a worker thread
+  struct ScheduleAwaitable
+  {
+    Scheduler* scheduler;
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+      this->scheduler->enqueueWorker(handle);
+    }
+
+    void await_resume() const noexcept { }
+  };
+
+  // Awaitable that resumes the coroutine from pumpMainThread
+  struct MainThreadAwaitable : MpscNode
+  {
+    Scheduler* scheduler;
+    std::coroutine_handle<> handle;
+
+    // Polled from pumpMainThread until it returns true, null to resume on the next pump.
+    // Awaitables that wait on something derive from this one and set it.
+    bool (*ready)(const MainThreadAwaitable& awaitable);
+
+    explicit MainThreadAwaitable(Scheduler* scheduler,
+                                 bool (*ready)(const MainThreadAwaitable&) = nullptr) :
+      scheduler(scheduler),
+      ready(ready)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+      this->handle = awaiting;
+      this->scheduler->main_queue_.push(this);
+    }
+
+    void await_resume() const noexcept { }
+  };
+
+  // Awaitable that reads a whole file on the I/O thread and resumes the coroutine on a worker
+  struct FileReadAwaitable : MpscNode
+  {
+    Scheduler* scheduler;
+    std::string file_name;
+    std::coroutine_handle<> handle;
+    std::vector<char> data;
+    std::exception_ptr exception;
+
+    FileReadAwaitable(Scheduler* scheduler, std::string file_name) :
+      scheduler(scheduler),
+      file_name(std::move(file_name))
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+      this->handle = awaiting;
+      this->scheduler->io_queue_.push(this);
+      this->scheduler->io_signal_.release();
+    }
+
+    // Returns the file contents or rethrows the error from reading it
+    std::vector<char> await_resume()
+    {
+      if (this->exception)
+        std::rethrow_exception(this->exception);
+      return std::move(this->data);
+    }
+  };
+
+private:
+  // Coroutines ready to run on a worker
+  MpmcQueue<std::coroutine_handle<>, 1024> worker_queue_;
+  std::counting_semaphore<> worker_signal_ { 0 };
+  std::vector<std::thread> workers_;
+
+  // File reads waiting for the I/O thread
+  MpscQueue<FileReadAwaitable> io_queue_;
+  std::counting_semaphore<> io_signal_ { 0 };
+  std::thread io_thread_;
+
+  // Coroutines waiting to be resumed on the main thread, fence waits stay in main_pending_ until
+  // their fence is signalled
+  MpscQueue<MainThreadAwaitable> main_queue_;
+  std::vector<MainThreadAwaitable*> main_pending_;
+
+  // Frame addresses of spawned coroutines that have not finished. Coroutines still waiting when
+  // the scheduler is destroyed are never resumed, destroying these destroys them and every task
+  // they await.
+  std::mutex spawned_mutex_;
+  std::unordered_set<void*> spawned_;
+
+  std::atomic<bool> running_ { true };
+
+  // Runs a spawned task to completion, logging instead of propagating its errors
+  static task_detail::DetachedTask runSpawned(Scheduler& scheduler, Task<void> task);
+
+  // Worker thread loop
+  void workerLoop();
+
+  // I/O thread loop
+  void ioLoop();
+
+public:
+  // Starts worker_count worker threads and the I/O thread
+  explicit Scheduler(uint32_t worker_count);
+
+  Scheduler(const Scheduler&) = delete;
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  // Queues a coroutine to be resumed on a worker thread
+  void enqueueWorker(std::coroutine_handle<> handle);
+
+  // co_await to continue on a worker thread
+  ScheduleAwaitable schedule()
+  {
+    return { this };
+  }
+
+  // co_await to continue on the main thread
+  MainThreadAwaitable resumeOnMainThread()
+  {
+    return MainThreadAwaitable(this);
+  }
+
+  // co_await to read a file without blocking a worker, continues on a worker thread
+  FileReadAwaitable readFile(std::string file_name)
+  {
+    return FileReadAwaitable(this, std::move(file_name));
+  }
+
+  // Starts a task without waiting for it, errors are logged
+  void spawn(Task<void> task);
+
+  // Resumes coroutines waiting on the main thread, called once per frame by the main thread
+  void pumpMainThread();
+
+  // Returns the number of worker threads
+  size_t workerCount() const;
+
+  // Native handles of the worker threads and the I/O thread, used to place them on CPUs
+  std::vector<std::thread::native_handle_type> workerHandles();
+  std::thread::native_handle_type ioThreadHandle();
+
+  ~Scheduler();
+};
+
+#endif
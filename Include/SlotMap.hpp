@@ -0,0 +1,220 @@
+#ifndef SLOT_MAP_HPP
+#define SLOT_MAP_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Handle is a stable 32-bit reference to an element of a SlotMap. The low bits index a slot and
+// the high bits hold the slot's generation when the handle was issued, so a handle to an erased
+// element is detected instead of silently resolving to whatever reused the slot. A value of zero
+// is never issued and acts as the null handle.
+template <typename T>
+struct Handle
+{
+  static constexpr uint32_t index_bits_      = 20;
+  static constexpr uint32_t generation_bits_ = 32 - index_bits_;
+  static constexpr uint32_t index_mask_      = (1u << index_bits_) - 1;
+  static constexpr uint32_t generation_mask_ = (1u << generation_bits_) - 1;
+
+  uint32_t value = 0;
+
+  Handle() = default;
+  Handle(uint32_t index, uint32_t generation) : value((generation << index_bits_) | index) { }
+
+  uint32_t index() const
+  {
+    return this->value & index_mask_;
+  }
+
+  uint32_t generation() const
+  {
+    return this->value >> index_bits_;
+  }
+
+  explicit operator bool() const
+  {
+    return this->value != 0;
+  }
+
+  bool operator==(const Handle& other) const
+  {
+    return this->value == other.value;
+  }
+
+  bool operator!=(const Handle& other) const
+  {
+    return this->value != other.value;
+  }
+};
+
+// SlotMap stores elements densely in insertion order (erase swaps the last element into the hole)
+// and hands out generational Handles. Insert, erase and lookup are O(1) and iteration walks a
+// contiguous array.
+template <typename T>
+class SlotMap
+{
+private:
+  using HandleType = Handle<T>;
+
+  static constexpr uint32_t no_free_slot_ = HandleType::index_mask_;
+
+  struct Slot
+  {
+    // Index into dense_ while the slot is live, next free slot while it is free
+    uint32_t index;
+    uint32_t generation;
+  };
+
+  std::vector<T> dense_;
+  std::vector<uint32_t> dense_to_slot_;
+  std::vector<Slot> slots_;
+  uint32_t free_head_ = no_free_slot_;
+
+  // Returns the slot of a live handle or nullptr if the handle is null or stale
+  const Slot* findSlot(HandleType handle) const
+  {
+    uint32_t index = handle.index();
+    if (!handle || index >= this->slots_.size())
+      return nullptr;
+    const Slot& slot = this->slots_[index];
+    if (slot.generation != handle.generation())
+      return nullptr;
+    return &slot;
+  }
+
+public:
+  // Constructs an element in place and returns its handle
+  template <typename... Args>
+  HandleType emplace(Args&&... args)
+  {
+    uint32_t slot_index;
+    if (this->free_head_ != no_free_slot_)
+    {
+      // Reuse the most recently freed slot
+      slot_index       = this->free_head_;
+      this->free_head_ = this->slots_[slot_index].index;
+    } else
+    {
+      if (this->slots_.size() == no_free_slot_)
+        throw std::length_error("SlotMap is full");
+      slot_index = static_cast<uint32_t>(this->slots_.size());
+      this->slots_.push_back({ 0, 1 });
+    }
+
+    Slot& slot = this->slots_[slot_index];
+    slot.index = static_cast<uint32_t>(this->dense_.size());
+    this->dense_.emplace_back(std::forward<Args>(args)...);
+    this->dense_to_slot_.push_back(slot_index);
+    return HandleType(slot_index, slot.generation);
+  }
+
+  HandleType insert(T value)
+  {
+    return this->emplace(std::move(value));
+  }
+
+  // Erases the element, returns false if the handle is null or stale
+  bool erase(HandleType handle)
+  {
+    if (!this->findSlot(handle))
+      return false;
+    Slot& slot = this->slots_[handle.index()];
+
+    // Move the last element into the hole and repoint its slot
+    uint32_t dense_index = slot.index;
+    uint32_t last_index  = static_cast<uint32_t>(this->dense_.size() - 1);
+    if (dense_index != last_index)
+    {
+      this->dense_[dense_index]         = std::move(this->dense_[last_index]);
+      this->dense_to_slot_[dense_index] = this->dense_to_slot_[last_index];
+      this->slots_[this->dense_to_slot_[dense_index]].index = dense_index;
+    }
+    this->dense_.pop_back();
+    this->dense_to_slot_.pop_back();
+
+    // Invalidate outstanding handles, generation zero is skipped so no handle is ever null
+    slot.generation = (slot.generation + 1) & HandleType::generation_mask_;
+    if (slot.generation == 0)
+      slot.generation = 1;
+    slot.index       = this->free_head_;
+    this->free_head_ = handle.index();
+    return true;
+  }
+
+  // Returns the element or nullptr if the handle is null or stale
+  T* get(HandleType handle)
+  {
+    const Slot* slot = this->findSlot(handle);
+    return slot ? &this->dense_[slot->index] : nullptr;
+  }
+
+  const T* get(HandleType handle) const
+  {
+    const Slot* slot = this->findSlot(handle);
+    return slot ? &this->dense_[slot->index] : nullptr;
+  }
+
+  // Returns the element, throwing if the handle is null or stale
+  T& at(HandleType handle)
+  {
+    T* element = this->get(handle);
+    if (!element)
+      throw std::out_of_range("Stale or null SlotMap handle");
+    return *element;
+  }
+
+  const T& at(HandleType handle) const
+  {
+    const T* element = this->get(handle);
+    if (!element)
+      throw std::out_of_range("Stale or null SlotMap handle");
+    return *element;
+  }
+
+  bool contains(HandleType handle) const
+  {
+    return this->findSlot(handle) != nullptr;
+  }
+
+  // Returns the handle of the element at a position in the dense array
+  HandleType handleAt(size_t dense_index) const
+  {
+    uint32_t slot_index = this->dense_to_slot_[dense_index];
+    return HandleType(slot_index, this->slots_[slot_index].generation);
+  }
+
+  size_t size() const
+  {
+    return this->dense_.size();
+  }
+
+  bool empty() const
+  {
+    return this->dense_.empty();
+  }
+
+  // Iteration over the dense elements, order changes when elements are erased
+  typename std::vector<T>::iterator begin()
+  {
+    return this->dense_.begin();
+  }
+
+  typename std::vector<T>::iterator end()
+  {
+    return this->dense_.end();
+  }
+
+  typename std::vector<T>::const_iterator begin() const
+  {
+    return this->dense_.begin();
+  }
+
+  typename std::vector<T>::const_iterator end() const
+  {
+    return this->dense_.end();
+  }
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef SPRITE_BATCH_HPP
+#define SPRITE_BATCH_HPP
+
+#include "AtlasPacker.hpp"
+#include "SlotMap.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// An image packed into a SpriteAtlas page
+struct Sprite
+{
+  uint32_t page;
+  float uv_min[2];
+  float uv_max[2];
+  uint32_t width;
+  uint32_t height;
+};
+
+using SpriteHandle = Handle<Sprite>;
+
+// A sprite placed on screen, position is the centre in pixels and color tints the sprite, as
+// RGBA8 with red in the lowest byte
+struct SpriteInstance
+{
+  SpriteHandle sprite;
+  float position[2];
+  float size[2];
+  float rotation;
+  uint32_t color;
+};
+
+// Vertex of a sprite quad as read by the sprite pipeline
+struct SpriteVertex
+{
+  float position[2];
+  float uv[2];
+  uint32_t color;
+};
+
+// A run of quads that all sample the same atlas page and are drawn with one call
+struct SpriteBatch
+{
+  uint32_t page;
+  uint32_t first_quad;
+  uint32_t quad_count;
+};
+
+// SpriteAtlas packs RGBA8 images into square pages, opening a new page whenever the existing ones
+// are full. Each image is padded with a copy of its edge texels so that linear filtering at the
+// border of a sprite never picks up its neighbours.
+class SpriteAtlas
+{
+private:
+  struct Page
+  {
+    SkylinePacker packer;
+    std::vector<uint32_t> texels;
+  };
+
+  uint32_t page_size_;
+  std::vector<Page> pages_;
+  SlotMap<Sprite> sprites_;
+
+  // Copies an image into a page at rect, extruding its edges into the padding
+  void blit(Page& page,
+            const AtlasRect& rect,
+            uint32_t width,
+            uint32_t height,
+            const uint32_t* texels);
+
+public:
+  // Texels of padding around every sprite
+  static constexpr uint32_t padding_ = 1;
+
+  explicit SpriteAtlas(uint32_t page_size);
+
+  // Packs a width by height RGBA8 image, throws std::length_error if it is larger than a page
+  SpriteHandle add(uint32_t width, uint32_t height, const uint32_t* texels);
+
+  // Returns the sprite or nullptr if the handle is null or stale
+  const Sprite* get(SpriteHandle handle) const;
+
+  uint32_t pageSize() const;
+  size_t pageCount() const;
+
+  // Returns the RGBA8 texels of a page, pageSize() squared of them in rows
+  const std::vector<uint32_t>& pageTexels(size_t page) const;
+};
+
+// Writes a quad of four vertices for every instance into vertices, grouped by atlas page, and
+// fills batches with one SpriteBatch per page used. Instances with stale handles and instances
+// beyond max_quads are dropped. Returns the number of quads written.
+size_t buildSpriteBatches(const SpriteAtlas& atlas,
+                          const std::vector<SpriteInstance>& instances,
+                          SpriteVertex* vertices,
+                          size_t max_quads,
+                          std::vector<SpriteBatch>& batches);
+
+#endif
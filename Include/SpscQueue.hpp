@@ -0,0 +1,107 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include "CacheLine.hpp"
+
+#include <array>
+#include <atomic>
+#include <new>
+#include <utility>
+
+// SpscQueue is a bounded lock-free ring for exactly one producer thread and one consumer thread.
+// Each side keeps a cached copy of the other side's index so that the shared indices are only
+// read when the ring looks full or empty.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+private:
+  static constexpr size_t mask_ = Capacity - 1;
+
+  struct Slot
+  {
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  // Producer side
+  alignas(cache_line_size) std::atomic<size_t> head_ { 0 };
+  size_t cached_tail_ = 0;
+
+  // Consumer side
+  alignas(cache_line_size) std::atomic<size_t> tail_ { 0 };
+  size_t cached_head_ = 0;
+
+  alignas(cache_line_size) std::array<Slot, Capacity> slots_;
+
+  T* slot(size_t index)
+  {
+    return std::launder(reinterpret_cast<T*>(this->slots_[index & mask_].storage));
+  }
+
+public:
+  SpscQueue() = default;
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Constructs an element at the back of the queue, returns false if the queue is full. Producer
+  // thread only.
+  template <typename... Args>
+  bool tryEmplace(Args&&... args)
+  {
+    size_t head = this->head_.load(std::memory_order_relaxed);
+    if (head - this->cached_tail_ == Capacity)
+    {
+      this->cached_tail_ = this->tail_.load(std::memory_order_acquire);
+      if (head - this->cached_tail_ == Capacity)
+        return false;
+    }
+    new (this->slots_[head & mask_].storage) T(std::forward<Args>(args)...);
+    this->head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPush(const T& value)
+  {
+    return this->tryEmplace(value);
+  }
+
+  bool tryPush(T&& value)
+  {
+    return this->tryEmplace(std::move(value));
+  }
+
+  // Moves the front element into value, returns false if the queue is empty. Consumer thread only.
+  bool tryPop(T& value)
+  {
+    size_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->cached_head_)
+    {
+      this->cached_head_ = this->head_.load(std::memory_order_acquire);
+      if (tail == this->cached_head_)
+        return false;
+    }
+    T* element = this->slot(tail);
+    value      = std::move(*element);
+    element->~T();
+    this->tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the number of queued elements, only exact when neither side is active
+  size_t sizeApprox() const
+  {
+    return this->head_.load(std::memory_order_acquire) -
+           this->tail_.load(std::memory_order_acquire);
+  }
+
+  ~SpscQueue()
+  {
+    size_t head = this->head_.load(std::memory_order_relaxed);
+    for (size_t i = this->tail_.load(std::memory_order_relaxed); i != head; i++)
+      this->slot(i)->~T();
+  }
+};
+
+#endif
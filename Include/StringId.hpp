@@ -0,0 +1,78 @@
+#ifndef STRING_ID_HPP
+#define STRING_ID_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// StringId is a 64-bit FNV-1a hash of a name, computed at compile time where possible, so that
+// resource lookups and keys compare integers instead of strings. Debug builds record the string
+// behind every id created at runtime, including every "name"_sid that is not a constant, so that
+// name() can turn ids back into text and hash collisions are caught.
+class StringId
+{
+private:
+  static constexpr uint64_t fnv_offset_basis_ = 14695981039346656037ull;
+  static constexpr uint64_t fnv_prime_        = 1099511628211ull;
+
+  uint64_t value_ = 0;
+
+  // Records the string behind an id for name(), throws std::logic_error on a collision
+  static void registerName(uint64_t value, std::string_view name);
+
+public:
+  static constexpr uint64_t hash(std::string_view string)
+  {
+    uint64_t value = fnv_offset_basis_;
+    for (char character : string)
+    {
+      value ^= static_cast<uint8_t>(character);
+      value *= fnv_prime_;
+    }
+    return value;
+  }
+
+  constexpr StringId() = default;
+
+  constexpr explicit StringId(std::string_view string) : value_(hash(string))
+  {
+#ifndef NDEBUG
+    if (!std::is_constant_evaluated())
+      registerName(this->value_, string);
+#endif
+  }
+
+  constexpr uint64_t value() const
+  {
+    return this->value_;
+  }
+
+  constexpr explicit operator bool() const
+  {
+    return this->value_ != 0;
+  }
+
+  constexpr bool operator==(const StringId& other) const = default;
+
+  // Returns the string the id was created from in debug builds, otherwise its value in hex
+  std::string name() const;
+};
+
+constexpr StringId operator""_sid(const char* string, size_t size)
+{
+  return StringId(std::string_view(string, size));
+}
+
+template <>
+struct std::hash<StringId>
+{
+  // FNV-1a output is already well mixed
+  size_t operator()(const StringId& id) const noexcept
+  {
+    return static_cast<size_t>(id.value());
+  }
+};
+
+#endif
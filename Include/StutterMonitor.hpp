@@ -0,0 +1,80 @@
+#ifndef STUTTER_MONITOR_HPP
+#define STUTTER_MONITOR_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <semaphore>
+#include <string>
+#include <thread>
+
+// StutterMonitor watches frame times for spikes, frames that take longer than a multiple of the
+// median of the recent ones, and writes the Profiler's zones of the seconds before each spike to a
+// trace file. Traces are written on the monitor's own thread, so a spike costs the render thread
+// nothing more than a median refresh, and while one is being written further spikes are ignored.
+class StutterMonitor
+{
+private:
+  // Frames the median is taken over, and the number of frames between median refreshes
+  static constexpr size_t history_size_      = 255;
+  static constexpr uint32_t median_interval_ = 32;
+
+  // Frames shorter than this are never spikes, however short the median is
+  static constexpr std::chrono::milliseconds min_spike_time_ { 4 };
+
+  // Time before a spike a trace covers, and after it, so the GPU zones of the frames in flight
+  // are collected before the trace is written
+  static constexpr std::chrono::seconds window_ { 3 };
+  static constexpr std::chrono::milliseconds tail_ { 250 };
+
+  // Traces written at most per run, so a machine that keeps stuttering does not fill its disk
+  static constexpr uint32_t max_traces_ = 16;
+
+  std::string trace_prefix_;
+  float threshold_;
+
+  // Render thread only. Recent frame times in nanoseconds, written round robin.
+  std::array<int64_t, history_size_> history_ {};
+  std::array<int64_t, history_size_> sorted_ {};
+  size_t history_count_      = 0;
+  size_t history_next_       = 0;
+  uint32_t frames_to_median_ = 0;
+  int64_t median_            = 0;
+  int64_t next_trace_time_   = 0;
+  uint32_t trace_count_      = 0;
+
+  // Spike handed to the monitor's thread, written by the render thread while no trace is pending
+  struct Spike
+  {
+    uint64_t frame_number;
+    int64_t frame_time;
+    int64_t median;
+    int64_t end;
+  } spike_ {};
+  std::atomic<bool> trace_pending_ { false };
+
+  std::counting_semaphore<> signal_ { 0 };
+  std::atomic<bool> running_ { true };
+  std::thread thread_;
+
+  // Writes the trace of each spike it is signalled for until stopped
+  void process();
+
+public:
+  // Spikes are frames longer than threshold times the median, traces are written to
+  // <trace_prefix>-<frame number>.json
+  StutterMonitor(std::string trace_prefix, float threshold);
+
+  StutterMonitor(const StutterMonitor&) = delete;
+  StutterMonitor& operator=(const StutterMonitor&) = delete;
+
+  // Adds a frame that ran from begin to end in Profiler time and returns true if it was a spike
+  // whose trace is going to be written. Never blocks or allocates. Render thread only.
+  bool addFrame(uint64_t frame_number, int64_t begin, int64_t end);
+
+  // Waits for a trace being written
+  ~StutterMonitor();
+};
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <semaphore>
+#include <utility>
+
+// Task is a lazily started coroutine producing a T. It starts running when it is awaited and
+// resumes its awaiter when it completes, so chains of tasks run without blocking any thread.
+template <typename T = void>
+class Task;
+
+namespace task_detail
+{
+// Resumes the coroutine that awaited the finished task, or returns to the resumer if none did
+struct FinalAwaiter
+{
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  template <typename Promise>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+  {
+    std::coroutine_handle<> continuation = handle.promise().continuation;
+    return continuation ? continuation : std::noop_coroutine();
+  }
+
+  void await_resume() const noexcept { }
+};
+
+struct PromiseBase
+{
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  std::suspend_always initial_suspend() const noexcept
+  {
+    return {};
+  }
+
+  FinalAwaiter final_suspend() const noexcept
+  {
+    return {};
+  }
+
+  void unhandled_exception() noexcept
+  {
+    this->exception = std::current_exception();
+  }
+};
+
+template <typename T>
+struct Promise : PromiseBase
+{
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U&& result)
+  {
+    this->value.emplace(std::forward<U>(result));
+  }
+
+  T take()
+  {
+    if (this->exception)
+      std::rethrow_exception(this->exception);
+    return std::move(*this->value);
+  }
+};
+
+template <>
+struct Promise<void> : PromiseBase
+{
+  Task<void> get_return_object() noexcept;
+
+  void return_void() noexcept { }
+
+  void take()
+  {
+    if (this->exception)
+      std::rethrow_exception(this->exception);
+  }
+};
+} // namespace task_detail
+
+template <typename T>
+class [[nodiscard]] Task
+{
+public:
+  using promise_type = task_detail::Promise<T>;
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+
+public:
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) { }
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) { }
+
+  Task& operator=(Task&& other) noexcept
+  {
+    if (this != &other)
+    {
+      if (this->handle_)
+        this->handle_.destroy();
+      this->handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  bool await_ready() const noexcept
+  {
+    return !this->handle_ || this->handle_.done();
+  }
+
+  // Starts the task, resuming the awaiter once it has finished
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+  {
+    this->handle_.promise().continuation = awaiter;
+    return this->handle_;
+  }
+
+  // Returns the task's value or rethrows its exception
+  T await_resume()
+  {
+    return this->handle_.promise().take();
+  }
+
+  ~Task()
+  {
+    if (this->handle_)
+      this->handle_.destroy();
+  }
+};
+
+namespace task_detail
+{
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept
+{
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept
+{
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Eagerly started coroutine that destroys itself when it finishes, used to drive a Task from
+// non-coroutine code
+struct DetachedTask
+{
+  struct promise_type
+  {
+    DetachedTask get_return_object() const noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never initial_suspend() const noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never final_suspend() const noexcept
+    {
+      return {};
+    }
+
+    void return_void() const noexcept { }
+
+    void unhandled_exception() const noexcept
+    {
+      std::terminate();
+    }
+  };
+};
+
+template <typename T>
+struct SyncWaitState
+{
+  std::binary_semaphore done { 0 };
+  std::optional<T> value;
+  std::exception_ptr exception;
+};
+
+template <>
+struct SyncWaitState<void>
+{
+  std::binary_semaphore done { 0 };
+  std::exception_ptr exception;
+};
+
+template <typename T>
+DetachedTask runSyncWait(Task<T>& task, SyncWaitState<T>* state)
+{
+  try
+  {
+    if constexpr (std::is_void_v<T>)
+      co_await task;
+    else
+      state->value.emplace(co_await task);
+  } catch (...)
+  {
+    state->exception = std::current_exception();
+  }
+  state->done.release();
+}
+} // namespace task_detail
+
+// Runs a task to completion, blocking the calling thread. Must not be called from a thread the
+// task needs to make progress, such as the thread that pumps the main thread queue it awaits.
+template <typename T>
+T syncWait(Task<T> task)
+{
+  task_detail::SyncWaitState<T> state;
+  task_detail::runSyncWait(task, &state);
+  state.done.acquire();
+  if (state.exception)
+    std::rethrow_exception(state.exception);
+  if constexpr (!std::is_void_v<T>)
+    return std::move(*state.value);
+}
+
+#endif
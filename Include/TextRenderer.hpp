@@ -0,0 +1,133 @@
+#ifndef TEXT_RENDERER_HPP
+#define TEXT_RENDERER_HPP
+
+#include "GlyphCache.hpp"
+#include "Scheduler.hpp"
+#include "Task.hpp"
+#include "TrueTypeFont.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// A glyph placed on screen, position is the x0, y0, x1, y1 pixel rectangle and uv the matching
+// rectangle of the glyph atlas page
+struct GlyphQuad
+{
+  float position[4];
+  float uv[4];
+  uint32_t page;
+  uint32_t color;
+};
+
+// Distance field texels of a glyph cell to copy into the glyph atlas
+struct GlyphUpload
+{
+  uint32_t page;
+  uint32_t x;
+  uint32_t y;
+  std::vector<uint32_t> texels;
+};
+
+// Vertex of a glyph quad as read by the text pipeline
+struct TextVertex
+{
+  float position[2];
+  float uv[2];
+  uint32_t color;
+  uint32_t page;
+};
+
+// TextRenderer lays out text with a TrueType font into GlyphQuads that sample multi-channel
+// distance field glyphs from a GlyphCache, so text stays sharp at any size and all of it can be
+// drawn at once. Glyphs missing from the cache are generated on worker threads and skipped until
+// they are ready. Everything but glyph generation runs on the thread that owns the renderer.
+class TextRenderer
+{
+public:
+  // Size of a glyph cell and the distance range stored in it, in texels
+  static constexpr uint32_t cell_size_   = 48;
+  static constexpr float distance_range_ = 4.0f;
+
+private:
+  // Glyph and metrics of a code point, looked up once
+  struct CodepointInfo
+  {
+    uint32_t glyph;
+    GlyphMetrics metrics;
+  };
+
+  // A distance field finished on a worker, waiting for room in the uploads
+  struct GeneratedGlyph
+  {
+    uint32_t glyph;
+    std::vector<uint32_t> texels;
+  };
+
+  Scheduler& scheduler_;
+  TrueTypeFont font_;
+  GlyphCache cache_;
+  uint32_t page_size_;
+  uint32_t max_uploads_per_frame_;
+
+  // Distance field texels per font unit, fitting the font's ascender to descender in a cell
+  float field_scale_;
+
+  uint64_t frame_         = 0;
+  uint64_t glyph_version_ = 0;
+  std::unordered_map<uint32_t, CodepointInfo> codepoints_;
+  std::unordered_set<uint32_t> pending_;
+  std::vector<GeneratedGlyph> generated_;
+  std::vector<GlyphUpload> uploads_;
+
+  const CodepointInfo& codepointInfo(uint32_t codepoint);
+
+  // Generates a glyph's distance field on a worker and hands it back on the main thread
+  Task<void> generateGlyph(uint32_t glyph, GlyphMetrics metrics);
+
+public:
+  TextRenderer(Scheduler& scheduler,
+               TrueTypeFont font,
+               uint32_t page_size,
+               uint32_t page_count,
+               uint32_t max_uploads_per_frame);
+
+  TextRenderer(const TextRenderer&) = delete;
+  TextRenderer& operator=(const TextRenderer&) = delete;
+
+  // Adds glyphs generated since the last frame to the cache, at most max_uploads_per_frame of
+  // them. Call once per frame before drawing text. Pages drawn from in the previous frame are not
+  // evicted, so a working set larger than the cache delays new glyphs instead of thrashing.
+  void beginFrame(uint64_t frame);
+
+  // Lays out UTF-8 text with its first baseline at (x, y) pixels and size pixels per em, appending
+  // a quad per visible glyph. Returns the pen position after the last glyph.
+  float drawText(std::string_view text,
+                 float x,
+                 float y,
+                 float size,
+                 uint32_t color,
+                 std::vector<GlyphQuad>& quads);
+
+  // Distance between baselines at a size
+  float lineHeight(float size) const;
+
+  // Moves the uploads of glyphs added to the cache this frame into uploads
+  void takeUploads(std::vector<GlyphUpload>& uploads);
+
+  // Changes whenever glyphs are added to the cache, which may evict others. Quads laid out under
+  // an older version can be missing glyphs or point at cells that now hold different ones.
+  uint64_t glyphVersion() const;
+
+  size_t cachedGlyphCount() const;
+  size_t pendingGlyphCount() const;
+};
+
+// Writes a quad of four vertices for every glyph into vertices, at most max_quads of them. Returns
+// the number of quads written.
+size_t
+buildTextVertices(const std::vector<GlyphQuad>& quads, TextVertex* vertices, size_t max_quads);
+
+#endif
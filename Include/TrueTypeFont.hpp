@@ -0,0 +1,100 @@
+#ifndef TRUE_TYPE_FONT_HPP
+#define TRUE_TYPE_FONT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A point of a glyph outline in font units, y points up
+struct OutlinePoint
+{
+  float x;
+  float y;
+};
+
+// A line, or a quadratic Bezier curve through control when quadratic is set
+struct OutlineEdge
+{
+  OutlinePoint start;
+  OutlinePoint control;
+  OutlinePoint end;
+  bool quadratic;
+};
+
+// A closed loop of edges, filled on the right hand side of its direction
+using OutlineContour = std::vector<OutlineEdge>;
+
+// Horizontal metrics and bounding box of a glyph in font units, the box is empty for blank glyphs
+struct GlyphMetrics
+{
+  float advance;
+  float x_min;
+  float y_min;
+  float x_max;
+  float y_max;
+};
+
+// TrueTypeFont reads the glyph outlines and metrics of a TrueType (glyf based) font file. It keeps
+// the file in memory and decodes glyphs on demand, so it can be shared by several threads once
+// constructed. Malformed fonts throw std::runtime_error.
+class TrueTypeFont
+{
+private:
+  std::vector<uint8_t> data_;
+
+  // Offsets of the tables used after construction
+  size_t glyf_ = 0;
+  size_t loca_ = 0;
+  size_t hmtx_ = 0;
+  size_t cmap_ = 0;
+
+  uint16_t cmap_format_   = 0;
+  bool long_loca_         = false;
+  uint16_t glyph_count_   = 0;
+  uint16_t hmetric_count_ = 0;
+  float units_per_em_     = 0.0f;
+  float ascender_         = 0.0f;
+  float descender_        = 0.0f;
+  float line_gap_         = 0.0f;
+
+  // Big endian reads, throwing if they run past the end of the file
+  uint8_t readU8(size_t offset) const;
+  uint16_t readU16(size_t offset) const;
+  int16_t readI16(size_t offset) const;
+  uint32_t readU32(size_t offset) const;
+
+  // Returns the offset of a table, or zero if the font has none
+  size_t findTable(std::string_view tag) const;
+
+  // Returns the byte range of a glyph in the glyf table, empty for blank glyphs
+  std::pair<size_t, size_t> glyphRange(uint32_t glyph) const;
+
+  // Appends the contours of a glyph, transformed by the 2x3 matrix, to contours. Composite glyphs
+  // recurse into their components.
+  void appendOutline(uint32_t glyph,
+                     const float transform[6],
+                     std::vector<OutlineContour>& contours,
+                     int depth) const;
+
+public:
+  explicit TrueTypeFont(std::vector<uint8_t> data);
+
+  // Returns the glyph of a Unicode code point, zero (the missing glyph) if the font has none
+  uint32_t glyphIndex(uint32_t codepoint) const;
+
+  GlyphMetrics metrics(uint32_t glyph) const;
+
+  std::vector<OutlineContour> outline(uint32_t glyph) const;
+
+  uint32_t glyphCount() const;
+
+  // Vertical metrics in font units, descender is negative
+  float unitsPerEm() const;
+  float ascender() const;
+  float descender() const;
+  float lineGap() const;
+};
+
+#endif
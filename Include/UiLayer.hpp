@@ -0,0 +1,139 @@
+#ifndef UI_LAYER_HPP
+#define UI_LAYER_HPP
+
+#include "SlotMap.hpp"
+#include "SpriteBatch.hpp"
+#include "TextRenderer.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Axis aligned rectangle in pixels from its top left (x0, y0) to its bottom right (x1, y1)
+struct UiRect
+{
+  float x0 = 0.0f;
+  float y0 = 0.0f;
+  float x1 = 0.0f;
+  float y1 = 0.0f;
+
+  bool empty() const;
+  bool intersects(const UiRect& other) const;
+
+  // Returns the smallest rectangle containing both, empty rectangles are ignored
+  UiRect united(const UiRect& other) const;
+};
+
+enum class UiWidgetKind
+{
+  // Filled rectangle
+  Panel,
+  // Single line of text, its rect only holds the left end of the baseline in x0, y0
+  Label,
+  // Rectangle filled from the left by value, between zero and one
+  Bar
+};
+
+// A widget and its tessellation, which is kept until the widget changes. Colours are RGBA8 with
+// red in the lowest byte.
+struct UiWidget
+{
+  UiWidgetKind kind;
+  UiRect rect;
+  uint32_t color      = 0xFFFFFFFFu;
+  uint32_t background = 0;
+  float value         = 0.0f;
+  float text_size     = 0.0f;
+  std::string text;
+  bool visible = true;
+  bool dirty   = true;
+
+  // Area covered by the tessellation and the quads drawing it
+  UiRect bounds;
+  std::vector<SpriteInstance> sprites;
+  std::vector<GlyphQuad> glyphs;
+};
+
+using UiWidgetHandle = Handle<UiWidget>;
+
+// Draws that bring a cached UI layer up to date. Only region is redrawn, it is cleared and then
+// every widget overlapping it is drawn, clipped to it.
+struct UiUpdate
+{
+  bool dirty = false;
+  UiRect region;
+  std::vector<SpriteInstance> sprites;
+  std::vector<GlyphQuad> glyphs;
+};
+
+// UiLayer is a retained set of widgets rendered into a cached layer. Widgets are tessellated when
+// they change rather than every frame, and only the region covered by changed widgets is redrawn,
+// so an idle UI costs nothing to update. Rectangles are drawn with a solid sprite tinted by the
+// widget colour, and text with the TextRenderer above all rectangles. Main thread only.
+class UiLayer
+{
+private:
+  SlotMap<UiWidget> widgets_;
+
+  // Widgets in draw order and the widgets changed since the last update
+  std::vector<UiWidgetHandle> order_;
+  std::vector<UiWidgetHandle> dirty_widgets_;
+
+  // Labels are laid out without text when text_renderer_ is null
+  TextRenderer* text_renderer_;
+  SpriteHandle solid_sprite_;
+
+  // Area to redraw that is not covered by a dirty widget, left by removed widgets
+  UiRect dirty_region_;
+
+  uint64_t glyph_version_      = 0;
+  uint64_t tessellation_count_ = 0;
+
+  UiWidgetHandle add(UiWidget widget);
+
+  // Queues a widget to be tessellated in the next update
+  void markDirty(UiWidgetHandle handle, UiWidget& widget);
+
+  // Rebuilds the sprites and glyphs of a widget
+  void tessellate(UiWidget& widget);
+
+  // Appends a solid rectangle to sprites
+  void addRect(const UiRect& rect, uint32_t color, std::vector<SpriteInstance>& sprites) const;
+
+public:
+  UiLayer(TextRenderer* text_renderer, SpriteHandle solid_sprite);
+
+  UiLayer(const UiLayer&) = delete;
+  UiLayer& operator=(const UiLayer&) = delete;
+
+  // Widgets are drawn in the order they are added
+  UiWidgetHandle addPanel(const UiRect& rect, uint32_t color);
+  UiWidgetHandle
+  addLabel(float x, float baseline, float size, uint32_t color, std::string_view text);
+  UiWidgetHandle addBar(const UiRect& rect, uint32_t background, uint32_t color, float value);
+
+  // Setters only mark a widget changed when the new state differs, stale handles are ignored
+  void setText(UiWidgetHandle handle, std::string_view text);
+  void setValue(UiWidgetHandle handle, float value);
+  void setColor(UiWidgetHandle handle, uint32_t color);
+  void setVisible(UiWidgetHandle handle, bool visible);
+
+  // Removes a widget, returns false if the handle is null or stale
+  bool remove(UiWidgetHandle handle);
+
+  // Redraws every widget in the next update, after the cached layer was lost
+  void invalidate();
+
+  // Tessellates the widgets changed since the last update and fills update with the draws for the
+  // region they cover. Text is laid out again whenever the glyph cache changed. Call after the
+  // TextRenderer's beginFrame.
+  void update(UiUpdate& update);
+
+  size_t widgetCount() const;
+
+  // Number of widget tessellations since the layer was created
+  uint64_t tessellationCount() const;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef WAV_HPP
+#define WAV_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Format and location of the samples of a RIFF WAVE file
+struct WavFormat
+{
+  uint32_t channels;
+  uint32_t sample_rate;
+  uint32_t bits_per_sample;
+  bool is_float;
+  size_t data_offset;
+  uint64_t frame_count;
+};
+
+// Parses the header of an 8, 16 or 24 bit integer or 32 bit float WAVE file, throws
+// std::runtime_error if it is malformed or in another format
+WavFormat parseWav(const std::vector<char>& data);
+
+// Decodes count frames starting at first_frame into floats between -1 and 1, channels holds one
+// array per channel. Frames past the end of the file are silent.
+void decodeWav(const WavFormat& format,
+               const std::vector<char>& data,
+               uint64_t first_frame,
+               uint32_t count,
+               float* const* channels);
+
+#endif
@@ -0,0 +1,24 @@
+// Encoding of the linear colour fragment shaders write to the swapchain. sRGB and scRGB swapchains
+// take linear colour as is, their format or presentation engine encodes it. HDR10 swapchains take
+// BT.2020 colour encoded with the SMPTE ST 2084 (PQ) curve, selected by specialization constant 0.
+
+layout(constant_id = 0) const bool pq_output = false;
+
+// Luminance linear 1.0 is shown at on an HDR10 display, the SDR reference white of ITU-R BT.2408
+const float sdr_white_nits = 203.0;
+
+vec3 encodePq(vec3 color)
+{
+  const mat3 bt709_to_bt2020 = mat3(0.6274, 0.0691, 0.0164,
+                                    0.3293, 0.9195, 0.0880,
+                                    0.0433, 0.0114, 0.8956);
+  vec3 y = clamp(bt709_to_bt2020 * color * (sdr_white_nits / 10000.0), 0.0, 1.0);
+  vec3 y_m1 = pow(y, vec3(0.1593017578125));
+  return pow((0.8359375 + 18.8515625 * y_m1) / (1.0 + 18.6875 * y_m1), vec3(78.84375));
+}
+
+// Alpha is left alone, so blending happens on encoded colour when the output is PQ
+vec4 encodeOutput(vec4 color)
+{
+  return pq_output ? vec4(encodePq(color.rgb), color.a) : color;
+}
@@ -1,4 +1,7 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "output.glsl"
 
 layout(location = 0) in vec3 frag_color;
 
@@ -6,5 +9,5 @@ layout(location = 0) out vec4 out_color;
 
 void main()
 {
-  out_color = vec4(frag_color, 1.0);
+  out_color = encodeOutput(vec4(frag_color, 1.0));
 }
@@ -1,5 +1,11 @@
 #version 450
 
+layout(set = 0, binding = 0) uniform DrawUniforms
+{
+  // offset.xy, scale and rotation in radians
+  vec4 transform;
+} draw;
+
 layout(location = 0) out vec3 frag_color;
 
 vec2 positions[3] = vec2[]
@@ -18,6 +24,9 @@ vec3 colors[3] = vec3[]
 
 void main()
 {
-  gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+  float s = sin(draw.transform.w);
+  float c = cos(draw.transform.w);
+  vec2 position = mat2(c, s, -s, c) * positions[gl_VertexIndex] * draw.transform.z;
+  gl_Position = vec4(position + draw.transform.xy, 0.0, 1.0);
   frag_color = colors[gl_VertexIndex];
 }
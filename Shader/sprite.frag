@@ -0,0 +1,16 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "output.glsl"
+
+layout(set = 0, binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) in vec2 frag_uv;
+layout(location = 1) in vec4 frag_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+  out_color = encodeOutput(texture(atlas, frag_uv) * frag_color);
+}
@@ -0,0 +1,37 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "output.glsl"
+
+layout(push_constant) uniform TextConstants
+{
+  vec2 pixel_to_ndc;
+  float distance_range;
+} constants;
+
+layout(set = 0, binding = 0) uniform sampler2DArray glyph_atlas;
+
+layout(location = 0) in vec2 frag_uv;
+layout(location = 1) in vec4 frag_color;
+layout(location = 2) flat in uint frag_page;
+
+layout(location = 0) out vec4 out_color;
+
+float median(float r, float g, float b)
+{
+  return max(min(r, g), min(max(r, g), b));
+}
+
+void main()
+{
+  // Convert the distance range from texels to screen pixels so edges stay one pixel wide at any
+  // scale, then take the median distance of the three channels
+  vec2 unit_range = vec2(constants.distance_range) / vec2(textureSize(glyph_atlas, 0).xy);
+  vec2 screen_texel_size = vec2(1.0) / fwidth(frag_uv);
+  float screen_range = max(0.5 * dot(unit_range, screen_texel_size), 1.0);
+
+  vec3 field = texture(glyph_atlas, vec3(frag_uv, float(frag_page))).rgb;
+  float distance = screen_range * (median(field.r, field.g, field.b) - 0.5);
+  float coverage = clamp(distance + 0.5, 0.0, 1.0);
+  out_color = encodeOutput(vec4(frag_color.rgb, frag_color.a * coverage));
+}
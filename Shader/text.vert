@@ -0,0 +1,26 @@
+#version 450
+
+layout(push_constant) uniform TextConstants
+{
+  // 2 / viewport size, maps pixel coordinates to normalised device coordinates
+  vec2 pixel_to_ndc;
+  // Distance range of the glyph atlas in texels
+  float distance_range;
+} constants;
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 uv;
+layout(location = 2) in vec4 color;
+layout(location = 3) in uint page;
+
+layout(location = 0) out vec2 frag_uv;
+layout(location = 1) out vec4 frag_color;
+layout(location = 2) flat out uint frag_page;
+
+void main()
+{
+  gl_Position = vec4(position * constants.pixel_to_ndc - 1.0, 0.0, 1.0);
+  frag_uv = uv;
+  frag_color = color;
+  frag_page = page;
+}
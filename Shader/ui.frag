@@ -0,0 +1,14 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "output.glsl"
+
+// Cached UI layer, the same size as the swapchain and holding premultiplied alpha
+layout(set = 0, binding = 0) uniform sampler2D ui_layer;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+  out_color = encodeOutput(texelFetch(ui_layer, ivec2(gl_FragCoord.xy), 0));
+}
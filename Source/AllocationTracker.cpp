@@ -0,0 +1,237 @@
+#include "AllocationTracker.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Call stacks of violations are reported in debug builds with glibc's backtrace
+#if ENGINE_ALLOCATION_TRACKING && !defined(NDEBUG) && defined(__GLIBC__)
+#include <execinfo.h>
+#include <unistd.h>
+#define ENGINE_ALLOCATION_STACKS 1
+#else
+#define ENGINE_ALLOCATION_STACKS 0
+#endif
+
+namespace
+{
+// Counters of the calling thread, constant initialised so that reading them needs no guard
+constinit thread_local AllocationCounts thread_counts;
+constinit thread_local uint32_t no_allocation_depth = 0;
+
+std::atomic<uint64_t> violation_count { 0 };
+
+#if ENGINE_ALLOCATION_TRACKING
+#if ENGINE_ALLOCATION_STACKS
+// Violations after the first few are only counted, a frame that allocates would flood stderr
+constexpr uint64_t max_reported_violations = 16;
+constexpr int max_stack_depth              = 32;
+
+constinit thread_local bool reporting = false;
+
+void reportViolation(size_t size)
+{
+  // Collecting the stack may allocate, those allocations are not reported again. The stack is
+  // written to stderr directly, the logger cannot hold it and may not run before a crash.
+  if (reporting)
+    return;
+  reporting = true;
+  std::fprintf(stderr, "Heap allocation of %zu bytes in an allocation free scope:\n", size);
+  void* frames[max_stack_depth];
+  int depth = backtrace(frames, max_stack_depth);
+  backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+  reporting = false;
+}
+#endif
+
+void recordAllocation(size_t size)
+{
+  thread_counts.count++;
+  thread_counts.bytes += size;
+  if (no_allocation_depth == 0)
+    return;
+  [[maybe_unused]] uint64_t violation = violation_count.fetch_add(1, std::memory_order_relaxed);
+#if ENGINE_ALLOCATION_STACKS
+  if (violation < max_reported_violations)
+    reportViolation(size);
+#endif
+}
+
+// Allocates like the default operator new, calling the new handler until it succeeds
+void* allocate(size_t size, size_t alignment)
+{
+  recordAllocation(size);
+  // operator new returns a unique pointer for size zero, and aligned_alloc needs a size that is a
+  // multiple of the alignment
+  size = std::max<size_t>(size, 1);
+  if (alignment > alignof(std::max_align_t))
+    size = (size + alignment - 1) & ~(alignment - 1);
+  while (true)
+  {
+    void* pointer = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, size)
+                                                          : std::malloc(size);
+    if (pointer)
+      return pointer;
+    std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void* allocateNoThrow(size_t size, size_t alignment) noexcept
+{
+  try
+  {
+    return allocate(size, alignment);
+  } catch (const std::bad_alloc&)
+  {
+    return nullptr;
+  }
+}
+#endif
+} // namespace
+
+AllocationCounts threadAllocations()
+{
+  return thread_counts;
+}
+
+uint64_t allocationViolations()
+{
+  return violation_count.load(std::memory_order_relaxed);
+}
+
+NoAllocationScope::NoAllocationScope(bool active) : active_(active)
+{
+  if (this->active_)
+    no_allocation_depth++;
+}
+
+NoAllocationScope::~NoAllocationScope()
+{
+  if (this->active_)
+    no_allocation_depth--;
+}
+
+AllowAllocationScope::AllowAllocationScope(bool active) : active_(active)
+{
+  if (!this->active_)
+    return;
+  this->saved_depth_  = no_allocation_depth;
+  no_allocation_depth = 0;
+}
+
+AllowAllocationScope::~AllowAllocationScope()
+{
+  if (this->active_)
+    no_allocation_depth = this->saved_depth_;
+}
+
+#if ENGINE_ALLOCATION_TRACKING
+// Replacements of every global operator new and delete, deletes free what either allocation
+// function returned
+void* operator new(size_t size)
+{
+  return allocate(size, 0);
+}
+
+void* operator new[](size_t size)
+{
+  return allocate(size, 0);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  return allocateNoThrow(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  return allocateNoThrow(size, 0);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return allocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return allocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
+#endif
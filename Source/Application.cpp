@@ -1,40 +1,39 @@
 #include "Application.hpp"
 
 #include "Config.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+#include "Result.hpp"
+#include "SceneSnapshot.hpp"
 
 #include <SDL2/SDL_vulkan.h>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
 #include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <random>
 #include <set>
+#include <stdexcept>
+#include <thread>
 
-std::vector<char> Application::readFile(const std::string& file_name) const
-{
-  // Open file to read
-  std::ifstream file(file_name, std::ios::ate | std::ios::binary);
-  if (!file.is_open())
-    throw std::runtime_error("Failed to open file");
-  // Get the size of the file
-  auto file_size = file.tellg();
-  // Allocate a vector the size of the file
-  std::vector<char> file_data(file_size);
-  // Read the file into the file data
-  file.seekg(0);
-  file.read(file_data.data(), file_size);
-  file.close();
-  return file_data;
-}
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
 bool Application::isDeviceSuitable(const vk::PhysicalDevice& phys_dev) const
 {
   vk::PhysicalDeviceProperties pdev_props        = phys_dev.getProperties();
-  std::vector<vk::ExtensionProperties> pdev_exts = phys_dev.enumerateDeviceExtensionProperties();
+  std::vector<vk::ExtensionProperties> pdev_exts =
+      VULKAN_CALL(phys_dev.enumerateDeviceExtensionProperties()).value();
 
   // Check if physical device is not a discrete GPU
   if (pdev_props.deviceType != vk::PhysicalDeviceType::eDiscreteGpu)
     return false;
 
+  // Check if physical device does not support Vulkan 1.1, needed for descriptor update templates
+  if (pdev_props.apiVersion < VK_API_VERSION_1_1)
+    return false;
+
   // Create a set of requested physical device extensions
   std::set<std::string> unsupported_extensions(this->required_device_extensions_.cbegin(),
                                                this->required_device_extensions_.cend());
@@ -74,7 +73,7 @@ Application::findQueueFamilies(const vk::PhysicalDevice& phys_dev) const
       queue_family_indices.compute = i;
 
     // Check queue family capabilities for presentation support
-    if (phys_dev.getSurfaceSupportKHR(i, this->surface_) == VK_TRUE)
+    if (VULKAN_CALL(phys_dev.getSurfaceSupportKHR(i, this->surface_)).value() == VK_TRUE)
       queue_family_indices.present = i;
   }
   return queue_family_indices;
@@ -84,31 +83,51 @@ Application::SwapchainSupportDetails
 Application::querySwapchainSupportDetails(const vk::PhysicalDevice& phys_dev) const
 {
   Application::SwapchainSupportDetails swapchain_support;
-  swapchain_support.capabilities  = phys_dev.getSurfaceCapabilitiesKHR(this->surface_);
-  swapchain_support.formats       = phys_dev.getSurfaceFormatsKHR(this->surface_);
-  swapchain_support.present_modes = phys_dev.getSurfacePresentModesKHR(this->surface_);
+  swapchain_support.capabilities =
+      VULKAN_CALL(phys_dev.getSurfaceCapabilitiesKHR(this->surface_)).value();
+  swapchain_support.formats = VULKAN_CALL(phys_dev.getSurfaceFormatsKHR(this->surface_)).value();
+  swapchain_support.present_modes =
+      VULKAN_CALL(phys_dev.getSurfacePresentModesKHR(this->surface_)).value();
   return swapchain_support;
 }
 
-vk::SurfaceFormatKHR
-Application::chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& formats) const
+vk::PresentModeKHR
+Application::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& present_modes,
+                                   bool vsync) const
 {
-  auto result = find_if(formats.cbegin(), formats.cend(), [](vk::SurfaceFormatKHR i) {
-    return i.format == vk::Format::eB8G8R8A8Srgb &&
-           i.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear;
-  });
-  if (result != formats.cend())
-    return *result;
-  return formats.front();
+  // FIFO is always supported. Without vsync mailbox presents the newest frame without tearing,
+  // immediate mode at least never waits for a vertical blank.
+  if (vsync)
+    return vk::PresentModeKHR::eFifo;
+  for (auto preferred : { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate })
+  {
+    if (std::find(present_modes.cbegin(), present_modes.cend(), preferred) != present_modes.cend())
+      return preferred;
+  }
+  return vk::PresentModeKHR::eFifo;
 }
 
-vk::PresentModeKHR
-Application::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& present_modes) const
+std::vector<vk::PresentModeKHR>
+Application::queryCompatiblePresentModes(vk::PresentModeKHR present_mode) const
 {
-  for (auto available_present_mode : present_modes)
-    if (available_present_mode == vk::PresentModeKHR::eMailbox)
-      return available_present_mode;
-  return vk::PresentModeKHR::eFifo;
+  // Queried like any other array, the count first and then the modes
+  vk::SurfacePresentModeEXT surface_present_mode(present_mode);
+  vk::PhysicalDeviceSurfaceInfo2KHR surface_info(this->surface_, &surface_present_mode);
+  vk::SurfacePresentModeCompatibilityEXT compatibility;
+  vk::SurfaceCapabilities2KHR capabilities({}, &compatibility);
+  Result<void> result = VULKAN_CALL(
+      this->physical_device_.getSurfaceCapabilities2KHR(&surface_info, &capabilities));
+  std::vector<vk::PresentModeKHR> present_modes(compatibility.presentModeCount);
+  compatibility.setPresentModes(present_modes);
+  if (result)
+  {
+    result = VULKAN_CALL(
+        this->physical_device_.getSurfaceCapabilities2KHR(&surface_info, &capabilities));
+  }
+  if (!result || compatibility.presentModeCount == 0)
+    return { present_mode };
+  present_modes.resize(compatibility.presentModeCount);
+  return present_modes;
 }
 
 vk::Extent2D Application::chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities) const
@@ -134,7 +153,1396 @@ vk::ShaderModule Application::createShaderModule(const std::vector<char>& shader
   vk::ShaderModuleCreateInfo create_info;
   create_info.setCodeSize(shader_code.size())
       .setPCode(reinterpret_cast<const uint32_t*>(shader_code.data()));
-  return this->device_.createShaderModule(create_info);
+  return VULKAN_CALL(this->device_.createShaderModule(create_info)).value();
+}
+
+Task<vk::ShaderModule> Application::loadShaderModule(std::string file_name)
+{
+  std::vector<char> shader_code = co_await this->scheduler_->readFile(std::move(file_name));
+  co_return this->createShaderModule(shader_code);
+}
+
+Task<TrueTypeFont> Application::loadFont(std::string file_name)
+{
+  std::vector<char> font_data = co_await this->scheduler_->readFile(std::move(file_name));
+  co_return TrueTypeFont(std::vector<uint8_t>(font_data.begin(), font_data.end()));
+}
+
+Task<void> Application::playMusic(std::string file_name)
+{
+  AudioVoiceHandle voice = co_await this->audio_->playStream(file_name, 0.5f, true);
+  if (!voice)
+    LOG_WARNING("No free voice to play {}", file_name);
+}
+
+bool Application::isDeviceExtensionEnabled(const char* extension) const
+{
+  return std::any_of(this->enabled_device_extensions_.cbegin(),
+                     this->enabled_device_extensions_.cend(),
+                     [&](const char* enabled) { return std::strcmp(enabled, extension) == 0; });
+}
+
+uint32_t Application::findMemoryType(uint32_t type_bits, vk::MemoryPropertyFlags properties) const
+{
+  vk::PhysicalDeviceMemoryProperties memory_properties =
+      this->physical_device_.getMemoryProperties();
+  for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+  {
+    if ((type_bits & (1 << i)) &&
+        (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+      return i;
+  }
+  throw std::runtime_error("Unable to find a suitable memory type");
+}
+
+BufferHandle Application::createBuffer(vk::DeviceSize size,
+                                       vk::BufferUsageFlags usage,
+                                       vk::MemoryPropertyFlags properties)
+{
+  Buffer buffer;
+  buffer.size  = size;
+  buffer.usage = usage;
+
+  vk::BufferCreateInfo create_info;
+  create_info.setSize(size).setUsage(usage).setSharingMode(vk::SharingMode::eExclusive);
+  buffer.buffer = VULKAN_CALL(this->device_.createBuffer(create_info)).value();
+
+  // Allocate memory that satisfies the buffer requirements and bind it
+  vk::MemoryRequirements requirements = this->device_.getBufferMemoryRequirements(buffer.buffer);
+  vk::MemoryAllocateInfo allocate_info;
+  allocate_info.setAllocationSize(requirements.size)
+      .setMemoryTypeIndex(this->findMemoryType(requirements.memoryTypeBits, properties));
+  buffer.memory = VULKAN_CALL(this->device_.allocateMemory(allocate_info)).value();
+  VULKAN_CALL(this->device_.bindBufferMemory(buffer.buffer, buffer.memory, 0)).value();
+
+  // Host visible buffers stay mapped for their whole lifetime
+  if (properties & vk::MemoryPropertyFlagBits::eHostVisible)
+    buffer.mapped = VULKAN_CALL(this->device_.mapMemory(buffer.memory, 0, size)).value();
+
+  return this->buffers_.insert(buffer);
+}
+
+ImageHandle Application::createImage(vk::Extent2D extent,
+                                     vk::Format format,
+                                     vk::ImageUsageFlags usage,
+                                     uint32_t layer_count,
+                                     vk::ImageViewType view_type)
+{
+  Image image;
+  image.format      = format;
+  image.extent      = extent;
+  image.usage       = usage;
+  image.layer_count = layer_count;
+  image.view_type   = view_type;
+
+  vk::ImageCreateInfo create_info;
+  create_info.setImageType(vk::ImageType::e2D)
+      .setFormat(format)
+      .setExtent(vk::Extent3D(extent, 1))
+      .setMipLevels(1)
+      .setArrayLayers(layer_count)
+      .setSamples(vk::SampleCountFlagBits::e1)
+      .setTiling(vk::ImageTiling::eOptimal)
+      .setUsage(usage)
+      .setSharingMode(vk::SharingMode::eExclusive)
+      .setInitialLayout(vk::ImageLayout::eUndefined);
+  image.image = VULKAN_CALL(this->device_.createImage(create_info)).value();
+
+  vk::MemoryRequirements requirements = this->device_.getImageMemoryRequirements(image.image);
+  vk::MemoryAllocateInfo allocate_info;
+  allocate_info.setAllocationSize(requirements.size)
+      .setMemoryTypeIndex(this->findMemoryType(requirements.memoryTypeBits,
+                                               vk::MemoryPropertyFlagBits::eDeviceLocal));
+  image.memory = VULKAN_CALL(this->device_.allocateMemory(allocate_info)).value();
+  VULKAN_CALL(this->device_.bindImageMemory(image.image, image.memory, 0)).value();
+
+  vk::ImageViewCreateInfo view_create_info;
+  view_create_info.setImage(image.image)
+      .setViewType(view_type)
+      .setFormat(format)
+      .setSubresourceRange(
+          vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, layer_count));
+  image.view = VULKAN_CALL(this->device_.createImageView(view_create_info)).value();
+
+  return this->images_.insert(image);
+}
+
+vk::CommandBuffer Application::beginOneTimeCommands()
+{
+  vk::CommandBufferAllocateInfo allocate_info;
+  allocate_info.setCommandPool(this->command_pool_)
+      .setLevel(vk::CommandBufferLevel::ePrimary)
+      .setCommandBufferCount(1);
+  vk::CommandBuffer command_buffer =
+      VULKAN_CALL(this->device_.allocateCommandBuffers(allocate_info)).value().front();
+  VULKAN_CALL(command_buffer.begin(
+                  vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)))
+      .value();
+  return command_buffer;
+}
+
+void Application::submitOneTimeCommands(vk::CommandBuffer command_buffer)
+{
+  VULKAN_CALL(command_buffer.end()).value();
+  vk::SubmitInfo submit_info;
+  submit_info.setCommandBuffers(command_buffer);
+  VULKAN_CALL(this->queues_.graphics.submit(submit_info)).value();
+  VULKAN_CALL(this->queues_.graphics.waitIdle()).value();
+  this->device_.freeCommandBuffers(this->command_pool_, command_buffer);
+}
+
+void Application::destroyBuffer(BufferHandle handle)
+{
+  Buffer* buffer = this->buffers_.get(handle);
+  if (!buffer)
+    return;
+  this->device_.destroyBuffer(buffer->buffer);
+  this->device_.freeMemory(buffer->memory);
+  this->buffers_.erase(handle);
+}
+
+void Application::destroyImage(ImageHandle handle)
+{
+  Image* image = this->images_.get(handle);
+  if (!image)
+    return;
+  this->device_.destroyImageView(image->view);
+  // Swapchain images are destroyed along with the swapchain
+  if (image->memory)
+  {
+    this->device_.destroyImage(image->image);
+    this->device_.freeMemory(image->memory);
+  }
+  this->images_.erase(handle);
+}
+
+void Application::destroyPipeline(PipelineHandle handle)
+{
+  Pipeline* pipeline = this->pipelines_.get(handle);
+  if (!pipeline)
+    return;
+  this->device_.destroyPipeline(pipeline->pipeline);
+  this->device_.destroyPipelineLayout(pipeline->layout);
+  this->pipelines_.erase(handle);
+  this->pipeline_descs_.erase(handle.value);
+  this->pipeline_render_passes_.erase(handle.value);
+}
+
+PipelineHandle Application::findPipeline(StringId name) const
+{
+  auto it = this->named_pipelines_.find(name);
+  return it != this->named_pipelines_.end() ? it->second : PipelineHandle();
+}
+
+MeshHandle Application::findMesh(StringId name) const
+{
+  auto it = this->named_meshes_.find(name);
+  return it != this->named_meshes_.end() ? it->second : MeshHandle();
+}
+
+uint32_t Application::queryMaxPushDescriptors() const
+{
+  if (!ENGINE_PUSH_DESCRIPTORS || !this->isDeviceExtensionEnabled("VK_KHR_push_descriptor"))
+    return 0;
+  using PushDescriptorProperties = vk::PhysicalDevicePushDescriptorPropertiesKHR;
+  using Properties2              = vk::PhysicalDeviceProperties2;
+  auto properties = this->physical_device_.getProperties2<Properties2, PushDescriptorProperties>();
+  return properties.get<PushDescriptorProperties>().maxPushDescriptors;
+}
+
+PipelineHandle Application::createGraphicsPipeline(const GraphicsPipelineDesc& desc,
+                                                   vk::RenderPass render_pass)
+{
+  if (!render_pass)
+    render_pass = this->render_pass_;
+
+  // Load the SPIR-V code and create shader modules off the main thread
+  auto creation_start                 = std::chrono::steady_clock::now();
+  vk::ShaderModule vert_shader_module = syncWait(this->loadShaderModule(desc.vertex_shader));
+  vk::ShaderModule frag_shader_module = syncWait(this->loadShaderModule(desc.fragment_shader));
+  Pipeline pipeline                   = buildGraphicsPipeline(
+      this->device_, render_pass, desc, vert_shader_module, frag_shader_module);
+  this->device_.destroyShaderModule(frag_shader_module);
+  this->device_.destroyShaderModule(vert_shader_module);
+  if (this->metrics_)
+    this->metrics_->recordPipelineCreation(std::chrono::steady_clock::now() - creation_start);
+
+  // The desc and render pass are kept to describe the pipeline in frame captures
+  PipelineHandle handle                       = this->pipelines_.insert(pipeline);
+  this->pipeline_descs_[handle.value]         = desc;
+  this->pipeline_render_passes_[handle.value] = render_pass;
+  return handle;
+}
+
+Result<void> Application::recordSprites(CommandRecorder& command_buffer,
+                                        PipelineHandle pipeline_handle,
+                                        const std::vector<SpriteInstance>& sprites,
+                                        BufferHandle vertex_buffer_handle,
+                                        size_t max_quads)
+{
+  // Sprites beyond the capacity of the vertex buffer are dropped
+  const Buffer& vertex_buffer = this->buffers_.at(vertex_buffer_handle);
+  size_t sprite_count         = buildSpriteBatches(this->sprite_atlas_,
+                                           sprites,
+                                           static_cast<SpriteVertex*>(vertex_buffer.mapped),
+                                           max_quads,
+                                           this->sprite_batches_);
+  this->frame_stats_.sprite_count += sprite_count;
+  this->frame_stats_.sprite_batch_count += this->sprite_batches_.size();
+  if (this->sprite_batches_.empty())
+    return vk::Result::eSuccess;
+
+  const Pipeline& pipeline = this->pipelines_.at(pipeline_handle);
+  command_buffer.bindPipeline(pipeline);
+
+  // Sprite positions are in pixels, the vertex shader maps them to the viewport
+  float pixel_to_ndc[2] = { 2.0f / this->swapchain_extent_.width,
+                            2.0f / this->swapchain_extent_.height };
+  command_buffer.pushConstants(
+      pipeline, vk::ShaderStageFlagBits::eVertex, 0, sizeof(pixel_to_ndc), pixel_to_ndc);
+
+  command_buffer.bindVertexBuffer(0, vertex_buffer, 0);
+  command_buffer.bindIndexBuffer(
+      this->buffers_.at(this->quad_index_buffer_), 0, vk::IndexType::eUint32);
+
+  // One draw per atlas page, the quads of a page are contiguous in the vertex buffer
+  for (const SpriteBatch& batch : this->sprite_batches_)
+  {
+    const Image& page = this->images_.at(this->sprite_atlas_images_.at(batch.page));
+    DescriptorInfo atlas_descriptor(vk::DescriptorImageInfo(
+        this->sprite_sampler_, page.view, vk::ImageLayout::eShaderReadOnlyOptimal));
+    Result<void> result =
+        command_buffer.bindDescriptors(*this->sprite_descriptors_, &atlas_descriptor);
+    if (!result)
+      return result;
+    command_buffer.drawIndexed(batch.quad_count * 6, 1, batch.first_quad * 6, 0, 0);
+  }
+  return vk::Result::eSuccess;
+}
+
+void Application::recordGlyphUploads(Frame& frame,
+                                     CommandRecorder& command_buffer,
+                                     const RenderSnapshot& snapshot)
+{
+  if (snapshot.glyph_uploads.empty())
+    return;
+
+  // Stage every cell, the text renderer never adds more than a staging buffer holds per frame
+  constexpr uint32_t cell_size        = TextRenderer::cell_size_;
+  constexpr vk::DeviceSize cell_bytes = cell_size * cell_size * sizeof(uint32_t);
+  const Buffer& staging               = this->buffers_.at(frame.glyph_staging_buffer);
+  const Image& atlas                  = this->images_.at(this->glyph_atlas_image_);
+  size_t upload_count =
+      std::min<size_t>(snapshot.glyph_uploads.size(), max_glyph_uploads_per_frame_);
+  this->glyph_copy_regions_.clear();
+  for (size_t i = 0; i < upload_count; i++)
+  {
+    const GlyphUpload& upload = snapshot.glyph_uploads[i];
+    std::memcpy(static_cast<char*>(staging.mapped) + i * cell_bytes,
+                upload.texels.data(),
+                cell_bytes);
+    vk::BufferImageCopy region;
+    region.setBufferOffset(i * cell_bytes)
+        .setImageSubresource(
+            vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, upload.page, 1))
+        .setImageOffset(vk::Offset3D(upload.x, upload.y, 0))
+        .setImageExtent(vk::Extent3D(cell_size, cell_size, 1));
+    this->glyph_copy_regions_.push_back(region);
+  }
+
+  // Earlier frames sampling the atlas finish before the copy, the copied cells are not in use
+  vk::ImageMemoryBarrier to_transfer;
+  to_transfer.setSrcAccessMask({})
+      .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setOldLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+      .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setImage(atlas.image)
+      .setSubresourceRange(vk::ImageSubresourceRange(
+          vk::ImageAspectFlagBits::eColor, 0, 1, 0, glyph_atlas_page_count_));
+  command_buffer.imageBarrier(vk::PipelineStageFlagBits::eFragmentShader,
+                              vk::PipelineStageFlagBits::eTransfer,
+                              to_transfer);
+  command_buffer.copyBufferToImage(
+      staging, atlas, vk::ImageLayout::eTransferDstOptimal, this->glyph_copy_regions_);
+
+  vk::ImageMemoryBarrier to_shader = to_transfer;
+  to_shader.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+      .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+  command_buffer.imageBarrier(vk::PipelineStageFlagBits::eTransfer,
+                              vk::PipelineStageFlagBits::eFragmentShader,
+                              to_shader);
+}
+
+Result<void> Application::recordText(CommandRecorder& command_buffer,
+                                     PipelineHandle pipeline_handle,
+                                     const std::vector<GlyphQuad>& glyphs,
+                                     BufferHandle vertex_buffer_handle,
+                                     size_t max_quads)
+{
+  const Buffer& vertex_buffer = this->buffers_.at(vertex_buffer_handle);
+  size_t glyph_count          = buildTextVertices(
+      glyphs, static_cast<TextVertex*>(vertex_buffer.mapped), max_quads);
+  if (glyph_count == 0)
+    return vk::Result::eSuccess;
+
+  const Pipeline& pipeline = this->pipelines_.at(pipeline_handle);
+  command_buffer.bindPipeline(pipeline);
+
+  // Matches TextConstants in the text shaders
+  float constants[4] = { 2.0f / this->swapchain_extent_.width,
+                         2.0f / this->swapchain_extent_.height,
+                         TextRenderer::distance_range_,
+                         0.0f };
+  command_buffer.pushConstants(pipeline,
+                               vk::ShaderStageFlagBits::eVertex |
+                                   vk::ShaderStageFlagBits::eFragment,
+                               0,
+                               sizeof(constants),
+                               constants);
+
+  // Every glyph page is a layer of one image, so all text is a single draw
+  const Image& atlas = this->images_.at(this->glyph_atlas_image_);
+  DescriptorInfo atlas_descriptor(vk::DescriptorImageInfo(
+      this->sprite_sampler_, atlas.view, vk::ImageLayout::eShaderReadOnlyOptimal));
+  Result<void> result = command_buffer.bindDescriptors(*this->text_descriptors_, &atlas_descriptor);
+  if (!result)
+    return result;
+
+  command_buffer.bindVertexBuffer(0, vertex_buffer, 0);
+  command_buffer.bindIndexBuffer(
+      this->buffers_.at(this->quad_index_buffer_), 0, vk::IndexType::eUint32);
+  command_buffer.drawIndexed(static_cast<uint32_t>(glyph_count) * 6, 1, 0, 0, 0);
+  return vk::Result::eSuccess;
+}
+
+Result<void> Application::recordUiLayer(Frame& frame,
+                                        CommandRecorder& command_buffer,
+                                        const RenderSnapshot& snapshot)
+{
+  if (!snapshot.ui.dirty)
+    return vk::Result::eSuccess;
+
+  // Round the region out to whole pixels inside the layer
+  const UiRect& region = snapshot.ui.region;
+  auto width           = static_cast<int32_t>(this->swapchain_extent_.width);
+  auto height          = static_cast<int32_t>(this->swapchain_extent_.height);
+  int32_t x0           = std::clamp(static_cast<int32_t>(std::floor(region.x0)), 0, width);
+  int32_t y0           = std::clamp(static_cast<int32_t>(std::floor(region.y0)), 0, height);
+  int32_t x1           = std::clamp(static_cast<int32_t>(std::ceil(region.x1)), 0, width);
+  int32_t y1           = std::clamp(static_cast<int32_t>(std::ceil(region.y1)), 0, height);
+  if (x0 >= x1 || y0 >= y1)
+    return vk::Result::eSuccess;
+  vk::Rect2D area({ x0, y0 },
+                  { static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0) });
+  uint64_t area_pixels = uint64_t(area.extent.width) * area.extent.height;
+  this->frame_stats_.render_target_bytes +=
+      2 * area_pixels * formatBytesPerPixel(this->ui_layer_format_);
+
+  // The layer is loaded, so everything outside the region keeps its cached pixels
+  vk::RenderPassBeginInfo render_pass_info;
+  render_pass_info.setRenderPass(this->ui_render_pass_)
+      .setFramebuffer(this->ui_framebuffer_)
+      .setRenderArea(area);
+  command_buffer.beginRenderPass(render_pass_info);
+
+  vk::Viewport viewport;
+  viewport.setX(0)
+      .setY(0)
+      .setWidth(this->swapchain_extent_.width)
+      .setHeight(this->swapchain_extent_.height)
+      .setMinDepth(0.0f)
+      .setMaxDepth(1.0f);
+  command_buffer.setViewport(viewport);
+  command_buffer.setScissor(area);
+
+  vk::ClearAttachment clear_attachment(
+      vk::ImageAspectFlagBits::eColor,
+      0,
+      vk::ClearColorValue(std::array<float, 4> { 0.0f, 0.0f, 0.0f, 0.0f }));
+  command_buffer.clearAttachment(clear_attachment, vk::ClearRect(area, 0, 1));
+
+  // Widget rectangles first, then their text
+  Result<void> result = this->recordSprites(command_buffer,
+                                            this->ui_sprite_pipeline_,
+                                            snapshot.ui.sprites,
+                                            frame.ui_sprite_vertex_buffer,
+                                            max_ui_quads_per_frame_);
+  if (result && this->glyph_atlas_image_)
+  {
+    result = this->recordText(command_buffer,
+                              this->ui_text_pipeline_,
+                              snapshot.ui.glyphs,
+                              frame.ui_text_vertex_buffer,
+                              max_ui_quads_per_frame_);
+  }
+  if (!result)
+    return result;
+
+  command_buffer.endRenderPass();
+  return vk::Result::eSuccess;
+}
+
+Result<void> Application::recordCommandBuffer(Frame& frame,
+                                              CommandRecorder& command_buffer,
+                                              uint32_t image_index,
+                                              const RenderSnapshot& snapshot)
+{
+  Result<void> result = VULKAN_CALL(frame.command_buffer.begin(vk::CommandBufferBeginInfo {}));
+  if (!result)
+    return result;
+
+  // GPU zones are timed on the command buffer itself, they are not part of captures
+  GpuProfiler& gpu_profiler = *this->gpu_profiler_;
+  gpu_profiler.beginFrame(frame.command_buffer, this->current_frame_);
+  uint32_t frame_zone = gpu_profiler.beginZone(frame.command_buffer, this->current_frame_, "frame");
+
+  // Occlusion queries are not captured either, captured frames draw everything untested
+  OcclusionCuller* culler = this->capture_ ? nullptr : this->occlusion_culler_.get();
+  if (culler)
+    culler->beginFrame(frame.command_buffer, this->current_frame_);
+
+  vk::ClearValue clear_value;
+  clear_value.setColor(vk::ClearColorValue(std::array<float, 4> { 0.0f, 0.0f, 0.0f, 1.0f }));
+
+  // Glyphs are copied into the atlas before the UI layer and the render pass sample it
+  uint32_t ui_zone = gpu_profiler.beginZone(frame.command_buffer, this->current_frame_, "UI layer");
+  if (this->glyph_atlas_image_)
+    this->recordGlyphUploads(frame, command_buffer, snapshot);
+  result = this->recordUiLayer(frame, command_buffer, snapshot);
+  if (!result)
+    return result;
+  gpu_profiler.endZone(frame.command_buffer, this->current_frame_, ui_zone);
+  uint32_t pass_zone =
+      gpu_profiler.beginZone(frame.command_buffer, this->current_frame_, "main pass");
+
+  // The main pass stores every pixel of the swapchain image and composites every pixel of the UI
+  // layer, blending reads more on top of that
+  uint64_t pixel_count = uint64_t(this->swapchain_extent_.width) * this->swapchain_extent_.height;
+  this->frame_stats_.render_target_bytes +=
+      pixel_count * (formatBytesPerPixel(this->swapchain_format_) +
+                     formatBytesPerPixel(this->ui_layer_format_));
+
+  vk::RenderPassBeginInfo render_pass_info;
+  render_pass_info.setRenderPass(this->render_pass_)
+      .setFramebuffer(this->swapchain_framebuffers_.at(image_index))
+      .setRenderArea(vk::Rect2D({ 0, 0 }, this->swapchain_extent_))
+      .setClearValues(clear_value);
+  command_buffer.beginRenderPass(render_pass_info);
+
+  // Viewport and scissor are dynamic so that the pipeline survives swapchain recreation
+  vk::Viewport viewport;
+  viewport.setX(0)
+      .setY(0)
+      .setWidth(this->swapchain_extent_.width)
+      .setHeight(this->swapchain_extent_.height)
+      .setMinDepth(0.0f)
+      .setMaxDepth(1.0f);
+  command_buffer.setViewport(viewport);
+  command_buffer.setScissor(vk::Rect2D({ 0, 0 }, this->swapchain_extent_));
+
+  // Draws beyond the capacity of the uniform buffer are dropped
+  const Buffer& uniform_buffer = this->buffers_.at(frame.uniform_buffer);
+  size_t draw_count = std::min<size_t>(snapshot.draws.size(), max_draws_per_frame_);
+  PipelineHandle bound_pipeline;
+  auto bind_pipeline = [&](PipelineHandle handle)
+  {
+    if (handle == bound_pipeline)
+      return;
+    command_buffer.bindPipeline(this->pipelines_.at(handle));
+    bound_pipeline = handle;
+  };
+  for (size_t i = 0; i < draw_count; i++)
+  {
+    const DrawItem& draw = snapshot.draws[i];
+
+    // Write the per-draw uniforms into this frame's buffer and bind them for the draw
+    DrawUniforms draw_uniforms;
+    std::memcpy(draw_uniforms.transform, draw.transform, sizeof(draw_uniforms.transform));
+    vk::DeviceSize draw_offset = i * this->draw_uniforms_stride_;
+    std::memcpy(static_cast<char*>(uniform_buffer.mapped) + draw_offset,
+                &draw_uniforms,
+                sizeof(DrawUniforms));
+
+    DescriptorInfo draw_descriptor(
+        vk::DescriptorBufferInfo(uniform_buffer.buffer, draw_offset, sizeof(DrawUniforms)));
+    result = command_buffer.bindDescriptors(*this->draw_descriptors_, &draw_descriptor);
+    if (!result)
+      return result;
+
+    // Draws with an occlusion proxy are measured by a query holding either the draw, if it was
+    // visible when last measured, or its proxy, so that it is drawn again once it reappears. A
+    // draw's index is its entity's, and entities are only appended or all replaced, so the index
+    // is the stable slot its results are kept under.
+    const Mesh& mesh = this->meshes_.at(draw.mesh);
+    auto proxy       = this->occlusion_proxies_.find(draw.pipeline.value);
+    uint32_t slot    = static_cast<uint32_t>(i);
+    uint32_t query   = OcclusionCuller::no_query_;
+    if (culler && proxy != this->occlusion_proxies_.end())
+      query = culler->beginQuery(frame.command_buffer, this->current_frame_, slot);
+    if (query == OcclusionCuller::no_query_)
+    {
+      bind_pipeline(draw.pipeline);
+      command_buffer.draw(mesh.vertex_count, 1, 0, 0);
+      continue;
+    }
+
+    // With conditional rendering both are recorded and the GPU picks one
+    bool conditional = culler->conditionalRendering();
+    if (conditional || culler->visible(slot))
+    {
+      bind_pipeline(draw.pipeline);
+      culler->beginConditional(frame.command_buffer, slot, false);
+      command_buffer.draw(mesh.vertex_count, 1, 0, 0);
+      culler->endConditional(frame.command_buffer);
+    }
+    if (conditional || !culler->visible(slot))
+    {
+      bind_pipeline(proxy->second);
+      culler->beginConditional(frame.command_buffer, slot, true);
+      command_buffer.draw(mesh.vertex_count, 1, 0, 0);
+      culler->endConditional(frame.command_buffer);
+    }
+    culler->endQuery(frame.command_buffer, this->current_frame_, query);
+  }
+
+  // Sprites are drawn over everything else, then text over them
+  result = this->recordSprites(command_buffer,
+                               this->sprite_pipeline_,
+                               snapshot.sprites,
+                               frame.sprite_vertex_buffer,
+                               max_sprites_per_frame_);
+  if (result && this->glyph_atlas_image_)
+  {
+    result = this->recordText(command_buffer,
+                              this->text_pipeline_,
+                              snapshot.glyphs,
+                              frame.text_vertex_buffer,
+                              max_glyphs_per_frame_);
+  }
+  if (!result)
+    return result;
+
+  // The cached UI layer goes on top, one full screen triangle whatever the UI holds
+  const Pipeline& ui_pipeline = this->pipelines_.at(this->ui_pipeline_);
+  command_buffer.bindPipeline(ui_pipeline);
+  DescriptorInfo layer_descriptor(
+      vk::DescriptorImageInfo(this->sprite_sampler_,
+                              this->images_.at(this->ui_layer_image_).view,
+                              vk::ImageLayout::eShaderReadOnlyOptimal));
+  result = command_buffer.bindDescriptors(*this->ui_descriptors_, &layer_descriptor);
+  if (!result)
+    return result;
+  command_buffer.draw(3, 1, 0, 0);
+
+  command_buffer.endRenderPass();
+  if (culler)
+    culler->endFrame(frame.command_buffer, this->current_frame_);
+  gpu_profiler.endZone(frame.command_buffer, this->current_frame_, pass_zone);
+  gpu_profiler.endZone(frame.command_buffer, this->current_frame_, frame_zone);
+  return VULKAN_CALL(frame.command_buffer.end());
+}
+
+std::vector<std::byte> Application::readBackBuffer(const Buffer& buffer)
+{
+  BufferHandle staging_handle = this->createBuffer(buffer.size,
+                                                   vk::BufferUsageFlagBits::eTransferDst,
+                                                   vk::MemoryPropertyFlagBits::eHostVisible |
+                                                       vk::MemoryPropertyFlagBits::eHostCoherent);
+  const Buffer& staging = this->buffers_.at(staging_handle);
+
+  vk::CommandBuffer commands = this->beginOneTimeCommands();
+  commands.copyBuffer(buffer.buffer, staging.buffer, vk::BufferCopy(0, 0, buffer.size));
+  this->submitOneTimeCommands(commands);
+
+  const auto* mapped = static_cast<const std::byte*>(staging.mapped);
+  std::vector<std::byte> contents(mapped, mapped + buffer.size);
+  this->destroyBuffer(staging_handle);
+  return contents;
+}
+
+std::vector<std::byte> Application::readBackImage(const Image& image, vk::ImageLayout layout)
+{
+  // Every image the engine creates has four bytes per texel, layers are copied one after another
+  vk::DeviceSize size =
+      vk::DeviceSize(image.extent.width) * image.extent.height * image.layer_count * 4;
+  BufferHandle staging_handle = this->createBuffer(size,
+                                                   vk::BufferUsageFlagBits::eTransferDst,
+                                                   vk::MemoryPropertyFlagBits::eHostVisible |
+                                                       vk::MemoryPropertyFlagBits::eHostCoherent);
+  const Buffer& staging = this->buffers_.at(staging_handle);
+
+  vk::CommandBuffer commands = this->beginOneTimeCommands();
+  vk::ImageMemoryBarrier to_transfer;
+  to_transfer.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eTransferRead)
+      .setOldLayout(layout)
+      .setNewLayout(vk::ImageLayout::eTransferSrcOptimal)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setImage(image.image)
+      .setSubresourceRange(
+          vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, image.layer_count));
+  commands.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands,
+                           vk::PipelineStageFlagBits::eTransfer,
+                           {},
+                           nullptr,
+                           nullptr,
+                           to_transfer);
+  vk::BufferImageCopy region;
+  region
+      .setImageSubresource(
+          vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, image.layer_count))
+      .setImageExtent(vk::Extent3D(image.extent, 1));
+  commands.copyImageToBuffer(
+      image.image, vk::ImageLayout::eTransferSrcOptimal, staging.buffer, region);
+  vk::ImageMemoryBarrier to_layout = to_transfer;
+  to_layout.setSrcAccessMask(vk::AccessFlagBits::eTransferRead)
+      .setDstAccessMask(vk::AccessFlagBits::eMemoryRead)
+      .setOldLayout(vk::ImageLayout::eTransferSrcOptimal)
+      .setNewLayout(layout);
+  commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                           vk::PipelineStageFlagBits::eAllCommands,
+                           {},
+                           nullptr,
+                           nullptr,
+                           to_layout);
+  this->submitOneTimeCommands(commands);
+
+  const auto* mapped = static_cast<const std::byte*>(staging.mapped);
+  std::vector<std::byte> contents(mapped, mapped + size);
+  this->destroyBuffer(staging_handle);
+  return contents;
+}
+
+void Application::beginCapture()
+{
+  PROFILE_ZONE("beginCapture");
+  AllowAllocationScope allocations;
+  VULKAN_CALL(this->device_.waitIdle()).value();
+  try
+  {
+    auto capture = std::make_unique<FrameCapture>(
+        this->options_.capture_file,
+        this->options_.capture_frames,
+        this->physical_device_.getProperties().deviceName.data(),
+        this->draw_descriptors_->usesPushDescriptors());
+
+    // Host visible buffers are copied as each frame leaves them, the others are read back now.
+    // Reading back creates buffers, so the buffers are copied before.
+    std::vector<Buffer> buffers(this->buffers_.begin(), this->buffers_.end());
+    for (const Buffer& buffer : buffers)
+    {
+      capture->addBuffer(buffer,
+                         buffer.mapped ? std::vector<std::byte>() : this->readBackBuffer(buffer));
+    }
+
+    // Between frames every image the engine created is ready to be sampled, the contents of the
+    // swapchain images are never read
+    for (const Image& image : this->images_)
+    {
+      if (image.memory)
+      {
+        capture->addImage(image,
+                          vk::ImageLayout::eShaderReadOnlyOptimal,
+                          this->readBackImage(image, vk::ImageLayout::eShaderReadOnlyOptimal));
+      } else
+      {
+        capture->addImage(image, vk::ImageLayout::eUndefined, {});
+      }
+    }
+
+    capture->addSampler(this->sprite_sampler_, this->sprite_sampler_ci_);
+    capture->addRenderPass(this->render_pass_, this->render_pass_desc_);
+    capture->addRenderPass(this->ui_render_pass_, this->ui_render_pass_desc_);
+    for (size_t i = 0; i < this->swapchain_framebuffers_.size(); i++)
+    {
+      capture->addFramebuffer(this->swapchain_framebuffers_[i],
+                              this->render_pass_,
+                              this->images_.at(this->swapchain_images_[i]),
+                              this->swapchain_extent_);
+    }
+    capture->addFramebuffer(this->ui_framebuffer_,
+                            this->ui_render_pass_,
+                            this->images_.at(this->ui_layer_image_),
+                            this->swapchain_extent_);
+
+    for (size_t i = 0; i < this->pipelines_.size(); i++)
+    {
+      PipelineHandle handle = this->pipelines_.handleAt(i);
+      capture->addPipeline(this->pipelines_.at(handle),
+                           this->pipeline_render_passes_.at(handle.value),
+                           this->pipeline_descs_.at(handle.value));
+    }
+    capture->addBinder(*this->draw_descriptors_);
+    capture->addBinder(*this->sprite_descriptors_);
+    if (this->text_descriptors_)
+      capture->addBinder(*this->text_descriptors_);
+    capture->addBinder(*this->ui_descriptors_);
+
+    this->capture_ = std::move(capture);
+    LOG_INFO("Capturing {} frames into {}",
+             this->options_.capture_frames,
+             this->options_.capture_file);
+  } catch (const std::exception& error)
+  {
+    LOG_ERROR("Failed to start frame capture: {}", error.what());
+  }
+}
+
+void Application::captureFrame(std::chrono::nanoseconds record_time)
+{
+  this->capture_->endFrame(record_time);
+  if (!this->capture_->error().empty())
+  {
+    LOG_ERROR("Frame capture failed: {}", this->capture_->error());
+    this->capture_.reset();
+    return;
+  }
+  if (!this->capture_->complete())
+    return;
+
+  // Written on the render thread, the frame after a capture is late
+  try
+  {
+    this->capture_->write();
+    LOG_INFO("Frame capture written to {}", this->options_.capture_file);
+  } catch (const std::exception& error)
+  {
+    LOG_ERROR("Failed to write frame capture: {}", error.what());
+  }
+  this->capture_.reset();
+}
+
+Result<void> Application::drawFrame(const RenderSnapshot& snapshot)
+{
+  PROFILE_ZONE("drawFrame");
+  auto frame_start                   = std::chrono::steady_clock::now();
+  AllocationCounts frame_allocations = threadAllocations();
+  Frame& frame                       = this->frames_.at(this->current_frame_);
+
+  // Wait until the GPU has finished with this frame's resources, then collect its GPU zones. With
+  // swapchain maintenance also wait until the frame's last present is done with render_finished.
+  std::array<vk::Fence, 2> fences = { frame.in_flight, frame.present_fence };
+  uint32_t fence_count            = this->swapchain_maintenance_ ? 2 : 1;
+  int64_t wait_start              = Profiler::time(frame_start);
+  Result<void> result             = VULKAN_CALL(this->device_.waitForFences(
+      vk::ArrayProxy<const vk::Fence>(fence_count, fences.data()), VK_TRUE, UINT64_MAX));
+  if (!result)
+    return result;
+  Profiler::instance().record("waitForFence", wait_start, Profiler::now());
+  this->gpu_profiler_->collect(this->current_frame_);
+  uint32_t skipped_draws = 0;
+  if (this->occlusion_culler_)
+  {
+    this->occlusion_culler_->collect(this->current_frame_);
+    skipped_draws = this->occlusion_culler_->skippedDraws();
+  }
+
+  // A present the present thread found suboptimal or out of date recreates the swapchain before
+  // the next image is acquired, other failures end the frame loop
+  if (this->presenter_)
+  {
+    vk::Result present_result = this->presenter_->takeResult();
+    if (present_result == vk::Result::eSuboptimalKHR ||
+        present_result == vk::Result::eErrorOutOfDateKHR)
+    {
+      AllowAllocationScope allocations;
+      result = this->recreateSwapchain();
+      if (!result)
+        return result;
+    } else if (static_cast<int32_t>(present_result) < 0)
+    {
+      return present_result;
+    }
+  }
+
+  // Vsync toggled on the main thread switches the present mode before the next image is acquired
+  bool vsync = this->vsync_.load(std::memory_order_relaxed);
+  if (vsync != this->present_vsync_)
+  {
+    AllowAllocationScope allocations;
+    result = this->switchPresentMode(vsync);
+    if (!result)
+      return result;
+  }
+
+  // Captures start here, while none of the frame's resources are being written
+  if (!this->capture_ && (this->capture_requested_.exchange(false) ||
+                          this->drawn_frames_ + 1 == this->options_.capture_start_frame))
+    this->beginCapture();
+  // Captured frames grow the capture's storage as they are recorded
+  AllowAllocationScope capture_allocations(this->capture_ != nullptr);
+
+  // The present thread acquires the image of a frame after presenting the frame before last, and
+  // only uses the swapchain from its own thread. Otherwise the image is acquired here, once the
+  // present thread is done with the swapchain. An out of date swapchain is expected on resize,
+  // recreate it and skip this frame.
+  int64_t acquire_start           = Profiler::now();
+  Result<uint32_t> acquire_result = vk::Result::eNotReady;
+  if (frame.acquire_request)
+  {
+    acquire_result = this->presenter_->takeAcquired(*frame.acquire_request);
+    frame.acquire_request.reset();
+  } else
+  {
+    if (this->presenter_)
+      this->presenter_->drain();
+    acquire_result = VULKAN_CALL(
+        this->device_.acquireNextImageKHR(this->swapchain_, UINT64_MAX, frame.image_available));
+  }
+  Profiler::instance().record("acquireNextImage", acquire_start, Profiler::now());
+
+  // With swapchain maintenance a suboptimal image is released without being presented and the
+  // swapchain recreated right away. Its semaphore is still waited on, so that it is unsignalled
+  // for the next acquire, and the image is released only once that wait and every present of the
+  // swapchain have finished. The frame's fence is signalled and unused here, the wait signals it
+  // again.
+  bool release_image = this->swapchain_maintenance_ &&
+                       acquire_result.code() == vk::Result::eSuboptimalKHR;
+  if (release_image)
+  {
+    if (this->presenter_)
+      this->presenter_->drain();
+    result = this->consumeImageAvailable(frame);
+    if (result)
+      result = this->waitForPresents();
+    if (!result)
+      return result;
+    vk::ReleaseSwapchainImagesInfoEXT release_info;
+    release_info.setSwapchain(this->swapchain_).setImageIndices(acquire_result.value());
+    result = VULKAN_CALL(this->device_.releaseSwapchainImagesEXT(release_info));
+    if (!result)
+      return result;
+  }
+  if (acquire_result.code() == vk::Result::eErrorOutOfDateKHR || release_image)
+  {
+    AllowAllocationScope allocations;
+    result = this->recreateSwapchain();
+    if (!result)
+      return result;
+
+    // The glyphs the snapshot added to the cache still have to reach the atlas, the device is idle
+    // so this frame's staging buffer is free
+    if (this->glyph_atlas_image_ && !snapshot.glyph_uploads.empty())
+    {
+      CommandRecorder upload_commands(this->beginOneTimeCommands());
+      this->recordGlyphUploads(frame, upload_commands, snapshot);
+      this->submitOneTimeCommands(upload_commands.commandBuffer());
+    }
+    return vk::Result::eSuccess;
+  }
+  if (!acquire_result)
+    return acquire_result.code();
+  uint32_t image_index = acquire_result.value();
+
+  result = VULKAN_CALL(this->device_.resetFences(frame.in_flight));
+  if (!result)
+    return result;
+
+  // Record the frame, timing how long the CPU spends recording
+  auto record_start            = std::chrono::steady_clock::now();
+  uint64_t sprite_count        = this->frame_stats_.sprite_count;
+  uint64_t render_target_bytes = this->frame_stats_.render_target_bytes;
+  CommandRecorder command_buffer(frame.command_buffer, this->capture_.get());
+  result = this->draw_descriptors_->beginFrame(this->current_frame_);
+  if (result)
+    result = this->sprite_descriptors_->beginFrame(this->current_frame_);
+  if (result && this->text_descriptors_)
+    result = this->text_descriptors_->beginFrame(this->current_frame_);
+  if (result)
+    result = this->ui_descriptors_->beginFrame(this->current_frame_);
+  if (result)
+    result = VULKAN_CALL(frame.command_buffer.reset());
+  if (result)
+    result = this->recordCommandBuffer(frame, command_buffer, image_index, snapshot);
+  if (!result)
+    return result;
+  auto record_time = std::chrono::steady_clock::now() - record_start;
+  this->frame_stats_.record_time += record_time;
+  Profiler::instance().record("recordCommandBuffer",
+                              Profiler::time(record_start),
+                              Profiler::time(record_start + record_time));
+  if (this->capture_)
+    this->captureFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(record_time));
+
+  vk::PipelineStageFlags wait_stage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+  vk::SubmitInfo submit_info;
+  submit_info.setWaitSemaphores(frame.image_available)
+      .setWaitDstStageMask(wait_stage)
+      .setCommandBuffers(frame.command_buffer)
+      .setSignalSemaphores(frame.render_finished);
+
+  // A queued present waits on render_finished, the present of the frame that last signalled it has
+  // to have returned before it is signalled again
+  if (this->presenter_)
+  {
+    int64_t present_wait_start = Profiler::now();
+    this->presenter_->wait(max_frames_in_flight_ - 1);
+    Profiler::instance().record("waitForPresent", present_wait_start, Profiler::now());
+  }
+  int64_t submit_start = Profiler::now();
+  result               = VULKAN_CALL(this->queues_.graphics.submit(submit_info, frame.in_flight));
+  if (!result)
+    return result;
+  int64_t present_start = Profiler::now();
+  Profiler::instance().record("submit", submit_start, present_start);
+  this->gpu_profiler_->submitted(this->current_frame_, submit_start);
+
+  // With swapchain maintenance the present signals the frame's present fence and picks the present
+  // mode, which then changes without recreating the swapchain
+  if (this->swapchain_maintenance_)
+  {
+    result = VULKAN_CALL(this->device_.resetFences(frame.present_fence));
+    if (!result)
+      return result;
+  }
+  Presenter::Request present_request;
+  present_request.swapchain      = this->swapchain_;
+  present_request.image_index    = image_index;
+  present_request.wait_semaphore = frame.render_finished;
+  present_request.fence          = this->swapchain_maintenance_ ? frame.present_fence : vk::Fence();
+  present_request.present_mode   = this->present_mode_;
+  present_request.frame_start    = Profiler::time(frame_start);
+
+  // The present thread presents the frame while the next one is recorded, and then acquires the
+  // image of this frame slot's next frame, which fits in the images the swapchain lets be held.
+  // Otherwise the frame is presented here, which can block until a vertical blank. Either way the
+  // latency of the presents that returned is counted.
+  Presenter::Latency present_latency;
+  if (this->presenter_)
+  {
+    bool acquire_ahead = this->swapchain_acquire_limit_ >= max_frames_in_flight_;
+    if (acquire_ahead)
+    {
+      present_request.acquire_semaphore = frame.image_available;
+      present_request.acquire_fence     = frame.in_flight;
+    }
+    uint64_t request = this->presenter_->present(present_request);
+    if (acquire_ahead)
+      frame.acquire_request = request;
+    present_latency = this->presenter_->takeLatency();
+  } else
+  {
+    result              = Presenter::presentNow(this->queues_.present, present_request);
+    int64_t present_end = Profiler::now();
+    Profiler::instance().record("present", present_start, present_end);
+    present_latency.total = present_end - present_request.frame_start;
+    present_latency.count = 1;
+    if (result.code() == vk::Result::eSuboptimalKHR ||
+        result.code() == vk::Result::eErrorOutOfDateKHR)
+      result = this->recreateSwapchain();
+    if (!result)
+      return result;
+  }
+  this->frame_stats_.present_latency += present_latency.total;
+  this->frame_stats_.present_count += present_latency.count;
+
+  this->current_frame_ = (this->current_frame_ + 1) % max_frames_in_flight_;
+  this->drawn_frames_++;
+  auto frame_time      = std::chrono::steady_clock::now() - frame_start;
+  double frame_time_ns = std::chrono::duration<double, std::nano>(frame_time).count();
+  this->frame_stats_.frame_time += frame_time;
+  this->frame_stats_.frame_time_squared += frame_time_ns * frame_time_ns;
+  this->frame_stats_.simulation_time += snapshot.simulation_time;
+  AllocationCounts render_allocations = threadAllocations() - frame_allocations;
+  this->frame_stats_.render_allocations += render_allocations;
+  this->frame_stats_.simulation_allocations += snapshot.simulation_allocations;
+  this->frame_stats_.skipped_draw_count += skipped_draws;
+  if (this->options_.benchmark_frames && this->drawn_frames_ > benchmark_warmup_frames_)
+  {
+    this->benchmark_stats_.frame_count++;
+    this->benchmark_stats_.frame_time += frame_time_ns;
+    this->benchmark_stats_.frame_time_squared += frame_time_ns * frame_time_ns;
+    this->benchmark_stats_.present_latency += present_latency.total;
+    this->benchmark_stats_.present_count += present_latency.count;
+  }
+  if (this->metrics_)
+  {
+    FrameMetrics metrics;
+    metrics.frame_time             = frame_time;
+    metrics.record_time            = record_time;
+    metrics.simulation_time        = snapshot.simulation_time;
+    metrics.draw_count             = command_buffer.drawCount();
+    metrics.pipeline_bind_count    = command_buffer.pipelineBindCount();
+    metrics.sprite_count           = this->frame_stats_.sprite_count - sprite_count;
+    metrics.skipped_draw_count     = skipped_draws;
+    metrics.render_target_bytes    = this->frame_stats_.render_target_bytes - render_target_bytes;
+    metrics.render_allocations     = render_allocations.count;
+    metrics.simulation_allocations = snapshot.simulation_allocations.count;
+    this->metrics_->recordFrame(metrics);
+  }
+  if (this->stutter_monitor_)
+  {
+    this->stutter_monitor_->addFrame(this->drawn_frames_,
+                                     Profiler::time(frame_start),
+                                     Profiler::time(frame_start + frame_time));
+  }
+
+  // Periodically report the average frame, recording and simulation times. Simulation runs on the
+  // main thread alongside drawFrame, so it only limits the frame rate once it exceeds frame time.
+  // The frame time standard deviation shows the effect of thread placement on frame pacing, and
+  // the allocation counts show which thread stopped allocating in steady state.
+  if (++this->frame_stats_.frame_count == frame_stats_interval_)
+  {
+    using std::chrono::nanoseconds;
+    auto average_frame_time = std::chrono::duration_cast<nanoseconds>(
+        this->frame_stats_.frame_time / this->frame_stats_.frame_count);
+    double mean_frame_time_ns = static_cast<double>(average_frame_time.count());
+    double frame_time_variance =
+        this->frame_stats_.frame_time_squared / this->frame_stats_.frame_count -
+        mean_frame_time_ns * mean_frame_time_ns;
+    auto frame_time_deviation = static_cast<int64_t>(std::sqrt(std::max(frame_time_variance, 0.0)));
+    auto average_record_time = std::chrono::duration_cast<nanoseconds>(
+        this->frame_stats_.record_time / this->frame_stats_.frame_count);
+    auto average_simulation_time = std::chrono::duration_cast<nanoseconds>(
+        this->frame_stats_.simulation_time / this->frame_stats_.frame_count);
+    LOG_INFO("Average CPU frame time: {}ns (standard deviation {}ns), command recording time: "
+             "{}ns, simulation time: {}ns, {} sprites in {} draws ({} descriptors, {})",
+             average_frame_time.count(),
+             frame_time_deviation,
+             average_record_time.count(),
+             average_simulation_time.count(),
+             this->frame_stats_.sprite_count / this->frame_stats_.frame_count,
+             this->frame_stats_.sprite_batch_count / this->frame_stats_.frame_count,
+             this->draw_descriptors_->usesPushDescriptors() ? "push" : "pooled",
+             vulkan_error_mode_);
+    LOG_INFO("Render target traffic per frame: {} bytes, {} bytes per pixel swapchain, {} UI layer",
+             this->frame_stats_.render_target_bytes / this->frame_stats_.frame_count,
+             formatBytesPerPixel(this->swapchain_format_),
+             formatBytesPerPixel(this->ui_layer_format_));
+    int64_t present_count =
+        static_cast<int64_t>(std::max<uint64_t>(this->frame_stats_.present_count, 1));
+    LOG_INFO("Average latency from frame start to present: {}ns, presenting on the {} thread",
+             this->frame_stats_.present_latency / present_count,
+             this->presenter_ ? "present" : "render");
+    if (this->occlusion_culler_)
+    {
+      LOG_INFO("Occlusion culling skipped {} draws per frame",
+               this->frame_stats_.skipped_draw_count / this->frame_stats_.frame_count);
+    }
+    LOG_INFO("Heap allocations per frame: {} ({} bytes) rendering, {} ({} bytes) simulating, {} "
+             "in allocation free scopes so far",
+             this->frame_stats_.render_allocations.count / this->frame_stats_.frame_count,
+             this->frame_stats_.render_allocations.bytes / this->frame_stats_.frame_count,
+             this->frame_stats_.simulation_allocations.count / this->frame_stats_.frame_count,
+             this->frame_stats_.simulation_allocations.bytes / this->frame_stats_.frame_count,
+             allocationViolations());
+    this->frame_stats_ = {};
+  }
+  return vk::Result::eSuccess;
+}
+
+void Application::simulate(float delta_time)
+{
+  PROFILE_ZONE("simulate");
+  for (auto& entity : this->entities_)
+    entity.rotation += entity.angular_velocity * delta_time;
+
+  // Sprites bounce off the edges of the window
+  const float bounds[2] = { static_cast<float>(this->window_width_),
+                            static_cast<float>(this->window_height_) };
+  for (auto& sprite : this->sprite_entities_)
+  {
+    sprite.rotation += sprite.angular_velocity * delta_time;
+    for (int axis = 0; axis < 2; axis++)
+    {
+      sprite.position[axis] += sprite.velocity[axis] * delta_time;
+      if (sprite.position[axis] < 0.0f || sprite.position[axis] > bounds[axis])
+      {
+        sprite.position[axis] = std::clamp(sprite.position[axis], 0.0f, bounds[axis]);
+        sprite.velocity[axis] = -sprite.velocity[axis];
+
+        // Smaller sprites bounce at a higher pitch, panned to where they hit. Bounces are dropped
+        // while every voice is playing.
+        if (this->audio_)
+        {
+          float pan   = sprite.position[0] / bounds[0] * 2.0f - 1.0f;
+          float pitch = 1.5f - (sprite.size - 8.0f) / 24.0f;
+          this->audio_->play(this->bounce_clip_, 0.05f, pan, pitch);
+        }
+      }
+    }
+  }
+  if (this->options_.collisions)
+    this->collideSprites();
+  this->simulation_frame_++;
+}
+
+void Application::collideSprites()
+{
+  PROFILE_ZONE("collideSprites");
+  auto sprite_count = static_cast<uint32_t>(this->sprite_entities_.size());
+  for (uint32_t i = 0; i < sprite_count; i++)
+  {
+    const SpriteEntity& sprite = this->sprite_entities_[i];
+    float radius               = sprite.size * 0.5f;
+    this->sprite_broadphase_.setBounds(i,
+                                       sprite.position[0] - radius,
+                                       sprite.position[1] - radius,
+                                       sprite.position[0] + radius,
+                                       sprite.position[1] + radius);
+  }
+  this->sprite_broadphase_.findPairs(*this->scheduler_, this->sprite_contacts_);
+
+  // Sprites are treated as circles of equal mass, touching ones moving towards each other swap
+  // their velocities along the line between their centres
+  for (const Broadphase::Pair& contact : this->sprite_contacts_)
+  {
+    SpriteEntity& a = this->sprite_entities_[contact.a];
+    SpriteEntity& b = this->sprite_entities_[contact.b];
+    float offset[2] = { b.position[0] - a.position[0], b.position[1] - a.position[1] };
+    float distance2 = offset[0] * offset[0] + offset[1] * offset[1];
+    float reach     = (a.size + b.size) * 0.5f;
+    if (distance2 >= reach * reach || distance2 == 0.0f)
+      continue;
+    float approach = (b.velocity[0] - a.velocity[0]) * offset[0] +
+                     (b.velocity[1] - a.velocity[1]) * offset[1];
+    if (approach >= 0.0f)
+      continue;
+    float impulse = approach / distance2;
+    for (int axis = 0; axis < 2; axis++)
+    {
+      a.velocity[axis] += impulse * offset[axis];
+      b.velocity[axis] -= impulse * offset[axis];
+    }
+  }
+}
+
+void Application::updateDashboard(float delta_time)
+{
+  PROFILE_ZONE("updateDashboard");
+  this->dashboard_.elapsed_time += delta_time;
+  if (++this->dashboard_.frame_count < dashboard_interval_)
+    return;
+
+  // Statistics are averaged over the interval, text that did not change is not laid out again
+  float frame_time =
+      this->dashboard_.elapsed_time * 1000.0f / static_cast<float>(this->dashboard_.frame_count);
+  this->dashboard_.elapsed_time = 0.0f;
+  this->dashboard_.frame_count  = 0;
+
+  char text[64];
+  std::snprintf(text, sizeof(text), "Frame time %.1f ms", frame_time);
+  this->ui_layer_->setText(this->dashboard_.frame_time_label, text);
+  this->ui_layer_->setValue(this->dashboard_.frame_time_bar, frame_time / 33.3f);
+  this->ui_layer_->setColor(this->dashboard_.frame_time_bar,
+                            frame_time > 16.7f ? 0xFF3060F0u : 0xFF60D060u);
+  std::snprintf(text,
+                sizeof(text),
+                "%zu sprites, %zu touching",
+                this->sprite_entities_.size(),
+                this->sprite_contacts_.size());
+  this->ui_layer_->setText(this->dashboard_.sprite_label, text);
+  if (this->text_renderer_)
+  {
+    std::snprintf(text,
+                  sizeof(text),
+                  "%zu glyphs cached, %zu pending",
+                  this->text_renderer_->cachedGlyphCount(),
+                  this->text_renderer_->pendingGlyphCount());
+    this->ui_layer_->setText(this->dashboard_.glyph_label, text);
+  }
+}
+
+void Application::extractRenderSnapshot(RenderSnapshot& snapshot)
+{
+  PROFILE_ZONE("extractRenderSnapshot");
+  // Clearing keeps the vector's capacity, so extraction stops allocating after the first frames
+  snapshot.frame_number = this->simulation_frame_;
+  snapshot.draws.clear();
+  for (const auto& entity : this->entities_)
+  {
+    snapshot.draws.push_back(
+        { entity.pipeline,
+          entity.mesh,
+          { entity.position[0], entity.position[1], entity.scale, entity.rotation } });
+  }
+
+  snapshot.sprites.clear();
+  for (const auto& sprite : this->sprite_entities_)
+  {
+    snapshot.sprites.push_back({ sprite.sprite,
+                                 { sprite.position[0], sprite.position[1] },
+                                 { sprite.size, sprite.size },
+                                 sprite.rotation,
+                                 sprite.color });
+  }
+
+  // Text is laid out every frame, glyphs missing from the cache appear once they are generated
+  snapshot.glyphs.clear();
+  if (this->text_renderer_)
+    this->text_renderer_->beginFrame(this->simulation_frame_);
+
+  // The UI only sends what changed, or everything once the render thread lost the layer
+  if (this->ui_layer_lost_.exchange(false))
+    this->ui_layer_->invalidate();
+  this->ui_layer_->update(snapshot.ui);
+
+  if (this->text_renderer_)
+  {
+    // The title pulses in size to show that the glyphs stay sharp at any scale
+    float phase      = static_cast<float>(this->simulation_frame_ % 628) * 0.01f;
+    float title_size = 64.0f + 32.0f * std::sin(phase);
+    this->text_renderer_->drawText("Vulkan-Engine",
+                                   16.0f,
+                                   16.0f + title_size,
+                                   title_size,
+                                   0xFFFFFFFFu,
+                                   snapshot.glyphs);
+    this->text_renderer_->takeUploads(snapshot.glyph_uploads);
+  }
+}
+
+void Application::renderLoop()
+{
+  Profiler::instance().setThreadName("render");
+  while (RenderSnapshot* snapshot = this->render_snapshots_.acquireRead())
+  {
+    // Frame errors are reported and end the loop, they are not thrown. Steady state frames must
+    // not allocate, paths that are known to are allowed to within drawFrame.
+    Result<void> frame_result = vk::Result::eSuccess;
+    {
+      NoAllocationScope no_allocations(this->drawn_frames_ >= allocation_free_after_frames_);
+      frame_result = this->drawFrame(*snapshot);
+    }
+    this->render_snapshots_.release(snapshot);
+    if (!frame_result)
+    {
+      LOG_ERROR("Failed to draw frame: {}", vk::to_string(frame_result.code()));
+      this->render_snapshots_.close();
+      return;
+    }
+  }
+}
+
+void Application::cleanupSwapchain()
+{
+  // Destroy all framebuffers
+  for (auto& framebuffer : this->swapchain_framebuffers_)
+    this->device_.destroyFramebuffer(framebuffer);
+  this->swapchain_framebuffers_.clear();
+  // Destroy all image views
+  for (auto& swapchain_image : this->swapchain_images_)
+    this->destroyImage(swapchain_image);
+  this->swapchain_images_.clear();
+  // Destroy the UI layer, it has the size of the swapchain
+  this->device_.destroyFramebuffer(this->ui_framebuffer_);
+  this->destroyImage(this->ui_layer_image_);
+  // Destroy the swapchain
+  this->device_.destroySwapchainKHR(this->swapchain_);
+}
+
+Result<void> Application::discardAcquiredImages()
+{
+  if (!this->presenter_)
+    return vk::Result::eSuccess;
+  this->presenter_->drain();
+  Result<void> result = vk::Result::eSuccess;
+  for (Frame& frame : this->frames_)
+  {
+    if (!frame.acquire_request)
+      continue;
+    Result<uint32_t> acquired = this->presenter_->takeAcquired(*frame.acquire_request);
+    frame.acquire_request.reset();
+    if (acquired && result)
+      result = this->consumeImageAvailable(frame);
+  }
+  return result;
+}
+
+Result<void> Application::consumeImageAvailable(Frame& frame)
+{
+  vk::PipelineStageFlags wait_stage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+  vk::SubmitInfo wait_info;
+  wait_info.setWaitSemaphores(frame.image_available).setWaitDstStageMask(wait_stage);
+  Result<void> result = VULKAN_CALL(this->device_.resetFences(frame.in_flight));
+  if (result)
+    result = VULKAN_CALL(this->queues_.graphics.submit(wait_info, frame.in_flight));
+  if (result)
+    result = VULKAN_CALL(this->device_.waitForFences(frame.in_flight, VK_TRUE, UINT64_MAX));
+  return result;
+}
+
+Result<void> Application::waitForPresents()
+{
+  if (!this->swapchain_maintenance_)
+    return vk::Result::eSuccess;
+  std::array<vk::Fence, max_frames_in_flight_> fences;
+  for (uint32_t i = 0; i < max_frames_in_flight_; i++)
+    fences[i] = this->frames_[i].present_fence;
+  return VULKAN_CALL(this->device_.waitForFences(fences, VK_TRUE, UINT64_MAX));
+}
+
+Result<void> Application::recreateSwapchain()
+{
+  PROFILE_ZONE("recreateSwapchain");
+  AllowAllocationScope allocations;
+
+  // A capture refers to the swapchain images and framebuffers, which are about to change
+  if (this->capture_)
+  {
+    LOG_WARNING("Frame capture abandoned, the swapchain was recreated");
+    this->capture_.reset();
+  }
+
+  // Queued presents and the images acquired ahead use the swapchain that is about to be destroyed,
+  // whether they found it out of date no longer matters
+  Result<void> result = this->discardAcquiredImages();
+  if (this->presenter_)
+    static_cast<void>(this->presenter_->takeResult());
+  if (result)
+    result = VULKAN_CALL(this->device_.waitIdle());
+  if (result)
+    result = this->waitForPresents();
+  if (!result)
+    return result;
+
+  // The swapchain is rebuilt by the initialisation code, which throws on failure. Its errors are
+  // returned so that the render thread ends the frame loop rather than terminating.
+  try
+  {
+    this->cleanupSwapchain();
+    this->initSwapchain();
+    this->initSwapchainImageViews();
+    this->initFramebuffers();
+    this->initUiLayerImage();
+  } catch (const VulkanError& error)
+  {
+    return error.code();
+  } catch (const std::exception& error)
+  {
+    LOG_ERROR("Failed to recreate the swapchain: {}", error.what());
+    return vk::Result::eErrorInitializationFailed;
+  }
+  this->ui_layer_lost_ = true;
+  return vk::Result::eSuccess;
+}
+
+Result<void> Application::switchPresentMode(bool vsync)
+{
+  PROFILE_ZONE("switchPresentMode");
+  this->present_vsync_ = vsync;
+  SwapchainSupportDetails swapchain_support =
+      this->querySwapchainSupportDetails(this->physical_device_);
+  vk::PresentModeKHR present_mode = chooseSwapPresentMode(swapchain_support.present_modes, vsync);
+  if (present_mode == this->present_mode_)
+    return vk::Result::eSuccess;
+
+  auto compatible = std::find(this->swapchain_present_modes_.cbegin(),
+                              this->swapchain_present_modes_.cend(),
+                              present_mode);
+  if (compatible != this->swapchain_present_modes_.cend())
+  {
+    this->present_mode_ = present_mode;
+    LOG_INFO("Presenting in {} from the next frame", vk::to_string(present_mode));
+    return vk::Result::eSuccess;
+  }
+  LOG_INFO("Recreating the swapchain to present in {}", vk::to_string(present_mode));
+  return this->recreateSwapchain();
 }
 
 void Application::initSDL()
@@ -167,6 +1575,30 @@ void Application::initInstance()
                                          requested_extensions_offset);
   }
 
+  // Initialise the dispatcher with the loader entry point provided by SDL
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(
+      reinterpret_cast<PFN_vkGetInstanceProcAddr>(SDL_Vulkan_GetVkGetInstanceProcAddr()));
+
+  // Surfaces only offer HDR colour spaces with VK_EXT_swapchain_colorspace. Swapchain maintenance
+  // is a device extension that needs surface maintenance on the instance.
+  std::vector<vk::ExtensionProperties> instance_extensions =
+      VULKAN_CALL(vk::enumerateInstanceExtensionProperties()).value();
+  auto instance_supports = [&](const char* name) {
+    return std::any_of(
+        instance_extensions.cbegin(), instance_extensions.cend(), [&](const auto& extension) {
+          return std::strcmp(extension.extensionName, name) == 0;
+        });
+  };
+  if (this->options_.hdr && instance_supports("VK_EXT_swapchain_colorspace"))
+    this->required_instance_extensions_.push_back("VK_EXT_swapchain_colorspace");
+  if (instance_supports("VK_KHR_get_surface_capabilities2") &&
+      instance_supports("VK_EXT_surface_maintenance1"))
+  {
+    this->required_instance_extensions_.push_back("VK_KHR_get_surface_capabilities2");
+    this->required_instance_extensions_.push_back("VK_EXT_surface_maintenance1");
+    this->optional_device_extensions_.push_back("VK_EXT_swapchain_maintenance1");
+  }
+
   // Make the application version
   uint32_t app_version =
       VK_MAKE_VERSION(PROJECT_VERSION_MAJOR, PROJECT_VERSION_MINOR, PROJECT_VERSION_PATCH);
@@ -180,7 +1612,7 @@ void Application::initInstance()
                                app_version,
                                "No Engine",
                                engine_version,
-                               VK_API_VERSION_1_0);
+                               VK_API_VERSION_1_1);
 
   // Initialise instance create information
   vk::InstanceCreateInfo create_info(
@@ -192,7 +1624,8 @@ void Application::initInstance()
       this->required_instance_extensions_.data());
 
   // Create Vulkan instance
-  this->instance_ = vk::createInstance(create_info);
+  this->instance_ = VULKAN_CALL(vk::createInstance(create_info)).value();
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(this->instance_);
 
   // Create Vulkan surface using SDL
   VkSurfaceKHR surface;
@@ -204,12 +1637,13 @@ void Application::initInstance()
 
 void Application::initPhysicalDevice()
 {
-  std::vector<vk::PhysicalDevice> phys_devs = this->instance_.enumeratePhysicalDevices();
+  std::vector<vk::PhysicalDevice> phys_devs =
+      VULKAN_CALL(this->instance_.enumeratePhysicalDevices()).value();
 
   // Check if no devices could be found
   if (phys_devs.size() == 0)
     throw std::runtime_error("Unable to find Vulkan compatible device");
-  std::cout << "Found " << phys_devs.size() << " Vulkan compatible device(s)" << std::endl;
+  LOG_INFO("Found {} Vulkan compatible device(s)", phys_devs.size());
 
   // Iterate through all physical devices and find first suitable one
   auto phys_dev = std::find_if(phys_devs.cbegin(), phys_devs.cend(), [&](auto& phys_dev) {
@@ -221,8 +1655,7 @@ void Application::initPhysicalDevice()
     throw std::runtime_error("Unable to find Vulkan compatible discrete GPU");
 
   this->physical_device_ = *phys_dev;
-  std::cout << "Device selected: " << this->physical_device_.getProperties().deviceName
-            << std::endl;
+  LOG_INFO("Device selected: {}", this->physical_device_.getProperties().deviceName.data());
 }
 
 void Application::initQueueFamilies()
@@ -238,9 +1671,9 @@ void Application::initQueueFamilies()
 
   // Check if optional queues exist
   if (!this->queue_family_indices_.transfer.has_value())
-    std::cerr << "Could not find a transfer queue for selected device" << std::endl;
+    LOG_WARNING("Could not find a transfer queue for selected device");
   if (!this->queue_family_indices_.compute.has_value())
-    std::cerr << "Could not find a compute queue for selected device" << std::endl;
+    LOG_WARNING("Could not find a compute queue for selected device");
 }
 
 void Application::initDevice()
@@ -251,21 +1684,71 @@ void Application::initDevice()
                                         this->queue_family_indices_.compute.value(),
                                         this->queue_family_indices_.present.value() };
 
+  // A present thread needs a present queue of its own, as queues are externally synchronised. If
+  // the present family is the graphics family that is its second queue, where it has one.
+  uint32_t graphics_family     = this->queue_family_indices_.graphics.value();
+  uint32_t present_family      = this->queue_family_indices_.present.value();
+  uint32_t present_queue_index = 0;
+  if (this->options_.present_thread && present_family == graphics_family &&
+      this->physical_device_.getQueueFamilyProperties().at(present_family).queueCount > 1)
+    present_queue_index = 1;
+  this->dedicated_present_queue_ = present_family != graphics_family || present_queue_index > 0;
+
   // Prepare to create queues for all indices
   std::vector<vk::DeviceQueueCreateInfo> queue_create_infos = {};
-  float queue_priority                                      = 1.0f;
-  uint32_t queue_count                                      = 1;
+  std::array<float, 2> queue_priorities                     = { 1.0f, 1.0f };
   for (auto& queue_family : queue_family_set)
   {
+    uint32_t queue_count = queue_family == present_family ? present_queue_index + 1 : 1;
     vk::DeviceQueueCreateInfo queue_create_info(vk::DeviceQueueCreateFlags {},
                                                 queue_family,
                                                 queue_count,
-                                                &queue_priority);
+                                                queue_priorities.data());
     queue_create_infos.push_back(queue_create_info);
   }
 
-  // Prepare enabled physical device features
+  // Enable the required extensions and any optional extensions the device supports
+  this->enabled_device_extensions_ = this->required_device_extensions_;
+  std::vector<vk::ExtensionProperties> pdev_exts =
+      VULKAN_CALL(this->physical_device_.enumerateDeviceExtensionProperties()).value();
+  for (const char* optional_extension : this->optional_device_extensions_)
+  {
+    auto supported = std::any_of(pdev_exts.cbegin(), pdev_exts.cend(), [&](const auto& pdev_ext) {
+      return std::strcmp(pdev_ext.extensionName, optional_extension) == 0;
+    });
+    if (supported)
+      this->enabled_device_extensions_.push_back(optional_extension);
+  }
+
+  // Prepare enabled physical device features, conditional rendering and swapchain maintenance
+  // are extension features and go in the create info's chain, each only if its extension is
+  // enabled as a structure of a disabled extension must not be chained
   vk::PhysicalDeviceFeatures requested_device_features = {};
+  vk::PhysicalDeviceConditionalRenderingFeaturesEXT conditional_rendering_features;
+  vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT swapchain_maintenance_features;
+  void* feature_chain = nullptr;
+  if (this->isDeviceExtensionEnabled("VK_EXT_conditional_rendering"))
+  {
+    auto features = this->physical_device_.getFeatures2<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceConditionalRenderingFeaturesEXT>();
+    this->conditional_rendering_ =
+        features.get<vk::PhysicalDeviceConditionalRenderingFeaturesEXT>().conditionalRendering;
+    conditional_rendering_features.setConditionalRendering(this->conditional_rendering_)
+        .setPNext(feature_chain);
+    feature_chain = &conditional_rendering_features;
+  }
+  if (this->isDeviceExtensionEnabled("VK_EXT_swapchain_maintenance1"))
+  {
+    auto features = this->physical_device_.getFeatures2<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>();
+    this->swapchain_maintenance_ =
+        features.get<vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>().swapchainMaintenance1;
+    swapchain_maintenance_features.setSwapchainMaintenance1(this->swapchain_maintenance_)
+        .setPNext(feature_chain);
+    feature_chain = &swapchain_maintenance_features;
+  }
 
   // Prepare the logical device create structure
   vk::DeviceCreateInfo create_info(vk::DeviceCreateFlags {},
@@ -273,17 +1756,65 @@ void Application::initDevice()
                                    queue_create_infos.data(),
                                    static_cast<uint32_t>(this->required_device_layers_.size()),
                                    this->required_device_layers_.data(),
-                                   static_cast<uint32_t>(this->required_device_extensions_.size()),
-                                   this->required_device_extensions_.data(),
+                                   static_cast<uint32_t>(this->enabled_device_extensions_.size()),
+                                   this->enabled_device_extensions_.data(),
                                    &requested_device_features);
+  create_info.setPNext(feature_chain);
 
-  this->device_ = this->physical_device_.createDevice(create_info);
+  this->device_ = VULKAN_CALL(this->physical_device_.createDevice(create_info)).value();
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(this->device_);
 
   // Get the first queue for each type of queue
   queues_.graphics = this->device_.getQueue(queue_family_indices_.graphics.value(), 0);
   queues_.transfer = this->device_.getQueue(queue_family_indices_.transfer.value(), 0);
   queues_.compute  = this->device_.getQueue(queue_family_indices_.compute.value(), 0);
-  queues_.present  = this->device_.getQueue(queue_family_indices_.present.value(), 0);
+  queues_.present  = this->device_.getQueue(present_family, present_queue_index);
+}
+
+void Application::initMetrics()
+{
+  if (this->options_.metrics_file.empty())
+    return;
+  uint32_t interval  = std::max(this->options_.metrics_interval, 1u);
+  bool memory_budget = this->isDeviceExtensionEnabled("VK_EXT_memory_budget");
+  this->metrics_     = std::make_unique<MetricsExporter>(this->options_.metrics_file,
+                                                         std::chrono::seconds(interval),
+                                                         this->physical_device_,
+                                                         memory_budget);
+  LOG_INFO("Writing metrics to {} every {} s, device memory budgets {}",
+           this->options_.metrics_file,
+           interval,
+           memory_budget ? "included" : "unavailable");
+}
+
+void Application::initProfiler()
+{
+  this->gpu_profiler_ = std::make_unique<GpuProfiler>(this->physical_device_,
+                                                      this->device_,
+                                                      this->queue_family_indices_.graphics.value(),
+                                                      this->max_frames_in_flight_);
+  if (this->options_.stutter_threshold <= 0.0f)
+    return;
+  this->stutter_monitor_ = std::make_unique<StutterMonitor>(this->options_.stutter_trace_prefix,
+                                                            this->options_.stutter_threshold);
+  LOG_INFO("Writing traces of frames over {} times the median to {}-<frame>.json, GPU zones {}",
+           this->options_.stutter_threshold,
+           this->options_.stutter_trace_prefix,
+           this->gpu_profiler_->enabled() ? "included" : "unavailable");
+}
+
+void Application::initPresenter()
+{
+  if (!this->options_.present_thread)
+    return;
+  if (!this->dedicated_present_queue_)
+  {
+    LOG_WARNING("The graphics family presents and has a single queue, presenting on the render "
+                "thread");
+    return;
+  }
+  this->presenter_ = std::make_unique<Presenter>(this->device_, this->queues_.present);
+  LOG_INFO("Presenting on a present thread");
 }
 
 void Application::initSwapchain()
@@ -291,11 +1822,16 @@ void Application::initSwapchain()
   SwapchainSupportDetails swapchain_support =
       this->querySwapchainSupportDetails(this->physical_device_);
 
-  vk::SurfaceFormatKHR surface_format = chooseSwapSurfaceFormat(swapchain_support.formats);
-  vk::PresentModeKHR present_mode     = chooseSwapPresentMode(swapchain_support.present_modes);
+  vk::SurfaceFormatKHR surface_format =
+      chooseSurfaceFormat(swapchain_support.formats, this->options_.hdr);
+  vk::PresentModeKHR present_mode     =
+      chooseSwapPresentMode(swapchain_support.present_modes, this->present_vsync_);
   vk::Extent2D extent                 = chooseSwapExtent(swapchain_support.capabilities);
 
-  uint32_t image_count  = swapchain_support.capabilities.minImageCount + 1;
+  // Presenting on the present thread holds an image acquired ahead for every frame in flight, so
+  // there are enough images that those acquires never wait on a present still queued
+  uint32_t image_count  = swapchain_support.capabilities.minImageCount +
+                         (this->presenter_ ? max_frames_in_flight_ : 1);
   uint32_t image_layers = 1;
 
   // Ensure that image_count is no higher than our maximum image count
@@ -336,10 +1872,46 @@ void Application::initSwapchain()
       .setClipped(VK_TRUE)
       .setOldSwapchain(nullptr);
 
-  this->swapchain_        = this->device_.createSwapchainKHR(create_info);
-  this->swapchain_images_ = this->device_.getSwapchainImagesKHR(this->swapchain_);
-  this->swapchain_format_ = surface_format.format;
-  this->swapchain_extent_ = extent;
+  // With swapchain maintenance the swapchain is created for all the modes it can switch to
+  this->swapchain_present_modes_ = { present_mode };
+  vk::SwapchainPresentModesCreateInfoEXT present_modes_info;
+  if (this->swapchain_maintenance_)
+  {
+    this->swapchain_present_modes_ = this->queryCompatiblePresentModes(present_mode);
+    present_modes_info.setPresentModes(this->swapchain_present_modes_);
+    create_info.setPNext(&present_modes_info);
+  }
+
+  this->swapchain_             = VULKAN_CALL(this->device_.createSwapchainKHR(create_info)).value();
+  this->swapchain_format_      = surface_format.format;
+  this->swapchain_color_space_ = surface_format.colorSpace;
+  this->swapchain_extent_      = extent;
+  this->present_mode_          = present_mode;
+  LOG_INFO("Presenting in {}, switchable to {} present modes without recreating the swapchain",
+           vk::to_string(present_mode),
+           this->swapchain_present_modes_.size() - 1);
+  LOG_INFO("Swapchain format {} in {}, {} bytes per pixel",
+           vk::to_string(surface_format.format),
+           vk::to_string(surface_format.colorSpace),
+           formatBytesPerPixel(surface_format.format));
+  if (this->options_.hdr && !isPqColorSpace(surface_format.colorSpace) &&
+      surface_format.colorSpace != vk::ColorSpaceKHR::eExtendedSrgbLinearEXT)
+    LOG_WARNING("The display offers no HDR10 or scRGB swapchain, presenting in SDR");
+
+  // Track the swapchain images as engine images, their views are created separately
+  std::vector<vk::Image> images =
+      VULKAN_CALL(this->device_.getSwapchainImagesKHR(this->swapchain_)).value();
+  for (auto& image : images)
+  {
+    Image swapchain_image;
+    swapchain_image.image  = image;
+    swapchain_image.format = surface_format.format;
+    swapchain_image.extent = extent;
+    swapchain_image.usage  = create_info.imageUsage;
+    this->swapchain_images_.push_back(this->images_.insert(swapchain_image));
+  }
+  this->swapchain_acquire_limit_ =
+      static_cast<uint32_t>(images.size()) - swapchain_support.capabilities.minImageCount;
 }
 
 void Application::initSwapchainImageViews()
@@ -360,110 +1932,1059 @@ void Application::initSwapchainImageViews()
       .setLayerCount(1);
 
   // Interate through all swapchain images
-  for (auto& swapchain_image : this->swapchain_images_)
+  for (auto& swapchain_image_handle : this->swapchain_images_)
   {
+    Image& swapchain_image = this->images_.at(swapchain_image_handle);
+
     // Prepare the image view create info
     vk::ImageViewCreateInfo create_info;
     create_info.setFlags(vk::ImageViewCreateFlags {})
-        .setImage(swapchain_image)
+        .setImage(swapchain_image.image)
         .setViewType(vk::ImageViewType::e2D)
         .setFormat(this->swapchain_format_)
         .setComponents(component_map)
         .setSubresourceRange(subresource_range);
 
-    // Create the image view and push it into the swapchain image views vector
-    vk::ImageView image_view = this->device_.createImageView(create_info);
-    this->swapchain_image_views_.push_back(image_view);
+    // Create the image view for the swapchain image
+    swapchain_image.view = VULKAN_CALL(this->device_.createImageView(create_info)).value();
   }
 }
 
+void Application::initRenderPass()
+{
+  // Single colour attachment that is cleared and then handed to the presentation engine
+  RenderPassDesc& desc = this->render_pass_desc_;
+  desc.color_attachment.setFormat(this->swapchain_format_)
+      .setSamples(vk::SampleCountFlagBits::e1)
+      .setLoadOp(vk::AttachmentLoadOp::eClear)
+      .setStoreOp(vk::AttachmentStoreOp::eStore)
+      .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+      .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+      .setInitialLayout(vk::ImageLayout::eUndefined)
+      .setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
+
+  // Wait for the acquired image to be released by the presentation engine before writing to it
+  vk::SubpassDependency dependency;
+  dependency.setSrcSubpass(VK_SUBPASS_EXTERNAL)
+      .setDstSubpass(0)
+      .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput)
+      .setSrcAccessMask(vk::AccessFlags {})
+      .setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput)
+      .setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite);
+  desc.dependencies = { dependency };
+
+  this->render_pass_ = buildRenderPass(this->device_, desc);
+}
+
 void Application::initGraphicsPipeline()
 {
-  // Load SPIR-V code from file into memory
-  auto vert_shader_code = this->readFile("vert.spv");
-  auto frag_shader_code = this->readFile("frag.spv");
+  // The per-draw uniforms are bound at set 0, binding 0
+  vk::DescriptorSetLayoutBinding draw_uniforms_binding;
+  draw_uniforms_binding.setBinding(0)
+      .setDescriptorType(vk::DescriptorType::eUniformBuffer)
+      .setDescriptorCount(1)
+      .setStageFlags(vk::ShaderStageFlagBits::eVertex);
+  std::vector<vk::DescriptorSetLayoutBinding> draw_bindings = { draw_uniforms_binding };
+  this->draw_descriptors_ = std::make_unique<DescriptorBinder>(this->device_,
+                                                               vk::PipelineBindPoint::eGraphics,
+                                                               draw_bindings,
+                                                               this->queryMaxPushDescriptors(),
+                                                               max_frames_in_flight_);
+
+  // The triangle's vertices are generated in the vertex shader, so it has no vertex input
+  GraphicsPipelineDesc triangle_desc;
+  triangle_desc.vertex_shader   = "Shader/shader.vert.spv";
+  triangle_desc.fragment_shader = "Shader/shader.frag.spv";
+  triangle_desc.set_layouts     = { this->draw_descriptors_->getSetLayout() };
+  triangle_desc.pq_output       = isPqColorSpace(this->swapchain_color_space_);
+  PipelineHandle triangle_pipeline = this->createGraphicsPipeline(triangle_desc);
+  this->named_pipelines_["triangle"_sid] = triangle_pipeline;
+
+  // The triangle's occlusion proxy is the triangle itself, rasterized without writing colour
+  GraphicsPipelineDesc proxy_desc = triangle_desc;
+  proxy_desc.color_write          = false;
+  PipelineHandle proxy_pipeline   = this->createGraphicsPipeline(proxy_desc);
+
+  this->named_pipelines_["triangle_proxy"_sid]      = proxy_pipeline;
+  this->occlusion_proxies_[triangle_pipeline.value] = proxy_pipeline;
+
+  // Hand the pipeline layout to the binder to create its update template
+  this->draw_descriptors_->setPipelineLayout(this->pipelines_.at(triangle_pipeline).layout, 0);
+
+  Mesh triangle_mesh;
+  triangle_mesh.vertex_count = 3;
+  this->named_meshes_["triangle"_sid] = this->meshes_.insert(triangle_mesh);
+}
 
-  // Create Vulkan shader modules from loaded SPIR-V code
-  vk::ShaderModule vert_shader_module = this->createShaderModule(vert_shader_code);
-  vk::ShaderModule frag_shader_module = this->createShaderModule(frag_shader_code);
+void Application::initFramebuffers()
+{
+  for (auto& swapchain_image : this->swapchain_images_)
+  {
+    vk::FramebufferCreateInfo create_info;
+    create_info.setRenderPass(this->render_pass_)
+        .setAttachments(this->images_.at(swapchain_image).view)
+        .setWidth(this->swapchain_extent_.width)
+        .setHeight(this->swapchain_extent_.height)
+        .setLayers(1);
+    vk::Framebuffer framebuffer = VULKAN_CALL(this->device_.createFramebuffer(create_info)).value();
+    this->swapchain_framebuffers_.push_back(framebuffer);
+  }
+}
 
-  // Prepare the vertex shader stage create info
-  vk::PipelineShaderStageCreateInfo vert_shader_stage_ci;
-  vert_shader_stage_ci.setStage(vk::ShaderStageFlagBits::eVertex)
-      .setModule(vert_shader_module)
-      .setPName("main");
+void Application::initCommandBuffers()
+{
+  // Command buffers are reset individually every time their frame is recorded
+  vk::CommandPoolCreateInfo pool_create_info;
+  pool_create_info.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+      .setQueueFamilyIndex(this->queue_family_indices_.graphics.value());
+  this->command_pool_ = VULKAN_CALL(this->device_.createCommandPool(pool_create_info)).value();
+
+  vk::CommandBufferAllocateInfo allocate_info;
+  allocate_info.setCommandPool(this->command_pool_)
+      .setLevel(vk::CommandBufferLevel::ePrimary)
+      .setCommandBufferCount(max_frames_in_flight_);
+  auto command_buffers = VULKAN_CALL(this->device_.allocateCommandBuffers(allocate_info)).value();
+  for (uint32_t i = 0; i < max_frames_in_flight_; i++)
+    this->frames_.at(i).command_buffer = command_buffers.at(i);
+}
 
-  // Prepare the fragment shader stage create info
-  vk::PipelineShaderStageCreateInfo frag_shader_stage_ci;
-  frag_shader_stage_ci.setStage(vk::ShaderStageFlagBits::eFragment)
-      .setModule(frag_shader_module)
-      .setPName("main");
+void Application::initSyncObjects()
+{
+  // Fences start signalled so the first wait on each frame returns immediately
+  vk::FenceCreateInfo fence_create_info(vk::FenceCreateFlagBits::eSignaled);
+  for (auto& frame : this->frames_)
+  {
+    vk::SemaphoreCreateInfo semaphore_ci;
+    frame.image_available = VULKAN_CALL(this->device_.createSemaphore(semaphore_ci)).value();
+    frame.render_finished = VULKAN_CALL(this->device_.createSemaphore(semaphore_ci)).value();
+    frame.in_flight       = VULKAN_CALL(this->device_.createFence(fence_create_info)).value();
+    frame.present_fence   = VULKAN_CALL(this->device_.createFence(fence_create_info)).value();
+  }
+}
 
-  // Collate shader stages create informations
-  std::vector<vk::PipelineShaderStageCreateInfo> shader_stages = { vert_shader_stage_ci,
-                                                                   frag_shader_stage_ci };
+void Application::initUniformBuffers()
+{
+  // Round the per-draw stride up to the device uniform buffer offset alignment
+  vk::DeviceSize alignment =
+      this->physical_device_.getProperties().limits.minUniformBufferOffsetAlignment;
+  this->draw_uniforms_stride_ = (sizeof(DrawUniforms) + alignment - 1) & ~(alignment - 1);
 
-  vk::PipelineVertexInputStateCreateInfo vert_input_state_ci;
-  vert_input_state_ci.setVertexAttributeDescriptionCount(0).setVertexBindingDescriptionCount(0);
+  // Each frame gets a persistently mapped, host coherent buffer
+  for (auto& frame : this->frames_)
+  {
+    frame.uniform_buffer = this->createBuffer(this->draw_uniforms_stride_ * max_draws_per_frame_,
+                                              vk::BufferUsageFlagBits::eUniformBuffer,
+                                              vk::MemoryPropertyFlagBits::eHostVisible |
+                                                  vk::MemoryPropertyFlagBits::eHostCoherent);
+  }
+}
 
-  vk::PipelineInputAssemblyStateCreateInfo input_assembly_state_ci;
-  input_assembly_state_ci.setTopology(vk::PrimitiveTopology::eTriangleList)
-      .setPrimitiveRestartEnable(VK_FALSE);
+void Application::initOcclusionCulling()
+{
+  if (!this->options_.occlusion_culling)
+    return;
 
-  vk::Viewport viewport;
-  viewport.setX(0)
-      .setY(0)
+  // Predicates start out non-zero, so every draw is drawn until it has been measured
+  vk::Buffer predicates;
+  if (this->conditional_rendering_)
+  {
+    vk::DeviceSize size         = max_draws_per_frame_ * sizeof(uint32_t);
+    this->occlusion_predicates_ = this->createBuffer(
+        size,
+        vk::BufferUsageFlagBits::eConditionalRenderingEXT | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+    const Buffer& buffer = this->buffers_.at(this->occlusion_predicates_);
+    std::fill_n(static_cast<uint32_t*>(buffer.mapped), max_draws_per_frame_, 1u);
+    predicates = buffer.buffer;
+  }
+  this->occlusion_culler_ = std::make_unique<OcclusionCuller>(
+      this->device_, max_frames_in_flight_, max_draws_per_frame_, predicates);
+  LOG_INFO("Occlusion culling draws with {}",
+           this->conditional_rendering_ ? "conditional rendering"
+                                        : "query results read back after each frame");
+}
+
+void Application::initSpriteImages()
+{
+  // Shapes with a one texel soft edge, white so that every instance can tint them
+  constexpr uint32_t sprite_size = 32;
+  constexpr float radius         = sprite_size / 2.0f - 1.0f;
+
+  auto add_shape = [&](StringId name, auto signed_distance) {
+    std::vector<uint32_t> texels(sprite_size * sprite_size);
+    for (uint32_t y = 0; y < sprite_size; y++)
+    {
+      for (uint32_t x = 0; x < sprite_size; x++)
+      {
+        float distance = signed_distance(x + 0.5f - sprite_size / 2.0f,
+                                         y + 0.5f - sprite_size / 2.0f);
+        float alpha    = std::clamp(0.5f - distance, 0.0f, 1.0f);
+        texels[y * sprite_size + x] =
+            0x00FFFFFFu | (static_cast<uint32_t>(alpha * 255.0f + 0.5f) << 24);
+      }
+    }
+    this->named_sprites_[name] = this->sprite_atlas_.add(sprite_size, sprite_size, texels.data());
+  };
+
+  // Signed distances from the edge of each shape in texels, negative inside
+  add_shape("circle"_sid, [&](float x, float y) { return std::hypot(x, y) - radius; });
+  add_shape("ring"_sid, [&](float x, float y) {
+    return std::abs(std::hypot(x, y) - 0.75f * radius) - 0.25f * radius;
+  });
+  add_shape("square"_sid,
+            [&](float x, float y) { return std::max(std::abs(x), std::abs(y)) - radius; });
+  add_shape("diamond"_sid,
+            [&](float x, float y) { return (std::abs(x) + std::abs(y) - radius) * 0.7071f; });
+
+  // Opaque everywhere, tinted and stretched into the rectangles of the UI
+  add_shape("solid"_sid, [&](float, float) { return -1.0f; });
+
+  LOG_INFO("Sprite atlas: {} sprites in {} pages of {}x{} texels",
+           this->named_sprites_.size(),
+           this->sprite_atlas_.pageCount(),
+           this->sprite_atlas_.pageSize(),
+           this->sprite_atlas_.pageSize());
+}
+
+void Application::initSpriteRenderer()
+{
+  // Every quad uses the same six indices relative to its first vertex, so one device local index
+  // buffer serves all frames, sprites and text alike. It is uploaded along with the atlas pages.
+  vk::DeviceSize index_bytes = vk::DeviceSize(max_sprites_per_frame_) * 6 * sizeof(uint32_t);
+  BufferHandle index_staging = this->createBuffer(index_bytes,
+                                                  vk::BufferUsageFlagBits::eTransferSrc,
+                                                  vk::MemoryPropertyFlagBits::eHostVisible |
+                                                      vk::MemoryPropertyFlagBits::eHostCoherent);
+  auto* indices = static_cast<uint32_t*>(this->buffers_.at(index_staging).mapped);
+  for (uint32_t quad = 0; quad < max_sprites_per_frame_; quad++)
+  {
+    const uint32_t quad_indices[6] = { 0, 1, 2, 2, 3, 0 };
+    for (uint32_t i = 0; i < 6; i++)
+      indices[quad * 6 + i] = quad * 4 + quad_indices[i];
+  }
+  this->quad_index_buffer_ = this->createBuffer(index_bytes,
+                                                vk::BufferUsageFlagBits::eIndexBuffer |
+                                                    vk::BufferUsageFlagBits::eTransferDst |
+                                                    vk::BufferUsageFlagBits::eTransferSrc,
+                                                vk::MemoryPropertyFlagBits::eDeviceLocal);
+  std::vector<BufferHandle> staging_buffers = { index_staging };
+
+  vk::CommandBuffer upload_commands = this->beginOneTimeCommands();
+  const Buffer& index_buffer = this->buffers_.at(this->quad_index_buffer_);
+  upload_commands.copyBuffer(this->buffers_.at(index_staging).buffer,
+                             index_buffer.buffer,
+                             vk::BufferCopy(0, 0, index_bytes));
+  vk::BufferMemoryBarrier index_barrier;
+  index_barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eIndexRead)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setBuffer(index_buffer.buffer)
+      .setSize(VK_WHOLE_SIZE);
+  upload_commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eVertexInput,
+                                  {},
+                                  nullptr,
+                                  index_barrier,
+                                  nullptr);
+
+  // Copy every atlas page into a device local image, the atlas does not change afterwards
+  uint32_t page_size        = this->sprite_atlas_.pageSize();
+  vk::DeviceSize page_bytes = vk::DeviceSize(page_size) * page_size * sizeof(uint32_t);
+  vk::ImageSubresourceRange color_range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+  for (size_t page = 0; page < this->sprite_atlas_.pageCount(); page++)
+  {
+    BufferHandle staging = this->createBuffer(page_bytes,
+                                              vk::BufferUsageFlagBits::eTransferSrc,
+                                              vk::MemoryPropertyFlagBits::eHostVisible |
+                                                  vk::MemoryPropertyFlagBits::eHostCoherent);
+    std::memcpy(this->buffers_.at(staging).mapped,
+                this->sprite_atlas_.pageTexels(page).data(),
+                page_bytes);
+    staging_buffers.push_back(staging);
+
+    // Transfer source so that frame captures can read the page back
+    ImageHandle page_image = this->createImage({ page_size, page_size },
+                                               vk::Format::eR8G8B8A8Srgb,
+                                               vk::ImageUsageFlagBits::eSampled |
+                                                   vk::ImageUsageFlagBits::eTransferDst |
+                                                   vk::ImageUsageFlagBits::eTransferSrc);
+    this->sprite_atlas_images_.push_back(page_image);
+
+    vk::ImageMemoryBarrier to_transfer;
+    to_transfer.setSrcAccessMask({})
+        .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+        .setOldLayout(vk::ImageLayout::eUndefined)
+        .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+        .setImage(this->images_.at(page_image).image)
+        .setSubresourceRange(color_range);
+    upload_commands.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                    vk::PipelineStageFlagBits::eTransfer,
+                                    {},
+                                    nullptr,
+                                    nullptr,
+                                    to_transfer);
+
+    vk::BufferImageCopy region;
+    region.setImageSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1))
+        .setImageExtent(vk::Extent3D(page_size, page_size, 1));
+    upload_commands.copyBufferToImage(this->buffers_.at(staging).buffer,
+                                      this->images_.at(page_image).image,
+                                      vk::ImageLayout::eTransferDstOptimal,
+                                      region);
+
+    vk::ImageMemoryBarrier to_shader = to_transfer;
+    to_shader.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+        .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+        .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    upload_commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                    vk::PipelineStageFlagBits::eFragmentShader,
+                                    {},
+                                    nullptr,
+                                    nullptr,
+                                    to_shader);
+  }
+
+  // Initialisation waits for the upload, then the staging memory is released
+  this->submitOneTimeCommands(upload_commands);
+  for (auto staging : staging_buffers)
+    this->destroyBuffer(staging);
+
+  // Pages are sampled without mipmaps, the padding around each sprite keeps filtering inside it
+  this->sprite_sampler_ci_.setMagFilter(vk::Filter::eLinear)
+      .setMinFilter(vk::Filter::eLinear)
+      .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+      .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+      .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+      .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+      .setMaxLod(0.0f);
+  this->sprite_sampler_ =
+      VULKAN_CALL(this->device_.createSampler(this->sprite_sampler_ci_)).value();
+
+  // The atlas page of each batch is bound at set 0, binding 0
+  vk::DescriptorSetLayoutBinding atlas_binding;
+  atlas_binding.setBinding(0)
+      .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+      .setDescriptorCount(1)
+      .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+  std::vector<vk::DescriptorSetLayoutBinding> sprite_bindings = { atlas_binding };
+  this->sprite_descriptors_ = std::make_unique<DescriptorBinder>(this->device_,
+                                                                 vk::PipelineBindPoint::eGraphics,
+                                                                 sprite_bindings,
+                                                                 this->queryMaxPushDescriptors(),
+                                                                 max_frames_in_flight_);
+
+  GraphicsPipelineDesc sprite_desc;
+  sprite_desc.vertex_shader   = "Shader/sprite.vert.spv";
+  sprite_desc.fragment_shader = "Shader/sprite.frag.spv";
+  sprite_desc.vertex_bindings = {
+    vk::VertexInputBindingDescription(0, sizeof(SpriteVertex), vk::VertexInputRate::eVertex)
+  };
+  sprite_desc.vertex_attributes = {
+    { 0, 0, vk::Format::eR32G32Sfloat, offsetof(SpriteVertex, position) },
+    { 1, 0, vk::Format::eR32G32Sfloat, offsetof(SpriteVertex, uv) },
+    { 2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(SpriteVertex, color) },
+  };
+  sprite_desc.set_layouts = { this->sprite_descriptors_->getSetLayout() };
+  sprite_desc.push_constant_ranges = {
+    vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, 2 * sizeof(float))
+  };
+  sprite_desc.cull_mode   = vk::CullModeFlagBits::eNone;
+  sprite_desc.alpha_blend = true;
+  sprite_desc.pq_output   = isPqColorSpace(this->swapchain_color_space_);
+  PipelineHandle sprite_pipeline       = this->createGraphicsPipeline(sprite_desc);
+  this->named_pipelines_["sprite"_sid] = sprite_pipeline;
+  this->sprite_pipeline_               = sprite_pipeline;
+  this->sprite_descriptors_->setPipelineLayout(this->pipelines_.at(sprite_pipeline).layout, 0);
+
+  // Each frame writes its quads straight into its own persistently mapped vertex buffer
+  for (auto& frame : this->frames_)
+  {
+    frame.sprite_vertex_buffer =
+        this->createBuffer(vk::DeviceSize(max_sprites_per_frame_) * 4 * sizeof(SpriteVertex),
+                           vk::BufferUsageFlagBits::eVertexBuffer,
+                           vk::MemoryPropertyFlagBits::eHostVisible |
+                               vk::MemoryPropertyFlagBits::eHostCoherent);
+  }
+}
+
+void Application::initTextRenderer()
+{
+  if (this->options_.font_file.empty())
+  {
+    LOG_INFO("No font given with --font, text is disabled");
+    return;
+  }
+
+  // A font that fails to load disables text rather than the engine
+  try
+  {
+    TrueTypeFont font    = syncWait(this->loadFont(this->options_.font_file));
+    this->text_renderer_ = std::make_unique<TextRenderer>(*this->scheduler_,
+                                                          std::move(font),
+                                                          glyph_atlas_page_size_,
+                                                          glyph_atlas_page_count_,
+                                                          max_glyph_uploads_per_frame_);
+  } catch (const std::exception& error)
+  {
+    LOG_ERROR("Failed to load font {}: {}", this->options_.font_file, error.what());
+    return;
+  }
+
+  // Distance fields are linear data, each cache page is a layer so one view samples them all
+  this->glyph_atlas_image_ =
+      this->createImage({ glyph_atlas_page_size_, glyph_atlas_page_size_ },
+                        vk::Format::eR8G8B8A8Unorm,
+                        vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst |
+                            vk::ImageUsageFlagBits::eTransferSrc,
+                        glyph_atlas_page_count_,
+                        vk::ImageViewType::e2DArray);
+
+  // Clear the atlas and leave it in the layout recordGlyphUploads expects
+  vk::CommandBuffer clear_commands = this->beginOneTimeCommands();
+  vk::ImageSubresourceRange atlas_range(
+      vk::ImageAspectFlagBits::eColor, 0, 1, 0, glyph_atlas_page_count_);
+  vk::ImageMemoryBarrier to_transfer;
+  to_transfer.setSrcAccessMask({})
+      .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setOldLayout(vk::ImageLayout::eUndefined)
+      .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setImage(this->images_.at(this->glyph_atlas_image_).image)
+      .setSubresourceRange(atlas_range);
+  clear_commands.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                 vk::PipelineStageFlagBits::eTransfer,
+                                 {},
+                                 nullptr,
+                                 nullptr,
+                                 to_transfer);
+  vk::ClearColorValue transparent(std::array<float, 4> { 0.0f, 0.0f, 0.0f, 0.0f });
+  clear_commands.clearColorImage(this->images_.at(this->glyph_atlas_image_).image,
+                                 vk::ImageLayout::eTransferDstOptimal,
+                                 transparent,
+                                 atlas_range);
+  vk::ImageMemoryBarrier to_shader = to_transfer;
+  to_shader.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+      .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+  clear_commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                 vk::PipelineStageFlagBits::eFragmentShader,
+                                 {},
+                                 nullptr,
+                                 nullptr,
+                                 to_shader);
+  this->submitOneTimeCommands(clear_commands);
+
+  // The glyph atlas is bound at set 0, binding 0
+  vk::DescriptorSetLayoutBinding atlas_binding;
+  atlas_binding.setBinding(0)
+      .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+      .setDescriptorCount(1)
+      .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+  std::vector<vk::DescriptorSetLayoutBinding> text_bindings = { atlas_binding };
+  this->text_descriptors_ = std::make_unique<DescriptorBinder>(this->device_,
+                                                               vk::PipelineBindPoint::eGraphics,
+                                                               text_bindings,
+                                                               this->queryMaxPushDescriptors(),
+                                                               max_frames_in_flight_);
+
+  GraphicsPipelineDesc text_desc;
+  text_desc.vertex_shader   = "Shader/text.vert.spv";
+  text_desc.fragment_shader = "Shader/text.frag.spv";
+  text_desc.vertex_bindings = {
+    vk::VertexInputBindingDescription(0, sizeof(TextVertex), vk::VertexInputRate::eVertex)
+  };
+  text_desc.vertex_attributes = {
+    { 0, 0, vk::Format::eR32G32Sfloat, offsetof(TextVertex, position) },
+    { 1, 0, vk::Format::eR32G32Sfloat, offsetof(TextVertex, uv) },
+    { 2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(TextVertex, color) },
+    { 3, 0, vk::Format::eR32Uint, offsetof(TextVertex, page) },
+  };
+  text_desc.set_layouts          = { this->text_descriptors_->getSetLayout() };
+  text_desc.push_constant_ranges = { vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex |
+                                                               vk::ShaderStageFlagBits::eFragment,
+                                                           0,
+                                                           4 * sizeof(float)) };
+  text_desc.cull_mode            = vk::CullModeFlagBits::eNone;
+  text_desc.alpha_blend          = true;
+  text_desc.pq_output            = isPqColorSpace(this->swapchain_color_space_);
+  PipelineHandle text_pipeline       = this->createGraphicsPipeline(text_desc);
+  this->named_pipelines_["text"_sid] = text_pipeline;
+  this->text_pipeline_               = text_pipeline;
+  this->text_descriptors_->setPipelineLayout(this->pipelines_.at(text_pipeline).layout, 0);
+
+  // Each frame writes its glyph quads and the cells it uploads into its own mapped buffers
+  constexpr vk::DeviceSize cell_bytes =
+      TextRenderer::cell_size_ * TextRenderer::cell_size_ * sizeof(uint32_t);
+  for (auto& frame : this->frames_)
+  {
+    frame.text_vertex_buffer =
+        this->createBuffer(vk::DeviceSize(max_glyphs_per_frame_) * 4 * sizeof(TextVertex),
+                           vk::BufferUsageFlagBits::eVertexBuffer,
+                           vk::MemoryPropertyFlagBits::eHostVisible |
+                               vk::MemoryPropertyFlagBits::eHostCoherent);
+    frame.glyph_staging_buffer = this->createBuffer(max_glyph_uploads_per_frame_ * cell_bytes,
+                                                    vk::BufferUsageFlagBits::eTransferSrc,
+                                                    vk::MemoryPropertyFlagBits::eHostVisible |
+                                                        vk::MemoryPropertyFlagBits::eHostCoherent);
+  }
+  LOG_INFO("Text enabled with {}, {} glyph atlas layers of {}x{} texels",
+           this->options_.font_file,
+           glyph_atlas_page_count_,
+           glyph_atlas_page_size_,
+           glyph_atlas_page_size_);
+}
+
+void Application::initUiRenderer()
+{
+  // The layer is loaded and stored around every partial redraw and sampled in between, in the
+  // cheapest format holding premultiplied alpha. The swapchain's format is kept when it is as
+  // cheap, so that the sprite and text pipelines of the main pass are compatible with this pass.
+  bool pq_output = isPqColorSpace(this->swapchain_color_space_);
+  IntermediateFormatDesc layer_format_desc;
+  layer_format_desc.alpha = true;
+  layer_format_desc.blend = true;
+  this->ui_layer_format_  = chooseIntermediateFormat(
+      this->physical_device_,
+      layer_format_desc,
+      pq_output ? vk::Format::eUndefined : this->swapchain_format_);
+  RenderPassDesc& desc = this->ui_render_pass_desc_;
+  desc.color_attachment.setFormat(this->ui_layer_format_)
+      .setSamples(vk::SampleCountFlagBits::e1)
+      .setLoadOp(vk::AttachmentLoadOp::eLoad)
+      .setStoreOp(vk::AttachmentStoreOp::eStore)
+      .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+      .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+      .setInitialLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+      .setFinalLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  // Earlier frames finish compositing the layer before it is drawn to, and the redraw finishes
+  // before this frame composites it
+  desc.dependencies.resize(2);
+  desc.dependencies[0]
+      .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+      .setDstSubpass(0)
+      .setSrcStageMask(vk::PipelineStageFlagBits::eFragmentShader)
+      .setSrcAccessMask(vk::AccessFlags {})
+      .setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput)
+      .setDstAccessMask(vk::AccessFlagBits::eColorAttachmentRead |
+                        vk::AccessFlagBits::eColorAttachmentWrite);
+  desc.dependencies[1]
+      .setSrcSubpass(0)
+      .setDstSubpass(VK_SUBPASS_EXTERNAL)
+      .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput)
+      .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+      .setDstStageMask(vk::PipelineStageFlagBits::eFragmentShader)
+      .setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+  this->ui_render_pass_ = buildRenderPass(this->device_, desc);
+
+  // The layer is bound at set 0, binding 0
+  vk::DescriptorSetLayoutBinding layer_binding;
+  layer_binding.setBinding(0)
+      .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+      .setDescriptorCount(1)
+      .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+  std::vector<vk::DescriptorSetLayoutBinding> ui_bindings = { layer_binding };
+  this->ui_descriptors_ = std::make_unique<DescriptorBinder>(this->device_,
+                                                             vk::PipelineBindPoint::eGraphics,
+                                                             ui_bindings,
+                                                             this->queryMaxPushDescriptors(),
+                                                             max_frames_in_flight_);
+
+  // Compositing covers the viewport with one triangle generated in the vertex shader
+  GraphicsPipelineDesc ui_desc;
+  ui_desc.vertex_shader            = "Shader/ui.vert.spv";
+  ui_desc.fragment_shader          = "Shader/ui.frag.spv";
+  ui_desc.set_layouts              = { this->ui_descriptors_->getSetLayout() };
+  ui_desc.cull_mode                = vk::CullModeFlagBits::eNone;
+  ui_desc.alpha_blend              = true;
+  ui_desc.premultiplied_alpha      = true;
+  ui_desc.pq_output                = pq_output;
+  PipelineHandle ui_pipeline       = this->createGraphicsPipeline(ui_desc);
+  this->named_pipelines_["ui"_sid] = ui_pipeline;
+  this->ui_pipeline_               = ui_pipeline;
+  this->ui_descriptors_->setPipelineLayout(this->pipelines_.at(ui_pipeline).layout, 0);
+
+  // Sprites and text drawn into the layer need pipelines of their own when the layer's format
+  // differs from the swapchain's, or when the main pass encodes its output
+  this->ui_sprite_pipeline_ = this->sprite_pipeline_;
+  this->ui_text_pipeline_   = this->text_pipeline_;
+  bool shared_pipelines     = this->ui_layer_format_ == this->swapchain_format_ && !pq_output;
+  if (!shared_pipelines)
+  {
+    GraphicsPipelineDesc sprite_desc = this->pipeline_descs_.at(this->ui_sprite_pipeline_.value);
+    sprite_desc.pq_output            = false;
+
+    // Named like the others, so they are destroyed with them
+    this->ui_sprite_pipeline_ = this->createGraphicsPipeline(sprite_desc, this->ui_render_pass_);
+    this->named_pipelines_.emplace("ui_sprite"_sid, this->ui_sprite_pipeline_);
+  }
+  if (!shared_pipelines && this->ui_text_pipeline_)
+  {
+    GraphicsPipelineDesc text_desc = this->pipeline_descs_.at(this->ui_text_pipeline_.value);
+    text_desc.pq_output            = false;
+
+    this->ui_text_pipeline_ = this->createGraphicsPipeline(text_desc, this->ui_render_pass_);
+    this->named_pipelines_.emplace("ui_text"_sid, this->ui_text_pipeline_);
+  }
+  LOG_INFO("UI layer format {}, {} bytes per pixel, {}",
+           vk::to_string(this->ui_layer_format_),
+           formatBytesPerPixel(this->ui_layer_format_),
+           shared_pipelines ? "sharing the main pass's pipelines" : "with pipelines of its own");
+
+  for (auto& frame : this->frames_)
+  {
+    frame.ui_sprite_vertex_buffer =
+        this->createBuffer(vk::DeviceSize(max_ui_quads_per_frame_) * 4 * sizeof(SpriteVertex),
+                           vk::BufferUsageFlagBits::eVertexBuffer,
+                           vk::MemoryPropertyFlagBits::eHostVisible |
+                               vk::MemoryPropertyFlagBits::eHostCoherent);
+    frame.ui_text_vertex_buffer =
+        this->createBuffer(vk::DeviceSize(max_ui_quads_per_frame_) * 4 * sizeof(TextVertex),
+                           vk::BufferUsageFlagBits::eVertexBuffer,
+                           vk::MemoryPropertyFlagBits::eHostVisible |
+                               vk::MemoryPropertyFlagBits::eHostCoherent);
+  }
+
+  this->initUiLayerImage();
+}
+
+void Application::initUiLayerImage()
+{
+  this->ui_layer_image_ =
+      this->createImage(this->swapchain_extent_,
+                        this->ui_layer_format_,
+                        vk::ImageUsageFlagBits::eColorAttachment |
+                            vk::ImageUsageFlagBits::eSampled |
+                            vk::ImageUsageFlagBits::eTransferDst |
+                            vk::ImageUsageFlagBits::eTransferSrc);
+  const Image& layer = this->images_.at(this->ui_layer_image_);
+
+  // Start out transparent and in the layout the render pass expects
+  vk::CommandBuffer clear_commands = this->beginOneTimeCommands();
+  vk::ImageSubresourceRange layer_range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+  vk::ImageMemoryBarrier to_transfer;
+  to_transfer.setSrcAccessMask({})
+      .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setOldLayout(vk::ImageLayout::eUndefined)
+      .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setImage(layer.image)
+      .setSubresourceRange(layer_range);
+  clear_commands.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                 vk::PipelineStageFlagBits::eTransfer,
+                                 {},
+                                 nullptr,
+                                 nullptr,
+                                 to_transfer);
+  vk::ClearColorValue transparent(std::array<float, 4> { 0.0f, 0.0f, 0.0f, 0.0f });
+  clear_commands.clearColorImage(
+      layer.image, vk::ImageLayout::eTransferDstOptimal, transparent, layer_range);
+  vk::ImageMemoryBarrier to_shader = to_transfer;
+  to_shader.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+      .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+  clear_commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                 vk::PipelineStageFlagBits::eFragmentShader,
+                                 {},
+                                 nullptr,
+                                 nullptr,
+                                 to_shader);
+  this->submitOneTimeCommands(clear_commands);
+
+  vk::FramebufferCreateInfo create_info;
+  create_info.setRenderPass(this->ui_render_pass_)
+      .setAttachments(layer.view)
       .setWidth(this->swapchain_extent_.width)
       .setHeight(this->swapchain_extent_.height)
-      .setMinDepth(0.0f)
-      .setMaxDepth(1.0f);
+      .setLayers(1);
+  this->ui_framebuffer_ = VULKAN_CALL(this->device_.createFramebuffer(create_info)).value();
+}
 
-  vk::Rect2D scissor;
-  scissor.setOffset({ 0, 0 }).setExtent(this->swapchain_extent_);
+void Application::initUi()
+{
+  this->ui_layer_ = std::make_unique<UiLayer>(this->text_renderer_.get(),
+                                              this->named_sprites_.at("solid"_sid));
+
+  // A dashboard in the top right corner, refreshed by updateDashboard
+  constexpr float width  = 240.0f;
+  constexpr float margin = 12.0f;
+  float left             = this->window_width_ - width - margin;
+  float text_left        = left + 10.0f;
+  float text_right       = left + width - 10.0f;
+  this->ui_layer_->addPanel({ left, margin, left + width, margin + 112.0f }, 0xC0202020u);
+  this->ui_layer_->addLabel(text_left, margin + 24.0f, 18.0f, 0xFFFFFFFFu, "Dashboard");
+  this->dashboard_.frame_time_label =
+      this->ui_layer_->addLabel(text_left, margin + 48.0f, 14.0f, 0xFFE0E0E0u, "");
+  this->dashboard_.frame_time_bar = this->ui_layer_->addBar(
+      { text_left, margin + 56.0f, text_right, margin + 62.0f }, 0xFF404040u, 0xFF60D060u, 0.0f);
+  this->dashboard_.sprite_label =
+      this->ui_layer_->addLabel(text_left, margin + 80.0f, 14.0f, 0xFFE0E0E0u, "");
+  this->dashboard_.glyph_label =
+      this->ui_layer_->addLabel(text_left, margin + 100.0f, 14.0f, 0xFFE0E0E0u, "");
+}
 
-  vk::PipelineViewportStateCreateInfo viewport_state_ci;
-  viewport_state_ci.setViewportCount(1).setPViewports(&viewport).setScissorCount(1).setPScissors(
-      &scissor);
+void Application::placeThread(const char* name,
+                              std::thread::native_handle_type thread,
+                              const std::vector<uint32_t>& cpus,
+                              ThreadPriority priority)
+{
+  if (!this->options_.thread_placement)
+    return;
+  if (!cpus.empty() && !setThreadAffinity(thread, cpus))
+    LOG_WARNING("Failed to pin the {} thread", name);
+  if (priority != ThreadPriority::Normal && !setThreadPriority(thread, priority))
+    LOG_DEBUG("Unable to change the {} thread priority, it may need elevated privileges", name);
+}
 
-  vk::PipelineRasterizationStateCreateInfo rasterization_state_ci;
-  rasterization_state_ci.setDepthClampEnable(VK_FALSE)
-      .setRasterizerDiscardEnable(VK_FALSE)
-      .setPolygonMode(vk::PolygonMode::eFill)
-      .setLineWidth(1.0)
-      .setCullMode(vk::CullModeFlagBits::eBack)
-      .setFrontFace(vk::FrontFace::eClockwise)
-      .setDepthBiasEnable(VK_FALSE);
+void Application::initScheduler()
+{
+  this->cpu_topology_ = CpuTopology::detect();
+  LOG_INFO("CPU topology: {} logical CPUs, {} cores, {} L3 domains, {} efficiency CPUs",
+           this->cpu_topology_.cpus().size(),
+           this->cpu_topology_.physicalCoreCount(),
+           this->cpu_topology_.l3DomainCount(),
+           this->cpu_topology_.efficiencyCpuCount());
+#if ENGINE_THREAD_PINNING
+  if (this->options_.thread_placement)
+    this->thread_placement_ = this->cpu_topology_.placeThreads();
+  else
+    LOG_INFO("Thread placement disabled, engine threads are left to the OS scheduler");
+#endif
+
+  // Leave a core for the main thread, hardware_concurrency returns zero when it is unknown. With
+  // dedicated main and render cores there is one worker for every remaining logical CPU.
+  uint32_t worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  if (this->thread_placement_.render_cpu)
+    worker_count = static_cast<uint32_t>(this->thread_placement_.worker_cpus.size());
+  this->scheduler_ = std::make_unique<Scheduler>(worker_count);
+  LOG_INFO("Scheduler started with {} workers", worker_count);
+
+#if ENGINE_THREAD_PINNING
+  for (auto worker : this->scheduler_->workerHandles())
+  {
+    this->placeThread("worker",
+                      worker,
+                      this->thread_placement_.worker_cpus,
+                      ThreadPriority::Normal);
+  }
+  this->placeThread("I/O",
+                    this->scheduler_->ioThreadHandle(),
+                    this->thread_placement_.io_cpus,
+                    ThreadPriority::Low);
+#endif
+}
 
-  vk::PipelineMultisampleStateCreateInfo multisample_state_ci;
-  multisample_state_ci.setSampleShadingEnable(VK_FALSE).setRasterizationSamples(
-      vk::SampleCountFlagBits::e1);
+void Application::initAudio()
+{
+  if (!this->options_.audio)
+    return;
+
+  // A missing audio device disables sound rather than the engine
+  try
+  {
+    this->audio_ = std::make_unique<AudioSystem>(*this->scheduler_);
+  } catch (const std::runtime_error& error)
+  {
+    LOG_WARNING("Failed to open an audio device, audio is disabled: {}", error.what());
+    return;
+  }
 
-  vk::PipelineColorBlendAttachmentState color_blend_attachment_state_ci;
-  color_blend_attachment_state_ci.setColorWriteMask(
-      vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-      vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA)
-  .setBlendEnable(VK_FALSE);
+  // A short decaying tone played whenever a sprite bounces
+  AudioClip bounce;
+  bounce.sample_rate = 48000;
+  bounce.channels    = 1;
+  bounce.frame_count = bounce.sample_rate * 80 / 1000;
+  bounce.samples.resize(bounce.frame_count);
+  for (uint32_t i = 0; i < bounce.frame_count; i++)
+  {
+    float time        = static_cast<float>(i) / static_cast<float>(bounce.sample_rate);
+    bounce.samples[i] = std::sin(6.2831853f * 880.0f * time) * std::exp(-40.0f * time);
+  }
+  this->bounce_clip_ = this->audio_->addClip(std::move(bounce));
 
-  this->device_.destroyShaderModule(frag_shader_module);
-  this->device_.destroyShaderModule(vert_shader_module);
+  if (!this->options_.music_file.empty())
+    this->scheduler_->spawn(this->playMusic(this->options_.music_file));
 }
 
-Application::Application()
+void Application::initEntities()
 {
+  LOG_INFO("World arena: {} MiB backed by {}",
+           this->world_arena_.capacity() / (1024 * 1024),
+           Arena::backingName(this->world_arena_.backing()));
+
+  // Reserve the most entities that can be drawn, the arena never gets reallocated storage back
+  this->entities_.reserve(max_draws_per_frame_);
+
+  if (!this->options_.load_scene_file.empty())
+  {
+    try
+    {
+      this->loadScene(this->options_.load_scene_file);
+      return;
+    } catch (const std::exception& error)
+    {
+      LOG_ERROR("Failed to load scene, generating one instead: {}", error.what());
+      this->entities_.clear();
+      this->sprite_entities_.clear();
+    }
+  }
+
+  // A grid of spinning triangles, each turning at its own rate
+  constexpr int grid_size = 4;
+  for (int y = 0; y < grid_size; y++)
+  {
+    for (int x = 0; x < grid_size; x++)
+    {
+      Entity entity;
+      entity.pipeline         = this->findPipeline("triangle"_sid);
+      entity.mesh             = this->findMesh("triangle"_sid);
+      entity.position[0]      = -0.75f + 0.5f * x;
+      entity.position[1]      = -0.75f + 0.5f * y;
+      entity.scale            = 0.2f;
+      entity.rotation         = 0.0f;
+      entity.angular_velocity = 0.5f + 0.25f * (y * grid_size + x);
+      this->entities_.push_back(entity);
+    }
+  }
+
+  // Sprites start at random positions with random shapes, colours and velocities
+  uint32_t sprite_count = std::min(this->options_.sprite_count, max_sprites_per_frame_);
+  if (sprite_count < this->options_.sprite_count)
+    LOG_WARNING("Limiting sprites to the {} that fit in a frame", max_sprites_per_frame_);
+  this->sprite_entities_.reserve(sprite_count);
+  this->sprite_broadphase_.resize(sprite_count);
+
+  const SpriteHandle shapes[] = { this->named_sprites_.at("circle"_sid),
+                                  this->named_sprites_.at("ring"_sid),
+                                  this->named_sprites_.at("square"_sid),
+                                  this->named_sprites_.at("diamond"_sid) };
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for (uint32_t i = 0; i < sprite_count; i++)
+  {
+    float angle = unit(random) * 6.2831853f;
+    float speed = 50.0f + 150.0f * unit(random);
+    SpriteEntity sprite;
+    sprite.sprite           = shapes[i % std::size(shapes)];
+    sprite.position[0]      = unit(random) * this->window_width_;
+    sprite.position[1]      = unit(random) * this->window_height_;
+    sprite.velocity[0]      = std::cos(angle) * speed;
+    sprite.velocity[1]      = std::sin(angle) * speed;
+    sprite.size             = 8.0f + 24.0f * unit(random);
+    sprite.rotation         = 0.0f;
+    sprite.angular_velocity = unit(random) * 4.0f - 2.0f;
+    sprite.color            = 0xFF000000u | (random() & 0x00FFFFFFu);
+    this->sprite_entities_.push_back(sprite);
+  }
+}
+
+void Application::loadScene(const std::string& file)
+{
+  auto start = std::chrono::steady_clock::now();
+  SceneSnapshot scene(file);
+  const SceneRoot& root = scene.root();
+
+  // Names are resolved once, records then look their handles up by index. A name stands for
+  // whichever kinds of resource are registered under it.
+  std::vector<PipelineHandle> pipelines(root.names.size());
+  std::vector<MeshHandle> meshes(root.names.size());
+  std::vector<SpriteHandle> sprites(root.names.size());
+  for (size_t i = 0; i < root.names.size(); i++)
+  {
+    pipelines[i] = this->findPipeline(root.names[i]);
+    meshes[i]    = this->findMesh(root.names[i]);
+    auto sprite  = this->named_sprites_.find(root.names[i]);
+    if (sprite != this->named_sprites_.end())
+      sprites[i] = sprite->second;
+  }
+  auto resolve = [&](const auto& handles, uint32_t index)
+  {
+    if (index >= handles.size())
+      throw std::runtime_error(file + " refers to name " + std::to_string(index) +
+                               " of " + std::to_string(handles.size()));
+    if (!handles[index])
+      throw std::runtime_error(file + " refers to unknown resource " +
+                               root.names[index].name());
+    return handles[index];
+  };
+
+  if (root.entities.size() > max_draws_per_frame_)
+    throw std::runtime_error(file + " has more entities than can be drawn");
+  for (const SceneEntity& record : root.entities)
+  {
+    Entity entity;
+    entity.pipeline         = resolve(pipelines, record.pipeline);
+    entity.mesh             = resolve(meshes, record.mesh);
+    entity.position[0]      = record.position[0];
+    entity.position[1]      = record.position[1];
+    entity.scale            = record.scale;
+    entity.rotation         = record.rotation;
+    entity.angular_velocity = record.angular_velocity;
+    this->entities_.push_back(entity);
+  }
+
+  uint32_t sprite_count = static_cast<uint32_t>(
+      std::min<uint64_t>(root.sprites.size(), max_sprites_per_frame_));
+  if (sprite_count < root.sprites.size())
+    LOG_WARNING("Limiting sprites to the {} that fit in a frame", max_sprites_per_frame_);
+  this->sprite_entities_.reserve(sprite_count);
+  this->sprite_broadphase_.resize(sprite_count);
+  for (uint32_t i = 0; i < sprite_count; i++)
+  {
+    const SceneSprite& record = root.sprites[i];
+    SpriteEntity sprite;
+    sprite.sprite           = resolve(sprites, record.sprite);
+    sprite.position[0]      = record.position[0];
+    sprite.position[1]      = record.position[1];
+    sprite.velocity[0]      = record.velocity[0];
+    sprite.velocity[1]      = record.velocity[1];
+    sprite.size             = record.size;
+    sprite.rotation         = record.rotation;
+    sprite.angular_velocity = record.angular_velocity;
+    sprite.color            = record.color;
+    this->sprite_entities_.push_back(sprite);
+  }
+  this->simulation_frame_ = root.simulation_frame;
+
+  std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - start;
+  LOG_INFO("Loaded {} entities and {} sprites from {} in {} ms",
+           this->entities_.size(),
+           this->sprite_entities_.size(),
+           file,
+           load_time.count());
+}
+
+void Application::saveScene(const std::string& file) const
+{
+  // Every name is written once, handles are mapped to the index of the name they are registered
+  // under
+  std::vector<StringId> names;
+  std::unordered_map<StringId, uint32_t> name_indices;
+  auto indexOf = [&](StringId name)
+  {
+    auto [it, inserted] = name_indices.try_emplace(name, static_cast<uint32_t>(names.size()));
+    if (inserted)
+      names.push_back(name);
+    return it->second;
+  };
+  std::unordered_map<uint32_t, uint32_t> pipeline_names;
+  std::unordered_map<uint32_t, uint32_t> mesh_names;
+  std::unordered_map<uint32_t, uint32_t> sprite_names;
+  for (const auto& [name, pipeline] : this->named_pipelines_)
+    pipeline_names.emplace(pipeline.value, indexOf(name));
+  for (const auto& [name, mesh] : this->named_meshes_)
+    mesh_names.emplace(mesh.value, indexOf(name));
+  for (const auto& [name, sprite] : this->named_sprites_)
+    sprite_names.emplace(sprite.value, indexOf(name));
+  auto nameOf = [&](const std::unordered_map<uint32_t, uint32_t>& handle_names, uint32_t handle)
+  {
+    auto it = handle_names.find(handle);
+    if (it == handle_names.end())
+      throw std::runtime_error("Cannot save an entity using an unnamed resource");
+    return it->second;
+  };
+
+  std::vector<SceneEntity> entities;
+  entities.reserve(this->entities_.size());
+  for (const Entity& entity : this->entities_)
+  {
+    SceneEntity record;
+    record.pipeline         = nameOf(pipeline_names, entity.pipeline.value);
+    record.mesh             = nameOf(mesh_names, entity.mesh.value);
+    record.position[0]      = entity.position[0];
+    record.position[1]      = entity.position[1];
+    record.scale            = entity.scale;
+    record.rotation         = entity.rotation;
+    record.angular_velocity = entity.angular_velocity;
+    entities.push_back(record);
+  }
+
+  std::vector<SceneSprite> sprites;
+  sprites.reserve(this->sprite_entities_.size());
+  for (const SpriteEntity& sprite : this->sprite_entities_)
+  {
+    SceneSprite record;
+    record.sprite           = nameOf(sprite_names, sprite.sprite.value);
+    record.position[0]      = sprite.position[0];
+    record.position[1]      = sprite.position[1];
+    record.velocity[0]      = sprite.velocity[0];
+    record.velocity[1]      = sprite.velocity[1];
+    record.size             = sprite.size;
+    record.rotation         = sprite.rotation;
+    record.angular_velocity = sprite.angular_velocity;
+    record.color            = sprite.color;
+    sprites.push_back(record);
+  }
+
+  writeSceneSnapshot(file, this->simulation_frame_, names, entities, sprites);
+  LOG_INFO("Saved {} entities and {} sprites to {}", entities.size(), sprites.size(), file);
+}
+
+Application::Application(const ApplicationOptions& options) :
+  options_(options),
+  present_vsync_(options.vsync),
+  vsync_(options.vsync)
+{
+  this->initScheduler();
   this->initSDL();
   this->initInstance();
   this->initPhysicalDevice();
   this->initQueueFamilies();
   this->initDevice();
+  this->initMetrics();
+  this->initProfiler();
+  this->initPresenter();
   this->initSwapchain();
   this->initSwapchainImageViews();
+  this->initRenderPass();
   this->initGraphicsPipeline();
+  this->initFramebuffers();
+  this->initCommandBuffers();
+  this->initSyncObjects();
+  this->initUniformBuffers();
+  this->initOcclusionCulling();
+  this->initSpriteImages();
+  this->initSpriteRenderer();
+  this->initTextRenderer();
+  this->initUiRenderer();
+  this->initUi();
+  this->initAudio();
+  this->initEntities();
 }
 
 void Application::run()
 {
+  Profiler::instance().setThreadName("main");
   SDL_ShowWindow(this->window_);
-  bool loop = true;
+
+  // The main thread simulates frame N+1 while the render thread records and presents frame N
+  this->render_thread_ = std::thread(&Application::renderLoop, this);
+#if ENGINE_THREAD_PINNING
+  // Pinned only now so that threads started during initialisation do not inherit a single CPU
+  std::vector<uint32_t> main_cpus;
+  std::vector<uint32_t> render_cpus;
+  if (this->thread_placement_.main_cpu)
+    main_cpus.push_back(*this->thread_placement_.main_cpu);
+  if (this->thread_placement_.render_cpu)
+    render_cpus.push_back(*this->thread_placement_.render_cpu);
+  this->placeThread("main", currentThreadHandle(), main_cpus, ThreadPriority::Normal);
+  this->placeThread("render",
+                    this->render_thread_.native_handle(),
+                    render_cpus,
+                    ThreadPriority::High);
+#endif
+
+  auto last_time            = std::chrono::steady_clock::now();
+  uint64_t simulated_frames = 0;
+  bool loop                 = true;
   while (loop)
   {
     SDL_Event event;
@@ -472,19 +2993,138 @@ void Application::run()
       if (event.type == SDL_EventType::SDL_QUIT)
       {
         loop = false;
+      } else if (event.type == SDL_EventType::SDL_KEYDOWN && event.key.keysym.sym == SDLK_F12 &&
+                 !event.key.repeat)
+      {
+        this->capture_requested_ = true;
+      } else if (event.type == SDL_EventType::SDL_KEYDOWN && event.key.keysym.sym == SDLK_v &&
+                 !event.key.repeat)
+      {
+        this->vsync_ = !this->vsync_.load(std::memory_order_relaxed);
       }
     }
+    // Resume coroutines waiting on the main thread
+    this->scheduler_->pumpMainThread();
+    if (this->audio_)
+      this->audio_->update();
+
+    // Blocks while the render thread is a full frame behind, returns nullptr if it stopped
+    int64_t wait_start       = Profiler::now();
+    RenderSnapshot* snapshot = this->render_snapshots_.acquireWrite();
+    if (!snapshot)
+      break;
+    Profiler::instance().record("waitForRenderThread", wait_start, Profiler::now());
+
+    auto simulation_start                   = std::chrono::steady_clock::now();
+    AllocationCounts simulation_allocations = threadAllocations();
+    std::chrono::duration<float> delta_time = simulation_start - last_time;
+    last_time                               = simulation_start;
+    this->simulate(delta_time.count());
+    this->updateDashboard(delta_time.count());
+    this->extractRenderSnapshot(*snapshot);
+    snapshot->simulation_time        = std::chrono::steady_clock::now() - simulation_start;
+    snapshot->simulation_allocations = threadAllocations() - simulation_allocations;
+    this->render_snapshots_.publish(snapshot);
+
+    // A benchmark ends once its frames have been simulated
+    simulated_frames++;
+    if (this->options_.benchmark_frames &&
+        simulated_frames == benchmark_warmup_frames_ + this->options_.benchmark_frames)
+      loop = false;
   }
+
+  // Stop the render thread, then wait for all frames to finish before resources are destroyed
+  this->render_snapshots_.close();
+  this->render_thread_.join();
+  this->discardAcquiredImages().value();
+  this->presenter_.reset();
+  VULKAN_CALL(this->device_.waitIdle()).value();
+  this->waitForPresents().value();
   SDL_HideWindow(this->window_);
+
+  if (this->benchmark_stats_.frame_count)
+  {
+    double frame_count  = static_cast<double>(this->benchmark_stats_.frame_count);
+    double mean         = this->benchmark_stats_.frame_time / frame_count;
+    double variance     = this->benchmark_stats_.frame_time_squared / frame_count - mean * mean;
+    bool placed         = ENGINE_THREAD_PINNING && this->options_.thread_placement;
+    bool present_thread = this->options_.present_thread && this->dedicated_present_queue_;
+
+    int64_t present_count =
+        static_cast<int64_t>(std::max<uint64_t>(this->benchmark_stats_.present_count, 1));
+    LOG_INFO("Benchmark of {} frames: average CPU frame time {}ns, standard deviation {}ns, "
+             "latency from frame start to present {}ns presenting on the {} thread, Vulkan errors "
+             "as {}, threads {}",
+             this->benchmark_stats_.frame_count,
+             static_cast<int64_t>(mean),
+             static_cast<int64_t>(std::sqrt(std::max(variance, 0.0))),
+             this->benchmark_stats_.present_latency / present_count,
+             present_thread ? "present" : "render",
+             vulkan_error_mode_,
+             placed ? "placed" : "left to the OS");
+  }
+
+  if (!this->options_.save_scene_file.empty())
+  {
+    try
+    {
+      this->saveScene(this->options_.save_scene_file);
+    } catch (const std::exception& error)
+    {
+      LOG_ERROR("Failed to save scene: {}", error.what());
+    }
+  }
 }
 
 Application::~Application()
 {
-  // Destroy all image views
-  for (auto& image_view : this->swapchain_image_views_)
-    this->device_.destroyImageView(image_view);
-  // Destroy the swapchain
-  this->device_.destroySwapchainKHR(this->swapchain_);
+  // Close the audio device and wait for stream decoding, then stop the scheduler threads before
+  // anything they could use is destroyed
+  this->audio_.reset();
+  this->scheduler_.reset();
+  // Stop the metrics exporter, its last write queries the physical device, and wait for a stutter
+  // trace being written
+  this->metrics_.reset();
+  this->stutter_monitor_.reset();
+  // Destroy per-frame resources
+  for (auto& frame : this->frames_)
+  {
+    this->destroyBuffer(frame.uniform_buffer);
+    this->destroyBuffer(frame.sprite_vertex_buffer);
+    this->destroyBuffer(frame.text_vertex_buffer);
+    this->destroyBuffer(frame.glyph_staging_buffer);
+    this->destroyBuffer(frame.ui_sprite_vertex_buffer);
+    this->destroyBuffer(frame.ui_text_vertex_buffer);
+    this->device_.destroyFence(frame.present_fence);
+    this->device_.destroyFence(frame.in_flight);
+    this->device_.destroySemaphore(frame.render_finished);
+    this->device_.destroySemaphore(frame.image_available);
+  }
+  // Destroy the command pool, freeing its command buffers
+  this->device_.destroyCommandPool(this->command_pool_);
+  // Destroy the swapchain, its image views and framebuffers
+  this->cleanupSwapchain();
+  // Destroy the sprite atlas pages, index buffer and sampler
+  for (auto& page_image : this->sprite_atlas_images_)
+    this->destroyImage(page_image);
+  this->destroyBuffer(this->quad_index_buffer_);
+  this->device_.destroySampler(this->sprite_sampler_);
+  // Destroy the glyph atlas, text is disabled when it was never created
+  this->destroyImage(this->glyph_atlas_image_);
+  // Destroy the pipelines, their layouts and descriptor state
+  for (const auto& [name, mesh] : this->named_meshes_)
+    this->meshes_.erase(mesh);
+  for (const auto& [name, pipeline] : this->named_pipelines_)
+    this->destroyPipeline(pipeline);
+  this->gpu_profiler_.reset();
+  this->occlusion_culler_.reset();
+  this->destroyBuffer(this->occlusion_predicates_);
+  this->draw_descriptors_.reset();
+  this->sprite_descriptors_.reset();
+  this->text_descriptors_.reset();
+  this->ui_descriptors_.reset();
+  this->device_.destroyRenderPass(this->ui_render_pass_);
+  this->device_.destroyRenderPass(this->render_pass_);
   // Destroy the surface
   this->instance_.destroySurfaceKHR(this->surface_);
   // Destroy the logical device
@@ -0,0 +1,119 @@
+#include "Arena.hpp"
+
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+size_t alignUp(size_t value, size_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+Arena::Arena(size_t capacity, bool huge_pages)
+{
+  this->capacity_ = alignUp(capacity, huge_page_size_);
+#ifdef __linux__
+  void* memory = MAP_FAILED;
+
+  // Explicit huge pages only succeed when the administrator has reserved enough of them
+  if (huge_pages)
+  {
+    memory = mmap(nullptr,
+                  this->capacity_,
+                  PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                  -1,
+                  0);
+    if (memory != MAP_FAILED)
+      this->backing_ = Backing::ExplicitHugePages;
+  }
+
+  if (memory == MAP_FAILED)
+  {
+    // Over-reserve by a huge page and trim, so transparent huge pages can back the whole range
+    size_t reserve_size = this->capacity_ + huge_page_size_;
+    void* reservation   = mmap(nullptr,
+                             reserve_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                             -1,
+                             0);
+    if (reservation == MAP_FAILED)
+      throw std::bad_alloc();
+
+    auto start   = reinterpret_cast<uintptr_t>(reservation);
+    auto aligned = alignUp(start, huge_page_size_);
+    size_t head  = aligned - start;
+    size_t tail  = reserve_size - head - this->capacity_;
+    if (head > 0)
+      munmap(reservation, head);
+    if (tail > 0)
+      munmap(reinterpret_cast<void*>(aligned + this->capacity_), tail);
+    memory = reinterpret_cast<void*>(aligned);
+
+    // Fails when transparent huge pages are disabled, the range then stays on normal pages
+    if (huge_pages && madvise(memory, this->capacity_, MADV_HUGEPAGE) == 0)
+      this->backing_ = Backing::TransparentHugePages;
+  }
+  this->base_ = static_cast<std::byte*>(memory);
+#else
+  static_cast<void>(huge_pages);
+  this->base_ = static_cast<std::byte*>(::operator new(this->capacity_, std::align_val_t(4096)));
+#endif
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+  size_t offset = alignUp(this->offset_, alignment);
+  if (offset > this->capacity_ || size > this->capacity_ - offset)
+    throw std::bad_alloc();
+  this->offset_ = offset + size;
+  return this->base_ + offset;
+}
+
+void Arena::reset()
+{
+  this->offset_ = 0;
+}
+
+size_t Arena::used() const
+{
+  return this->offset_;
+}
+
+size_t Arena::capacity() const
+{
+  return this->capacity_;
+}
+
+Arena::Backing Arena::backing() const
+{
+  return this->backing_;
+}
+
+const char* Arena::backingName(Backing backing)
+{
+  switch (backing)
+  {
+  case Backing::ExplicitHugePages:
+    return "explicit huge pages";
+  case Backing::TransparentHugePages:
+    return "transparent huge pages";
+  default:
+    return "normal pages";
+  }
+}
+
+Arena::~Arena()
+{
+#ifdef __linux__
+  munmap(this->base_, this->capacity_);
+#else
+  ::operator delete(this->base_, std::align_val_t(4096));
+#endif
+}
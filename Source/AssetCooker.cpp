@@ -0,0 +1,536 @@
+#include "AssetCooker.hpp"
+
+#include "Json.hpp"
+#include "Logger.hpp"
+#include "StringId.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#if COOKER_HAS_PNG
+#include <png.h>
+#endif
+
+namespace fs = std::filesystem;
+
+struct AssetConverter
+{
+  const char* name;
+  std::vector<std::string_view> extensions;
+  const char* output_extension;
+
+  // Bump when the output of the converter changes so that existing outputs are rebuilt
+  uint32_t version;
+
+  // Returns every source file the output depends on, the source itself first
+  std::vector<std::string> (*dependencies)(const CookOptions& options, const std::string& source);
+
+  // Converts the source into the output file
+  void (*convert)(const CookOptions& options, const std::string& source, const fs::path& output);
+};
+
+namespace
+{
+std::string readSource(const CookOptions& options, const std::string& path)
+{
+  std::ifstream stream(options.source_root / path, std::ios::binary);
+  if (!stream)
+    throw std::runtime_error("Failed to open " + path);
+  return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+}
+
+// Writes an output through a temporary file so that a failed cook never leaves a partial output
+void writeOutput(const fs::path& output, const std::vector<std::string_view>& parts)
+{
+  fs::path temporary = output;
+  temporary += ".tmp";
+  {
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+    for (const auto& part : parts)
+      stream.write(part.data(), static_cast<std::streamsize>(part.size()));
+    if (!stream)
+      throw std::runtime_error("Failed to write " + temporary.string());
+  }
+  fs::rename(temporary, output);
+}
+
+template <typename T>
+std::string_view bytesOf(const std::vector<T>& values)
+{
+  return std::string_view(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+std::string_view bytesOf(const T& value)
+{
+  return std::string_view(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Resolves a path referenced from a source file against that file's directory
+std::string resolveRelative(const std::string& from, const std::string& reference)
+{
+  return (fs::path(from).parent_path() / reference).lexically_normal().generic_string();
+}
+
+// GLSL ---------------------------------------------------------------------------------------
+
+// Follows #include directives recursively, glslc resolves them relative to the including file
+void collectShaderIncludes(const CookOptions& options,
+                           const std::string& path,
+                           std::vector<std::string>& dependencies,
+                           std::set<std::string>& visited)
+{
+  if (!visited.insert(path).second)
+    return;
+  dependencies.push_back(path);
+
+  std::stringstream stream(readSource(options, path));
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+      continue;
+    size_t open = line.find_first_of("\"<", start + 8);
+    if (open == std::string::npos)
+      continue;
+    size_t close = line.find_first_of("\">", open + 1);
+    if (close == std::string::npos)
+      throw std::runtime_error("Malformed #include in " + path);
+    std::string include = resolveRelative(path, line.substr(open + 1, close - open - 1));
+    collectShaderIncludes(options, include, dependencies, visited);
+  }
+}
+
+std::vector<std::string> shaderDependencies(const CookOptions& options, const std::string& source)
+{
+  std::vector<std::string> dependencies;
+  std::set<std::string> visited;
+  collectShaderIncludes(options, source, dependencies, visited);
+  return dependencies;
+}
+
+void convertShader(const CookOptions& options, const std::string& source, const fs::path& output)
+{
+  fs::path temporary = output;
+  temporary += ".tmp";
+  std::string command = "\"" + options.glslc + "\" -o \"" + temporary.string() + "\" \"" +
+                        (options.source_root / source).string() + "\"";
+  if (std::system(command.c_str()) != 0)
+  {
+    fs::remove(temporary);
+    throw std::runtime_error("glslc failed");
+  }
+  fs::rename(temporary, output);
+}
+
+// PNG ----------------------------------------------------------------------------------------
+
+std::vector<std::string> textureDependencies(const CookOptions&, const std::string& source)
+{
+  return { source };
+}
+
+void convertTexture(const CookOptions& options, const std::string& source, const fs::path& output)
+{
+#if COOKER_HAS_PNG
+  std::string data = readSource(options, source);
+  png_image image;
+  std::memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_memory(&image, data.data(), data.size()))
+    throw std::runtime_error(image.message);
+
+  // Every image is expanded to RGBA8 so the runtime only handles one texel format
+  image.format = PNG_FORMAT_RGBA;
+  std::vector<uint8_t> texels(PNG_IMAGE_SIZE(image));
+  if (!png_image_finish_read(&image, nullptr, texels.data(), 0, nullptr))
+  {
+    png_image_free(&image);
+    throw std::runtime_error(image.message);
+  }
+
+  TextureFileHeader header;
+  header.width  = image.width;
+  header.height = image.height;
+  writeOutput(output, { bytesOf(header), bytesOf(texels) });
+#else
+  static_cast<void>(options);
+  static_cast<void>(source);
+  static_cast<void>(output);
+  throw std::runtime_error("Asset-Cooker was built without libpng");
+#endif
+}
+
+// glTF ---------------------------------------------------------------------------------------
+
+std::string decodeUri(const std::string& uri)
+{
+  std::string decoded;
+  for (size_t i = 0; i < uri.size(); i++)
+  {
+    if (uri[i] == '%' && i + 2 < uri.size())
+    {
+      decoded += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+      i += 2;
+    } else
+    {
+      decoded += uri[i];
+    }
+  }
+  return decoded;
+}
+
+std::string decodeBase64(std::string_view encoded)
+{
+  auto value = [](char character) -> int {
+    if (character >= 'A' && character <= 'Z')
+      return character - 'A';
+    if (character >= 'a' && character <= 'z')
+      return character - 'a' + 26;
+    if (character >= '0' && character <= '9')
+      return character - '0' + 52;
+    if (character == '+')
+      return 62;
+    if (character == '/')
+      return 63;
+    return -1;
+  };
+
+  std::string decoded;
+  uint32_t bits = 0;
+  int bit_count = 0;
+  for (char character : encoded)
+  {
+    int digit = value(character);
+    if (digit < 0)
+      break;
+    bits = (bits << 6) | static_cast<uint32_t>(digit);
+    bit_count += 6;
+    if (bit_count >= 8)
+    {
+      bit_count -= 8;
+      decoded += static_cast<char>((bits >> bit_count) & 0xFF);
+    }
+  }
+  return decoded;
+}
+
+bool isDataUri(const std::string& uri)
+{
+  return uri.rfind("data:", 0) == 0;
+}
+
+std::vector<std::string> meshDependencies(const CookOptions& options, const std::string& source)
+{
+  std::vector<std::string> dependencies = { source };
+  JsonValue document = JsonValue::parse(readSource(options, source));
+  if (const JsonValue* buffers = document.find("buffers"))
+  {
+    for (const auto& buffer : buffers->asArray())
+    {
+      const JsonValue* uri = buffer.find("uri");
+      if (uri && !isDataUri(uri->asString()))
+        dependencies.push_back(resolveRelative(source, decodeUri(uri->asString())));
+    }
+  }
+  return dependencies;
+}
+
+// Reads the elements of a glTF accessor, converting every component to T
+template <typename T>
+std::vector<T> readAccessor(const JsonValue& document,
+                            const std::vector<std::string>& buffers,
+                            size_t accessor_index,
+                            uint32_t expected_components)
+{
+  const JsonValue& accessor = document.at("accessors").at(accessor_index);
+  static const std::pair<std::string_view, uint32_t> types[] = {
+    { "SCALAR", 1 }, { "VEC2", 2 }, { "VEC3", 3 }, { "VEC4", 4 }
+  };
+  uint32_t components = 0;
+  for (const auto& [name, count] : types)
+  {
+    if (accessor.at("type").asString() == name)
+      components = count;
+  }
+  if (components != expected_components)
+    throw std::runtime_error("Unexpected glTF accessor type " + accessor.at("type").asString());
+
+  uint32_t component_type = static_cast<uint32_t>(accessor.at("componentType").asNumber());
+  size_t component_size;
+  switch (component_type)
+  {
+  case 5121: // UNSIGNED_BYTE
+    component_size = 1;
+    break;
+  case 5123: // UNSIGNED_SHORT
+    component_size = 2;
+    break;
+  case 5125: // UNSIGNED_INT
+  case 5126: // FLOAT
+    component_size = 4;
+    break;
+  default:
+    throw std::runtime_error("Unsupported glTF component type");
+  }
+  if (std::is_floating_point_v<T> != (component_type == 5126))
+    throw std::runtime_error("glTF accessor has an unexpected component type");
+
+  size_t count = static_cast<size_t>(accessor.at("count").asNumber());
+  std::vector<T> values(count * components);
+  if (!accessor.find("bufferView"))
+    return values; // Sparse or zero-initialised accessors read as zeros
+
+  const JsonValue& view =
+      document.at("bufferViews").at(static_cast<size_t>(accessor.at("bufferView").asNumber()));
+  const std::string& buffer = buffers.at(static_cast<size_t>(view.at("buffer").asNumber()));
+  size_t element_size       = component_size * components;
+  size_t stride =
+      static_cast<size_t>(view.numberOr("byteStride", static_cast<double>(element_size)));
+  size_t offset = static_cast<size_t>(view.numberOr("byteOffset", 0)) +
+                  static_cast<size_t>(accessor.numberOr("byteOffset", 0));
+  if (count > 0 && offset + (count - 1) * stride + element_size > buffer.size())
+    throw std::runtime_error("glTF accessor reads past the end of its buffer");
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const char* element = buffer.data() + offset + i * stride;
+    for (uint32_t c = 0; c < components; c++)
+    {
+      const char* component = element + c * component_size;
+      if (component_type == 5126)
+      {
+        float value;
+        std::memcpy(&value, component, sizeof(value));
+        values[i * components + c] = static_cast<T>(value);
+      } else
+      {
+        uint32_t value = 0;
+        std::memcpy(&value, component, component_size);
+        values[i * components + c] = static_cast<T>(value);
+      }
+    }
+  }
+  return values;
+}
+
+void convertMesh(const CookOptions& options, const std::string& source, const fs::path& output)
+{
+  JsonValue document = JsonValue::parse(readSource(options, source));
+
+  std::vector<std::string> buffers;
+  if (const JsonValue* buffer_list = document.find("buffers"))
+  {
+    for (const auto& buffer : buffer_list->asArray())
+    {
+      const std::string& uri = buffer.at("uri").asString();
+      if (isDataUri(uri))
+        buffers.push_back(decodeBase64(std::string_view(uri).substr(uri.find(',') + 1)));
+      else
+        buffers.push_back(readSource(options, resolveRelative(source, decodeUri(uri))));
+    }
+  }
+
+  // Every triangle primitive of every mesh is merged into one vertex and index list. Node
+  // transforms are not applied, meshes are cooked in their own space.
+  std::vector<MeshVertex> vertices;
+  std::vector<uint32_t> indices;
+  for (const auto& mesh : document.at("meshes").asArray())
+  {
+    for (const auto& primitive : mesh.at("primitives").asArray())
+    {
+      if (primitive.numberOr("mode", 4) != 4)
+        throw std::runtime_error("Only glTF triangle list primitives are supported");
+
+      const JsonValue& attributes = primitive.at("attributes");
+      auto attribute              = [&](const char* name, uint32_t components) {
+        const JsonValue* accessor = attributes.find(name);
+        return accessor ?
+                   readAccessor<float>(
+                       document, buffers, static_cast<size_t>(accessor->asNumber()), components) :
+                   std::vector<float>();
+      };
+      std::vector<float> positions = attribute("POSITION", 3);
+      std::vector<float> normals   = attribute("NORMAL", 3);
+      std::vector<float> uvs       = attribute("TEXCOORD_0", 2);
+      size_t vertex_count          = positions.size() / 3;
+      if (vertex_count == 0)
+        throw std::runtime_error("glTF primitive has no POSITION attribute");
+
+      uint32_t base = static_cast<uint32_t>(vertices.size());
+      for (size_t i = 0; i < vertex_count; i++)
+      {
+        MeshVertex vertex {};
+        std::memcpy(vertex.position, &positions[i * 3], sizeof(vertex.position));
+        if (normals.size() == positions.size())
+          std::memcpy(vertex.normal, &normals[i * 3], sizeof(vertex.normal));
+        if (uvs.size() == vertex_count * 2)
+          std::memcpy(vertex.uv, &uvs[i * 2], sizeof(vertex.uv));
+        vertices.push_back(vertex);
+      }
+
+      if (const JsonValue* accessor = primitive.find("indices"))
+      {
+        for (uint32_t index : readAccessor<uint32_t>(
+                 document, buffers, static_cast<size_t>(accessor->asNumber()), 1))
+        {
+          if (index >= vertex_count)
+            throw std::runtime_error("glTF index out of range");
+          indices.push_back(base + index);
+        }
+      } else
+      {
+        for (uint32_t i = 0; i < vertex_count; i++)
+          indices.push_back(base + i);
+      }
+    }
+  }
+
+  MeshFileHeader header;
+  header.vertex_count = static_cast<uint32_t>(vertices.size());
+  header.index_count  = static_cast<uint32_t>(indices.size());
+  writeOutput(output, { bytesOf(header), bytesOf(vertices), bytesOf(indices) });
+}
+
+const AssetConverter converters[] = {
+  { "shader",
+    { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" },
+    ".spv",
+    1,
+    shaderDependencies,
+    convertShader },
+  { "texture", { ".png" }, ".tex", 1, textureDependencies, convertTexture },
+  { "mesh", { ".gltf" }, ".mesh", 1, meshDependencies, convertMesh },
+};
+} // namespace
+
+AssetCooker::AssetCooker(CookOptions options) :
+  options_(std::move(options)),
+  database_(this->options_.source_root)
+{
+}
+
+std::vector<AssetCooker::Job> AssetCooker::findJobs() const
+{
+  std::vector<Job> jobs;
+  for (const auto& directory : this->options_.directories)
+  {
+    fs::path root = this->options_.source_root / directory;
+    if (!fs::is_directory(root))
+    {
+      LOG_WARNING("Skipping missing asset directory {}", root.string());
+      continue;
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(root))
+    {
+      if (!entry.is_regular_file())
+        continue;
+      std::string extension = entry.path().extension().string();
+      for (const auto& converter : converters)
+      {
+        if (std::find(converter.extensions.begin(), converter.extensions.end(), extension) ==
+            converter.extensions.end())
+          continue;
+        std::string source =
+            entry.path().lexically_relative(this->options_.source_root).generic_string();
+        jobs.push_back({ &converter, source, source + converter.output_extension });
+      }
+    }
+  }
+  return jobs;
+}
+
+uint64_t AssetCooker::hashInputs(const Job& job, const std::vector<std::string>& dependencies)
+{
+  std::stringstream inputs;
+  inputs << job.converter->name << '\t' << job.converter->version << '\n';
+  for (const auto& dependency : dependencies)
+    inputs << dependency << '\t' << this->database_.hashFile(dependency) << '\n';
+  return StringId::hash(inputs.str());
+}
+
+bool AssetCooker::isUpToDate(const Job& job, const AssetDatabase::OutputRecord& record)
+{
+  if (record.converter_version != job.converter->version ||
+      !fs::exists(this->options_.output_root / job.output))
+    return false;
+  return std::all_of(record.dependencies.begin(),
+                     record.dependencies.end(),
+                     [&](const std::string& dependency) {
+                       return this->database_.isFileUnchanged(dependency);
+                     });
+}
+
+void AssetCooker::runJob(const Job& job)
+{
+  try
+  {
+    // Fast path, nothing the output was built from has been touched
+    std::optional<AssetDatabase::OutputRecord> record = this->database_.findOutput(job.output);
+    if (!this->options_.force && record && this->isUpToDate(job, *record))
+    {
+      this->up_to_date_++;
+      return;
+    }
+
+    // Something was touched, rebuild only if the content actually changed
+    std::vector<std::string> dependencies =
+        job.converter->dependencies(this->options_, job.source);
+    uint64_t input_hash  = this->hashInputs(job, dependencies);
+    fs::path output_path = this->options_.output_root / job.output;
+    bool unchanged = record && record->converter_version == job.converter->version &&
+                     record->input_hash == input_hash && fs::exists(output_path);
+    AssetDatabase::OutputRecord new_record = { job.converter->version, input_hash, dependencies };
+    if (!this->options_.force && unchanged)
+    {
+      this->database_.recordOutput(job.output, std::move(new_record));
+      this->up_to_date_++;
+      return;
+    }
+
+    fs::create_directories(output_path.parent_path());
+    job.converter->convert(this->options_, job.source, output_path);
+    this->database_.recordOutput(job.output, std::move(new_record));
+    this->cooked_++;
+    LOG_INFO("Cooked {} ({})", job.output, job.converter->name);
+  } catch (const std::exception& error)
+  {
+    this->failed_++;
+    LOG_ERROR("Failed to cook {}: {}", job.source, error.what());
+  }
+}
+
+CookStats AssetCooker::cook()
+{
+  fs::create_directories(this->options_.output_root);
+  fs::path database_file = this->options_.output_root / "AssetDatabase.txt";
+  this->database_.load(database_file);
+
+  std::vector<Job> jobs = this->findJobs();
+
+  // Workers take jobs in order from a shared counter until none are left
+  std::atomic<size_t> next_job { 0 };
+  auto worker = [&]() {
+    for (size_t i = next_job++; i < jobs.size(); i = next_job++)
+      this->runJob(jobs[i]);
+  };
+  uint32_t thread_count =
+      std::clamp<uint32_t>(this->options_.thread_count, 1, std::max<size_t>(jobs.size(), 1));
+  std::vector<std::thread> threads;
+  for (uint32_t i = 1; i < thread_count; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+
+  this->database_.save(database_file);
+  return { this->cooked_, this->up_to_date_, this->failed_ };
+}
@@ -0,0 +1,51 @@
+#include "AssetCooker.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// Usage: Asset-Cooker --source <dir> --output <dir> [--glslc <path>] [--threads <n>] [--force]
+//        <asset directory>...
+int main(int argc, char* argv[])
+{
+  CookOptions options;
+  options.source_root  = std::filesystem::current_path();
+  options.output_root  = std::filesystem::current_path();
+  options.thread_count = std::max(1u, std::thread::hardware_concurrency());
+#ifdef COOKER_GLSLC
+  options.glslc = COOKER_GLSLC;
+#endif
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--source") == 0 && has_value)
+      options.source_root = argv[++i];
+    else if (std::strcmp(argv[i], "--output") == 0 && has_value)
+      options.output_root = argv[++i];
+    else if (std::strcmp(argv[i], "--glslc") == 0 && has_value)
+      options.glslc = argv[++i];
+    else if (std::strcmp(argv[i], "--threads") == 0 && has_value)
+      options.thread_count = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+    else if (std::strcmp(argv[i], "--force") == 0)
+      options.force = true;
+    else
+      options.directories.emplace_back(argv[i]);
+  }
+
+  if (options.directories.empty())
+  {
+    LOG_ERROR("No asset directories given");
+    return EXIT_FAILURE;
+  }
+
+  AssetCooker cooker(options);
+  CookStats stats = cooker.cook();
+  LOG_INFO("Assets cooked: {}, up to date: {}, failed: {}",
+           stats.cooked,
+           stats.up_to_date,
+           stats.failed);
+  return stats.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,151 @@
+#include "AssetDatabase.hpp"
+
+#include "StringId.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+AssetDatabase::AssetDatabase(fs::path source_root) : source_root_(std::move(source_root)) { }
+
+std::optional<AssetDatabase::FileRecord> AssetDatabase::statFile(const std::string& path) const
+{
+  std::error_code error;
+  fs::path full_path = this->source_root_ / path;
+  uint64_t size      = fs::file_size(full_path, error);
+  if (error)
+    return std::nullopt;
+  auto modified = fs::last_write_time(full_path, error);
+  if (error)
+    return std::nullopt;
+  return FileRecord { 0, size, static_cast<int64_t>(modified.time_since_epoch().count()) };
+}
+
+void AssetDatabase::load(const fs::path& file)
+{
+  // One record per line, fields separated by tabs:
+  //   F <hash> <size> <modified> <path>
+  //   O <converter version> <input hash> <output> <dependency>...
+  std::ifstream stream(file);
+  std::string line;
+  std::lock_guard lock(this->mutex_);
+  while (std::getline(stream, line))
+  {
+    std::vector<std::string> fields;
+    std::stringstream line_stream(line);
+    std::string field;
+    while (std::getline(line_stream, field, '\t'))
+      fields.push_back(field);
+
+    try
+    {
+      if (fields.size() == 5 && fields[0] == "F")
+      {
+        this->files_[fields[4]] = { std::stoull(fields[1], nullptr, 16),
+                                    std::stoull(fields[2]),
+                                    std::stoll(fields[3]) };
+      } else if (fields.size() >= 5 && fields[0] == "O")
+      {
+        OutputRecord record;
+        record.converter_version = static_cast<uint32_t>(std::stoul(fields[1]));
+        record.input_hash        = std::stoull(fields[2], nullptr, 16);
+        record.dependencies.assign(fields.begin() + 4, fields.end());
+        this->outputs_[fields[3]] = std::move(record);
+      }
+    } catch (const std::exception&)
+    {
+      // A damaged line only costs a rebuild of whatever it described
+    }
+  }
+}
+
+void AssetDatabase::save(const fs::path& file) const
+{
+  std::lock_guard lock(this->mutex_);
+  std::vector<std::string> lines;
+  for (const auto& [path, record] : this->files_)
+  {
+    std::stringstream line;
+    line << "F\t" << std::hex << record.hash << std::dec << '\t' << record.size << '\t'
+         << record.modified << '\t' << path;
+    lines.push_back(line.str());
+  }
+  for (const auto& [output, record] : this->outputs_)
+  {
+    std::stringstream line;
+    line << "O\t" << record.converter_version << '\t' << std::hex << record.input_hash << std::dec
+         << '\t' << output;
+    for (const auto& dependency : record.dependencies)
+      line << '\t' << dependency;
+    lines.push_back(line.str());
+  }
+  std::sort(lines.begin(), lines.end());
+
+  // Write to a temporary file first so an interrupted save never leaves a truncated database
+  fs::path temporary = file;
+  temporary += ".tmp";
+  {
+    std::ofstream stream(temporary, std::ios::trunc);
+    for (const auto& line : lines)
+      stream << line << '\n';
+    if (!stream)
+      throw std::runtime_error("Failed to write asset database " + temporary.string());
+  }
+  fs::rename(temporary, file);
+}
+
+uint64_t AssetDatabase::hashFile(const std::string& path)
+{
+  std::optional<FileRecord> current = this->statFile(path);
+  if (!current)
+    throw std::runtime_error("Failed to read " + path);
+
+  {
+    std::lock_guard lock(this->mutex_);
+    auto it = this->files_.find(path);
+    if (it != this->files_.end() && it->second.size == current->size &&
+        it->second.modified == current->modified)
+      return it->second.hash;
+  }
+
+  // Hash outside the lock so that several threads can read files at once
+  std::ifstream stream(this->source_root_ / path, std::ios::binary);
+  if (!stream)
+    throw std::runtime_error("Failed to read " + path);
+  std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+  current->hash = StringId::hash(content);
+
+  std::lock_guard lock(this->mutex_);
+  this->files_[path] = *current;
+  return current->hash;
+}
+
+bool AssetDatabase::isFileUnchanged(const std::string& path) const
+{
+  std::optional<FileRecord> current = this->statFile(path);
+  if (!current)
+    return false;
+  std::lock_guard lock(this->mutex_);
+  auto it = this->files_.find(path);
+  return it != this->files_.end() && it->second.size == current->size &&
+         it->second.modified == current->modified;
+}
+
+std::optional<AssetDatabase::OutputRecord>
+AssetDatabase::findOutput(const std::string& output) const
+{
+  std::lock_guard lock(this->mutex_);
+  auto it = this->outputs_.find(output);
+  if (it == this->outputs_.end())
+    return std::nullopt;
+  return it->second;
+}
+
+void AssetDatabase::recordOutput(const std::string& output, OutputRecord record)
+{
+  std::lock_guard lock(this->mutex_);
+  this->outputs_[output] = std::move(record);
+}
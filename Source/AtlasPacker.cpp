@@ -0,0 +1,100 @@
+#include "AtlasPacker.hpp"
+
+#include <algorithm>
+
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height) : width_(width), height_(height)
+{
+  this->reset();
+}
+
+std::optional<uint32_t> SkylinePacker::fitAt(size_t index, uint32_t width, uint32_t height) const
+{
+  if (this->skyline_[index].x + width > this->width_)
+    return std::nullopt;
+
+  // The rectangle rests on the highest segment it spans
+  uint32_t y          = 0;
+  uint32_t width_left = width;
+  for (size_t i = index; width_left > 0; i++)
+  {
+    y = std::max(y, this->skyline_[i].y);
+    if (y + height > this->height_)
+      return std::nullopt;
+    width_left -= std::min(width_left, this->skyline_[i].width);
+  }
+  return y;
+}
+
+std::optional<AtlasRect> SkylinePacker::pack(uint32_t width, uint32_t height)
+{
+  if (width == 0 || height == 0)
+    return std::nullopt;
+
+  // Pick the position with the lowest top edge, ties go to the narrowest segment to limit waste
+  size_t best_index   = this->skyline_.size();
+  uint32_t best_top   = UINT32_MAX;
+  uint32_t best_width = UINT32_MAX;
+  uint32_t best_y     = 0;
+  for (size_t i = 0; i < this->skyline_.size(); i++)
+  {
+    std::optional<uint32_t> y = this->fitAt(i, width, height);
+    if (!y)
+      continue;
+    uint32_t top = *y + height;
+    if (top < best_top || (top == best_top && this->skyline_[i].width < best_width))
+    {
+      best_index = i;
+      best_top   = top;
+      best_width = this->skyline_[i].width;
+      best_y     = *y;
+    }
+  }
+  if (best_index == this->skyline_.size())
+    return std::nullopt;
+
+  // Raise the skyline over the new rectangle and trim the segments it now covers
+  AtlasRect rect = { this->skyline_[best_index].x, best_y, width, height };
+  this->skyline_.insert(this->skyline_.begin() + best_index, { rect.x, best_top, width });
+  uint32_t right = rect.x + width;
+  for (size_t i = best_index + 1; i < this->skyline_.size() && this->skyline_[i].x < right;)
+  {
+    Segment& segment = this->skyline_[i];
+    uint32_t overlap = right - segment.x;
+    if (overlap >= segment.width)
+    {
+      this->skyline_.erase(this->skyline_.begin() + i);
+      continue;
+    }
+    segment.x += overlap;
+    segment.width -= overlap;
+    break;
+  }
+
+  // Merge neighbouring segments of the same height
+  for (size_t i = 0; i + 1 < this->skyline_.size();)
+  {
+    if (this->skyline_[i].y == this->skyline_[i + 1].y)
+    {
+      this->skyline_[i].width += this->skyline_[i + 1].width;
+      this->skyline_.erase(this->skyline_.begin() + i + 1);
+    } else
+    {
+      i++;
+    }
+  }
+
+  this->used_area_ += static_cast<uint64_t>(width) * height;
+  return rect;
+}
+
+void SkylinePacker::reset()
+{
+  this->skyline_   = { { 0, 0, this->width_ } };
+  this->used_area_ = 0;
+}
+
+float SkylinePacker::occupancy() const
+{
+  return static_cast<float>(this->used_area_) /
+         (static_cast<float>(this->width_) * static_cast<float>(this->height_));
+}
@@ -0,0 +1,363 @@
+#include "AudioMixer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AUDIO_MIXER_SSE2 1
+#else
+#define AUDIO_MIXER_SSE2 0
+#endif
+
+namespace
+{
+constexpr uint64_t fixed_one = uint64_t(1) << 32;
+
+// Position step per output frame for playing a source at a pitch, 32.32 fixed point
+uint64_t pitchStep(float pitch, uint32_t source_rate, uint32_t output_rate)
+{
+  double step = static_cast<double>(pitch) * source_rate / output_rate * fixed_one;
+  return std::max<uint64_t>(static_cast<uint64_t>(step), 1);
+}
+
+// Writes count samples of src, starting at a 32.32 fixed point position and advancing by step for
+// each, interpolating linearly between neighbours. Every sample read must be inside src.
+void resampleLinear(const float* src, uint64_t position, uint64_t step, uint32_t count, float* dst)
+{
+  uint32_t i = 0;
+#if AUDIO_MIXER_SSE2
+  // Gathering the neighbours is scalar, the interpolation of four samples is not
+  const __m128 fraction_scale = _mm_set1_ps(1.0f / 16777216.0f);
+  for (; i + 4 <= count; i += 4)
+  {
+    uint64_t p0 = position;
+    uint64_t p1 = p0 + step;
+    uint64_t p2 = p1 + step;
+    uint64_t p3 = p2 + step;
+    position    = p3 + step;
+    const float* s0 = src + (p0 >> 32);
+    const float* s1 = src + (p1 >> 32);
+    const float* s2 = src + (p2 >> 32);
+    const float* s3 = src + (p3 >> 32);
+    __m128 a        = _mm_setr_ps(s0[0], s1[0], s2[0], s3[0]);
+    __m128 b        = _mm_setr_ps(s0[1], s1[1], s2[1], s3[1]);
+
+    // The top 24 bits of the fraction convert to float exactly
+    __m128i fraction_bits = _mm_setr_epi32(static_cast<int32_t>((p0 & 0xFFFFFFFFu) >> 8),
+                                           static_cast<int32_t>((p1 & 0xFFFFFFFFu) >> 8),
+                                           static_cast<int32_t>((p2 & 0xFFFFFFFFu) >> 8),
+                                           static_cast<int32_t>((p3 & 0xFFFFFFFFu) >> 8));
+    __m128 fraction       = _mm_mul_ps(_mm_cvtepi32_ps(fraction_bits), fraction_scale);
+    _mm_storeu_ps(dst + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fraction)));
+  }
+#endif
+  for (; i < count; i++, position += step)
+  {
+    const float* s = src + (position >> 32);
+    float fraction = static_cast<float>((position & 0xFFFFFFFFu) >> 8) / 16777216.0f;
+    dst[i]         = s[0] + (s[1] - s[0]) * fraction;
+  }
+}
+
+// Adds count samples of src to out, scaled by a gain that starts at gain and grows by gain_step
+// per sample
+void accumulate(const float* src, uint32_t count, float gain, float gain_step, float* out)
+{
+  uint32_t i = 0;
+#if AUDIO_MIXER_SSE2
+  __m128 gains =
+      _mm_setr_ps(gain, gain + gain_step, gain + 2 * gain_step, gain + 3 * gain_step);
+  const __m128 step = _mm_set1_ps(4 * gain_step);
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 mixed = _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(src + i), gains));
+    _mm_storeu_ps(out + i, mixed);
+    gains = _mm_add_ps(gains, step);
+  }
+#endif
+  for (; i < count; i++)
+    out[i] += src[i] * (gain + gain_step * i);
+}
+
+// Interleaves left and right into stereo frames, clipped to [-1, 1]
+void interleave(const float* left, const float* right, uint32_t count, float* output)
+{
+  uint32_t i = 0;
+#if AUDIO_MIXER_SSE2
+  const __m128 low  = _mm_set1_ps(-1.0f);
+  const __m128 high = _mm_set1_ps(1.0f);
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 l = _mm_min_ps(_mm_max_ps(_mm_load_ps(left + i), low), high);
+    __m128 r = _mm_min_ps(_mm_max_ps(_mm_load_ps(right + i), low), high);
+    _mm_storeu_ps(output + 2 * i, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(output + 2 * i + 4, _mm_unpackhi_ps(l, r));
+  }
+#endif
+  for (; i < count; i++)
+  {
+    output[2 * i]     = std::clamp(left[i], -1.0f, 1.0f);
+    output[2 * i + 1] = std::clamp(right[i], -1.0f, 1.0f);
+  }
+}
+} // namespace
+
+AudioStreamBuffer::AudioStreamBuffer() :
+  left_(std::make_unique<float[]>(capacity_)),
+  right_(std::make_unique<float[]>(capacity_))
+{
+}
+
+uint32_t AudioStreamBuffer::writable() const
+{
+  uint64_t written = this->write_.load(std::memory_order_relaxed);
+  return capacity_ - static_cast<uint32_t>(written - this->read_.load(std::memory_order_acquire));
+}
+
+void AudioStreamBuffer::write(const float* left, const float* right, uint32_t count)
+{
+  uint64_t written = this->write_.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    this->left_[(written + i) & mask_]  = left[i];
+    this->right_[(written + i) & mask_] = right[i];
+  }
+  this->write_.store(written + count, std::memory_order_release);
+}
+
+uint32_t AudioStreamBuffer::read(float* left, float* right, uint32_t count)
+{
+  uint64_t read      = this->read_.load(std::memory_order_relaxed);
+  uint64_t available = this->write_.load(std::memory_order_acquire) - read;
+  count              = static_cast<uint32_t>(std::min<uint64_t>(count, available));
+
+  // At most two contiguous runs, before and after the end of the ring
+  uint32_t start = static_cast<uint32_t>(read & mask_);
+  uint32_t first = std::min(count, capacity_ - start);
+  std::copy_n(&this->left_[start], first, left);
+  std::copy_n(&this->right_[start], first, right);
+  std::copy_n(&this->left_[0], count - first, left + first);
+  std::copy_n(&this->right_[0], count - first, right + first);
+  this->read_.store(read + count, std::memory_order_release);
+  return count;
+}
+
+AudioMixer::AudioMixer(uint32_t sample_rate) : sample_rate_(sample_rate) { }
+
+bool AudioMixer::pushCommand(const AudioCommand& command)
+{
+  return this->commands_.tryPush(command);
+}
+
+bool AudioMixer::popFinished(uint32_t& voice)
+{
+  return this->finished_.tryPop(voice);
+}
+
+void AudioMixer::applyCommands()
+{
+  AudioCommand command;
+  while (this->commands_.tryPop(command))
+  {
+    Voice& voice = this->voices_[command.voice];
+
+    // Equal power panning keeps the loudness constant across the stereo field
+    float angle      = (std::clamp(command.pan, -1.0f, 1.0f) + 1.0f) * 0.78539816f;
+    float gain_left  = command.gain * std::cos(angle);
+    float gain_right = command.gain * std::sin(angle);
+
+    switch (command.type)
+    {
+    case AudioCommand::Type::Play:
+      voice.source         = command.source;
+      voice.position       = 0;
+      voice.gain[0]        = gain_left;
+      voice.gain[1]        = gain_right;
+      voice.target_gain[0] = gain_left;
+      voice.target_gain[1] = gain_right;
+      voice.loop           = command.loop;
+      voice.stopping       = false;
+
+      // Streams ignore the step, they are decoded at the mixer's rate
+      voice.step = pitchStep(command.pitch, command.source.sample_rate, this->sample_rate_);
+      if (!voice.active)
+      {
+        voice.active                         = true;
+        this->active_[this->active_count_++] = command.voice;
+      }
+      break;
+    case AudioCommand::Type::Stop:
+      voice.stopping       = true;
+      voice.target_gain[0] = 0.0f;
+      voice.target_gain[1] = 0.0f;
+      break;
+    case AudioCommand::Type::SetGain:
+      if (!voice.stopping)
+      {
+        voice.target_gain[0] = gain_left;
+        voice.target_gain[1] = gain_right;
+      }
+      break;
+    case AudioCommand::Type::SetPitch:
+      voice.step = pitchStep(command.pitch, voice.source.sample_rate, this->sample_rate_);
+      break;
+    }
+  }
+}
+
+bool AudioMixer::mixClip(Voice& voice, uint32_t frames)
+{
+  const AudioSource& source = voice.source;
+  float gain_step[2]        = { (voice.target_gain[0] - voice.gain[0]) / frames,
+                                (voice.target_gain[1] - voice.gain[1]) / frames };
+
+  // Adds a run of resampled or direct samples of every channel, mono goes to both sides
+  auto add_run = [&](uint32_t offset, uint32_t count, const float* const* channels) {
+    for (uint32_t side = 0; side < 2; side++)
+    {
+      const float* samples = channels[source.channels == 1 ? 0 : side];
+      float* out           = side == 0 ? this->left_ : this->right_;
+      accumulate(samples, count, voice.gain[side], gain_step[side], out + offset);
+      voice.gain[side] += gain_step[side] * count;
+    }
+  };
+
+  uint32_t channel_count = std::min(source.channels, 2u);
+  uint32_t done          = 0;
+  while (done < frames)
+  {
+    // Frames whose both neighbours are inside the clip take the vectorised path
+    uint64_t last_pair = static_cast<uint64_t>(source.frame_count - 1) << 32;
+    if (source.frame_count > 1 && voice.position < last_pair)
+    {
+      uint64_t run = std::min<uint64_t>((last_pair - voice.position + voice.step - 1) / voice.step,
+                                        frames - done);
+      auto count   = static_cast<uint32_t>(run);
+      const float* channels[2];
+      if (voice.step == fixed_one && (voice.position & 0xFFFFFFFFu) == 0)
+      {
+        // Playing at the mixer's rate, the samples are added as they are
+        for (uint32_t c = 0; c < channel_count; c++)
+          channels[c] = source.samples + c * source.frame_count + (voice.position >> 32);
+      } else
+      {
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+          resampleLinear(source.samples + c * source.frame_count,
+                         voice.position,
+                         voice.step,
+                         count,
+                         this->scratch_[c]);
+          channels[c] = this->scratch_[c];
+        }
+      }
+      add_run(done, count, channels);
+      voice.position += voice.step * count;
+      done += count;
+      continue;
+    }
+
+    // Past the last sample the clip wraps around or ends
+    uint64_t index = voice.position >> 32;
+    if (index >= source.frame_count)
+    {
+      if (!voice.loop)
+        return false;
+      voice.position -= static_cast<uint64_t>(source.frame_count) << 32;
+      continue;
+    }
+
+    // On the last sample, interpolate towards the start or silence one frame at a time
+    float fraction = static_cast<float>((voice.position & 0xFFFFFFFFu) >> 8) / 16777216.0f;
+    float frame[2];
+    const float* channels[2] = { &frame[0], &frame[1] };
+    for (uint32_t c = 0; c < channel_count; c++)
+    {
+      const float* samples = source.samples + c * source.frame_count;
+      float next           = voice.loop ? samples[0] : 0.0f;
+      frame[c]             = samples[index] + (next - samples[index]) * fraction;
+    }
+    add_run(done, 1, channels);
+    voice.position += voice.step;
+    done++;
+  }
+  return true;
+}
+
+bool AudioMixer::mixStream(Voice& voice, uint32_t frames)
+{
+  uint32_t count = voice.source.stream->read(this->scratch_[0], this->scratch_[1], frames);
+  for (uint32_t side = 0; side < 2; side++)
+  {
+    float gain_step = (voice.target_gain[side] - voice.gain[side]) / frames;
+    float* out      = side == 0 ? this->left_ : this->right_;
+    accumulate(this->scratch_[side], count, voice.gain[side], gain_step, out);
+    voice.gain[side] += gain_step * frames;
+  }
+
+  // A stream that ran dry ends once its producer is done, otherwise it is an underrun
+  if (count < frames)
+  {
+    if (voice.source.stream_finished->load(std::memory_order_acquire))
+      return false;
+    this->stream_underruns_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+void AudioMixer::finish(uint32_t active_index)
+{
+  uint32_t voice_index              = this->active_[active_index];
+  this->voices_[voice_index].active = false;
+  this->active_[active_index]       = this->active_[--this->active_count_];
+
+  // Never fails, a voice index is queued at most once until the game thread takes it back
+  this->finished_.tryPush(voice_index);
+}
+
+void AudioMixer::mix(float* output, uint32_t frames)
+{
+  this->applyCommands();
+
+  for (uint32_t offset = 0; offset < frames; offset += block_frames_)
+  {
+    uint32_t block = std::min(block_frames_, frames - offset);
+    std::fill_n(this->left_, block, 0.0f);
+    std::fill_n(this->right_, block, 0.0f);
+
+    for (uint32_t i = 0; i < this->active_count_;)
+    {
+      Voice& voice = this->voices_[this->active_[i]];
+      bool playing = voice.source.stream ? this->mixStream(voice, block)
+                                         : this->mixClip(voice, block);
+      if (!playing || voice.stopping)
+      {
+        this->finish(i);
+        continue;
+      }
+
+      // Gains reached their target by the end of the block
+      voice.gain[0] = voice.target_gain[0];
+      voice.gain[1] = voice.target_gain[1];
+      i++;
+    }
+    interleave(this->left_, this->right_, block, output + 2 * offset);
+  }
+  this->active_voice_count_.store(this->active_count_, std::memory_order_relaxed);
+}
+
+uint32_t AudioMixer::sampleRate() const
+{
+  return this->sample_rate_;
+}
+
+uint32_t AudioMixer::activeVoiceCount() const
+{
+  return this->active_voice_count_.load(std::memory_order_relaxed);
+}
+
+uint64_t AudioMixer::streamUnderruns() const
+{
+  return this->stream_underruns_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,353 @@
+#include "AudioSystem.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+AudioSystem::AudioSystem(Scheduler& scheduler) :
+  scheduler_(scheduler),
+  last_report_(std::chrono::steady_clock::now())
+{
+  if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+    throw std::runtime_error(SDL_GetError());
+
+  // Float stereo is mixed straight into the device buffer at whatever rate the device prefers,
+  // clips and streams are resampled to it
+  SDL_AudioSpec desired {};
+  desired.freq     = 48000;
+  desired.format   = AUDIO_F32SYS;
+  desired.channels = 2;
+  desired.samples  = 512;
+  desired.callback = &AudioSystem::audioCallback;
+  desired.userdata = this;
+  SDL_AudioSpec obtained {};
+  this->device_ =
+      SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+  if (this->device_ == 0)
+  {
+    std::string error = SDL_GetError();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    throw std::runtime_error(error);
+  }
+
+  this->mixer_              = std::make_unique<AudioMixer>(static_cast<uint32_t>(obtained.freq));
+  this->callback_budget_ns_ = static_cast<uint64_t>(obtained.samples * 1e9 * callback_budget_ /
+                                                    obtained.freq);
+  for (uint32_t index = AudioMixer::max_voices_; index > 0; index--)
+    this->free_voices_.push_back(index - 1);
+
+  LOG_INFO("Audio device opened at {} Hz with {} frame buffers", obtained.freq, obtained.samples);
+  SDL_PauseAudioDevice(this->device_, 0);
+}
+
+void SDLCALL AudioSystem::audioCallback(void* user_data, Uint8* stream, int length)
+{
+  static_cast<AudioSystem*>(user_data)->mixCallback(reinterpret_cast<float*>(stream),
+                                                    static_cast<uint32_t>(length) /
+                                                        (2 * sizeof(float)));
+}
+
+void AudioSystem::mixCallback(float* output, uint32_t frames)
+{
+  auto start = std::chrono::steady_clock::now();
+  this->mixer_->mix(output, frames);
+  auto elapsed = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+          .count());
+
+  this->callback_count_.fetch_add(1, std::memory_order_relaxed);
+  this->callback_total_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+  uint64_t max = this->callback_max_ns_.load(std::memory_order_relaxed);
+  while (elapsed > max &&
+         !this->callback_max_ns_.compare_exchange_weak(max, elapsed, std::memory_order_relaxed))
+    ;
+  if (elapsed > this->callback_budget_ns_)
+    this->callback_over_budget_.fetch_add(1, std::memory_order_relaxed);
+}
+
+AudioClipHandle AudioSystem::addClip(AudioClip clip)
+{
+  // The mixer would loop an empty clip forever
+  if (clip.sample_rate == 0 || clip.channels == 0 || clip.frame_count == 0 ||
+      clip.samples.size() < static_cast<size_t>(clip.frame_count) * clip.channels)
+    throw std::invalid_argument("Empty or malformed audio clip");
+  return this->clips_.insert(std::move(clip));
+}
+
+AudioVoiceHandle AudioSystem::allocateVoice()
+{
+  if (this->free_voices_.empty())
+    return {};
+  uint32_t index = this->free_voices_.back();
+  this->free_voices_.pop_back();
+  this->voices_[index].playing = true;
+  return AudioVoiceHandle(index, this->voices_[index].generation);
+}
+
+AudioVoice* AudioSystem::findVoice(AudioVoiceHandle handle)
+{
+  if (!handle || handle.index() >= AudioMixer::max_voices_)
+    return nullptr;
+  AudioVoice& voice = this->voices_[handle.index()];
+  return voice.playing && voice.generation == handle.generation() ? &voice : nullptr;
+}
+
+void AudioSystem::releaseVoice(uint32_t index)
+{
+  // Invalidate outstanding handles, generation zero is skipped so no handle is ever null
+  AudioVoice& voice = this->voices_[index];
+  voice.generation  = (voice.generation + 1) & AudioVoiceHandle::generation_mask_;
+  if (voice.generation == 0)
+    voice.generation = 1;
+  voice.playing = false;
+  this->free_voices_.push_back(index);
+
+  std::unique_ptr<AudioStream>& stream = this->voice_streams_[index];
+  if (stream && stream->decoding.load(std::memory_order_acquire))
+    this->retired_streams_.push_back(std::move(stream));
+  stream.reset();
+}
+
+bool AudioSystem::sendCommand(const AudioCommand& command)
+{
+  if (this->mixer_->pushCommand(command))
+    return true;
+  LOG_WARNING("Audio command queue is full, command for voice {} dropped", command.voice);
+  return false;
+}
+
+AudioVoiceHandle
+AudioSystem::play(AudioClipHandle clip, float gain, float pan, float pitch, bool loop)
+{
+  const AudioClip* audio_clip = this->clips_.get(clip);
+  if (!audio_clip)
+    return {};
+  AudioVoiceHandle voice = this->allocateVoice();
+  if (!voice)
+    return voice;
+
+  AudioCommand command {};
+  command.type               = AudioCommand::Type::Play;
+  command.voice              = voice.index();
+  command.source.samples     = audio_clip->samples.data();
+  command.source.sample_rate = audio_clip->sample_rate;
+  command.source.channels    = audio_clip->channels;
+  command.source.frame_count = audio_clip->frame_count;
+  command.gain               = gain;
+  command.pan                = pan;
+  command.pitch              = pitch;
+  command.loop               = loop;
+  if (!this->sendCommand(command))
+  {
+    this->releaseVoice(voice.index());
+    return {};
+  }
+  return voice;
+}
+
+void AudioSystem::decodeChunk(AudioStream& stream, uint32_t sample_rate)
+{
+  const WavFormat& format = stream.format;
+  uint32_t count          = std::min(stream.buffer.writable(), stream_chunk_frames_);
+  if (count == 0 || stream.finished.load(std::memory_order_relaxed))
+    return;
+
+  // Source frames covering the chunk and the one after it, which the last frame interpolates to
+  double ratio      = static_cast<double>(format.sample_rate) / sample_rate;
+  auto first        = static_cast<uint64_t>(stream.position);
+  double offset     = stream.position - static_cast<double>(first);
+  auto source_count = static_cast<uint32_t>(offset + (count - 1) * ratio) + 2;
+  std::vector<std::vector<float>> channels(format.channels, std::vector<float>(source_count));
+  std::vector<float*> outputs(format.channels);
+  for (uint32_t decoded = 0; decoded < source_count;)
+  {
+    // Looping streams continue from their start, others are followed by silence
+    uint64_t frame = first + decoded;
+    uint32_t run   = source_count - decoded;
+    if (stream.loop)
+    {
+      frame %= format.frame_count;
+      run = static_cast<uint32_t>(std::min<uint64_t>(run, format.frame_count - frame));
+    }
+    for (uint32_t channel = 0; channel < format.channels; channel++)
+      outputs[channel] = channels[channel].data() + decoded;
+    decodeWav(format, stream.data, frame, run, outputs.data());
+    decoded += run;
+  }
+
+  // Only the first two channels are played, mono goes to both sides
+  const float* source_left  = channels[0].data();
+  const float* source_right = channels[format.channels > 1 ? 1 : 0].data();
+  std::vector<float> left(count);
+  std::vector<float> right(count);
+  uint32_t produced = count;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    double position = offset + i * ratio;
+    auto index      = static_cast<uint32_t>(position);
+    if (!stream.loop && first + index >= format.frame_count)
+    {
+      produced = i;
+      break;
+    }
+    auto fraction = static_cast<float>(position - index);
+    auto lerp     = [&](const float* samples) {
+      return samples[index] + (samples[index + 1] - samples[index]) * fraction;
+    };
+    left[i]  = lerp(source_left);
+    right[i] = lerp(source_right);
+  }
+  stream.buffer.write(left.data(), right.data(), produced);
+
+  stream.position += count * ratio;
+  if (stream.loop)
+    stream.position = std::fmod(stream.position, static_cast<double>(format.frame_count));
+  else if (produced < count)
+    stream.finished.store(true, std::memory_order_release);
+}
+
+Task<void> AudioSystem::refillStream(AudioStream& stream)
+{
+  uint32_t sample_rate = this->sampleRate();
+  co_await this->scheduler_.schedule();
+  decodeChunk(stream, sample_rate);
+
+  // Last access to the stream, the main thread may destroy it from here on
+  stream.decoding.store(false, std::memory_order_release);
+}
+
+Task<AudioVoiceHandle> AudioSystem::playStream(std::string file_name, float gain, bool loop)
+{
+  // Members are only touched on the main thread, workers get a copy of the rate
+  uint32_t sample_rate = this->sampleRate();
+  auto stream          = std::make_unique<AudioStream>();
+  stream->data         = co_await this->scheduler_.readFile(std::move(file_name));
+  stream->format       = parseWav(stream->data);
+  stream->loop         = loop;
+  if (stream->format.frame_count == 0)
+    throw std::runtime_error("WAVE file without samples");
+  decodeChunk(*stream, sample_rate);
+
+  co_await this->scheduler_.resumeOnMainThread();
+  AudioVoiceHandle voice = this->allocateVoice();
+  if (!voice)
+    co_return voice;
+
+  AudioCommand command {};
+  command.type                   = AudioCommand::Type::Play;
+  command.voice                  = voice.index();
+  command.source.stream          = &stream->buffer;
+  command.source.stream_finished = &stream->finished;
+  command.gain                   = gain;
+  if (!this->sendCommand(command))
+  {
+    this->releaseVoice(voice.index());
+    co_return AudioVoiceHandle();
+  }
+  this->voice_streams_[voice.index()] = std::move(stream);
+  co_return voice;
+}
+
+void AudioSystem::stop(AudioVoiceHandle voice)
+{
+  if (!this->findVoice(voice))
+    return;
+  AudioCommand command {};
+  command.type  = AudioCommand::Type::Stop;
+  command.voice = voice.index();
+  this->sendCommand(command);
+}
+
+void AudioSystem::setGain(AudioVoiceHandle voice, float gain, float pan)
+{
+  if (!this->findVoice(voice))
+    return;
+  AudioCommand command {};
+  command.type  = AudioCommand::Type::SetGain;
+  command.voice = voice.index();
+  command.gain  = gain;
+  command.pan   = pan;
+  this->sendCommand(command);
+}
+
+void AudioSystem::setPitch(AudioVoiceHandle voice, float pitch)
+{
+  if (!this->findVoice(voice))
+    return;
+  AudioCommand command {};
+  command.type  = AudioCommand::Type::SetPitch;
+  command.voice = voice.index();
+  command.pitch = pitch;
+  this->sendCommand(command);
+}
+
+void AudioSystem::update()
+{
+  PROFILE_ZONE("AudioSystem::update");
+  uint32_t index;
+  while (this->mixer_->popFinished(index))
+    this->releaseVoice(index);
+  std::erase_if(this->retired_streams_, [](const std::unique_ptr<AudioStream>& stream) {
+    return !stream->decoding.load(std::memory_order_acquire);
+  });
+
+  // The main thread owns the producer side of a ring while no worker decodes into it
+  for (std::unique_ptr<AudioStream>& stream : this->voice_streams_)
+  {
+    if (!stream || stream->decoding.load(std::memory_order_acquire) ||
+        stream->finished.load(std::memory_order_relaxed) ||
+        stream->buffer.writable() < stream_chunk_frames_)
+      continue;
+    stream->decoding.store(true, std::memory_order_relaxed);
+    this->scheduler_.spawn(this->refillStream(*stream));
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - this->last_report_ < std::chrono::duration<double>(stats_interval_))
+    return;
+  this->last_report_ = now;
+
+  uint64_t count       = this->callback_count_.exchange(0, std::memory_order_relaxed);
+  uint64_t total_ns    = this->callback_total_ns_.exchange(0, std::memory_order_relaxed);
+  uint64_t max_ns      = this->callback_max_ns_.exchange(0, std::memory_order_relaxed);
+  uint64_t over_budget = this->callback_over_budget_.exchange(0, std::memory_order_relaxed);
+  LOG_INFO("Audio: {} voices, {} callbacks taking {} us on average and {} us at most",
+           this->mixer_->activeVoiceCount(),
+           count,
+           count ? total_ns / 1000.0 / static_cast<double>(count) : 0.0,
+           max_ns / 1000.0);
+  if (over_budget > 0)
+  {
+    LOG_WARNING("Audio callback exceeded its {} us budget {} times",
+                this->callback_budget_ns_ / 1000.0,
+                over_budget);
+  }
+  uint64_t underruns = this->mixer_->streamUnderruns();
+  if (underruns != this->reported_underruns_)
+  {
+    LOG_WARNING("Audio streams ran out of decoded frames {} times",
+                underruns - this->reported_underruns_);
+    this->reported_underruns_ = underruns;
+  }
+}
+
+uint32_t AudioSystem::sampleRate() const
+{
+  return this->mixer_->sampleRate();
+}
+
+AudioSystem::~AudioSystem()
+{
+  // Closing the device waits for a running callback, workers may still be decoding streams
+  SDL_CloseAudioDevice(this->device_);
+  auto decoding = [](const std::unique_ptr<AudioStream>& stream) {
+    return stream && stream->decoding.load(std::memory_order_acquire);
+  };
+  while (std::any_of(this->voice_streams_.begin(), this->voice_streams_.end(), decoding) ||
+         std::any_of(this->retired_streams_.begin(), this->retired_streams_.end(), decoding))
+    std::this_thread::yield();
+  SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
@@ -0,0 +1,321 @@
+#include "Broadphase.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BROADPHASE_SSE2 1
+#else
+#define BROADPHASE_SSE2 0
+#endif
+
+void Broadphase::resize(uint32_t count)
+{
+  // New bodies start inverted so they overlap nothing, and at the end of the order
+  uint32_t old_count = this->size();
+  for (uint32_t axis = 0; axis < 2; axis++)
+  {
+    this->min_[axis].resize(count, std::numeric_limits<float>::max());
+    this->max_[axis].resize(count, std::numeric_limits<float>::lowest());
+  }
+  if (count < old_count)
+    std::erase_if(this->entries_, [count](SortEntry entry) { return entry.body >= count; });
+  for (uint32_t body = old_count; body < count; body++)
+    this->entries_.push_back({ std::numeric_limits<float>::max(), body });
+}
+
+uint32_t Broadphase::size() const
+{
+  return static_cast<uint32_t>(this->min_[0].size());
+}
+
+void Broadphase::setBounds(uint32_t body, float min_x, float min_y, float max_x, float max_y)
+{
+  this->min_[0][body] = min_x;
+  this->min_[1][body] = min_y;
+  this->max_[0][body] = max_x;
+  this->max_[1][body] = max_y;
+}
+
+void Broadphase::sort()
+{
+  uint32_t count = this->size();
+
+  // Spread of the centres, extent of the bounds and total size of the bodies on each axis
+  double sum[2]        = {};
+  double square[2]     = {};
+  double total_size[2] = {};
+  float lowest[2]      = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+  float highest[2] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+  uint32_t bounded = 0;
+  for (uint32_t axis = 0; axis < 2; axis++)
+  {
+    const float* min = this->min_[axis].data();
+    const float* max = this->max_[axis].data();
+    for (uint32_t body = 0; body < count; body++)
+    {
+      if (min[body] > max[body])
+        continue;
+      double centre = (static_cast<double>(min[body]) + max[body]) * 0.5;
+      sum[axis] += centre;
+      square[axis] += centre * centre;
+      total_size[axis] += max[body] - min[body];
+      lowest[axis]  = std::min(lowest[axis], min[body]);
+      highest[axis] = std::max(highest[axis], max[body]);
+      bounded += axis == 0;
+    }
+  }
+
+  // Sweeping along the axis the centres spread most on leaves the fewest candidates. The axis
+  // only changes when the other one is clearly better, as changing it costs a full sort.
+  double variance[2];
+  for (uint32_t axis = 0; axis < 2; axis++)
+    variance[axis] = square[axis] - sum[axis] * sum[axis] / std::max<uint32_t>(bounded, 1);
+  uint32_t other_axis = 1 - this->sweep_axis_;
+  bool full_sort      = false;
+  if (variance[other_axis] > variance[this->sweep_axis_] * 1.25)
+  {
+    this->sweep_axis_ = other_axis;
+    other_axis        = 1 - other_axis;
+    full_sort         = true;
+  }
+
+  // Bands narrower than twice the average body would hold most bodies several times
+  this->band_count_  = 1;
+  this->band_origin_ = lowest[other_axis];
+  this->band_scale_  = 0.0f;
+  if (bounded > 0)
+  {
+    double extent       = static_cast<double>(highest[other_axis]) - lowest[other_axis];
+    double average_size = std::max(total_size[other_axis] / bounded, 1e-6);
+    double band_count   = std::min<double>({ static_cast<double>(max_bands_),
+                                             static_cast<double>(bounded / bodies_per_band_),
+                                             std::floor(extent / (2.0 * average_size)) });
+    this->band_count_   = static_cast<uint32_t>(std::max(band_count, 1.0));
+    if (extent > 0.0)
+      this->band_scale_ = static_cast<float>(this->band_count_ / extent);
+  }
+
+  // Refresh the keys in the previous order, then repair it with an insertion sort over the
+  // contiguous entries. Sorting from scratch is cheaper once bodies moved too far.
+  const float* key   = this->min_[this->sweep_axis_].data();
+  SortEntry* entries = this->entries_.data();
+  for (uint32_t i = 0; i < count; i++)
+    entries[i].key = key[entries[i].body];
+  uint64_t moves  = 0;
+  uint64_t budget = static_cast<uint64_t>(count) * max_moves_per_body_;
+  for (uint32_t i = 1; i < count && !full_sort; i++)
+  {
+    SortEntry entry = entries[i];
+    uint32_t j      = i;
+    for (; j > 0 && entries[j - 1].key > entry.key; j--)
+      entries[j] = entries[j - 1];
+    entries[j] = entry;
+    moves += i - j;
+    full_sort = moves > budget;
+  }
+  if (full_sort)
+  {
+    std::sort(this->entries_.begin(),
+              this->entries_.end(),
+              [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+    this->full_sorts_++;
+  }
+}
+
+uint32_t Broadphase::bandOf(float coordinate) const
+{
+  float band = (coordinate - this->band_origin_) * this->band_scale_;
+  return static_cast<uint32_t>(std::clamp(band, 0.0f, static_cast<float>(this->band_count_ - 1)));
+}
+
+void Broadphase::fillBands()
+{
+  const uint32_t other_axis = 1 - this->sweep_axis_;
+  auto count                = static_cast<uint32_t>(this->entries_.size());
+
+  // Gather the bounds in sweep order and count the bodies of each band, bodies with empty bounds
+  // are in none
+  std::vector<uint32_t>& offsets = this->band_offsets_;
+  offsets.assign(this->band_count_ + 1, 0);
+  this->sorted_bands_.resize(count);
+  for (uint32_t axis = 0; axis < 2; axis++)
+  {
+    this->sorted_min_[axis].resize(count);
+    this->sorted_max_[axis].resize(count);
+  }
+  for (uint32_t i = 0; i < count; i++)
+  {
+    uint32_t body = this->entries_[i].body;
+    for (uint32_t axis = 0; axis < 2; axis++)
+    {
+      this->sorted_min_[axis][i] = this->min_[axis][body];
+      this->sorted_max_[axis][i] = this->max_[axis][body];
+    }
+    float other_min = this->sorted_min_[other_axis][i];
+    float other_max = this->sorted_max_[other_axis][i];
+    if (other_min > other_max)
+    {
+      this->sorted_bands_[i] = { 1, 0 };
+      continue;
+    }
+    BandSpan span          = { this->bandOf(other_min), this->bandOf(other_max) };
+    this->sorted_bands_[i] = span;
+    for (uint32_t band = span.first; band <= span.last; band++)
+      offsets[band + 1]++;
+  }
+  for (uint32_t band = 0; band < this->band_count_; band++)
+    offsets[band + 1] += offsets[band] + padding_;
+
+  // Copy the bodies in sweep order, so every band is sorted, and pad each band with bodies that
+  // start past everything
+  size_t total = offsets[this->band_count_];
+  this->band_bodies_.resize(total);
+  for (uint32_t axis = 0; axis < 2; axis++)
+  {
+    this->band_min_[axis].assign(total, std::numeric_limits<float>::max());
+    this->band_max_[axis].assign(total, std::numeric_limits<float>::lowest());
+  }
+  std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    BandSpan span = this->sorted_bands_[i];
+    for (uint32_t band = span.first; band <= span.last; band++)
+    {
+      uint32_t index            = next[band]++;
+      this->band_bodies_[index] = this->entries_[i].body;
+      this->band_min_[0][index] = this->sorted_min_[0][i];
+      this->band_min_[1][index] = this->sorted_min_[1][i];
+      this->band_max_[0][index] = this->sorted_max_[0][i];
+      this->band_max_[1][index] = this->sorted_max_[1][i];
+    }
+  }
+
+  // Crowded bands are split into several ranges
+  this->ranges_.clear();
+  for (uint32_t band = 0; band < this->band_count_; band++)
+  {
+    uint32_t end = offsets[band + 1] - padding_;
+    for (uint32_t begin = offsets[band]; begin < end; begin += range_size_)
+      this->ranges_.push_back({ band, begin, std::min(begin + range_size_, end) });
+  }
+}
+
+void Broadphase::sweep(const SweepRange& range, std::vector<Pair>& pairs) const
+{
+  const uint32_t sweep_axis = this->sweep_axis_;
+  const uint32_t other_axis = 1 - sweep_axis;
+  const float* sweep_min    = this->band_min_[sweep_axis].data();
+  const float* sweep_max    = this->band_max_[sweep_axis].data();
+  const float* other_min    = this->band_min_[other_axis].data();
+  const float* other_max    = this->band_max_[other_axis].data();
+  const uint32_t* bodies    = this->band_bodies_.data();
+
+  // A pair is in every band both bodies overlap, only the band where their overlap starts on the
+  // band axis reports it
+  auto addPair = [&](uint32_t i, uint32_t j) {
+    if (this->bandOf(std::max(other_min[i], other_min[j])) != range.band)
+      return;
+    pairs.push_back({ std::min(bodies[i], bodies[j]), std::max(bodies[i], bodies[j]) });
+  };
+
+  for (uint32_t i = range.begin; i < range.end; i++)
+  {
+    // Later bodies are candidates until one starts past this body's end on the sweep axis
+    float end_i       = sweep_max[i];
+    float other_min_i = other_min[i];
+    float other_max_i = other_max[i];
+#if BROADPHASE_SSE2
+    __m128 end_4       = _mm_set1_ps(end_i);
+    __m128 other_min_4 = _mm_set1_ps(other_min_i);
+    __m128 other_max_4 = _mm_set1_ps(other_max_i);
+    for (uint32_t j = i + 1;; j += 4)
+    {
+      __m128 candidate = _mm_cmple_ps(_mm_loadu_ps(sweep_min + j), end_4);
+      __m128 overlap   = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(other_min + j), other_max_4),
+                                  _mm_cmpge_ps(_mm_loadu_ps(other_max + j), other_min_4));
+      auto mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(candidate, overlap)));
+      for (; mask != 0; mask &= mask - 1)
+        addPair(i, j + std::countr_zero(mask));
+      if (_mm_movemask_ps(candidate) != 0xF)
+        break;
+    }
+#else
+    for (uint32_t j = i + 1; sweep_min[j] <= end_i; j++)
+    {
+      if (other_min[j] <= other_max_i && other_max[j] >= other_min_i)
+        addPair(i, j);
+    }
+#endif
+  }
+}
+
+void Broadphase::sweepRanges(std::atomic<uint32_t>& next)
+{
+  PROFILE_ZONE("sweepRanges");
+  auto range_count = static_cast<uint32_t>(this->ranges_.size());
+  for (;;)
+  {
+    uint32_t range = next.fetch_add(1, std::memory_order_relaxed);
+    if (range >= range_count)
+      return;
+    this->sweep(this->ranges_[range], this->range_pairs_[range]);
+  }
+}
+
+Task<void> Broadphase::sweepOnWorker(Scheduler& scheduler,
+                                     std::atomic<uint32_t>& next,
+                                     std::latch& done)
+{
+  co_await scheduler.schedule();
+  this->sweepRanges(next);
+  done.count_down();
+}
+
+void Broadphase::findPairs(Scheduler& scheduler, std::vector<Pair>& pairs)
+{
+  pairs.clear();
+  this->sort();
+  this->fillBands();
+  if (this->size() < parallel_threshold_ || scheduler.workerCount() == 0)
+  {
+    for (const SweepRange& range : this->ranges_)
+      this->sweep(range, pairs);
+    return;
+  }
+
+  // Ranges are handed out one at a time, bodies in crowded areas take longer to sweep
+  auto range_count = static_cast<uint32_t>(this->ranges_.size());
+  this->range_pairs_.resize(range_count);
+  for (std::vector<Pair>& range : this->range_pairs_)
+    range.clear();
+  auto worker_count = static_cast<uint32_t>(
+      std::min<size_t>(scheduler.workerCount(), std::max(range_count, 1u) - 1));
+  std::atomic<uint32_t> next { 0 };
+  std::latch done(worker_count);
+  for (uint32_t worker = 0; worker < worker_count; worker++)
+    scheduler.spawn(this->sweepOnWorker(scheduler, next, done));
+  this->sweepRanges(next);
+  done.wait();
+
+  size_t pair_count = 0;
+  for (const std::vector<Pair>& range : this->range_pairs_)
+    pair_count += range.size();
+  pairs.reserve(pair_count);
+  for (const std::vector<Pair>& range : this->range_pairs_)
+    pairs.insert(pairs.end(), range.begin(), range.end());
+}
+
+uint32_t Broadphase::bandCount() const
+{
+  return this->band_count_;
+}
+
+uint64_t Broadphase::fullSortCount() const
+{
+  return this->full_sorts_;
+}
@@ -0,0 +1,77 @@
+#include "CaptureFile.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr char capture_magic[8] = "VKCAPTR";
+} // namespace
+
+CaptureFile::CaptureFile(const fs::path& file) : file_(file)
+{
+  const std::byte* begin = this->file_.data();
+  const std::byte* end   = begin + this->file_.size();
+  auto header            = reinterpret_cast<const CaptureHeader*>(begin);
+  if (this->file_.size() < sizeof(CaptureHeader) ||
+      std::memcmp(header->magic, capture_magic, sizeof(capture_magic)) != 0)
+    throw std::runtime_error(file.string() + " is not a capture file");
+  if (header->byte_order != CaptureHeader::byte_order_mark_)
+    throw std::runtime_error(file.string() + " was written with the other byte order");
+  if (header->version != CaptureHeader::current_version_)
+    throw std::runtime_error(file.string() + " has unsupported capture version " +
+                             std::to_string(header->version));
+  if (header->size != this->file_.size())
+    throw std::runtime_error(file.string() + " is truncated");
+  if (!header->root.within(begin, end))
+    throw std::runtime_error(file.string() + " has an invalid root");
+  this->root_ = header->root.get();
+
+  // Every array is checked before anything reads through it, nested ones included
+  auto check = [&](const auto& array)
+  {
+    if (!array.within(begin, end))
+      throw std::runtime_error(file.string() + " has an array outside the file");
+  };
+  const CaptureRoot& root = *this->root_;
+  check(root.buffers);
+  for (const CaptureBuffer& buffer : root.buffers)
+    check(buffer.contents);
+  check(root.images);
+  for (const CaptureImage& image : root.images)
+    check(image.contents);
+  check(root.samplers);
+  check(root.render_passes);
+  for (const CaptureRenderPass& render_pass : root.render_passes)
+    check(render_pass.dependencies);
+  check(root.framebuffers);
+  check(root.binders);
+  for (const CaptureBinder& binder : root.binders)
+    check(binder.bindings);
+  check(root.pipelines);
+  for (const CapturePipeline& pipeline : root.pipelines)
+  {
+    check(pipeline.vertex_shader);
+    check(pipeline.fragment_shader);
+    check(pipeline.vertex_bindings);
+    check(pipeline.vertex_attributes);
+    check(pipeline.set_layouts);
+    check(pipeline.push_constant_ranges);
+  }
+  check(root.frames);
+  for (const CaptureFrame& frame : root.frames)
+  {
+    check(frame.buffer_writes);
+    for (const CaptureBufferWrite& write : frame.buffer_writes)
+      check(write.contents);
+    check(frame.commands);
+  }
+}
+
+const CaptureRoot& CaptureFile::root() const
+{
+  return *this->root_;
+}
@@ -0,0 +1,284 @@
+#include "CommandRecorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+CommandRecorder::CommandRecorder(vk::CommandBuffer command_buffer, FrameCapture* capture) :
+  command_buffer_(command_buffer),
+  capture_(capture)
+{
+}
+
+vk::CommandBuffer CommandRecorder::commandBuffer() const
+{
+  return this->command_buffer_;
+}
+
+uint32_t CommandRecorder::drawCount() const
+{
+  return this->draw_count_;
+}
+
+uint32_t CommandRecorder::pipelineBindCount() const
+{
+  return this->pipeline_bind_count_;
+}
+
+void CommandRecorder::beginRenderPass(const vk::RenderPassBeginInfo& begin_info)
+{
+  this->command_buffer_.beginRenderPass(begin_info, vk::SubpassContents::eInline);
+  if (!this->capture_)
+    return;
+  FrameCapture& capture = *this->capture_;
+  capture.beginCommand(CaptureOp::BeginRenderPass);
+  capture.put(capture.renderPassIndex(begin_info.renderPass));
+  capture.put(capture.framebufferIndex(begin_info.framebuffer));
+  capture.put(begin_info.renderArea.offset.x);
+  capture.put(begin_info.renderArea.offset.y);
+  capture.put(begin_info.renderArea.extent.width);
+  capture.put(begin_info.renderArea.extent.height);
+  capture.put(begin_info.clearValueCount);
+  for (uint32_t i = 0; i < begin_info.clearValueCount; i++)
+  {
+    for (float channel : begin_info.pClearValues[i].color.float32)
+      capture.put(channel);
+  }
+  capture.endCommand();
+}
+
+void CommandRecorder::endRenderPass()
+{
+  this->command_buffer_.endRenderPass();
+  if (this->capture_)
+    this->capture_->command(CaptureOp::EndRenderPass);
+}
+
+void CommandRecorder::setViewport(const vk::Viewport& viewport)
+{
+  this->command_buffer_.setViewport(0, viewport);
+  if (this->capture_)
+  {
+    this->capture_->command(CaptureOp::SetViewport,
+                            viewport.x,
+                            viewport.y,
+                            viewport.width,
+                            viewport.height,
+                            viewport.minDepth,
+                            viewport.maxDepth);
+  }
+}
+
+void CommandRecorder::setScissor(const vk::Rect2D& scissor)
+{
+  this->command_buffer_.setScissor(0, scissor);
+  if (this->capture_)
+  {
+    this->capture_->command(CaptureOp::SetScissor,
+                            scissor.offset.x,
+                            scissor.offset.y,
+                            scissor.extent.width,
+                            scissor.extent.height);
+  }
+}
+
+void CommandRecorder::clearAttachment(const vk::ClearAttachment& attachment,
+                                      const vk::ClearRect& rect)
+{
+  this->command_buffer_.clearAttachments(attachment, rect);
+  if (!this->capture_)
+    return;
+  FrameCapture& capture = *this->capture_;
+  capture.beginCommand(CaptureOp::ClearAttachment);
+  capture.put(static_cast<uint32_t>(attachment.aspectMask));
+  capture.put(attachment.colorAttachment);
+  for (float channel : attachment.clearValue.color.float32)
+    capture.put(channel);
+  capture.put(rect.rect.offset.x);
+  capture.put(rect.rect.offset.y);
+  capture.put(rect.rect.extent.width);
+  capture.put(rect.rect.extent.height);
+  capture.put(rect.baseArrayLayer);
+  capture.put(rect.layerCount);
+  capture.endCommand();
+}
+
+void CommandRecorder::bindPipeline(const Pipeline& pipeline)
+{
+  this->command_buffer_.bindPipeline(pipeline.bind_point, pipeline.pipeline);
+  this->pipeline_bind_count_++;
+  if (this->capture_)
+  {
+    this->capture_->command(CaptureOp::BindPipeline,
+                            this->capture_->pipelineIndex(pipeline.pipeline));
+  }
+}
+
+void CommandRecorder::pushConstants(const Pipeline& pipeline,
+                                    vk::ShaderStageFlags stages,
+                                    uint32_t offset,
+                                    uint32_t size,
+                                    const void* values)
+{
+  this->command_buffer_.pushConstants(pipeline.layout, stages, offset, size, values);
+  if (!this->capture_)
+    return;
+  FrameCapture& capture = *this->capture_;
+  capture.beginCommand(CaptureOp::PushConstants);
+  capture.put(capture.pipelineIndex(pipeline.pipeline));
+  capture.put(static_cast<uint32_t>(stages));
+  capture.put(offset);
+  capture.put(size);
+  for (uint32_t word_offset = 0; word_offset < size; word_offset += sizeof(uint32_t))
+  {
+    uint32_t word = 0;
+    std::memcpy(&word,
+                static_cast<const char*>(values) + word_offset,
+                std::min<uint32_t>(sizeof(uint32_t), size - word_offset));
+    capture.put(word);
+  }
+  capture.endCommand();
+}
+
+void CommandRecorder::bindVertexBuffer(uint32_t binding,
+                                       const Buffer& buffer,
+                                       vk::DeviceSize offset)
+{
+  this->command_buffer_.bindVertexBuffers(binding, buffer.buffer, offset);
+  if (this->capture_)
+  {
+    this->capture_->command(
+        CaptureOp::BindVertexBuffer, binding, this->capture_->bufferIndex(buffer.buffer), offset);
+  }
+}
+
+void CommandRecorder::bindIndexBuffer(const Buffer& buffer,
+                                      vk::DeviceSize offset,
+                                      vk::IndexType index_type)
+{
+  this->command_buffer_.bindIndexBuffer(buffer.buffer, offset, index_type);
+  if (this->capture_)
+  {
+    this->capture_->command(CaptureOp::BindIndexBuffer,
+                            this->capture_->bufferIndex(buffer.buffer),
+                            offset,
+                            static_cast<uint32_t>(index_type));
+  }
+}
+
+Result<void> CommandRecorder::bindDescriptors(DescriptorBinder& binder, const DescriptorInfo* infos)
+{
+  Result<void> result = binder.bind(this->command_buffer_, infos);
+  if (!result || !this->capture_)
+    return result;
+  FrameCapture& capture = *this->capture_;
+  capture.beginCommand(CaptureOp::BindDescriptors);
+  capture.put(capture.binderIndex(binder));
+  const std::vector<vk::DescriptorSetLayoutBinding>& bindings = binder.bindings();
+  for (size_t i = 0; i < bindings.size(); i++)
+  {
+    if (captureDescriptorIsBuffer(bindings[i].descriptorType))
+    {
+      capture.put(capture.bufferIndex(infos[i].buffer.buffer));
+      capture.put(infos[i].buffer.offset);
+      capture.put(infos[i].buffer.range);
+    } else
+    {
+      capture.put(capture.samplerIndex(infos[i].image.sampler));
+      capture.put(capture.viewIndex(infos[i].image.imageView));
+      capture.put(static_cast<uint32_t>(infos[i].image.imageLayout));
+    }
+  }
+  capture.endCommand();
+  return result;
+}
+
+void CommandRecorder::draw(uint32_t vertex_count,
+                           uint32_t instance_count,
+                           uint32_t first_vertex,
+                           uint32_t first_instance)
+{
+  this->command_buffer_.draw(vertex_count, instance_count, first_vertex, first_instance);
+  this->draw_count_++;
+  if (this->capture_)
+  {
+    this->capture_->command(
+        CaptureOp::Draw, vertex_count, instance_count, first_vertex, first_instance);
+  }
+}
+
+void CommandRecorder::drawIndexed(uint32_t index_count,
+                                  uint32_t instance_count,
+                                  uint32_t first_index,
+                                  int32_t vertex_offset,
+                                  uint32_t first_instance)
+{
+  this->command_buffer_.drawIndexed(
+      index_count, instance_count, first_index, vertex_offset, first_instance);
+  this->draw_count_++;
+  if (this->capture_)
+  {
+    this->capture_->command(CaptureOp::DrawIndexed,
+                            index_count,
+                            instance_count,
+                            first_index,
+                            vertex_offset,
+                            first_instance);
+  }
+}
+
+void CommandRecorder::imageBarrier(vk::PipelineStageFlags src_stages,
+                                   vk::PipelineStageFlags dst_stages,
+                                   const vk::ImageMemoryBarrier& barrier)
+{
+  this->command_buffer_.pipelineBarrier(src_stages, dst_stages, {}, nullptr, nullptr, barrier);
+  if (!this->capture_)
+    return;
+  const vk::ImageSubresourceRange& range = barrier.subresourceRange;
+  this->capture_->command(CaptureOp::ImageBarrier,
+                          static_cast<uint32_t>(src_stages),
+                          static_cast<uint32_t>(dst_stages),
+                          static_cast<uint32_t>(barrier.srcAccessMask),
+                          static_cast<uint32_t>(barrier.dstAccessMask),
+                          static_cast<uint32_t>(barrier.oldLayout),
+                          static_cast<uint32_t>(barrier.newLayout),
+                          this->capture_->imageIndex(barrier.image),
+                          static_cast<uint32_t>(range.aspectMask),
+                          range.baseMipLevel,
+                          range.levelCount,
+                          range.baseArrayLayer,
+                          range.layerCount);
+}
+
+void CommandRecorder::copyBufferToImage(const Buffer& buffer,
+                                        const Image& image,
+                                        vk::ImageLayout layout,
+                                        const std::vector<vk::BufferImageCopy>& regions)
+{
+  this->command_buffer_.copyBufferToImage(buffer.buffer, image.image, layout, regions);
+  if (!this->capture_)
+    return;
+  FrameCapture& capture = *this->capture_;
+  capture.beginCommand(CaptureOp::CopyBufferToImage);
+  capture.put(capture.bufferIndex(buffer.buffer));
+  capture.put(capture.imageIndex(image.image));
+  capture.put(static_cast<uint32_t>(layout));
+  capture.put(static_cast<uint32_t>(regions.size()));
+  for (const vk::BufferImageCopy& region : regions)
+  {
+    const vk::ImageSubresourceLayers& subresource = region.imageSubresource;
+    capture.put(region.bufferOffset);
+    capture.put(region.bufferRowLength);
+    capture.put(region.bufferImageHeight);
+    capture.put(static_cast<uint32_t>(subresource.aspectMask));
+    capture.put(subresource.mipLevel);
+    capture.put(subresource.baseArrayLayer);
+    capture.put(subresource.layerCount);
+    capture.put(region.imageOffset.x);
+    capture.put(region.imageOffset.y);
+    capture.put(region.imageOffset.z);
+    capture.put(region.imageExtent.width);
+    capture.put(region.imageExtent.height);
+    capture.put(region.imageExtent.depth);
+  }
+  capture.endCommand();
+}
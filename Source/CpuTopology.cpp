@@ -0,0 +1,325 @@
+#include "CpuTopology.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+// Reads the first line of a /sys file, returns nullopt if it cannot be read
+std::optional<std::string> readSysLine(const std::string& path)
+{
+  std::ifstream file(path);
+  std::string line;
+  if (!file.is_open() || !std::getline(file, line))
+    return std::nullopt;
+  return line;
+}
+
+std::optional<uint32_t> readSysNumber(const std::string& path)
+{
+  auto line = readSysLine(path);
+  if (!line)
+    return std::nullopt;
+  try
+  {
+    return static_cast<uint32_t>(std::stoul(*line));
+  } catch (const std::exception&)
+  {
+    return std::nullopt;
+  }
+}
+
+// Every logical CPU as its own performance core, used when /sys is unavailable
+std::vector<LogicalCpu> fallbackCpus()
+{
+  std::vector<LogicalCpu> cpus;
+  uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+  for (uint32_t i = 0; i < count; i++)
+    cpus.push_back({ i, 0, i, 0, 1024, false });
+  return cpus;
+}
+
+#ifdef __linux__
+std::vector<LogicalCpu> detectLinuxCpus()
+{
+  const std::string cpu_root = "/sys/devices/system/cpu/";
+  auto online                = readSysLine(cpu_root + "online");
+  if (!online)
+    return {};
+
+  // Hybrid Intel processors list their efficiency cores under the cpu_atom PMU
+  std::set<uint32_t> atom_cpus;
+  if (auto atom_list = readSysLine("/sys/devices/cpu_atom/cpus"))
+  {
+    for (uint32_t id : CpuTopology::parseCpuList(*atom_list))
+      atom_cpus.insert(id);
+  }
+
+  std::vector<LogicalCpu> cpus;
+  for (uint32_t id : CpuTopology::parseCpuList(*online))
+  {
+    std::string cpu_path = cpu_root + "cpu" + std::to_string(id) + "/";
+    LogicalCpu cpu;
+    cpu.id         = id;
+    cpu.package_id = readSysNumber(cpu_path + "topology/physical_package_id").value_or(0);
+    cpu.core_id    = readSysNumber(cpu_path + "topology/core_id").value_or(id);
+    cpu.capacity   = readSysNumber(cpu_path + "cpu_capacity").value_or(1024);
+    cpu.efficiency = atom_cpus.count(id) != 0;
+
+    // Find the level 3 cache, or the last level cache if there is no level 3
+    cpu.l3_id = -1;
+    uint32_t best_level = 0;
+    for (uint32_t index = 0;; index++)
+    {
+      std::string cache_path = cpu_path + "cache/index" + std::to_string(index) + "/";
+      auto level             = readSysNumber(cache_path + "level");
+      if (!level)
+        break;
+      if (*level < best_level || *level > 3)
+        continue;
+      // Older kernels have no cache id, the first CPU sharing the cache identifies it instead
+      auto cache_id = readSysNumber(cache_path + "id");
+      if (!cache_id)
+      {
+        auto shared = readSysLine(cache_path + "shared_cpu_list");
+        auto list   = shared ? CpuTopology::parseCpuList(*shared) : std::vector<uint32_t> {};
+        cache_id    = list.empty() ? id : list.front();
+      }
+      best_level = *level;
+      cpu.l3_id  = static_cast<int32_t>(*cache_id);
+    }
+    cpus.push_back(cpu);
+  }
+
+  // Heterogeneous ARM systems report lower cpu_capacity on their efficiency cores instead
+  if (atom_cpus.empty() && !cpus.empty())
+  {
+    auto [min_cpu, max_cpu] = std::minmax_element(
+        cpus.begin(), cpus.end(), [](const LogicalCpu& a, const LogicalCpu& b) {
+          return a.capacity < b.capacity;
+        });
+    uint32_t max_capacity = max_cpu->capacity;
+    if (min_cpu->capacity < max_capacity)
+    {
+      for (auto& cpu : cpus)
+        cpu.efficiency = cpu.capacity < max_capacity;
+    }
+  }
+  return cpus;
+}
+#endif
+} // namespace
+
+bool CpuTopology::sameCore(const LogicalCpu& a, const LogicalCpu& b)
+{
+  return a.package_id == b.package_id && a.core_id == b.core_id;
+}
+
+CpuTopology CpuTopology::detect()
+{
+  CpuTopology topology;
+#ifdef __linux__
+  topology.cpus_ = detectLinuxCpus();
+#endif
+  if (topology.cpus_.empty())
+    topology.cpus_ = fallbackCpus();
+  return topology;
+}
+
+std::vector<uint32_t> CpuTopology::parseCpuList(const std::string& list)
+{
+  std::vector<uint32_t> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ','))
+  {
+    try
+    {
+      size_t dash    = range.find('-');
+      uint32_t first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+      uint32_t last  = dash == std::string::npos ?
+                           first :
+                           static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+      for (uint32_t id = first; id <= last; id++)
+        cpus.push_back(id);
+    } catch (const std::exception&)
+    {
+      // Skip malformed entries such as the empty list of an absent PMU
+    }
+  }
+  return cpus;
+}
+
+const std::vector<LogicalCpu>& CpuTopology::cpus() const
+{
+  return this->cpus_;
+}
+
+std::vector<uint32_t> CpuTopology::siblings(uint32_t cpu) const
+{
+  std::vector<uint32_t> result;
+  auto it = std::find_if(this->cpus_.begin(), this->cpus_.end(), [&](const LogicalCpu& other) {
+    return other.id == cpu;
+  });
+  if (it == this->cpus_.end())
+    return result;
+  for (const auto& other : this->cpus_)
+  {
+    if (sameCore(*it, other))
+      result.push_back(other.id);
+  }
+  return result;
+}
+
+uint32_t CpuTopology::physicalCoreCount() const
+{
+  std::set<std::pair<uint32_t, uint32_t>> cores;
+  for (const auto& cpu : this->cpus_)
+    cores.emplace(cpu.package_id, cpu.core_id);
+  return static_cast<uint32_t>(cores.size());
+}
+
+uint32_t CpuTopology::l3DomainCount() const
+{
+  std::set<int32_t> domains;
+  for (const auto& cpu : this->cpus_)
+    domains.insert(cpu.l3_id);
+  return static_cast<uint32_t>(domains.size());
+}
+
+uint32_t CpuTopology::efficiencyCpuCount() const
+{
+  return static_cast<uint32_t>(
+      std::count_if(this->cpus_.begin(), this->cpus_.end(), [](const LogicalCpu& cpu) {
+        return cpu.efficiency;
+      }));
+}
+
+ThreadPlacement CpuTopology::placeThreads() const
+{
+  ThreadPlacement placement;
+
+  // One representative logical CPU per physical performance core
+  std::vector<const LogicalCpu*> performance_cores;
+  for (const auto& cpu : this->cpus_)
+  {
+    if (cpu.efficiency)
+      continue;
+    bool seen = std::any_of(performance_cores.begin(),
+                            performance_cores.end(),
+                            [&](const LogicalCpu* core) { return sameCore(*core, cpu); });
+    if (!seen)
+      performance_cores.push_back(&cpu);
+  }
+
+  std::vector<uint32_t> all_cpus;
+  for (const auto& cpu : this->cpus_)
+    all_cpus.push_back(cpu.id);
+
+  if (performance_cores.size() < 3)
+  {
+    placement.worker_cpus = all_cpus;
+    placement.io_cpus     = all_cpus;
+    return placement;
+  }
+
+  // Fastest cores first, then the highest numbered since CPU 0 tends to service most interrupts
+  std::sort(performance_cores.begin(),
+            performance_cores.end(),
+            [](const LogicalCpu* a, const LogicalCpu* b) {
+              if (a->capacity != b->capacity)
+                return a->capacity > b->capacity;
+              return a->id > b->id;
+            });
+  const LogicalCpu* render_core = performance_cores[0];
+
+  // Keep the main thread in the render thread's L3 domain so snapshots stay in cache
+  const LogicalCpu* main_core = performance_cores[1];
+  for (size_t i = 1; i < performance_cores.size(); i++)
+  {
+    if (performance_cores[i]->l3_id == render_core->l3_id)
+    {
+      main_core = performance_cores[i];
+      break;
+    }
+  }
+  placement.render_cpu = render_core->id;
+  placement.main_cpu   = main_core->id;
+
+  // Workers get every other CPU, never the dedicated cores or their SMT siblings
+  for (const auto& cpu : this->cpus_)
+  {
+    if (!sameCore(cpu, *render_core) && !sameCore(cpu, *main_core))
+      placement.worker_cpus.push_back(cpu.id);
+  }
+
+  // The I/O thread mostly waits on the disk, efficiency cores are the right place for it
+  for (const auto& cpu : this->cpus_)
+  {
+    if (cpu.efficiency)
+      placement.io_cpus.push_back(cpu.id);
+  }
+  if (placement.io_cpus.empty())
+    placement.io_cpus = placement.worker_cpus;
+  return placement;
+}
+
+std::thread::native_handle_type currentThreadHandle()
+{
+#ifdef __linux__
+  return pthread_self();
+#else
+  return {};
+#endif
+}
+
+bool setThreadAffinity(std::thread::native_handle_type thread, const std::vector<uint32_t>& cpus)
+{
+#ifdef __linux__
+  if (cpus.empty())
+    return false;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (uint32_t cpu : cpus)
+  {
+    if (cpu < CPU_SETSIZE)
+      CPU_SET(cpu, &cpu_set);
+  }
+  return pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set) == 0;
+#else
+  static_cast<void>(thread);
+  static_cast<void>(cpus);
+  return false;
+#endif
+}
+
+bool setThreadPriority(std::thread::native_handle_type thread, ThreadPriority priority)
+{
+#ifdef __linux__
+  // Low priority threads are batch scheduled, high priority threads get the lowest real-time
+  // priority so they still yield to the kernel's own real-time work
+  sched_param param {};
+  int policy = SCHED_OTHER;
+  if (priority == ThreadPriority::Low)
+  {
+    policy = SCHED_BATCH;
+  } else if (priority == ThreadPriority::High)
+  {
+    policy               = SCHED_RR;
+    param.sched_priority = sched_get_priority_min(SCHED_RR);
+  }
+  return pthread_setschedparam(thread, policy, &param) == 0;
+#else
+  static_cast<void>(thread);
+  static_cast<void>(priority);
+  return false;
+#endif
+}
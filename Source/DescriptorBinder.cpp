@@ -0,0 +1,163 @@
+#include "DescriptorBinder.hpp"
+
+#include <map>
+
+DescriptorBinder::DescriptorBinder(vk::Device device,
+                                   vk::PipelineBindPoint bind_point,
+                                   const std::vector<vk::DescriptorSetLayoutBinding>& bindings,
+                                   uint32_t max_push_descriptors,
+                                   uint32_t frame_count) :
+  device_(device),
+  bind_point_(bind_point),
+  bindings_(bindings)
+{
+  if (this->bindings_.empty())
+    throw std::runtime_error("DescriptorBinder requires at least one binding");
+
+  // Count the descriptors in the set, the push path is limited by maxPushDescriptors
+  uint32_t descriptor_count = 0;
+  for (const auto& binding : this->bindings_)
+    descriptor_count += binding.descriptorCount;
+
+  // A max_push_descriptors of zero means the extension is not enabled
+  this->use_push_descriptors_ = this->bindings_.size() <= max_push_bindings_ &&
+                                descriptor_count <= max_push_descriptors;
+
+  this->initSetLayout();
+  if (!this->use_push_descriptors_)
+    this->initPools(frame_count);
+}
+
+void DescriptorBinder::initSetLayout()
+{
+  vk::DescriptorSetLayoutCreateInfo create_info;
+  create_info.setBindings(this->bindings_);
+  if (this->use_push_descriptors_)
+    create_info.setFlags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR);
+  this->set_layout_ = VULKAN_CALL(this->device_.createDescriptorSetLayout(create_info)).value();
+}
+
+void DescriptorBinder::initPools(uint32_t frame_count)
+{
+  // Size every pool so that sets_per_frame_ sets of this layout can be allocated from it
+  std::map<vk::DescriptorType, uint32_t> type_counts;
+  for (const auto& binding : this->bindings_)
+    type_counts[binding.descriptorType] += binding.descriptorCount * sets_per_frame_;
+
+  std::vector<vk::DescriptorPoolSize> pool_sizes;
+  for (const auto& [type, count] : type_counts)
+    pool_sizes.emplace_back(type, count);
+
+  vk::DescriptorPoolCreateInfo create_info;
+  create_info.setMaxSets(sets_per_frame_).setPoolSizes(pool_sizes);
+
+  for (uint32_t i = 0; i < frame_count; i++)
+    this->pools_.push_back(VULKAN_CALL(this->device_.createDescriptorPool(create_info)).value());
+}
+
+vk::DescriptorSetLayout DescriptorBinder::getSetLayout() const
+{
+  return this->set_layout_;
+}
+
+bool DescriptorBinder::usesPushDescriptors() const
+{
+  return this->use_push_descriptors_;
+}
+
+const std::vector<vk::DescriptorSetLayoutBinding>& DescriptorBinder::bindings() const
+{
+  return this->bindings_;
+}
+
+vk::PipelineLayout DescriptorBinder::pipelineLayout() const
+{
+  return this->pipeline_layout_;
+}
+
+uint32_t DescriptorBinder::setIndex() const
+{
+  return this->set_index_;
+}
+
+void DescriptorBinder::setPipelineLayout(vk::PipelineLayout pipeline_layout, uint32_t set_index)
+{
+  this->pipeline_layout_ = pipeline_layout;
+  this->set_index_       = set_index;
+
+  // Every binding reads its DescriptorInfo from the array passed to bind, in binding order
+  std::vector<vk::DescriptorUpdateTemplateEntry> entries;
+  for (size_t i = 0; i < this->bindings_.size(); i++)
+  {
+    const auto& binding = this->bindings_.at(i);
+    entries.emplace_back(binding.binding,
+                         0,
+                         binding.descriptorCount,
+                         binding.descriptorType,
+                         i * sizeof(DescriptorInfo),
+                         sizeof(DescriptorInfo));
+  }
+
+  vk::DescriptorUpdateTemplateCreateInfo create_info;
+  create_info.setDescriptorUpdateEntries(entries)
+      .setDescriptorSetLayout(this->set_layout_)
+      .setPipelineBindPoint(this->bind_point_)
+      .setPipelineLayout(pipeline_layout)
+      .setSet(set_index);
+  if (this->use_push_descriptors_)
+    create_info.setTemplateType(vk::DescriptorUpdateTemplateType::ePushDescriptorsKHR);
+  else
+    create_info.setTemplateType(vk::DescriptorUpdateTemplateType::eDescriptorSet);
+
+  this->update_template_ =
+      VULKAN_CALL(this->device_.createDescriptorUpdateTemplate(create_info)).value();
+}
+
+Result<void> DescriptorBinder::beginFrame(uint32_t frame_index)
+{
+  this->frame_index_ = frame_index;
+  if (this->use_push_descriptors_)
+    return vk::Result::eSuccess;
+  return VULKAN_CALL(this->device_.resetDescriptorPool(this->pools_.at(frame_index)));
+}
+
+Result<void> DescriptorBinder::bind(vk::CommandBuffer command_buffer, const DescriptorInfo* infos)
+{
+  // Push path, the descriptors are written straight into the command buffer
+  if (this->use_push_descriptors_)
+  {
+    command_buffer.pushDescriptorSetWithTemplateKHR(this->update_template_,
+                                                    this->pipeline_layout_,
+                                                    this->set_index_,
+                                                    infos);
+    return vk::Result::eSuccess;
+  }
+
+  // Pooled path, allocate a set from this frame's pool, write it and bind it
+  vk::DescriptorSetAllocateInfo allocate_info;
+  allocate_info.setDescriptorPool(this->pools_[this->frame_index_])
+      .setDescriptorSetCount(1)
+      .setPSetLayouts(&this->set_layout_);
+
+  vk::DescriptorSet descriptor_set;
+  Result<void> result =
+      VULKAN_CALL(this->device_.allocateDescriptorSets(&allocate_info, &descriptor_set));
+  if (!result)
+    return result;
+
+  this->device_.updateDescriptorSetWithTemplate(descriptor_set, this->update_template_, infos);
+  command_buffer.bindDescriptorSets(this->bind_point_,
+                                    this->pipeline_layout_,
+                                    this->set_index_,
+                                    descriptor_set,
+                                    nullptr);
+  return vk::Result::eSuccess;
+}
+
+DescriptorBinder::~DescriptorBinder()
+{
+  for (auto& pool : this->pools_)
+    this->device_.destroyDescriptorPool(pool);
+  this->device_.destroyDescriptorUpdateTemplate(this->update_template_);
+  this->device_.destroyDescriptorSetLayout(this->set_layout_);
+}
@@ -0,0 +1,124 @@
+#include "FormatPolicy.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+// Intermediate candidates in order of preference among formats of the same size, the cheapest
+// supported one wins
+struct IntermediateCandidate
+{
+  vk::Format format;
+  bool alpha;
+  bool high_dynamic_range;
+};
+
+constexpr IntermediateCandidate intermediate_candidates[] = {
+  { vk::Format::eB10G11R11UfloatPack32, false, true },
+  { vk::Format::eB8G8R8A8Srgb, true, false },
+  { vk::Format::eR8G8B8A8Srgb, true, false },
+  { vk::Format::eR16G16B16A16Sfloat, true, true },
+};
+
+// Surface formats for each kind of output, cheapest first
+constexpr vk::SurfaceFormatKHR sdr_surface_formats[] = {
+  { vk::Format::eB8G8R8A8Srgb, vk::ColorSpaceKHR::eSrgbNonlinear },
+  { vk::Format::eR8G8B8A8Srgb, vk::ColorSpaceKHR::eSrgbNonlinear },
+  { vk::Format::eA8B8G8R8SrgbPack32, vk::ColorSpaceKHR::eSrgbNonlinear },
+};
+
+constexpr vk::SurfaceFormatKHR hdr_surface_formats[] = {
+  { vk::Format::eA2B10G10R10UnormPack32, vk::ColorSpaceKHR::eHdr10St2084EXT },
+  { vk::Format::eA2R10G10B10UnormPack32, vk::ColorSpaceKHR::eHdr10St2084EXT },
+  { vk::Format::eR16G16B16A16Sfloat, vk::ColorSpaceKHR::eExtendedSrgbLinearEXT },
+};
+
+template <size_t N>
+const vk::SurfaceFormatKHR* findSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& formats,
+                                              const vk::SurfaceFormatKHR (&candidates)[N])
+{
+  for (const vk::SurfaceFormatKHR& candidate : candidates)
+  {
+    if (std::find(formats.cbegin(), formats.cend(), candidate) != formats.cend())
+      return &candidate;
+  }
+  return nullptr;
+}
+} // namespace
+
+uint32_t formatBytesPerPixel(vk::Format format)
+{
+  switch (format)
+  {
+  case vk::Format::eB8G8R8A8Srgb:
+  case vk::Format::eB8G8R8A8Unorm:
+  case vk::Format::eR8G8B8A8Srgb:
+  case vk::Format::eR8G8B8A8Unorm:
+  case vk::Format::eA8B8G8R8SrgbPack32:
+  case vk::Format::eA8B8G8R8UnormPack32:
+  case vk::Format::eA2B10G10R10UnormPack32:
+  case vk::Format::eA2R10G10B10UnormPack32:
+  case vk::Format::eB10G11R11UfloatPack32:
+    return 4;
+  case vk::Format::eR16G16B16A16Sfloat:
+    return 8;
+  case vk::Format::eR32G32B32A32Sfloat:
+    return 16;
+  default:
+    return 0;
+  }
+}
+
+vk::SurfaceFormatKHR chooseSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& formats,
+                                         bool hdr)
+{
+  const vk::SurfaceFormatKHR* format = nullptr;
+  if (hdr)
+    format = findSurfaceFormat(formats, hdr_surface_formats);
+  if (!format)
+    format = findSurfaceFormat(formats, sdr_surface_formats);
+  return format ? *format : formats.front();
+}
+
+bool isPqColorSpace(vk::ColorSpaceKHR color_space)
+{
+  return color_space == vk::ColorSpaceKHR::eHdr10St2084EXT;
+}
+
+vk::Format chooseIntermediateFormat(vk::PhysicalDevice physical_device,
+                                    const IntermediateFormatDesc& desc,
+                                    vk::Format preferred)
+{
+  vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eColorAttachment |
+                                    vk::FormatFeatureFlagBits::eSampledImage;
+  if (desc.blend)
+    required |= vk::FormatFeatureFlagBits::eColorAttachmentBlend;
+  auto supported = [&](vk::Format format)
+  {
+    vk::FormatProperties properties = physical_device.getFormatProperties(format);
+    return (properties.optimalTilingFeatures & required) == required;
+  };
+
+  vk::Format cheapest      = vk::Format::eUndefined;
+  uint32_t cheapest_size   = UINT32_MAX;
+  bool preferred_qualifies = false;
+  for (const IntermediateCandidate& candidate : intermediate_candidates)
+  {
+    if ((desc.alpha && !candidate.alpha) ||
+        (desc.high_dynamic_range && !candidate.high_dynamic_range) || !supported(candidate.format))
+      continue;
+    preferred_qualifies = preferred_qualifies || candidate.format == preferred;
+    uint32_t size       = formatBytesPerPixel(candidate.format);
+    if (size < cheapest_size)
+    {
+      cheapest      = candidate.format;
+      cheapest_size = size;
+    }
+  }
+  if (cheapest == vk::Format::eUndefined)
+    throw std::runtime_error("No supported intermediate render target format");
+  if (preferred_qualifies && formatBytesPerPixel(preferred) == cheapest_size)
+    return preferred;
+  return cheapest;
+}
@@ -0,0 +1,436 @@
+#include "FrameCapture.hpp"
+
+#include "MappedFile.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr char capture_magic[8] = "VKCAPTR";
+
+// Reads a SPIR-V file into words
+std::vector<uint32_t> readShader(const std::string& file_name)
+{
+  MappedFile file(file_name);
+  if (file.size() % sizeof(uint32_t) != 0)
+    throw std::runtime_error(file_name + " is not SPIR-V");
+  std::vector<uint32_t> code(file.size() / sizeof(uint32_t));
+  std::memcpy(code.data(), file.data(), file.size());
+  return code;
+}
+} // namespace
+
+FrameCapture::FrameCapture(fs::path file,
+                           uint32_t frame_count,
+                           std::string device_name,
+                           bool push_descriptors) :
+  file_(std::move(file)),
+  frame_count_(frame_count),
+  device_name_(std::move(device_name)),
+  push_descriptors_(push_descriptors)
+{
+}
+
+uint32_t FrameCapture::find(const std::unordered_map<uint64_t, uint32_t>& indices,
+                            uint64_t key,
+                            const char* kind)
+{
+  auto it = indices.find(key);
+  if (it != indices.end())
+    return it->second;
+  if (this->error_.empty())
+    this->error_ = std::string("a frame used a ") + kind + " that was not added to the capture";
+  return capture_no_index;
+}
+
+void FrameCapture::addBuffer(const Buffer& buffer, std::vector<std::byte> contents)
+{
+  this->buffer_indices_[key(buffer.buffer)] = static_cast<uint32_t>(this->buffers_.size());
+  this->buffers_.push_back({ buffer, std::move(contents) });
+  this->buffers_used_.push_back(false);
+}
+
+void FrameCapture::addImage(const Image& image,
+                            vk::ImageLayout layout,
+                            std::vector<std::byte> contents)
+{
+  auto index                             = static_cast<uint32_t>(this->images_.size());
+  this->image_indices_[key(image.image)] = index;
+  this->view_indices_[key(image.view)]   = index;
+  this->images_.push_back({ image, layout, std::move(contents) });
+}
+
+void FrameCapture::addSampler(vk::Sampler sampler, const vk::SamplerCreateInfo& create_info)
+{
+  this->sampler_indices_[key(sampler)] = static_cast<uint32_t>(this->samplers_.size());
+  this->samplers_.push_back(create_info);
+}
+
+void FrameCapture::addRenderPass(vk::RenderPass render_pass, const RenderPassDesc& desc)
+{
+  this->render_pass_indices_[key(render_pass)] = static_cast<uint32_t>(this->render_passes_.size());
+  this->render_passes_.push_back(desc);
+}
+
+void FrameCapture::addFramebuffer(vk::Framebuffer framebuffer,
+                                  vk::RenderPass render_pass,
+                                  const Image& attachment,
+                                  vk::Extent2D extent)
+{
+  FramebufferRecord record;
+  record.render_pass = this->find(this->render_pass_indices_, key(render_pass), "render pass");
+  record.image       = this->find(this->view_indices_, key(attachment.view), "image");
+  record.extent      = extent;
+
+  this->framebuffer_indices_[key(framebuffer)] = static_cast<uint32_t>(this->framebuffers_.size());
+  this->framebuffers_.push_back(record);
+}
+
+void FrameCapture::addBinder(const DescriptorBinder& binder)
+{
+  this->binder_indices_[&binder] = static_cast<uint32_t>(this->binders_.size());
+  this->binders_.push_back({ &binder });
+}
+
+void FrameCapture::addPipeline(const Pipeline& pipeline,
+                               vk::RenderPass render_pass,
+                               const GraphicsPipelineDesc& desc)
+{
+  PipelineRecord record;
+  record.pipeline        = pipeline;
+  record.render_pass     = this->find(this->render_pass_indices_, key(render_pass), "render pass");
+  record.desc            = desc;
+  record.vertex_shader   = readShader(desc.vertex_shader);
+  record.fragment_shader = readShader(desc.fragment_shader);
+
+  this->pipeline_indices_[key(pipeline.pipeline)] = static_cast<uint32_t>(this->pipelines_.size());
+  this->pipelines_.push_back(std::move(record));
+}
+
+uint32_t FrameCapture::bufferIndex(vk::Buffer buffer)
+{
+  uint32_t index = this->find(this->buffer_indices_, key(buffer), "buffer");
+  if (index != capture_no_index)
+    this->buffers_used_[index] = true;
+  return index;
+}
+
+uint32_t FrameCapture::imageIndex(vk::Image image)
+{
+  return this->find(this->image_indices_, key(image), "image");
+}
+
+uint32_t FrameCapture::viewIndex(vk::ImageView view)
+{
+  return this->find(this->view_indices_, key(view), "image view");
+}
+
+uint32_t FrameCapture::samplerIndex(vk::Sampler sampler)
+{
+  if (!sampler)
+    return capture_no_index;
+  return this->find(this->sampler_indices_, key(sampler), "sampler");
+}
+
+uint32_t FrameCapture::renderPassIndex(vk::RenderPass render_pass)
+{
+  return this->find(this->render_pass_indices_, key(render_pass), "render pass");
+}
+
+uint32_t FrameCapture::framebufferIndex(vk::Framebuffer framebuffer)
+{
+  return this->find(this->framebuffer_indices_, key(framebuffer), "framebuffer");
+}
+
+uint32_t FrameCapture::pipelineIndex(vk::Pipeline pipeline)
+{
+  return this->find(this->pipeline_indices_, key(pipeline), "pipeline");
+}
+
+uint32_t FrameCapture::binderIndex(const DescriptorBinder& binder)
+{
+  auto it = this->binder_indices_.find(&binder);
+  if (it != this->binder_indices_.end())
+    return it->second;
+  if (this->error_.empty())
+    this->error_ = "a frame used a descriptor binder that was not added to the capture";
+  return capture_no_index;
+}
+
+void FrameCapture::beginCommand(CaptureOp op)
+{
+  this->command_start_ = this->commands_.size();
+  this->commands_.push_back(static_cast<uint32_t>(op));
+}
+
+void FrameCapture::put(uint32_t word)
+{
+  this->commands_.push_back(word);
+}
+
+void FrameCapture::put(int32_t word)
+{
+  this->commands_.push_back(static_cast<uint32_t>(word));
+}
+
+void FrameCapture::put(uint64_t words)
+{
+  this->commands_.push_back(static_cast<uint32_t>(words));
+  this->commands_.push_back(static_cast<uint32_t>(words >> 32));
+}
+
+void FrameCapture::put(float word)
+{
+  this->commands_.push_back(std::bit_cast<uint32_t>(word));
+}
+
+void FrameCapture::endCommand()
+{
+  auto word_count = static_cast<uint32_t>(this->commands_.size() - this->command_start_ - 1);
+  this->commands_[this->command_start_] |= word_count << 8;
+}
+
+void FrameCapture::endFrame(std::chrono::nanoseconds record_time)
+{
+  FrameRecord frame;
+  frame.record_time = record_time;
+  frame.commands    = std::move(this->commands_);
+  this->commands_.clear();
+  for (size_t i = 0; i < this->buffers_.size(); i++)
+  {
+    const Buffer& buffer = this->buffers_[i].buffer;
+    if (!this->buffers_used_[i] || !buffer.mapped)
+      continue;
+    auto mapped = static_cast<const std::byte*>(buffer.mapped);
+    frame.buffer_writes.emplace_back(static_cast<uint32_t>(i),
+                                     std::vector<std::byte>(mapped, mapped + buffer.size));
+    this->buffers_used_[i] = false;
+  }
+  this->frames_.push_back(std::move(frame));
+}
+
+bool FrameCapture::complete() const
+{
+  return this->frames_.size() >= this->frame_count_;
+}
+
+const std::string& FrameCapture::error() const
+{
+  return this->error_;
+}
+
+void FrameCapture::write() const
+{
+  BlobBuilder blob;
+  size_t header = blob.allocate<CaptureHeader>();
+  size_t root   = blob.allocate<CaptureRoot>();
+  blob.link<CaptureRoot>(header + offsetof(CaptureHeader, root), root);
+  {
+    CaptureRoot* capture_root = blob.at<CaptureRoot>(root);
+    std::strncpy(capture_root->device_name,
+                 this->device_name_.c_str(),
+                 sizeof(capture_root->device_name) - 1);
+    capture_root->push_descriptors = this->push_descriptors_;
+  }
+
+  // Records are allocated first and their arrays appended after them. Pointers into the blob are
+  // only held until the next allocation, as it may move the blob.
+  size_t buffers = blob.allocateArray<CaptureBuffer>(root + offsetof(CaptureRoot, buffers),
+                                                     this->buffers_.size());
+  for (size_t i = 0; i < this->buffers_.size(); i++)
+  {
+    const BufferRecord& record = this->buffers_[i];
+    size_t offset              = buffers + i * sizeof(CaptureBuffer);
+    CaptureBuffer* buffer      = blob.at<CaptureBuffer>(offset);
+    buffer->size               = record.buffer.size;
+    buffer->usage              = static_cast<uint32_t>(record.buffer.usage);
+    buffer->host_visible       = record.buffer.mapped != nullptr;
+    blob.fill(offset + offsetof(CaptureBuffer, contents),
+              record.contents.data(),
+              record.contents.size());
+  }
+
+  size_t images = blob.allocateArray<CaptureImage>(root + offsetof(CaptureRoot, images),
+                                                   this->images_.size());
+  for (size_t i = 0; i < this->images_.size(); i++)
+  {
+    const ImageRecord& record = this->images_[i];
+    size_t offset             = images + i * sizeof(CaptureImage);
+    CaptureImage* image       = blob.at<CaptureImage>(offset);
+    image->format             = static_cast<uint32_t>(record.image.format);
+    image->usage              = static_cast<uint32_t>(record.image.usage);
+    image->width              = record.image.extent.width;
+    image->height             = record.image.extent.height;
+    image->layer_count        = record.image.layer_count;
+    image->view_type          = static_cast<uint32_t>(record.image.view_type);
+    image->layout             = static_cast<uint32_t>(record.layout);
+    image->swapchain          = !record.image.memory;
+    blob.fill(offset + offsetof(CaptureImage, contents),
+              record.contents.data(),
+              record.contents.size());
+  }
+
+  size_t samplers = blob.allocateArray<CaptureSampler>(root + offsetof(CaptureRoot, samplers),
+                                                       this->samplers_.size());
+  for (size_t i = 0; i < this->samplers_.size(); i++)
+  {
+    CaptureSampler* sampler = blob.at<CaptureSampler>(samplers + i * sizeof(CaptureSampler));
+    sampler->mag_filter     = static_cast<uint32_t>(this->samplers_[i].magFilter);
+    sampler->min_filter     = static_cast<uint32_t>(this->samplers_[i].minFilter);
+    sampler->mipmap_mode    = static_cast<uint32_t>(this->samplers_[i].mipmapMode);
+    sampler->address_mode_u = static_cast<uint32_t>(this->samplers_[i].addressModeU);
+    sampler->address_mode_v = static_cast<uint32_t>(this->samplers_[i].addressModeV);
+    sampler->address_mode_w = static_cast<uint32_t>(this->samplers_[i].addressModeW);
+    sampler->max_lod        = this->samplers_[i].maxLod;
+  }
+
+  size_t render_passes = blob.allocateArray<CaptureRenderPass>(
+      root + offsetof(CaptureRoot, render_passes), this->render_passes_.size());
+  for (size_t i = 0; i < this->render_passes_.size(); i++)
+  {
+    const RenderPassDesc& desc = this->render_passes_[i];
+    size_t offset              = render_passes + i * sizeof(CaptureRenderPass);
+    std::vector<VkSubpassDependency> dependencies(desc.dependencies.begin(),
+                                                  desc.dependencies.end());
+    blob.at<CaptureRenderPass>(offset)->color_attachment = desc.color_attachment;
+    blob.fill(offset + offsetof(CaptureRenderPass, dependencies),
+              dependencies.data(),
+              dependencies.size());
+  }
+
+  std::vector<CaptureFramebuffer> framebuffers;
+  for (const FramebufferRecord& record : this->framebuffers_)
+  {
+    framebuffers.push_back(
+        { record.render_pass, record.image, record.extent.width, record.extent.height });
+  }
+  blob.fill(root + offsetof(CaptureRoot, framebuffers), framebuffers.data(), framebuffers.size());
+
+  // Binders are matched with the pipeline whose layout they were given, pipelines with the binders
+  // of their set layouts
+  std::unordered_map<uint64_t, uint32_t> pipelines_by_layout;
+  for (size_t i = 0; i < this->pipelines_.size(); i++)
+    pipelines_by_layout[key(this->pipelines_[i].pipeline.layout)] = static_cast<uint32_t>(i);
+  std::unordered_map<uint64_t, uint32_t> binders_by_set_layout;
+  for (size_t i = 0; i < this->binders_.size(); i++)
+    binders_by_set_layout[key(this->binders_[i].binder->getSetLayout())] = static_cast<uint32_t>(i);
+
+  size_t binders = blob.allocateArray<CaptureBinder>(root + offsetof(CaptureRoot, binders),
+                                                     this->binders_.size());
+  for (size_t i = 0; i < this->binders_.size(); i++)
+  {
+    const DescriptorBinder& binder = *this->binders_[i].binder;
+    auto pipeline                  = pipelines_by_layout.find(key(binder.pipelineLayout()));
+    if (pipeline == pipelines_by_layout.end())
+      throw std::runtime_error("Captured descriptor binder has no captured pipeline layout");
+    std::vector<CaptureDescriptorBinding> bindings;
+    for (const vk::DescriptorSetLayoutBinding& binding : binder.bindings())
+    {
+      bindings.push_back({ binding.binding,
+                           static_cast<uint32_t>(binding.descriptorType),
+                           binding.descriptorCount,
+                           static_cast<uint32_t>(binding.stageFlags) });
+    }
+    size_t offset         = binders + i * sizeof(CaptureBinder);
+    CaptureBinder* record = blob.at<CaptureBinder>(offset);
+    record->pipeline      = pipeline->second;
+    record->set_index     = binder.setIndex();
+    blob.fill(offset + offsetof(CaptureBinder, bindings), bindings.data(), bindings.size());
+  }
+
+  size_t pipelines = blob.allocateArray<CapturePipeline>(root + offsetof(CaptureRoot, pipelines),
+                                                         this->pipelines_.size());
+  for (size_t i = 0; i < this->pipelines_.size(); i++)
+  {
+    const PipelineRecord& record     = this->pipelines_[i];
+    const GraphicsPipelineDesc& desc = record.desc;
+    std::vector<uint32_t> set_layouts;
+    for (vk::DescriptorSetLayout set_layout : desc.set_layouts)
+    {
+      auto binder = binders_by_set_layout.find(key(set_layout));
+      if (binder == binders_by_set_layout.end())
+        throw std::runtime_error("Captured pipeline uses a set layout without a captured binder");
+      set_layouts.push_back(binder->second);
+    }
+    std::vector<VkVertexInputBindingDescription> vertex_bindings(desc.vertex_bindings.begin(),
+                                                                 desc.vertex_bindings.end());
+    std::vector<VkVertexInputAttributeDescription> vertex_attributes(
+        desc.vertex_attributes.begin(), desc.vertex_attributes.end());
+    std::vector<VkPushConstantRange> push_constant_ranges(desc.push_constant_ranges.begin(),
+                                                          desc.push_constant_ranges.end());
+
+    size_t offset                 = pipelines + i * sizeof(CapturePipeline);
+    CapturePipeline* pipeline     = blob.at<CapturePipeline>(offset);
+    pipeline->render_pass         = record.render_pass;
+    pipeline->cull_mode           = static_cast<uint32_t>(desc.cull_mode);
+    pipeline->alpha_blend         = desc.alpha_blend;
+    pipeline->premultiplied_alpha = desc.premultiplied_alpha;
+    pipeline->color_write         = desc.color_write;
+    pipeline->pq_output           = desc.pq_output;
+    blob.fill(offset + offsetof(CapturePipeline, vertex_shader),
+              record.vertex_shader.data(),
+              record.vertex_shader.size());
+    blob.fill(offset + offsetof(CapturePipeline, fragment_shader),
+              record.fragment_shader.data(),
+              record.fragment_shader.size());
+    blob.fill(offset + offsetof(CapturePipeline, vertex_bindings),
+              vertex_bindings.data(),
+              vertex_bindings.size());
+    blob.fill(offset + offsetof(CapturePipeline, vertex_attributes),
+              vertex_attributes.data(),
+              vertex_attributes.size());
+    blob.fill(offset + offsetof(CapturePipeline, set_layouts),
+              set_layouts.data(),
+              set_layouts.size());
+    blob.fill(offset + offsetof(CapturePipeline, push_constant_ranges),
+              push_constant_ranges.data(),
+              push_constant_ranges.size());
+  }
+
+  size_t frames = blob.allocateArray<CaptureFrame>(root + offsetof(CaptureRoot, frames),
+                                                   this->frames_.size());
+  for (size_t i = 0; i < this->frames_.size(); i++)
+  {
+    const FrameRecord& record = this->frames_[i];
+    size_t offset             = frames + i * sizeof(CaptureFrame);
+
+    blob.at<CaptureFrame>(offset)->record_ns = record.record_time.count();
+    blob.fill(offset + offsetof(CaptureFrame, commands),
+              record.commands.data(),
+              record.commands.size());
+    size_t writes = blob.allocateArray<CaptureBufferWrite>(
+        offset + offsetof(CaptureFrame, buffer_writes), record.buffer_writes.size());
+    for (size_t j = 0; j < record.buffer_writes.size(); j++)
+    {
+      const auto& [buffer, contents] = record.buffer_writes[j];
+      size_t write_offset            = writes + j * sizeof(CaptureBufferWrite);
+
+      blob.at<CaptureBufferWrite>(write_offset)->buffer = buffer;
+      blob.fill(write_offset + offsetof(CaptureBufferWrite, contents),
+                contents.data(),
+                contents.size());
+    }
+  }
+
+  CaptureHeader* capture_header = blob.at<CaptureHeader>(header);
+  std::memcpy(capture_header->magic, capture_magic, sizeof(capture_magic));
+  capture_header->version    = CaptureHeader::current_version_;
+  capture_header->byte_order = CaptureHeader::byte_order_mark_;
+  capture_header->size       = blob.data().size();
+
+  fs::path temporary = this->file_;
+  temporary += ".tmp";
+  {
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(blob.data().data()),
+                 static_cast<std::streamsize>(blob.data().size()));
+    if (!stream)
+      throw std::runtime_error("Failed to write capture " + temporary.string());
+  }
+  fs::rename(temporary, this->file_);
+}
@@ -0,0 +1,878 @@
+#include "FrameReplayer.hpp"
+
+#include "Config.hpp"
+#include "GraphicsPipeline.hpp"
+#include "Logger.hpp"
+#include "Result.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace
+{
+// Returns the object at a capture index, throws if the capture refers to one it does not hold
+template <typename T>
+const T& at(const std::vector<T>& objects, uint32_t index, const char* kind)
+{
+  if (index >= objects.size())
+    throw std::runtime_error(std::string("capture refers to a missing ") + kind);
+  return objects[index];
+}
+
+// Reads the words of a single command, throws if the command is shorter than its op requires
+class CommandReader
+{
+private:
+  const uint32_t* word_;
+  const uint32_t* end_;
+
+public:
+  CommandReader(const uint32_t* words, uint32_t count) : word_(words), end_(words + count) { }
+
+  // Returns the next count words and skips them
+  const uint32_t* words(uint32_t count)
+  {
+    if (count > static_cast<size_t>(this->end_ - this->word_))
+      throw std::runtime_error("capture has a truncated command");
+    const uint32_t* words = this->word_;
+    this->word_ += count;
+    return words;
+  }
+
+  uint32_t u32()
+  {
+    return *this->words(1);
+  }
+
+  int32_t i32()
+  {
+    return static_cast<int32_t>(this->u32());
+  }
+
+  uint64_t u64()
+  {
+    const uint32_t* words = this->words(2);
+    return words[0] | static_cast<uint64_t>(words[1]) << 32;
+  }
+
+  float f32()
+  {
+    uint32_t word = this->u32();
+    float value;
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+  }
+
+  template <typename T>
+  T as()
+  {
+    return static_cast<T>(this->u32());
+  }
+};
+
+// Moves a whole image from one layout to another during initialisation
+void transitionImage(vk::CommandBuffer commands,
+                     vk::Image image,
+                     const vk::ImageSubresourceRange& range,
+                     vk::ImageLayout old_layout,
+                     vk::ImageLayout new_layout)
+{
+  vk::ImageMemoryBarrier barrier;
+  barrier.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite)
+      .setOldLayout(old_layout)
+      .setNewLayout(new_layout)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setImage(image)
+      .setSubresourceRange(range);
+  commands.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands,
+                           vk::PipelineStageFlagBits::eAllCommands,
+                           {},
+                           nullptr,
+                           nullptr,
+                           barrier);
+}
+
+vk::ShaderModule createShaderModule(vk::Device device, const OffsetArray<uint32_t>& code)
+{
+  vk::ShaderModuleCreateInfo create_info;
+  create_info.setCodeSize(code.size() * sizeof(uint32_t)).setPCode(code.begin());
+  return VULKAN_CALL(device.createShaderModule(create_info)).value();
+}
+} // namespace
+
+FrameReplayer::FrameReplayer(const ReplayOptions& options) :
+  options_(options),
+  capture_(options.capture_file)
+{
+  this->initInstance();
+  this->initDevice();
+  this->initCommands();
+  this->initBuffers();
+  this->initImages();
+  this->initSamplers();
+  this->initRenderPasses();
+  this->initFramebuffers();
+  this->initPipelines();
+}
+
+uint32_t FrameReplayer::findMemoryType(uint32_t type_bits, vk::MemoryPropertyFlags properties) const
+{
+  vk::PhysicalDeviceMemoryProperties memory_properties =
+      this->physical_device_.getMemoryProperties();
+  for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+  {
+    if ((type_bits & (1 << i)) &&
+        (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+      return i;
+  }
+  throw std::runtime_error("Unable to find a suitable memory type");
+}
+
+Buffer FrameReplayer::createBuffer(vk::DeviceSize size,
+                                   vk::BufferUsageFlags usage,
+                                   vk::MemoryPropertyFlags properties)
+{
+  Buffer buffer;
+  buffer.size  = size;
+  buffer.usage = usage;
+
+  vk::BufferCreateInfo create_info;
+  create_info.setSize(size).setUsage(usage).setSharingMode(vk::SharingMode::eExclusive);
+  buffer.buffer = VULKAN_CALL(this->device_.createBuffer(create_info)).value();
+
+  vk::MemoryRequirements requirements = this->device_.getBufferMemoryRequirements(buffer.buffer);
+  vk::MemoryAllocateInfo allocate_info;
+  allocate_info.setAllocationSize(requirements.size)
+      .setMemoryTypeIndex(this->findMemoryType(requirements.memoryTypeBits, properties));
+  buffer.memory = VULKAN_CALL(this->device_.allocateMemory(allocate_info)).value();
+  VULKAN_CALL(this->device_.bindBufferMemory(buffer.buffer, buffer.memory, 0)).value();
+
+  if (properties & vk::MemoryPropertyFlagBits::eHostVisible)
+    buffer.mapped = VULKAN_CALL(this->device_.mapMemory(buffer.memory, 0, size)).value();
+  return buffer;
+}
+
+void FrameReplayer::destroyBuffer(const Buffer& buffer)
+{
+  this->device_.destroyBuffer(buffer.buffer);
+  this->device_.freeMemory(buffer.memory);
+}
+
+template <typename Record>
+void FrameReplayer::submitNow(Record record)
+{
+  VULKAN_CALL(this->command_buffer_.begin(
+                  vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)))
+      .value();
+  record(this->command_buffer_);
+  VULKAN_CALL(this->command_buffer_.end()).value();
+  vk::SubmitInfo submit_info;
+  submit_info.setCommandBuffers(this->command_buffer_);
+  VULKAN_CALL(this->queue_.submit(submit_info)).value();
+  VULKAN_CALL(this->queue_.waitIdle()).value();
+}
+
+void FrameReplayer::initInstance()
+{
+  // The loader is linked in, there is no window system to provide its entry point
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+
+  uint32_t version =
+      VK_MAKE_VERSION(PROJECT_VERSION_MAJOR, PROJECT_VERSION_MINOR, PROJECT_VERSION_PATCH);
+  vk::ApplicationInfo app_info("Vulkan-Replay", version, "No Engine", version, VK_API_VERSION_1_1);
+
+  std::vector<const char*> layers;
+  if (this->options_.validation)
+    layers.push_back("VK_LAYER_KHRONOS_validation");
+
+  vk::InstanceCreateInfo create_info;
+  create_info.setPApplicationInfo(&app_info).setPEnabledLayerNames(layers);
+  this->instance_ = VULKAN_CALL(vk::createInstance(create_info)).value();
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(this->instance_);
+}
+
+void FrameReplayer::initDevice()
+{
+  std::vector<vk::PhysicalDevice> physical_devices =
+      VULKAN_CALL(this->instance_.enumeratePhysicalDevices()).value();
+
+  // Replays only need a graphics queue, nothing is presented
+  auto graphics_family = [](vk::PhysicalDevice physical_device) -> std::optional<uint32_t> {
+    std::vector<vk::QueueFamilyProperties> families = physical_device.getQueueFamilyProperties();
+    for (uint32_t i = 0; i < families.size(); i++)
+    {
+      if (families[i].queueFlags & vk::QueueFlagBits::eGraphics)
+        return i;
+    }
+    return std::nullopt;
+  };
+  std::optional<uint32_t> family;
+  if (this->options_.device_index)
+  {
+    if (*this->options_.device_index >= physical_devices.size())
+    {
+      throw std::runtime_error("There is no device " +
+                               std::to_string(*this->options_.device_index));
+    }
+    this->physical_device_ = physical_devices[*this->options_.device_index];
+    family                 = graphics_family(this->physical_device_);
+  } else
+  {
+    for (vk::PhysicalDevice physical_device : physical_devices)
+    {
+      family = graphics_family(physical_device);
+      if (family)
+      {
+        this->physical_device_ = physical_device;
+        break;
+      }
+    }
+  }
+  if (!family)
+    throw std::runtime_error("Unable to find a device with a graphics queue");
+  this->queue_family_ = *family;
+
+  const CaptureRoot& root = this->capture_.root();
+  std::string captured_device(
+      root.device_name,
+      std::find(std::begin(root.device_name), std::end(root.device_name), '\0'));
+  LOG_INFO("Replaying on {}, captured on {}",
+           this->physical_device_.getProperties().deviceName.data(),
+           captured_device);
+
+  // Descriptors are pushed if the engine pushed them, as long as this device can too
+  std::vector<const char*> extensions;
+  if (this->options_.push_descriptors && root.push_descriptors)
+  {
+    std::vector<vk::ExtensionProperties> supported_extensions =
+        VULKAN_CALL(this->physical_device_.enumerateDeviceExtensionProperties()).value();
+    auto supported = std::any_of(
+        supported_extensions.cbegin(), supported_extensions.cend(), [](const auto& extension) {
+          return std::strcmp(extension.extensionName, "VK_KHR_push_descriptor") == 0;
+        });
+    if (supported)
+      extensions.push_back("VK_KHR_push_descriptor");
+  }
+
+  float queue_priority = 1.0f;
+  vk::DeviceQueueCreateInfo queue_create_info({}, this->queue_family_, 1, &queue_priority);
+  vk::DeviceCreateInfo create_info;
+  create_info.setQueueCreateInfos(queue_create_info).setPEnabledExtensionNames(extensions);
+  this->device_ = VULKAN_CALL(this->physical_device_.createDevice(create_info)).value();
+  VULKAN_HPP_DEFAULT_DISPATCHER.init(this->device_);
+  this->queue_ = this->device_.getQueue(this->queue_family_, 0);
+
+  if (!extensions.empty())
+  {
+    using PushDescriptorProperties = vk::PhysicalDevicePushDescriptorPropertiesKHR;
+    using Properties2              = vk::PhysicalDeviceProperties2;
+    auto properties =
+        this->physical_device_.getProperties2<Properties2, PushDescriptorProperties>();
+    this->max_push_descriptors_ = properties.get<PushDescriptorProperties>().maxPushDescriptors;
+  }
+  LOG_INFO("Descriptors are {} like in the engine",
+           (this->max_push_descriptors_ > 0) == (root.push_descriptors != 0) ? "bound"
+                                                                              : "not bound");
+}
+
+void FrameReplayer::initCommands()
+{
+  vk::CommandPoolCreateInfo pool_create_info;
+  pool_create_info.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+      .setQueueFamilyIndex(this->queue_family_);
+  this->command_pool_ = VULKAN_CALL(this->device_.createCommandPool(pool_create_info)).value();
+
+  vk::CommandBufferAllocateInfo allocate_info;
+  allocate_info.setCommandPool(this->command_pool_)
+      .setLevel(vk::CommandBufferLevel::ePrimary)
+      .setCommandBufferCount(1);
+  this->command_buffer_ =
+      VULKAN_CALL(this->device_.allocateCommandBuffers(allocate_info)).value().front();
+  this->fence_ = VULKAN_CALL(this->device_.createFence(vk::FenceCreateInfo {})).value();
+
+  // GPU time is measured with timestamps around each frame where the queue has them
+  std::vector<vk::QueueFamilyProperties> families =
+      this->physical_device_.getQueueFamilyProperties();
+  if (families[this->queue_family_].timestampValidBits == 0)
+  {
+    LOG_WARNING("The replay queue has no timestamps, GPU time is not measured");
+    return;
+  }
+  vk::QueryPoolCreateInfo query_create_info;
+  query_create_info.setQueryType(vk::QueryType::eTimestamp).setQueryCount(2);
+  this->query_pool_ = VULKAN_CALL(this->device_.createQueryPool(query_create_info)).value();
+  this->timestamp_period_ = this->physical_device_.getProperties().limits.timestampPeriod;
+}
+
+void FrameReplayer::initBuffers()
+{
+  for (const CaptureBuffer& captured : this->capture_.root().buffers)
+  {
+    // Host visible buffers are written before every frame, the others hold their contents from
+    // the start of the capture
+    auto usage = vk::BufferUsageFlags(captured.usage);
+    if (captured.host_visible)
+    {
+      this->buffers_.push_back(this->createBuffer(captured.size,
+                                                  usage,
+                                                  vk::MemoryPropertyFlagBits::eHostVisible |
+                                                      vk::MemoryPropertyFlagBits::eHostCoherent));
+      continue;
+    }
+    this->buffers_.push_back(this->createBuffer(captured.size,
+                                                usage | vk::BufferUsageFlagBits::eTransferDst,
+                                                vk::MemoryPropertyFlagBits::eDeviceLocal));
+    if (captured.contents.size() == 0)
+      continue;
+    if (captured.contents.size() > captured.size)
+      throw std::runtime_error("capture holds more contents than a buffer has room for");
+
+    Buffer staging = this->createBuffer(captured.contents.size(),
+                                        vk::BufferUsageFlagBits::eTransferSrc,
+                                        vk::MemoryPropertyFlagBits::eHostVisible |
+                                            vk::MemoryPropertyFlagBits::eHostCoherent);
+    std::memcpy(staging.mapped, captured.contents.begin(), captured.contents.size());
+    this->submitNow([&](vk::CommandBuffer commands) {
+      commands.copyBuffer(staging.buffer,
+                          this->buffers_.back().buffer,
+                          vk::BufferCopy(0, 0, captured.contents.size()));
+    });
+    this->destroyBuffer(staging);
+  }
+}
+
+void FrameReplayer::initImages()
+{
+  for (const CaptureImage& captured : this->capture_.root().images)
+  {
+    // Swapchain images become offscreen images with the same format and usage
+    Image image;
+    image.format      = static_cast<vk::Format>(captured.format);
+    image.extent      = vk::Extent2D(captured.width, captured.height);
+    image.usage       = vk::ImageUsageFlags(captured.usage) | vk::ImageUsageFlagBits::eTransferDst;
+    image.layer_count = captured.layer_count;
+    image.view_type   = static_cast<vk::ImageViewType>(captured.view_type);
+
+    vk::ImageCreateInfo create_info;
+    create_info.setImageType(vk::ImageType::e2D)
+        .setFormat(image.format)
+        .setExtent(vk::Extent3D(image.extent, 1))
+        .setMipLevels(1)
+        .setArrayLayers(image.layer_count)
+        .setSamples(vk::SampleCountFlagBits::e1)
+        .setTiling(vk::ImageTiling::eOptimal)
+        .setUsage(image.usage)
+        .setSharingMode(vk::SharingMode::eExclusive)
+        .setInitialLayout(vk::ImageLayout::eUndefined);
+    image.image = VULKAN_CALL(this->device_.createImage(create_info)).value();
+
+    vk::MemoryRequirements requirements = this->device_.getImageMemoryRequirements(image.image);
+    vk::MemoryAllocateInfo allocate_info;
+    allocate_info.setAllocationSize(requirements.size)
+        .setMemoryTypeIndex(this->findMemoryType(requirements.memoryTypeBits,
+                                                 vk::MemoryPropertyFlagBits::eDeviceLocal));
+    image.memory = VULKAN_CALL(this->device_.allocateMemory(allocate_info)).value();
+    VULKAN_CALL(this->device_.bindImageMemory(image.image, image.memory, 0)).value();
+
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, image.layer_count);
+    vk::ImageViewCreateInfo view_create_info;
+    view_create_info.setImage(image.image)
+        .setViewType(image.view_type)
+        .setFormat(image.format)
+        .setSubresourceRange(range);
+    image.view = VULKAN_CALL(this->device_.createImageView(view_create_info)).value();
+    this->images_.push_back(image);
+
+    // Bring the image into its captured layout, with its captured texels if it has any
+    auto layout = static_cast<vk::ImageLayout>(captured.layout);
+    if (captured.contents.size() == 0)
+    {
+      if (layout != vk::ImageLayout::eUndefined)
+      {
+        this->submitNow([&](vk::CommandBuffer commands) {
+          transitionImage(commands, image.image, range, vk::ImageLayout::eUndefined, layout);
+        });
+      }
+      continue;
+    }
+    uint64_t texel_count = uint64_t(captured.width) * captured.height * captured.layer_count;
+    if (texel_count == 0 || captured.contents.size() % texel_count != 0)
+      throw std::runtime_error("capture holds contents that do not fit an image");
+
+    Buffer staging = this->createBuffer(captured.contents.size(),
+                                        vk::BufferUsageFlagBits::eTransferSrc,
+                                        vk::MemoryPropertyFlagBits::eHostVisible |
+                                            vk::MemoryPropertyFlagBits::eHostCoherent);
+    std::memcpy(staging.mapped, captured.contents.begin(), captured.contents.size());
+    this->submitNow([&](vk::CommandBuffer commands) {
+      transitionImage(commands,
+                      image.image,
+                      range,
+                      vk::ImageLayout::eUndefined,
+                      vk::ImageLayout::eTransferDstOptimal);
+      vk::BufferImageCopy region;
+      region
+          .setImageSubresource(vk::ImageSubresourceLayers(
+              vk::ImageAspectFlagBits::eColor, 0, 0, image.layer_count))
+          .setImageExtent(vk::Extent3D(image.extent, 1));
+      commands.copyBufferToImage(
+          staging.buffer, image.image, vk::ImageLayout::eTransferDstOptimal, region);
+      transitionImage(commands, image.image, range, vk::ImageLayout::eTransferDstOptimal, layout);
+    });
+    this->destroyBuffer(staging);
+  }
+}
+
+void FrameReplayer::initSamplers()
+{
+  for (const CaptureSampler& captured : this->capture_.root().samplers)
+  {
+    vk::SamplerCreateInfo create_info;
+    create_info.setMagFilter(static_cast<vk::Filter>(captured.mag_filter))
+        .setMinFilter(static_cast<vk::Filter>(captured.min_filter))
+        .setMipmapMode(static_cast<vk::SamplerMipmapMode>(captured.mipmap_mode))
+        .setAddressModeU(static_cast<vk::SamplerAddressMode>(captured.address_mode_u))
+        .setAddressModeV(static_cast<vk::SamplerAddressMode>(captured.address_mode_v))
+        .setAddressModeW(static_cast<vk::SamplerAddressMode>(captured.address_mode_w))
+        .setMaxLod(captured.max_lod);
+    this->samplers_.push_back(VULKAN_CALL(this->device_.createSampler(create_info)).value());
+  }
+}
+
+void FrameReplayer::initRenderPasses()
+{
+  for (const CaptureRenderPass& captured : this->capture_.root().render_passes)
+  {
+    RenderPassDesc desc;
+    desc.color_attachment = vk::AttachmentDescription(captured.color_attachment);
+    desc.dependencies.assign(captured.dependencies.begin(), captured.dependencies.end());
+
+    // Nothing is presented, images the engine presented stay ready to be rendered to
+    if (desc.color_attachment.finalLayout == vk::ImageLayout::ePresentSrcKHR)
+      desc.color_attachment.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    this->render_passes_.push_back(buildRenderPass(this->device_, desc));
+  }
+}
+
+void FrameReplayer::initFramebuffers()
+{
+  for (const CaptureFramebuffer& captured : this->capture_.root().framebuffers)
+  {
+    vk::FramebufferCreateInfo create_info;
+    create_info.setRenderPass(at(this->render_passes_, captured.render_pass, "render pass"))
+        .setAttachments(at(this->images_, captured.image, "image").view)
+        .setWidth(captured.width)
+        .setHeight(captured.height)
+        .setLayers(1);
+    this->framebuffers_.push_back(
+        VULKAN_CALL(this->device_.createFramebuffer(create_info)).value());
+  }
+}
+
+void FrameReplayer::initPipelines()
+{
+  // Binders are created first, pipeline layouts are made of their set layouts
+  const CaptureRoot& root = this->capture_.root();
+  for (const CaptureBinder& captured : root.binders)
+  {
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+    for (const CaptureDescriptorBinding& binding : captured.bindings)
+    {
+      bindings.emplace_back(binding.binding,
+                            static_cast<vk::DescriptorType>(binding.type),
+                            binding.count,
+                            vk::ShaderStageFlags(binding.stages));
+    }
+    // Every frame is waited for, so a single frame's pool is enough
+    this->binders_.push_back(std::make_unique<DescriptorBinder>(this->device_,
+                                                                vk::PipelineBindPoint::eGraphics,
+                                                                bindings,
+                                                                this->max_push_descriptors_,
+                                                                1));
+  }
+
+  for (const CapturePipeline& captured : root.pipelines)
+  {
+    GraphicsPipelineDesc desc;
+    desc.vertex_bindings.assign(captured.vertex_bindings.begin(), captured.vertex_bindings.end());
+    desc.vertex_attributes.assign(captured.vertex_attributes.begin(),
+                                  captured.vertex_attributes.end());
+    for (uint32_t binder : captured.set_layouts)
+      desc.set_layouts.push_back(at(this->binders_, binder, "binder")->getSetLayout());
+    desc.push_constant_ranges.assign(captured.push_constant_ranges.begin(),
+                                     captured.push_constant_ranges.end());
+    desc.cull_mode           = vk::CullModeFlags(captured.cull_mode);
+    desc.alpha_blend         = captured.alpha_blend != 0;
+    desc.premultiplied_alpha = captured.premultiplied_alpha != 0;
+    desc.color_write         = captured.color_write != 0;
+    desc.pq_output           = captured.pq_output != 0;
+
+    vk::ShaderModule vertex_shader   = createShaderModule(this->device_, captured.vertex_shader);
+    vk::ShaderModule fragment_shader = createShaderModule(this->device_, captured.fragment_shader);
+    this->pipelines_.push_back(
+        buildGraphicsPipeline(this->device_,
+                              at(this->render_passes_, captured.render_pass, "render pass"),
+                              desc,
+                              vertex_shader,
+                              fragment_shader));
+    this->device_.destroyShaderModule(fragment_shader);
+    this->device_.destroyShaderModule(vertex_shader);
+  }
+
+  for (size_t i = 0; i < this->binders_.size(); i++)
+  {
+    const CaptureBinder& captured = root.binders[i];
+    this->binders_[i]->setPipelineLayout(
+        at(this->pipelines_, captured.pipeline, "pipeline").layout, captured.set_index);
+  }
+}
+
+void FrameReplayer::recordFrame(const CaptureFrame& frame)
+{
+  vk::CommandBuffer commands = this->command_buffer_;
+  VULKAN_CALL(commands.begin(
+                  vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)))
+      .value();
+  if (this->query_pool_)
+  {
+    commands.resetQueryPool(this->query_pool_, 0, 2);
+    commands.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, this->query_pool_, 0);
+  }
+
+  const uint32_t* word = frame.commands.begin();
+  const uint32_t* end  = frame.commands.end();
+  while (word != end)
+  {
+    auto op            = static_cast<CaptureOp>(*word & 0xff);
+    uint32_t remaining = *word >> 8;
+    word++;
+    if (remaining > static_cast<size_t>(end - word))
+      throw std::runtime_error("capture has a truncated command");
+    CommandReader command(word, remaining);
+    word += remaining;
+
+    switch (op)
+    {
+    case CaptureOp::BeginRenderPass:
+    {
+      vk::RenderPass render_pass  = at(this->render_passes_, command.u32(), "render pass");
+      vk::Framebuffer framebuffer = at(this->framebuffers_, command.u32(), "framebuffer");
+      int32_t x                   = command.i32();
+      int32_t y                   = command.i32();
+      uint32_t width              = command.u32();
+      uint32_t height             = command.u32();
+      uint32_t clear_count        = command.u32();
+      this->clear_values_.clear();
+      for (uint32_t i = 0; i < clear_count; i++)
+      {
+        std::array<float, 4> color;
+        for (float& channel : color)
+          channel = command.f32();
+        this->clear_values_.push_back(vk::ClearColorValue(color));
+      }
+      vk::RenderPassBeginInfo begin_info;
+      begin_info.setRenderPass(render_pass)
+          .setFramebuffer(framebuffer)
+          .setRenderArea(vk::Rect2D({ x, y }, { width, height }))
+          .setClearValues(this->clear_values_);
+      commands.beginRenderPass(begin_info, vk::SubpassContents::eInline);
+      break;
+    }
+    case CaptureOp::EndRenderPass:
+      commands.endRenderPass();
+      break;
+    case CaptureOp::SetViewport:
+    {
+      vk::Viewport viewport;
+      viewport.setX(command.f32())
+          .setY(command.f32())
+          .setWidth(command.f32())
+          .setHeight(command.f32())
+          .setMinDepth(command.f32())
+          .setMaxDepth(command.f32());
+      commands.setViewport(0, viewport);
+      break;
+    }
+    case CaptureOp::SetScissor:
+    {
+      int32_t x       = command.i32();
+      int32_t y       = command.i32();
+      uint32_t width  = command.u32();
+      uint32_t height = command.u32();
+      commands.setScissor(0, vk::Rect2D({ x, y }, { width, height }));
+      break;
+    }
+    case CaptureOp::ClearAttachment:
+    {
+      vk::ClearAttachment attachment;
+      attachment.setAspectMask(vk::ImageAspectFlags(command.u32()))
+          .setColorAttachment(command.u32());
+      std::array<float, 4> color;
+      for (float& channel : color)
+        channel = command.f32();
+      attachment.setClearValue(vk::ClearColorValue(color));
+      int32_t x       = command.i32();
+      int32_t y       = command.i32();
+      uint32_t width  = command.u32();
+      uint32_t height = command.u32();
+      uint32_t base   = command.u32();
+      uint32_t layers = command.u32();
+      vk::ClearRect rect(vk::Rect2D({ x, y }, { width, height }), base, layers);
+      commands.clearAttachments(attachment, rect);
+      break;
+    }
+    case CaptureOp::BindPipeline:
+    {
+      const Pipeline& pipeline = at(this->pipelines_, command.u32(), "pipeline");
+      commands.bindPipeline(pipeline.bind_point, pipeline.pipeline);
+      break;
+    }
+    case CaptureOp::PushConstants:
+    {
+      const Pipeline& pipeline = at(this->pipelines_, command.u32(), "pipeline");
+      auto stages              = vk::ShaderStageFlags(command.u32());
+      uint32_t offset          = command.u32();
+      uint32_t size            = command.u32();
+      const uint32_t* values   = command.words((size + 3) / 4);
+      commands.pushConstants(pipeline.layout, stages, offset, size, values);
+      break;
+    }
+    case CaptureOp::BindVertexBuffer:
+    {
+      uint32_t binding      = command.u32();
+      const Buffer& buffer  = at(this->buffers_, command.u32(), "buffer");
+      vk::DeviceSize offset = command.u64();
+      commands.bindVertexBuffers(binding, buffer.buffer, offset);
+      break;
+    }
+    case CaptureOp::BindIndexBuffer:
+    {
+      const Buffer& buffer  = at(this->buffers_, command.u32(), "buffer");
+      vk::DeviceSize offset = command.u64();
+      commands.bindIndexBuffer(buffer.buffer, offset, command.as<vk::IndexType>());
+      break;
+    }
+    case CaptureOp::BindDescriptors:
+    {
+      DescriptorBinder& binder = *at(this->binders_, command.u32(), "binder");
+      this->descriptor_infos_.clear();
+      for (const vk::DescriptorSetLayoutBinding& binding : binder.bindings())
+      {
+        if (captureDescriptorIsBuffer(binding.descriptorType))
+        {
+          const Buffer& buffer  = at(this->buffers_, command.u32(), "buffer");
+          vk::DeviceSize offset = command.u64();
+          vk::DeviceSize range  = command.u64();
+          this->descriptor_infos_.emplace_back(
+              vk::DescriptorBufferInfo(buffer.buffer, offset, range));
+        } else
+        {
+          uint32_t sampler_index = command.u32();
+          vk::Sampler sampler;
+          if (sampler_index != capture_no_index)
+            sampler = at(this->samplers_, sampler_index, "sampler");
+          const Image& image = at(this->images_, command.u32(), "image");
+          this->descriptor_infos_.emplace_back(
+              vk::DescriptorImageInfo(sampler, image.view, command.as<vk::ImageLayout>()));
+        }
+      }
+      Result<void> result = binder.bind(commands, this->descriptor_infos_.data());
+      if (!result)
+        throw std::runtime_error("Failed to bind descriptors: " + vk::to_string(result.code()));
+      break;
+    }
+    case CaptureOp::Draw:
+    {
+      uint32_t vertex_count   = command.u32();
+      uint32_t instance_count = command.u32();
+      uint32_t first_vertex   = command.u32();
+      uint32_t first_instance = command.u32();
+      commands.draw(vertex_count, instance_count, first_vertex, first_instance);
+      break;
+    }
+    case CaptureOp::DrawIndexed:
+    {
+      uint32_t index_count    = command.u32();
+      uint32_t instance_count = command.u32();
+      uint32_t first_index    = command.u32();
+      int32_t vertex_offset   = command.i32();
+      uint32_t first_instance = command.u32();
+      commands.drawIndexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+      break;
+    }
+    case CaptureOp::ImageBarrier:
+    {
+      auto src_stages = vk::PipelineStageFlags(command.u32());
+      auto dst_stages = vk::PipelineStageFlags(command.u32());
+      vk::ImageMemoryBarrier barrier;
+      barrier.setSrcAccessMask(vk::AccessFlags(command.u32()))
+          .setDstAccessMask(vk::AccessFlags(command.u32()))
+          .setOldLayout(command.as<vk::ImageLayout>())
+          .setNewLayout(command.as<vk::ImageLayout>())
+          .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+          .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+          .setImage(at(this->images_, command.u32(), "image").image);
+      vk::ImageSubresourceRange range;
+      range.setAspectMask(vk::ImageAspectFlags(command.u32()))
+          .setBaseMipLevel(command.u32())
+          .setLevelCount(command.u32())
+          .setBaseArrayLayer(command.u32())
+          .setLayerCount(command.u32());
+      barrier.setSubresourceRange(range);
+      commands.pipelineBarrier(src_stages, dst_stages, {}, nullptr, nullptr, barrier);
+      break;
+    }
+    case CaptureOp::CopyBufferToImage:
+    {
+      const Buffer& buffer  = at(this->buffers_, command.u32(), "buffer");
+      const Image& image    = at(this->images_, command.u32(), "image");
+      auto layout           = command.as<vk::ImageLayout>();
+      uint32_t region_count = command.u32();
+      this->copy_regions_.clear();
+      for (uint32_t i = 0; i < region_count; i++)
+      {
+        vk::BufferImageCopy region;
+        region.setBufferOffset(command.u64())
+            .setBufferRowLength(command.u32())
+            .setBufferImageHeight(command.u32());
+        vk::ImageSubresourceLayers subresource;
+        subresource.setAspectMask(vk::ImageAspectFlags(command.u32()))
+            .setMipLevel(command.u32())
+            .setBaseArrayLayer(command.u32())
+            .setLayerCount(command.u32());
+        region.setImageSubresource(subresource);
+        int32_t x = command.i32();
+        int32_t y = command.i32();
+        int32_t z = command.i32();
+        region.setImageOffset(vk::Offset3D(x, y, z));
+        uint32_t width  = command.u32();
+        uint32_t height = command.u32();
+        uint32_t depth  = command.u32();
+        region.setImageExtent(vk::Extent3D(width, height, depth));
+        this->copy_regions_.push_back(region);
+      }
+      commands.copyBufferToImage(buffer.buffer, image.image, layout, this->copy_regions_);
+      break;
+    }
+    default:
+      throw std::runtime_error("capture has an unknown command " +
+                               std::to_string(static_cast<uint32_t>(op)));
+    }
+  }
+
+  if (this->query_pool_)
+    commands.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, this->query_pool_, 1);
+  VULKAN_CALL(commands.end()).value();
+}
+
+std::vector<ReplayFrameStats> FrameReplayer::replay()
+{
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  using Clock = std::chrono::steady_clock;
+
+  const CaptureRoot& root = this->capture_.root();
+  std::vector<ReplayFrameStats> stats(root.frames.size());
+  for (size_t i = 0; i < stats.size(); i++)
+  {
+    stats[i].captured_record_time = nanoseconds(root.frames[i].record_ns);
+    stats[i].min_record_time      = nanoseconds::max();
+  }
+
+  for (uint32_t repeat = 0; repeat < this->options_.repeat_count; repeat++)
+  {
+    for (size_t i = 0; i < root.frames.size(); i++)
+    {
+      const CaptureFrame& frame     = root.frames[i];
+      ReplayFrameStats& frame_stats = stats[i];
+
+      // Host visible buffers get the contents the GPU read when the frame was captured
+      auto upload_start = Clock::now();
+      for (const CaptureBufferWrite& write : frame.buffer_writes)
+      {
+        const Buffer& buffer = at(this->buffers_, write.buffer, "buffer");
+        if (!buffer.mapped || write.contents.size() > buffer.size)
+          throw std::runtime_error("capture writes contents that do not fit a buffer");
+        std::memcpy(buffer.mapped, write.contents.begin(), write.contents.size());
+      }
+      frame_stats.upload_time += duration_cast<nanoseconds>(Clock::now() - upload_start);
+
+      // Timed like the engine times recording, from the binders' new frame to the end of the
+      // command buffer
+      auto record_start = Clock::now();
+      for (const std::unique_ptr<DescriptorBinder>& binder : this->binders_)
+        binder->beginFrame(0).value();
+      VULKAN_CALL(this->command_buffer_.reset()).value();
+      this->recordFrame(frame);
+      auto record_time = duration_cast<nanoseconds>(Clock::now() - record_start);
+      frame_stats.record_time += record_time;
+      frame_stats.min_record_time = std::min(frame_stats.min_record_time, record_time);
+
+      vk::SubmitInfo submit_info;
+      submit_info.setCommandBuffers(this->command_buffer_);
+      VULKAN_CALL(this->queue_.submit(submit_info, this->fence_)).value();
+      VULKAN_CALL(this->device_.waitForFences(this->fence_, VK_TRUE, UINT64_MAX)).value();
+      VULKAN_CALL(this->device_.resetFences(this->fence_)).value();
+
+      if (this->query_pool_)
+      {
+        uint64_t timestamps[2];
+        VULKAN_CALL(this->device_.getQueryPoolResults(this->query_pool_,
+                                                      0,
+                                                      2,
+                                                      sizeof(timestamps),
+                                                      timestamps,
+                                                      sizeof(uint64_t),
+                                                      vk::QueryResultFlagBits::e64 |
+                                                          vk::QueryResultFlagBits::eWait))
+            .value();
+        double ticks = static_cast<double>(timestamps[1] - timestamps[0]);
+        frame_stats.gpu_time += nanoseconds(static_cast<int64_t>(ticks * this->timestamp_period_));
+      }
+    }
+  }
+
+  for (ReplayFrameStats& frame_stats : stats)
+  {
+    frame_stats.record_time /= this->options_.repeat_count;
+    frame_stats.gpu_time /= this->options_.repeat_count;
+    frame_stats.upload_time /= this->options_.repeat_count;
+  }
+  return stats;
+}
+
+FrameReplayer::~FrameReplayer()
+{
+  for (const Pipeline& pipeline : this->pipelines_)
+  {
+    this->device_.destroyPipeline(pipeline.pipeline);
+    this->device_.destroyPipelineLayout(pipeline.layout);
+  }
+  this->binders_.clear();
+  for (vk::Framebuffer framebuffer : this->framebuffers_)
+    this->device_.destroyFramebuffer(framebuffer);
+  for (vk::RenderPass render_pass : this->render_passes_)
+    this->device_.destroyRenderPass(render_pass);
+  for (vk::Sampler sampler : this->samplers_)
+    this->device_.destroySampler(sampler);
+  for (const Image& image : this->images_)
+  {
+    this->device_.destroyImageView(image.view);
+    this->device_.destroyImage(image.image);
+    this->device_.freeMemory(image.memory);
+  }
+  for (const Buffer& buffer : this->buffers_)
+    this->destroyBuffer(buffer);
+  this->device_.destroyQueryPool(this->query_pool_);
+  this->device_.destroyFence(this->fence_);
+  this->device_.destroyCommandPool(this->command_pool_);
+  this->device_.destroy();
+  this->instance_.destroy();
+}
@@ -0,0 +1,65 @@
+#include "GlyphCache.hpp"
+
+#include <algorithm>
+
+GlyphCache::GlyphCache(uint32_t page_size, uint32_t cell_size, uint32_t page_count) :
+  cell_size_(cell_size),
+  cells_per_row_(page_size / cell_size),
+  cells_per_page_(cells_per_row_ * cells_per_row_),
+  pages_(page_count)
+{
+}
+
+const GlyphSlot* GlyphCache::find(uint32_t glyph, uint64_t frame)
+{
+  auto it = this->slots_.find(glyph);
+  if (it == this->slots_.end())
+    return nullptr;
+  this->pages_[it->second.page].last_used = frame;
+  return &it->second;
+}
+
+std::optional<GlyphSlot> GlyphCache::insert(uint32_t glyph, uint64_t frame, uint64_t evict_before)
+{
+  auto existing = this->slots_.find(glyph);
+  if (existing != this->slots_.end())
+    return existing->second;
+
+  // Move on to the least recently used page once the current one is full, emptying it
+  if (this->pages_[this->fill_page_].glyphs.size() == this->cells_per_page_)
+  {
+    auto oldest = std::min_element(this->pages_.begin(),
+                                   this->pages_.end(),
+                                   [](const Page& a, const Page& b) {
+                                     return a.last_used < b.last_used;
+                                   });
+    if (!oldest->glyphs.empty() && oldest->last_used >= evict_before)
+      return std::nullopt;
+    for (uint32_t evicted : oldest->glyphs)
+      this->slots_.erase(evicted);
+    if (!oldest->glyphs.empty())
+      this->eviction_count_++;
+    oldest->glyphs.clear();
+    this->fill_page_ = static_cast<uint32_t>(oldest - this->pages_.begin());
+  }
+
+  Page& page     = this->pages_[this->fill_page_];
+  uint32_t cell  = static_cast<uint32_t>(page.glyphs.size());
+  page.last_used = frame;
+  page.glyphs.push_back(glyph);
+  GlyphSlot slot = { this->fill_page_,
+                     (cell % this->cells_per_row_) * this->cell_size_,
+                     (cell / this->cells_per_row_) * this->cell_size_ };
+  this->slots_.emplace(glyph, slot);
+  return slot;
+}
+
+size_t GlyphCache::size() const
+{
+  return this->slots_.size();
+}
+
+uint64_t GlyphCache::evictionCount() const
+{
+  return this->eviction_count_;
+}
@@ -0,0 +1,110 @@
+#include "GpuProfiler.hpp"
+#include "Profiler.hpp"
+#include "Result.hpp"
+
+#include <algorithm>
+
+GpuProfiler::GpuProfiler(vk::PhysicalDevice physical_device,
+                         vk::Device device,
+                         uint32_t queue_family,
+                         uint32_t frame_count) :
+  device_(device),
+  frames_(frame_count)
+{
+  std::vector<vk::QueueFamilyProperties> families = physical_device.getQueueFamilyProperties();
+  uint32_t valid_bits                              = families.at(queue_family).timestampValidBits;
+  if (valid_bits == 0)
+    return;
+  this->timestamp_mask_   = valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << valid_bits) - 1;
+  this->timestamp_period_ = physical_device.getProperties().limits.timestampPeriod;
+
+  // Two timestamps per zone
+  vk::QueryPoolCreateInfo create_info;
+  create_info.setQueryType(vk::QueryType::eTimestamp)
+      .setQueryCount(frame_count * max_zones_per_frame_ * 2);
+  this->query_pool_ = VULKAN_CALL(this->device_.createQueryPool(create_info)).value();
+}
+
+bool GpuProfiler::enabled() const
+{
+  return static_cast<bool>(this->query_pool_);
+}
+
+void GpuProfiler::collect(uint32_t frame)
+{
+  FrameZones& zones = this->frames_[frame];
+  if (!this->query_pool_ || zones.count == 0 || zones.submit_time == 0)
+    return;
+
+  std::array<uint64_t, max_zones_per_frame_ * 2> timestamps;
+  vk::Result result = this->device_.getQueryPoolResults(this->query_pool_,
+                                                        frame * max_zones_per_frame_ * 2,
+                                                        zones.count * 2,
+                                                        sizeof(timestamps),
+                                                        timestamps.data(),
+                                                        sizeof(uint64_t),
+                                                        vk::QueryResultFlagBits::e64);
+  uint32_t count    = zones.count;
+  zones.count       = 0;
+  if (result != vk::Result::eSuccess)
+    return;
+
+  // The first zone starts the frame, everything is placed relative to it
+  auto nanoseconds = [&](uint64_t ticks)
+  {
+    uint64_t elapsed = (ticks - timestamps[0]) & this->timestamp_mask_;
+    return static_cast<int64_t>(static_cast<double>(elapsed) * this->timestamp_period_);
+  };
+  int64_t frame_begin = std::max(zones.submit_time, this->last_end_);
+  for (uint32_t zone = 0; zone < count; zone++)
+  {
+    int64_t begin = frame_begin + nanoseconds(timestamps[zone * 2]);
+    int64_t end   = frame_begin + nanoseconds(timestamps[zone * 2 + 1]);
+    Profiler::instance().recordGpu(zones.names[zone], begin, end);
+    this->last_end_ = std::max(this->last_end_, end);
+  }
+}
+
+void GpuProfiler::beginFrame(vk::CommandBuffer command_buffer, uint32_t frame)
+{
+  FrameZones& zones = this->frames_[frame];
+  zones.count       = 0;
+  zones.submit_time = 0;
+  if (this->query_pool_)
+  {
+    command_buffer.resetQueryPool(
+        this->query_pool_, frame * max_zones_per_frame_ * 2, max_zones_per_frame_ * 2);
+  }
+}
+
+uint32_t GpuProfiler::beginZone(vk::CommandBuffer command_buffer, uint32_t frame, const char* name)
+{
+  FrameZones& zones = this->frames_[frame];
+  if (!this->query_pool_ || zones.count == max_zones_per_frame_)
+    return no_zone_;
+  uint32_t zone     = zones.count++;
+  zones.names[zone] = name;
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe,
+                                this->query_pool_,
+                                (frame * max_zones_per_frame_ + zone) * 2);
+  return zone;
+}
+
+void GpuProfiler::endZone(vk::CommandBuffer command_buffer, uint32_t frame, uint32_t zone)
+{
+  if (zone == no_zone_)
+    return;
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                this->query_pool_,
+                                (frame * max_zones_per_frame_ + zone) * 2 + 1);
+}
+
+void GpuProfiler::submitted(uint32_t frame, int64_t submit_time)
+{
+  this->frames_[frame].submit_time = submit_time;
+}
+
+GpuProfiler::~GpuProfiler()
+{
+  this->device_.destroyQueryPool(this->query_pool_);
+}
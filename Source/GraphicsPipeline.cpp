@@ -0,0 +1,120 @@
+#include "GraphicsPipeline.hpp"
+
+#include "Result.hpp"
+
+vk::RenderPass buildRenderPass(vk::Device device, const RenderPassDesc& desc)
+{
+  vk::AttachmentReference color_attachment_ref(0, vk::ImageLayout::eColorAttachmentOptimal);
+
+  vk::SubpassDescription subpass;
+  subpass.setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+      .setColorAttachments(color_attachment_ref);
+
+  vk::RenderPassCreateInfo create_info;
+  create_info.setAttachments(desc.color_attachment)
+      .setSubpasses(subpass)
+      .setDependencies(desc.dependencies);
+  return VULKAN_CALL(device.createRenderPass(create_info)).value();
+}
+
+Pipeline buildGraphicsPipeline(vk::Device device,
+                               vk::RenderPass render_pass,
+                               const GraphicsPipelineDesc& desc,
+                               vk::ShaderModule vertex_shader,
+                               vk::ShaderModule fragment_shader)
+{
+  // Prepare the vertex shader stage create info
+  vk::PipelineShaderStageCreateInfo vert_shader_stage_ci;
+  vert_shader_stage_ci.setStage(vk::ShaderStageFlagBits::eVertex)
+      .setModule(vertex_shader)
+      .setPName("main");
+
+  // Prepare the fragment shader stage create info, constant 0 selects the output encoding of the
+  // shaders including Shader/output.glsl and is ignored by the others
+  vk::Bool32 pq_output = desc.pq_output ? VK_TRUE : VK_FALSE;
+  vk::SpecializationMapEntry pq_output_entry(0, 0, sizeof(pq_output));
+  vk::SpecializationInfo specialization_info(1, &pq_output_entry, sizeof(pq_output), &pq_output);
+  vk::PipelineShaderStageCreateInfo frag_shader_stage_ci;
+  frag_shader_stage_ci.setStage(vk::ShaderStageFlagBits::eFragment)
+      .setModule(fragment_shader)
+      .setPName("main")
+      .setPSpecializationInfo(&specialization_info);
+
+  // Collate shader stages create informations
+  std::vector<vk::PipelineShaderStageCreateInfo> shader_stages = { vert_shader_stage_ci,
+                                                                   frag_shader_stage_ci };
+
+  vk::PipelineVertexInputStateCreateInfo vert_input_state_ci;
+  vert_input_state_ci.setVertexBindingDescriptions(desc.vertex_bindings)
+      .setVertexAttributeDescriptions(desc.vertex_attributes);
+
+  vk::PipelineInputAssemblyStateCreateInfo input_assembly_state_ci;
+  input_assembly_state_ci.setTopology(vk::PrimitiveTopology::eTriangleList)
+      .setPrimitiveRestartEnable(VK_FALSE);
+
+  // Viewport and scissor are set while recording, only their counts are part of the pipeline
+  vk::PipelineViewportStateCreateInfo viewport_state_ci;
+  viewport_state_ci.setViewportCount(1).setScissorCount(1);
+
+  std::vector<vk::DynamicState> dynamic_states = { vk::DynamicState::eViewport,
+                                                   vk::DynamicState::eScissor };
+  vk::PipelineDynamicStateCreateInfo dynamic_state_ci;
+  dynamic_state_ci.setDynamicStates(dynamic_states);
+
+  vk::PipelineRasterizationStateCreateInfo rasterization_state_ci;
+  rasterization_state_ci.setDepthClampEnable(VK_FALSE)
+      .setRasterizerDiscardEnable(VK_FALSE)
+      .setPolygonMode(vk::PolygonMode::eFill)
+      .setLineWidth(1.0)
+      .setCullMode(desc.cull_mode)
+      .setFrontFace(vk::FrontFace::eClockwise)
+      .setDepthBiasEnable(VK_FALSE);
+
+  vk::PipelineMultisampleStateCreateInfo multisample_state_ci;
+  multisample_state_ci.setSampleShadingEnable(VK_FALSE).setRasterizationSamples(
+      vk::SampleCountFlagBits::e1);
+
+  // Alpha blending uses straight alpha unless the desc says otherwise. Blending into a transparent
+  // target leaves premultiplied colour behind, which is how cached layers are composited.
+  vk::BlendFactor src_color_factor =
+      desc.premultiplied_alpha ? vk::BlendFactor::eOne : vk::BlendFactor::eSrcAlpha;
+  vk::ColorComponentFlags color_write_mask;
+  if (desc.color_write)
+  {
+    color_write_mask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+                       vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+  }
+  vk::PipelineColorBlendAttachmentState color_blend_attachment_state_ci;
+  color_blend_attachment_state_ci.setColorWriteMask(color_write_mask)
+      .setBlendEnable(desc.alpha_blend ? VK_TRUE : VK_FALSE)
+      .setSrcColorBlendFactor(src_color_factor)
+      .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
+      .setColorBlendOp(vk::BlendOp::eAdd)
+      .setSrcAlphaBlendFactor(vk::BlendFactor::eOne)
+      .setDstAlphaBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
+      .setAlphaBlendOp(vk::BlendOp::eAdd);
+
+  vk::PipelineColorBlendStateCreateInfo color_blend_state_ci;
+  color_blend_state_ci.setLogicOpEnable(VK_FALSE).setAttachments(color_blend_attachment_state_ci);
+
+  vk::PipelineLayoutCreateInfo pipeline_layout_ci;
+  pipeline_layout_ci.setSetLayouts(desc.set_layouts)
+      .setPushConstantRanges(desc.push_constant_ranges);
+  Pipeline pipeline;
+  pipeline.layout = VULKAN_CALL(device.createPipelineLayout(pipeline_layout_ci)).value();
+
+  vk::GraphicsPipelineCreateInfo pipeline_ci;
+  pipeline_ci.setStages(shader_stages)
+      .setPVertexInputState(&vert_input_state_ci)
+      .setPInputAssemblyState(&input_assembly_state_ci)
+      .setPViewportState(&viewport_state_ci)
+      .setPRasterizationState(&rasterization_state_ci)
+      .setPMultisampleState(&multisample_state_ci)
+      .setPColorBlendState(&color_blend_state_ci)
+      .setPDynamicState(&dynamic_state_ci)
+      .setLayout(pipeline.layout)
+      .setRenderPass(render_pass)
+      .setSubpass(0);
+  pipeline.pipeline = VULKAN_CALL(device.createGraphicsPipeline(nullptr, pipeline_ci)).value();
+  return pipeline;
+}
@@ -0,0 +1,329 @@
+#include "Json.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+// Recursive descent parser over the document text
+class JsonParser
+{
+private:
+  std::string_view text_;
+  size_t position_ = 0;
+
+  [[noreturn]] void fail(const char* message) const
+  {
+    throw std::runtime_error(std::string("JSON parse error at offset ") +
+                             std::to_string(this->position_) + ": " + message);
+  }
+
+  void skipWhitespace()
+  {
+    while (this->position_ < this->text_.size() &&
+           (this->text_[this->position_] == ' ' || this->text_[this->position_] == '\t' ||
+            this->text_[this->position_] == '\n' || this->text_[this->position_] == '\r'))
+      this->position_++;
+  }
+
+  char peek()
+  {
+    this->skipWhitespace();
+    if (this->position_ >= this->text_.size())
+      this->fail("unexpected end of document");
+    return this->text_[this->position_];
+  }
+
+  void expect(char character)
+  {
+    if (this->peek() != character)
+      this->fail("unexpected character");
+    this->position_++;
+  }
+
+  bool consumeLiteral(std::string_view literal)
+  {
+    if (this->text_.substr(this->position_, literal.size()) != literal)
+      return false;
+    this->position_ += literal.size();
+    return true;
+  }
+
+  // Appends a code point as UTF-8
+  static void appendUtf8(std::string& string, uint32_t code_point)
+  {
+    if (code_point < 0x80)
+    {
+      string += static_cast<char>(code_point);
+    } else if (code_point < 0x800)
+    {
+      string += static_cast<char>(0xC0 | (code_point >> 6));
+      string += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000)
+    {
+      string += static_cast<char>(0xE0 | (code_point >> 12));
+      string += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      string += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else
+    {
+      string += static_cast<char>(0xF0 | (code_point >> 18));
+      string += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      string += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      string += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  uint32_t parseHex4()
+  {
+    if (this->position_ + 4 > this->text_.size())
+      this->fail("truncated unicode escape");
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+      char digit = this->text_[this->position_++];
+      value <<= 4;
+      if (digit >= '0' && digit <= '9')
+        value |= digit - '0';
+      else if (digit >= 'a' && digit <= 'f')
+        value |= digit - 'a' + 10;
+      else if (digit >= 'A' && digit <= 'F')
+        value |= digit - 'A' + 10;
+      else
+        this->fail("invalid unicode escape");
+    }
+    return value;
+  }
+
+  std::string parseString()
+  {
+    this->expect('"');
+    std::string string;
+    while (true)
+    {
+      if (this->position_ >= this->text_.size())
+        this->fail("unterminated string");
+      char character = this->text_[this->position_++];
+      if (character == '"')
+        return string;
+      if (character != '\\')
+      {
+        string += character;
+        continue;
+      }
+      if (this->position_ >= this->text_.size())
+        this->fail("unterminated escape");
+      char escape = this->text_[this->position_++];
+      switch (escape)
+      {
+      case '"':
+      case '\\':
+      case '/':
+        string += escape;
+        break;
+      case 'b':
+        string += '\b';
+        break;
+      case 'f':
+        string += '\f';
+        break;
+      case 'n':
+        string += '\n';
+        break;
+      case 'r':
+        string += '\r';
+        break;
+      case 't':
+        string += '\t';
+        break;
+      case 'u':
+      {
+        uint32_t code_point = this->parseHex4();
+        // Combine a surrogate pair into one code point
+        if (code_point >= 0xD800 && code_point < 0xDC00 && this->consumeLiteral("\\u"))
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) + (this->parseHex4() - 0xDC00);
+        appendUtf8(string, code_point);
+        break;
+      }
+      default:
+        this->fail("invalid escape");
+      }
+    }
+  }
+
+  double parseNumber()
+  {
+    const char* start = this->text_.data() + this->position_;
+    char* end         = nullptr;
+    // The document is a string_view, copy the number out so strtod cannot read past it
+    size_t length = 0;
+    while (this->position_ + length < this->text_.size() &&
+           std::string_view("+-0123456789.eE").find(this->text_[this->position_ + length]) !=
+               std::string_view::npos)
+      length++;
+    std::string number(start, length);
+    double value = std::strtod(number.c_str(), &end);
+    if (end == number.c_str())
+      this->fail("invalid number");
+    this->position_ += end - number.c_str();
+    return value;
+  }
+
+public:
+  explicit JsonParser(std::string_view text) : text_(text) { }
+
+  JsonValue parseValue(int depth)
+  {
+    if (depth > 256)
+      this->fail("document nested too deeply");
+
+    JsonValue value;
+    char character = this->peek();
+    if (character == '{')
+    {
+      value.type_ = JsonValue::Type::Object;
+      this->position_++;
+      if (this->peek() == '}')
+      {
+        this->position_++;
+        return value;
+      }
+      while (true)
+      {
+        std::string key = this->parseString();
+        this->expect(':');
+        value.object_.emplace_back(std::move(key), this->parseValue(depth + 1));
+        if (this->peek() == ',')
+        {
+          this->position_++;
+          continue;
+        }
+        this->expect('}');
+        return value;
+      }
+    }
+    if (character == '[')
+    {
+      value.type_ = JsonValue::Type::Array;
+      this->position_++;
+      if (this->peek() == ']')
+      {
+        this->position_++;
+        return value;
+      }
+      while (true)
+      {
+        value.array_.push_back(this->parseValue(depth + 1));
+        if (this->peek() == ',')
+        {
+          this->position_++;
+          continue;
+        }
+        this->expect(']');
+        return value;
+      }
+    }
+    if (character == '"')
+    {
+      value.type_   = JsonValue::Type::String;
+      value.string_ = this->parseString();
+      return value;
+    }
+    if (this->consumeLiteral("true") || this->consumeLiteral("false"))
+    {
+      value.type_    = JsonValue::Type::Boolean;
+      value.boolean_ = character == 't';
+      return value;
+    }
+    if (this->consumeLiteral("null"))
+      return value;
+
+    value.type_   = JsonValue::Type::Number;
+    value.number_ = this->parseNumber();
+    return value;
+  }
+
+  void finish()
+  {
+    this->skipWhitespace();
+    if (this->position_ != this->text_.size())
+      this->fail("trailing characters after document");
+  }
+};
+
+JsonValue JsonValue::parse(std::string_view text)
+{
+  JsonParser parser(text);
+  JsonValue value = parser.parseValue(0);
+  parser.finish();
+  return value;
+}
+
+JsonValue::Type JsonValue::type() const
+{
+  return this->type_;
+}
+
+bool JsonValue::asBoolean() const
+{
+  if (this->type_ != Type::Boolean)
+    throw std::runtime_error("JSON value is not a boolean");
+  return this->boolean_;
+}
+
+double JsonValue::asNumber() const
+{
+  if (this->type_ != Type::Number)
+    throw std::runtime_error("JSON value is not a number");
+  return this->number_;
+}
+
+const std::string& JsonValue::asString() const
+{
+  if (this->type_ != Type::String)
+    throw std::runtime_error("JSON value is not a string");
+  return this->string_;
+}
+
+const std::vector<JsonValue>& JsonValue::asArray() const
+{
+  if (this->type_ != Type::Array)
+    throw std::runtime_error("JSON value is not an array");
+  return this->array_;
+}
+
+const std::vector<std::pair<std::string, JsonValue>>& JsonValue::asObject() const
+{
+  if (this->type_ != Type::Object)
+    throw std::runtime_error("JSON value is not an object");
+  return this->object_;
+}
+
+const JsonValue* JsonValue::find(std::string_view key) const
+{
+  for (const auto& [member_key, member] : this->object_)
+  {
+    if (member_key == key)
+      return &member;
+  }
+  return nullptr;
+}
+
+const JsonValue& JsonValue::at(std::string_view key) const
+{
+  const JsonValue* member = this->find(key);
+  if (!member)
+    throw std::runtime_error("JSON object has no member " + std::string(key));
+  return *member;
+}
+
+const JsonValue& JsonValue::at(size_t index) const
+{
+  const auto& array = this->asArray();
+  if (index >= array.size())
+    throw std::runtime_error("JSON array index out of range");
+  return array[index];
+}
+
+double JsonValue::numberOr(std::string_view key, double fallback) const
+{
+  const JsonValue* member = this->find(key);
+  return member ? member->asNumber() : fallback;
+}
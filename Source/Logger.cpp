@@ -0,0 +1,213 @@
+#include "Logger.hpp"
+
+#include <cinttypes>
+#include <stdexcept>
+#include <string>
+
+Logger::Logger() : start_time_(std::chrono::steady_clock::now())
+{
+  this->thread_ = std::thread(&Logger::process, this);
+}
+
+Logger& Logger::instance()
+{
+  static Logger logger;
+  return logger;
+}
+
+Logger::ThreadBuffer& Logger::threadBuffer()
+{
+  // Retires the thread's buffer when the thread exits, so that short-lived threads do not leave
+  // theirs behind
+  struct Registration
+  {
+    ThreadBuffer* buffer = nullptr;
+
+    ~Registration()
+    {
+      if (this->buffer)
+        this->buffer->retired.store(true, std::memory_order_release);
+    }
+  };
+  thread_local Registration registration;
+  if (registration.buffer)
+    return *registration.buffer;
+
+  // Register a buffer for this thread, only the first record from each thread takes the lock
+  std::lock_guard lock(this->buffers_mutex_);
+  auto& buffer         = this->buffers_.emplace_back(std::make_unique<ThreadBuffer>());
+  buffer->thread_index = this->next_thread_index_++;
+  registration.buffer  = buffer.get();
+  return *registration.buffer;
+}
+
+void Logger::openBinaryFile(const char* file_name)
+{
+  std::lock_guard lock(this->output_mutex_);
+  std::FILE* file = std::fopen(file_name, "wb");
+  if (!file)
+    throw std::runtime_error("Failed to open binary log file");
+  if (this->binary_file_)
+    std::fclose(this->binary_file_);
+  this->binary_file_ = file;
+}
+
+void Logger::process()
+{
+  while (this->running_.load(std::memory_order_relaxed))
+  {
+    // Back off while there is nothing to write
+    if (!this->drain())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // Write anything logged before the logger was stopped
+  this->drain();
+}
+
+bool Logger::drain()
+{
+  // Only the list of buffers is copied under the lock, a thread registering its buffer never
+  // waits for the writes below
+  {
+    std::lock_guard lock(this->buffers_mutex_);
+    this->draining_.clear();
+    for (auto& buffer : this->buffers_)
+      this->draining_.push_back(buffer.get());
+  }
+
+  // Gather every pending record so that records from different threads are written in order
+  this->pending_.clear();
+  bool retired = false;
+  for (ThreadBuffer* buffer : this->draining_)
+  {
+    Record record;
+    while (buffer->records.tryPop(record))
+      this->pending_.push_back(record);
+    retired |= buffer->retired.load(std::memory_order_relaxed);
+  }
+
+  // Free the buffers of exited threads. A buffer that retired before it was checked here holds no
+  // record that was not popped above, one that still holds records is freed on the next drain.
+  if (retired)
+  {
+    auto drained = [](const std::unique_ptr<ThreadBuffer>& buffer) {
+      return buffer->retired.load(std::memory_order_acquire) && buffer->records.sizeApprox() == 0;
+    };
+    std::lock_guard lock(this->buffers_mutex_);
+    this->buffers_.erase(std::remove_if(this->buffers_.begin(), this->buffers_.end(), drained),
+                         this->buffers_.end());
+  }
+
+  if (this->pending_.empty())
+    return false;
+
+  std::stable_sort(this->pending_.begin(),
+                   this->pending_.end(),
+                   [](const Record& a, const Record& b) { return a.timestamp < b.timestamp; });
+
+  std::lock_guard lock(this->output_mutex_);
+  for (const auto& record : this->pending_)
+  {
+    if (this->binary_file_)
+      this->writeBinary(record);
+    else
+      this->writeText(record);
+  }
+
+  if (this->binary_file_)
+    std::fflush(this->binary_file_);
+  std::fflush(stdout);
+  return true;
+}
+
+void Logger::writeText(const Record& record) const
+{
+  static constexpr const char* level_names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+
+  std::string line;
+  char prefix[64];
+  std::snprintf(prefix,
+                sizeof(prefix),
+                "[%12.6f] [%-5s] [T%" PRIu32 "] ",
+                record.timestamp / 1e9,
+                level_names[static_cast<size_t>(record.level)],
+                record.thread_index);
+  line += prefix;
+
+  // Substitute each {} in the format string with the next argument
+  size_t argument_index = 0;
+  for (const char* c = record.format; *c; c++)
+  {
+    if (c[0] != '{' || c[1] != '}' || argument_index == record.argument_count)
+    {
+      line += *c;
+      continue;
+    }
+    c++;
+
+    const Argument& argument = record.arguments[argument_index++];
+    switch (argument.type)
+    {
+      case Argument::Type::Signed:
+        line += std::to_string(argument.signed_value);
+        break;
+      case Argument::Type::Unsigned:
+        line += std::to_string(argument.unsigned_value);
+        break;
+      case Argument::Type::Floating:
+        line += std::to_string(argument.floating_value);
+        break;
+      case Argument::Type::String:
+        line.append(record.strings.data() + argument.string_value.offset,
+                    argument.string_value.size);
+        break;
+    }
+  }
+  line += '\n';
+
+  // Warnings and errors go to stderr, everything else to stdout
+  std::FILE* stream = record.level >= LogLevel::Warning ? stderr : stdout;
+  std::fwrite(line.data(), 1, line.size(), stream);
+}
+
+void Logger::writeBinary(const Record& record) const
+{
+  std::FILE* file = this->binary_file_;
+
+  // Record header
+  std::fwrite(&record.timestamp, sizeof(record.timestamp), 1, file);
+  std::fwrite(&record.thread_index, sizeof(record.thread_index), 1, file);
+  std::fwrite(&record.level, sizeof(record.level), 1, file);
+  std::fwrite(&record.argument_count, sizeof(record.argument_count), 1, file);
+
+  // Length prefixed format string
+  uint16_t format_size = static_cast<uint16_t>(std::char_traits<char>::length(record.format));
+  std::fwrite(&format_size, sizeof(format_size), 1, file);
+  std::fwrite(record.format, 1, format_size, file);
+
+  // Tagged arguments, strings are length prefixed
+  for (size_t i = 0; i < record.argument_count; i++)
+  {
+    const Argument& argument = record.arguments[i];
+    std::fwrite(&argument.type, sizeof(argument.type), 1, file);
+    if (argument.type == Argument::Type::String)
+    {
+      std::fwrite(&argument.string_value.size, sizeof(argument.string_value.size), 1, file);
+      std::fwrite(record.strings.data() + argument.string_value.offset,
+                  1,
+                  argument.string_value.size,
+                  file);
+    } else
+    {
+      std::fwrite(&argument.unsigned_value, sizeof(argument.unsigned_value), 1, file);
+    }
+  }
+}
+
+Logger::~Logger()
+{
+  this->running_.store(false, std::memory_order_relaxed);
+  this->thread_.join();
+  if (this->binary_file_)
+    std::fclose(this->binary_file_);
+}
@@ -1,10 +1,95 @@
 #include "Application.hpp"
+#include "Logger.hpp"
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
+// Printed by --help, one line per option
+static constexpr const char* usage =
+    "Usage: Vulkan-Engine [options]\n"
+    "  --binary-log FILE        Write the log to FILE in binary form\n"
+    "  --sprites N              Simulate and draw N sprites, 1000 by default\n"
+    "  --font FILE              Draw text with the TrueType font FILE\n"
+    "  --music FILE             Stream the WAVE file FILE in a loop\n"
+    "  --no-audio               Disable audio\n"
+    "  --no-collisions          Disable collisions between sprites\n"
+    "  --occlusion-culling      Occlusion test the triangle draws and skip those found hidden\n"
+    "  --hdr                    Present in HDR10 or scRGB where the display offers either\n"
+    "  --vsync                  Present one frame per vertical blank, V toggles it while running\n"
+    "  --present-thread         Present from a thread of its own\n"
+    "  --load-scene FILE        Start the simulation from the scene file FILE\n"
+    "  --save-scene FILE        Save the simulation to the scene file FILE on exit\n"
+    "  --capture FILE           Write frame captures for Vulkan-Replay to FILE, F12 captures\n"
+    "  --capture-frames N       Capture N consecutive frames, 1 by default\n"
+    "  --capture-start N        Capture by itself once N frames were drawn\n"
+    "  --metrics FILE           Write metrics for a node exporter's textfile collector to FILE\n"
+    "  --metrics-interval S     Write metrics every S seconds, 5 by default\n"
+    "  --stutter-threshold X    Trace frames over X times the median frame time, 0 disables it\n"
+    "  --stutter-trace PREFIX   Write stutter traces to PREFIX-<frame>.json\n"
+    "  --no-thread-placement    Leave engine threads to the OS instead of pinning them\n"
+    "  --benchmark-frames N     Exit after N frames and log their average frame time\n"
+    "  --help                   Print this and exit\n";
+
 int main(int argc, char* argv[])
 {
-  Application app;
+  ApplicationOptions options;
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strcmp(argv[i], "--binary-log") == 0 && i + 1 < argc)
+      Logger::instance().openBinaryFile(argv[++i]);
+    else if (std::strcmp(argv[i], "--sprites") == 0 && i + 1 < argc)
+      options.sprite_count = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (std::strcmp(argv[i], "--font") == 0 && i + 1 < argc)
+      options.font_file = argv[++i];
+    else if (std::strcmp(argv[i], "--music") == 0 && i + 1 < argc)
+      options.music_file = argv[++i];
+    else if (std::strcmp(argv[i], "--no-audio") == 0)
+      options.audio = false;
+    else if (std::strcmp(argv[i], "--no-collisions") == 0)
+      options.collisions = false;
+    else if (std::strcmp(argv[i], "--occlusion-culling") == 0)
+      options.occlusion_culling = true;
+    else if (std::strcmp(argv[i], "--no-thread-placement") == 0)
+      options.thread_placement = false;
+    else if (std::strcmp(argv[i], "--hdr") == 0)
+      options.hdr = true;
+    else if (std::strcmp(argv[i], "--vsync") == 0)
+      options.vsync = true;
+    else if (std::strcmp(argv[i], "--present-thread") == 0)
+      options.present_thread = true;
+    else if (std::strcmp(argv[i], "--load-scene") == 0 && i + 1 < argc)
+      options.load_scene_file = argv[++i];
+    else if (std::strcmp(argv[i], "--save-scene") == 0 && i + 1 < argc)
+      options.save_scene_file = argv[++i];
+    else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+      options.capture_file = argv[++i];
+    else if (std::strcmp(argv[i], "--capture-frames") == 0 && i + 1 < argc)
+      options.capture_frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (std::strcmp(argv[i], "--capture-start") == 0 && i + 1 < argc)
+      options.capture_start_frame = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+      options.metrics_file = argv[++i];
+    else if (std::strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc)
+      options.metrics_interval = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (std::strcmp(argv[i], "--stutter-threshold") == 0 && i + 1 < argc)
+      options.stutter_threshold = std::strtof(argv[++i], nullptr);
+    else if (std::strcmp(argv[i], "--stutter-trace") == 0 && i + 1 < argc)
+      options.stutter_trace_prefix = argv[++i];
+    else if (std::strcmp(argv[i], "--benchmark-frames") == 0 && i + 1 < argc)
+      options.benchmark_frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (std::strcmp(argv[i], "--help") == 0)
+    {
+      std::cout << usage;
+      return EXIT_SUCCESS;
+    } else
+    {
+      std::cerr << "Unknown option " << argv[i] << "\n" << usage;
+      return EXIT_FAILURE;
+    }
+  }
+
+  Application app(options);
 
   app.run();
 
@@ -0,0 +1,73 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& file)
+{
+#ifdef __linux__
+  int descriptor = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0)
+    throw std::runtime_error("Failed to open " + file.string());
+
+  // The mapping keeps the file alive, the descriptor is closed once it exists
+  struct stat status;
+  if (fstat(descriptor, &status) != 0)
+  {
+    close(descriptor);
+    throw std::runtime_error("Failed to stat " + file.string());
+  }
+  this->size_ = static_cast<size_t>(status.st_size);
+  if (this->size_ > 0)
+  {
+    void* memory = mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (memory == MAP_FAILED)
+    {
+      close(descriptor);
+      throw std::runtime_error("Failed to map " + file.string());
+    }
+    this->data_ = static_cast<std::byte*>(memory);
+  }
+  close(descriptor);
+#else
+  std::ifstream stream(file, std::ios::ate | std::ios::binary);
+  if (!stream)
+    throw std::runtime_error("Failed to open " + file.string());
+  this->size_ = static_cast<size_t>(stream.tellg());
+  this->data_ = new std::byte[this->size_];
+  stream.seekg(0);
+  if (!stream.read(reinterpret_cast<char*>(this->data_), static_cast<std::streamsize>(this->size_)))
+  {
+    delete[] this->data_;
+    throw std::runtime_error("Failed to read " + file.string());
+  }
+#endif
+}
+
+const std::byte* MappedFile::data() const
+{
+  return this->data_;
+}
+
+size_t MappedFile::size() const
+{
+  return this->size_;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef __linux__
+  if (this->data_)
+    munmap(this->data_, this->size_);
+#else
+  delete[] this->data_;
+#endif
+}
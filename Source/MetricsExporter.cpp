@@ -0,0 +1,319 @@
+#include "MetricsExporter.hpp"
+#include "AllocationTracker.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <system_error>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+void writeHeader(std::FILE* file, const char* name, const char* type, const char* help)
+{
+  std::fprintf(file, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+double seconds(std::chrono::nanoseconds time)
+{
+  return std::chrono::duration<double>(time).count();
+}
+
+// Returns the q quantile of values by nearest rank, reordering them, NaN if there are none
+double quantile(std::vector<double>& values, double q)
+{
+  if (values.empty())
+    return NAN;
+  auto rank = static_cast<size_t>(std::ceil(q * static_cast<double>(values.size())));
+  auto nth  = values.begin() + static_cast<ptrdiff_t>(std::max<size_t>(rank, 1) - 1);
+  std::nth_element(values.begin(), nth, values.end());
+  return *nth;
+}
+
+// Prometheus spells not a number NaN
+void writeValue(std::FILE* file, const char* series, double value)
+{
+  if (std::isnan(value))
+    std::fprintf(file, "%s NaN\n", series);
+  else
+    std::fprintf(file, "%s %.9g\n", series, value);
+}
+
+void writeValue(std::FILE* file, const char* series, uint64_t value)
+{
+  std::fprintf(file, "%s %" PRIu64 "\n", series, value);
+}
+
+// Returns the resident and peak resident memory of the process in bytes, zero where unknown
+void residentMemory(uint64_t& resident, uint64_t& peak)
+{
+  resident = 0;
+  peak     = 0;
+#ifdef __linux__
+  if (std::FILE* statm = std::fopen("/proc/self/statm", "r"))
+  {
+    unsigned long long size_pages     = 0;
+    unsigned long long resident_pages = 0;
+    if (std::fscanf(statm, "%llu %llu", &size_pages, &resident_pages) == 2)
+      resident = resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    std::fclose(statm);
+  }
+  rusage usage {};
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    peak = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+} // namespace
+
+MetricsExporter::MetricsExporter(std::filesystem::path file,
+                                 std::chrono::milliseconds interval,
+                                 vk::PhysicalDevice physical_device,
+                                 bool memory_budget) :
+  file_(std::move(file)),
+  interval_(interval),
+  physical_device_(physical_device),
+  memory_budget_(memory_budget)
+{
+  // The collector only reads files ending in .prom, so the temporary file is never scraped
+  this->temporary_file_ = this->file_;
+  this->temporary_file_ += ".tmp";
+  this->frame_times_.reserve(queue_capacity_);
+  this->thread_ = std::thread(&MetricsExporter::process, this);
+}
+
+void MetricsExporter::recordFrame(const FrameMetrics& frame)
+{
+  if (!this->frames_.tryEmplace(frame))
+    this->dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsExporter::recordPipelineCreation(std::chrono::nanoseconds creation_time)
+{
+  this->pipeline_count_.fetch_add(1, std::memory_order_relaxed);
+  this->pipeline_creation_ns_.fetch_add(static_cast<uint64_t>(creation_time.count()),
+                                        std::memory_order_relaxed);
+}
+
+void MetricsExporter::process()
+{
+  auto next_write = std::chrono::steady_clock::now() + this->interval_;
+  while (this->running_.load(std::memory_order_relaxed))
+  {
+    std::this_thread::sleep_for(drain_interval_);
+    this->drain();
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_write)
+      continue;
+    next_write = std::max(next_write + this->interval_, now);
+
+    // Failures are reported once, not on every write while the directory is unavailable
+    bool written = this->write();
+    if (!written && !this->write_failed_)
+      LOG_WARNING("Failed to write metrics to {}", this->file_.string());
+    this->write_failed_ = !written;
+  }
+  // Write the frames measured since the last write
+  this->drain();
+  if (!this->write())
+    LOG_WARNING("Failed to write metrics to {}", this->file_.string());
+}
+
+void MetricsExporter::drain()
+{
+  FrameMetrics frame;
+  while (this->frames_.tryPop(frame))
+  {
+    this->frame_times_.push_back(seconds(frame.frame_time));
+    this->frame_count_++;
+    this->frame_time_sum_ += seconds(frame.frame_time);
+    this->totals_.frame_time += frame.frame_time;
+    this->totals_.record_time += frame.record_time;
+    this->totals_.simulation_time += frame.simulation_time;
+    this->totals_.draw_count += frame.draw_count;
+    this->totals_.pipeline_bind_count += frame.pipeline_bind_count;
+    this->totals_.sprite_count += frame.sprite_count;
+    this->totals_.skipped_draw_count += frame.skipped_draw_count;
+    this->totals_.render_target_bytes += frame.render_target_bytes;
+    this->totals_.render_allocations += frame.render_allocations;
+    this->totals_.simulation_allocations += frame.simulation_allocations;
+  }
+}
+
+bool MetricsExporter::write()
+{
+  std::FILE* file = std::fopen(this->temporary_file_.string().c_str(), "w");
+  if (!file)
+    return false;
+
+  // Percentiles cover the frames since the last write, sums and counts every frame so far
+  double frame_time_max = this->frame_times_.empty()
+                              ? NAN
+                              : *std::max_element(this->frame_times_.begin(),
+                                                  this->frame_times_.end());
+  writeHeader(file,
+              "engine_frame_time_seconds",
+              "summary",
+              "CPU time per frame, quantiles over the last export interval");
+  writeValue(file,
+             "engine_frame_time_seconds{quantile=\"0.5\"}",
+             quantile(this->frame_times_, 0.5));
+  writeValue(file,
+             "engine_frame_time_seconds{quantile=\"0.9\"}",
+             quantile(this->frame_times_, 0.9));
+  writeValue(file,
+             "engine_frame_time_seconds{quantile=\"0.99\"}",
+             quantile(this->frame_times_, 0.99));
+  writeValue(file, "engine_frame_time_seconds_sum", this->frame_time_sum_);
+  writeValue(file, "engine_frame_time_seconds_count", this->frame_count_);
+  this->frame_times_.clear();
+
+  writeHeader(file,
+              "engine_frame_time_max_seconds",
+              "gauge",
+              "Longest CPU frame time over the last export interval");
+  writeValue(file, "engine_frame_time_max_seconds", frame_time_max);
+
+  writeHeader(file,
+              "engine_record_time_seconds_total",
+              "counter",
+              "CPU time spent recording command buffers");
+  writeValue(file, "engine_record_time_seconds_total", seconds(this->totals_.record_time));
+  writeHeader(file,
+              "engine_simulation_time_seconds_total",
+              "counter",
+              "CPU time spent simulating and extracting frames");
+  writeValue(file, "engine_simulation_time_seconds_total", seconds(this->totals_.simulation_time));
+
+  writeHeader(file, "engine_draws_total", "counter", "Draw commands recorded");
+  writeValue(file, "engine_draws_total", this->totals_.draw_count);
+  writeHeader(file, "engine_pipeline_binds_total", "counter", "Pipeline binds recorded");
+  writeValue(file, "engine_pipeline_binds_total", this->totals_.pipeline_bind_count);
+  writeHeader(file, "engine_sprites_total", "counter", "Sprites drawn");
+  writeValue(file, "engine_sprites_total", this->totals_.sprite_count);
+  writeHeader(file,
+              "engine_occlusion_skipped_draws_total",
+              "counter",
+              "Draws skipped by occlusion culling");
+  writeValue(file, "engine_occlusion_skipped_draws_total", this->totals_.skipped_draw_count);
+  writeHeader(file,
+              "engine_render_target_bytes_total",
+              "counter",
+              "Estimated render target bytes written and read");
+  writeValue(file, "engine_render_target_bytes_total", this->totals_.render_target_bytes);
+
+  writeHeader(file,
+              "engine_heap_allocations_total",
+              "counter",
+              "Heap allocations made while drawing or simulating frames");
+  writeValue(file,
+             "engine_heap_allocations_total{thread=\"render\"}",
+             this->totals_.render_allocations);
+  writeValue(file,
+             "engine_heap_allocations_total{thread=\"simulation\"}",
+             this->totals_.simulation_allocations);
+  writeHeader(file,
+              "engine_allocation_violations_total",
+              "counter",
+              "Heap allocations made in allocation free scopes");
+  writeValue(file, "engine_allocation_violations_total", allocationViolations());
+  writeHeader(file,
+              "engine_frame_metrics_dropped_total",
+              "counter",
+              "Frames left out of these metrics because the exporter fell behind");
+  writeValue(file,
+             "engine_frame_metrics_dropped_total",
+             this->dropped_frames_.load(std::memory_order_relaxed));
+
+  uint64_t resident      = 0;
+  uint64_t resident_peak = 0;
+  residentMemory(resident, resident_peak);
+  writeHeader(file, "engine_resident_memory_bytes", "gauge", "Resident memory of the process");
+  writeValue(file, "engine_resident_memory_bytes", resident);
+  writeHeader(file,
+              "engine_resident_memory_peak_bytes",
+              "gauge",
+              "Peak resident memory of the process");
+  writeValue(file, "engine_resident_memory_peak_bytes", resident_peak);
+
+  // Budgets and usage include other processes' allocations and are only known with
+  // VK_EXT_memory_budget
+  using MemoryBudget = vk::PhysicalDeviceMemoryBudgetPropertiesEXT;
+  vk::PhysicalDeviceMemoryProperties memory_properties;
+  MemoryBudget memory_budget;
+  if (this->memory_budget_)
+  {
+    auto properties =
+        this->physical_device_.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2,
+                                                    MemoryBudget>();
+    memory_properties = properties.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+    memory_budget     = properties.get<MemoryBudget>();
+  } else
+  {
+    memory_properties = this->physical_device_.getMemoryProperties();
+  }
+  char series[128];
+  writeHeader(file, "engine_gpu_heap_size_bytes", "gauge", "Size of each device memory heap");
+  for (uint32_t heap = 0; heap < memory_properties.memoryHeapCount; heap++)
+  {
+    bool device_local = static_cast<bool>(memory_properties.memoryHeaps[heap].flags &
+                                          vk::MemoryHeapFlagBits::eDeviceLocal);
+    std::snprintf(series,
+                  sizeof(series),
+                  "engine_gpu_heap_size_bytes{heap=\"%u\",device_local=\"%s\"}",
+                  heap,
+                  device_local ? "true" : "false");
+    writeValue(file, series, uint64_t(memory_properties.memoryHeaps[heap].size));
+  }
+  if (this->memory_budget_)
+  {
+    writeHeader(file,
+                "engine_gpu_heap_budget_bytes",
+                "gauge",
+                "Memory of each device heap the process can use");
+    for (uint32_t heap = 0; heap < memory_properties.memoryHeapCount; heap++)
+    {
+      std::snprintf(series, sizeof(series), "engine_gpu_heap_budget_bytes{heap=\"%u\"}", heap);
+      writeValue(file, series, uint64_t(memory_budget.heapBudget[heap]));
+    }
+    writeHeader(file,
+                "engine_gpu_heap_usage_bytes",
+                "gauge",
+                "Memory of each device heap the process uses");
+    for (uint32_t heap = 0; heap < memory_properties.memoryHeapCount; heap++)
+    {
+      std::snprintf(series, sizeof(series), "engine_gpu_heap_usage_bytes{heap=\"%u\"}", heap);
+      writeValue(file, series, uint64_t(memory_budget.heapUsage[heap]));
+    }
+  }
+
+  writeHeader(file, "engine_pipelines", "gauge", "Graphics pipelines created");
+  writeValue(file, "engine_pipelines", uint64_t(this->pipeline_count_.load()));
+  writeHeader(file,
+              "engine_pipeline_creation_seconds_total",
+              "counter",
+              "CPU time spent creating pipelines, shader loading included");
+  writeValue(file,
+             "engine_pipeline_creation_seconds_total",
+             seconds(std::chrono::nanoseconds(this->pipeline_creation_ns_.load())));
+
+  bool written = std::ferror(file) == 0;
+  written      = std::fclose(file) == 0 && written;
+  if (!written)
+    return false;
+  std::error_code error;
+  std::filesystem::rename(this->temporary_file_, this->file_, error);
+  return !error;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+  this->running_ = false;
+  this->thread_.join();
+}
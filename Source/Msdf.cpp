@@ -0,0 +1,247 @@
+#include "Msdf.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Channels an edge contributes to
+constexpr uint8_t red_channel   = 1;
+constexpr uint8_t green_channel = 2;
+constexpr uint8_t blue_channel  = 4;
+constexpr uint8_t cyan          = green_channel | blue_channel;
+constexpr uint8_t magenta       = red_channel | blue_channel;
+constexpr uint8_t yellow        = red_channel | green_channel;
+constexpr uint8_t white         = red_channel | green_channel | blue_channel;
+
+// Edges meeting at more than about 8 degrees form a corner
+constexpr float corner_threshold = 0.1411f;
+
+struct Vec2
+{
+  float x;
+  float y;
+};
+
+Vec2 operator-(Vec2 a, Vec2 b)
+{
+  return { a.x - b.x, a.y - b.y };
+}
+
+float dot(Vec2 a, Vec2 b)
+{
+  return a.x * b.x + a.y * b.y;
+}
+
+float cross(Vec2 a, Vec2 b)
+{
+  return a.x * b.y - a.y * b.x;
+}
+
+Vec2 normalize(Vec2 v)
+{
+  float length = std::sqrt(dot(v, v));
+  return length > 0.0f ? Vec2 { v.x / length, v.y / length } : Vec2 { 0.0f, 0.0f };
+}
+
+// A straight piece of a flattened edge in texel space
+struct Segment
+{
+  Vec2 start;
+  Vec2 direction;
+  float inverse_length_squared;
+  uint8_t color;
+};
+
+// Closest segment to a texel for one channel, ties between segments sharing an end point go to
+// the one the texel lies most squarely in front of
+struct Closest
+{
+  float distance         = INFINITY;
+  float obliquity        = 1.0f;
+  const Segment* segment = nullptr;
+};
+
+Vec2 toTexel(const MsdfTransform& transform, OutlinePoint point)
+{
+  return { point.x * transform.scale + transform.offset_x,
+           transform.offset_y - point.y * transform.scale };
+}
+
+// Directions at the start and end of an edge, used to find corners
+Vec2 startDirection(const OutlineEdge& edge)
+{
+  if (edge.quadratic && (edge.control.x != edge.start.x || edge.control.y != edge.start.y))
+    return { edge.control.x - edge.start.x, edge.control.y - edge.start.y };
+  return { edge.end.x - edge.start.x, edge.end.y - edge.start.y };
+}
+
+Vec2 endDirection(const OutlineEdge& edge)
+{
+  if (edge.quadratic && (edge.control.x != edge.end.x || edge.control.y != edge.end.y))
+    return { edge.end.x - edge.control.x, edge.end.y - edge.control.y };
+  return { edge.end.x - edge.start.x, edge.end.y - edge.start.y };
+}
+
+bool isCorner(Vec2 a, Vec2 b)
+{
+  a = normalize(a);
+  b = normalize(b);
+  return dot(a, b) <= 0.0f || std::abs(cross(a, b)) > corner_threshold;
+}
+
+// Colours the edges of a contour so that the two edges at every corner share exactly one channel.
+// Smooth contours are white, every channel sees every edge.
+std::vector<uint8_t> colorContour(const OutlineContour& contour)
+{
+  size_t count = contour.size();
+  std::vector<size_t> corners;
+  for (size_t i = 0; i < count; i++)
+  {
+    if (isCorner(endDirection(contour[(i + count - 1) % count]), startDirection(contour[i])))
+      corners.push_back(i);
+  }
+
+  std::vector<uint8_t> colors(count, white);
+  if (corners.size() == 1)
+  {
+    // A teardrop, split the loop from its corner into three differently coloured parts
+    const uint8_t thirds[3] = { magenta, cyan, yellow };
+    for (size_t k = 0; k < count; k++)
+      colors[(corners[0] + k) % count] = count < 3 ? thirds[k] : thirds[k * 3 / count];
+  } else if (corners.size() > 1)
+  {
+    // Alternate between cyan and magenta, the last run is yellow so it differs from the first
+    for (size_t run = 0; run < corners.size(); run++)
+    {
+      uint8_t color = run + 1 == corners.size() ? yellow : (run % 2 ? magenta : cyan);
+      size_t end    = corners[(run + 1) % corners.size()];
+      for (size_t i = corners[run]; i != end; i = (i + 1) % count)
+        colors[i] = color;
+    }
+  }
+  return colors;
+}
+
+void addSegment(std::vector<Segment>& segments, Vec2 start, Vec2 end, uint8_t color)
+{
+  Vec2 direction       = end - start;
+  float length_squared = dot(direction, direction);
+  if (length_squared > 0.0f)
+    segments.push_back({ start, direction, 1.0f / length_squared, color });
+}
+
+uint32_t encode(float distance, float range)
+{
+  float value = std::clamp(0.5f + distance / range, 0.0f, 1.0f);
+  return static_cast<uint32_t>(value * 255.0f + 0.5f);
+}
+} // namespace
+
+std::vector<uint32_t> generateMsdf(const std::vector<OutlineContour>& contours,
+                                   const MsdfTransform& transform,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   float range)
+{
+  // Colour the edges, then flatten curves into segments of about two texels in texel space
+  std::vector<Segment> segments;
+  for (const auto& contour : contours)
+  {
+    std::vector<uint8_t> colors = colorContour(contour);
+    for (size_t i = 0; i < contour.size(); i++)
+    {
+      const OutlineEdge& edge = contour[i];
+      Vec2 start              = toTexel(transform, edge.start);
+      Vec2 end                = toTexel(transform, edge.end);
+      if (!edge.quadratic)
+      {
+        addSegment(segments, start, end, colors[i]);
+        continue;
+      }
+      Vec2 control  = toTexel(transform, edge.control);
+      float length  = std::sqrt(dot(control - start, control - start)) +
+                      std::sqrt(dot(end - control, end - control));
+      int steps     = std::clamp(static_cast<int>(std::ceil(length / 2.0f)), 2, 16);
+      Vec2 previous = start;
+      for (int step = 1; step <= steps; step++)
+      {
+        float t = static_cast<float>(step) / steps;
+        float u = 1.0f - t;
+        Vec2 point = { u * u * start.x + 2.0f * u * t * control.x + t * t * end.x,
+                       u * u * start.y + 2.0f * u * t * control.y + t * t * end.y };
+        addSegment(segments, previous, point, colors[i]);
+        previous = point;
+      }
+    }
+  }
+
+  std::vector<uint32_t> texels(size_t(width) * height);
+  for (uint32_t y = 0; y < height; y++)
+  {
+    for (uint32_t x = 0; x < width; x++)
+    {
+      Vec2 p = { x + 0.5f, y + 0.5f };
+
+      // Closest segment per channel and overall, and the winding number for the true sign
+      Closest closest[3];
+      float true_distance = INFINITY;
+      int winding         = 0;
+      for (const Segment& segment : segments)
+      {
+        Vec2 to_point = p - segment.start;
+        float t       = dot(to_point, segment.direction) * segment.inverse_length_squared;
+        float clamped = std::clamp(t, 0.0f, 1.0f);
+        Vec2 offset   = { to_point.x - segment.direction.x * clamped,
+                          to_point.y - segment.direction.y * clamped };
+        float distance  = std::sqrt(dot(offset, offset));
+        float obliquity = 0.0f;
+        if (t != clamped)
+          obliquity = std::abs(dot(normalize(segment.direction), normalize(offset)));
+        true_distance = std::min(true_distance, distance);
+
+        for (int channel = 0; channel < 3; channel++)
+        {
+          Closest& best = closest[channel];
+          if (!(segment.color & (1 << channel)))
+            continue;
+          if (distance < best.distance - 1e-4f ||
+              (distance <= best.distance + 1e-4f && obliquity < best.obliquity))
+            best = { distance, obliquity, &segment };
+        }
+
+        // Crossings of the horizontal ray to the right of the texel
+        Vec2 end = { segment.start.x + segment.direction.x, segment.start.y + segment.direction.y };
+        if (segment.start.y <= p.y && end.y > p.y && cross(segment.direction, to_point) > 0.0f)
+          winding++;
+        else if (end.y <= p.y && segment.start.y > p.y && cross(segment.direction, to_point) < 0.0f)
+          winding--;
+      }
+      bool inside       = winding != 0;
+      float true_signed = inside ? true_distance : -true_distance;
+
+      // Each channel stores the signed distance to the line through its closest segment, which
+      // extends edges past corners. Outlines are filled on the left of their direction in texels.
+      float channels[3];
+      for (int channel = 0; channel < 3; channel++)
+      {
+        const Segment* segment = closest[channel].segment;
+        channels[channel] =
+            segment ? cross(normalize(segment->direction), p - segment->start) : true_signed;
+      }
+
+      // Where the channels disagree with the outline about inside and outside, for example where
+      // two corners are close together, fall back to the true distance
+      float median = std::max(std::min(channels[0], channels[1]),
+                              std::min(std::max(channels[0], channels[1]), channels[2]));
+      if ((median > 0.0f) != inside)
+        channels[0] = channels[1] = channels[2] = true_signed;
+
+      texels[size_t(y) * width + x] = encode(channels[0], range) |
+                                      encode(channels[1], range) << 8 |
+                                      encode(channels[2], range) << 16 |
+                                      encode(true_signed, range) << 24;
+    }
+  }
+  return texels;
+}
@@ -0,0 +1,181 @@
+#include "OcclusionCuller.hpp"
+#include "Result.hpp"
+
+#include <algorithm>
+
+OcclusionCuller::OcclusionCuller(vk::Device device,
+                                 uint32_t frame_count,
+                                 uint32_t max_queries,
+                                 vk::Buffer predicates) :
+  device_(device),
+  max_queries_(max_queries),
+  predicates_(predicates),
+  query_counts_(frame_count),
+  query_slots_(size_t(frame_count) * max_queries),
+  query_results_(max_queries),
+  results_(max_queries, 1u)
+{
+  vk::QueryPoolCreateInfo create_info;
+  create_info.setQueryType(vk::QueryType::eOcclusion).setQueryCount(frame_count * max_queries);
+  this->query_pool_ = VULKAN_CALL(this->device_.createQueryPool(create_info)).value();
+}
+
+bool OcclusionCuller::conditionalRendering() const
+{
+  return static_cast<bool>(this->predicates_);
+}
+
+void OcclusionCuller::collect(uint32_t frame)
+{
+  uint32_t count             = this->query_counts_[frame];
+  this->query_counts_[frame] = 0;
+  if (count == 0)
+    return;
+
+  // The fence has signalled, so the results are available and reading them does not wait
+  vk::Result result = this->device_.getQueryPoolResults(this->query_pool_,
+                                                        frame * this->max_queries_,
+                                                        count,
+                                                        count * sizeof(uint32_t),
+                                                        this->query_results_.data(),
+                                                        sizeof(uint32_t),
+                                                        vk::QueryResultFlags {});
+  if (result != vk::Result::eSuccess)
+    return;
+
+  // Results go under the slots of their draws, slots not measured in this frame are visible
+  const uint32_t* slots = this->query_slots_.data() + frame * this->max_queries_;
+  std::fill(this->results_.begin(), this->results_.end(), 1u);
+  this->skipped_draws_ = 0;
+  for (uint32_t query = 0; query < count; query++)
+  {
+    this->results_[slots[query]] = this->query_results_[query];
+    this->skipped_draws_ += this->query_results_[query] == 0;
+  }
+}
+
+uint32_t OcclusionCuller::skippedDraws() const
+{
+  return this->skipped_draws_;
+}
+
+void OcclusionCuller::beginFrame(vk::CommandBuffer command_buffer, uint32_t frame)
+{
+  this->query_counts_[frame] = 0;
+  command_buffer.resetQueryPool(this->query_pool_, frame * this->max_queries_, this->max_queries_);
+  if (!this->predicates_)
+    return;
+
+  // The previous frame's copy into the predicates happens before they are read
+  vk::BufferMemoryBarrier barrier;
+  barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eConditionalRenderingReadEXT)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setBuffer(this->predicates_)
+      .setOffset(0)
+      .setSize(VK_WHOLE_SIZE);
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                 vk::PipelineStageFlagBits::eConditionalRenderingEXT,
+                                 vk::DependencyFlags {},
+                                 nullptr,
+                                 barrier,
+                                 nullptr);
+}
+
+uint32_t OcclusionCuller::beginQuery(vk::CommandBuffer command_buffer,
+                                     uint32_t frame,
+                                     uint32_t slot)
+{
+  uint32_t& count = this->query_counts_[frame];
+  if (count == this->max_queries_ || slot >= this->max_queries_)
+    return no_query_;
+  uint32_t query                                         = count++;
+  this->query_slots_[frame * this->max_queries_ + query] = slot;
+  command_buffer.beginQuery(this->query_pool_, frame * this->max_queries_ + query, {});
+  return query;
+}
+
+void OcclusionCuller::endQuery(vk::CommandBuffer command_buffer, uint32_t frame, uint32_t query)
+{
+  command_buffer.endQuery(this->query_pool_, frame * this->max_queries_ + query);
+}
+
+bool OcclusionCuller::visible(uint32_t slot) const
+{
+  return slot >= this->max_queries_ || this->results_[slot] != 0;
+}
+
+void OcclusionCuller::beginConditional(vk::CommandBuffer command_buffer,
+                                       uint32_t slot,
+                                       bool inverted)
+{
+  if (!this->predicates_)
+    return;
+  vk::ConditionalRenderingBeginInfoEXT begin_info;
+  begin_info.setBuffer(this->predicates_).setOffset(slot * sizeof(uint32_t));
+  if (inverted)
+    begin_info.setFlags(vk::ConditionalRenderingFlagBitsEXT::eInverted);
+  command_buffer.beginConditionalRenderingEXT(begin_info);
+}
+
+void OcclusionCuller::endConditional(vk::CommandBuffer command_buffer)
+{
+  if (this->predicates_)
+    command_buffer.endConditionalRenderingEXT();
+}
+
+void OcclusionCuller::endFrame(vk::CommandBuffer command_buffer, uint32_t frame)
+{
+  uint32_t count = this->query_counts_[frame];
+  if (!this->predicates_ || count == 0)
+    return;
+
+  // The predicates are read by this frame's draws before they are overwritten. Copying waits for
+  // the queries on the GPU, the CPU never does.
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eConditionalRenderingEXT,
+                                 vk::PipelineStageFlagBits::eTransfer,
+                                 vk::DependencyFlags {},
+                                 nullptr,
+                                 nullptr,
+                                 nullptr);
+  // Slots not measured in this frame become visible, then each run of queries whose slots follow
+  // one another is copied at once, which is a single copy when draws are recorded in slot order
+  command_buffer.fillBuffer(this->predicates_, 0, VK_WHOLE_SIZE, 1u);
+  vk::BufferMemoryBarrier barrier;
+  barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+      .setBuffer(this->predicates_)
+      .setOffset(0)
+      .setSize(VK_WHOLE_SIZE);
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                 vk::PipelineStageFlagBits::eTransfer,
+                                 vk::DependencyFlags {},
+                                 nullptr,
+                                 barrier,
+                                 nullptr);
+
+  const uint32_t* slots = this->query_slots_.data() + frame * this->max_queries_;
+  uint32_t first        = 0;
+  while (first < count)
+  {
+    uint32_t last = first + 1;
+    while (last < count && slots[last] == slots[last - 1] + 1)
+      last++;
+    command_buffer.copyQueryPoolResults(this->query_pool_,
+                                        frame * this->max_queries_ + first,
+                                        last - first,
+                                        this->predicates_,
+                                        slots[first] * sizeof(uint32_t),
+                                        sizeof(uint32_t),
+                                        vk::QueryResultFlagBits::eWait);
+    first = last;
+  }
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+  this->device_.destroyQueryPool(this->query_pool_);
+}
@@ -0,0 +1,145 @@
+#include "Presenter.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+Presenter::Presenter(vk::Device device, vk::Queue queue) : device_(device), queue_(queue)
+{
+  this->thread_ = std::thread(&Presenter::process, this);
+}
+
+Result<void> Presenter::presentNow(vk::Queue queue, const Request& request)
+{
+  vk::PresentInfoKHR present_info;
+  present_info.setWaitSemaphores(request.wait_semaphore)
+      .setSwapchains(request.swapchain)
+      .setImageIndices(request.image_index);
+  vk::SwapchainPresentFenceInfoEXT present_fence_info;
+  vk::SwapchainPresentModeInfoEXT present_mode_info;
+  if (request.fence)
+  {
+    present_mode_info.setPresentModes(request.present_mode);
+    present_fence_info.setFences(request.fence).setPNext(&present_mode_info);
+    present_info.setPNext(&present_fence_info);
+  }
+  return VULKAN_CALL(queue.presentKHR(present_info));
+}
+
+uint64_t Presenter::present(const Request& request)
+{
+  // Never fails once the presenter is less than capacity_ requests behind
+  uint64_t target    = this->queued_ - std::min<uint64_t>(capacity_ - 1, this->queued_);
+  uint64_t processed = this->processed_.load(std::memory_order_acquire);
+  while (processed < target)
+  {
+    this->processed_.wait(processed, std::memory_order_acquire);
+    processed = this->processed_.load(std::memory_order_acquire);
+  }
+  static_cast<void>(this->requests_.tryPush(request));
+  this->request_count_.release();
+  return this->queued_++;
+}
+
+void Presenter::wait(uint64_t pending)
+{
+  uint64_t target    = this->queued_ - std::min(pending, this->queued_);
+  uint64_t presented = this->presented_.load(std::memory_order_acquire);
+  while (presented < target)
+  {
+    this->presented_.wait(presented, std::memory_order_acquire);
+    presented = this->presented_.load(std::memory_order_acquire);
+  }
+}
+
+void Presenter::drain()
+{
+  uint64_t processed = this->processed_.load(std::memory_order_acquire);
+  while (processed < this->queued_)
+  {
+    this->processed_.wait(processed, std::memory_order_acquire);
+    processed = this->processed_.load(std::memory_order_acquire);
+  }
+}
+
+Result<uint32_t> Presenter::takeAcquired(uint64_t request)
+{
+  uint64_t processed = this->processed_.load(std::memory_order_acquire);
+  while (processed <= request)
+  {
+    this->processed_.wait(processed, std::memory_order_acquire);
+    processed = this->processed_.load(std::memory_order_acquire);
+  }
+  const Acquired& acquired = this->acquired_[request % capacity_];
+  if (static_cast<int32_t>(acquired.result) < 0)
+    return acquired.result;
+  return Result<uint32_t>(acquired.result, acquired.image_index);
+}
+
+vk::Result Presenter::takeResult()
+{
+  return this->result_.exchange(vk::Result::eSuccess, std::memory_order_acq_rel);
+}
+
+Presenter::Latency Presenter::takeLatency()
+{
+  Latency latency;
+  latency.total = this->latency_total_.exchange(0, std::memory_order_relaxed);
+  latency.count = this->latency_count_.exchange(0, std::memory_order_relaxed);
+  return latency;
+}
+
+void Presenter::process()
+{
+  Profiler::instance().setThreadName("present");
+  while (true)
+  {
+    this->request_count_.acquire();
+    Request request;
+    if (!this->requests_.tryPop(request))
+      return;
+
+    int64_t present_start = Profiler::now();
+    Result<void> result   = presentNow(this->queue_, request);
+    int64_t present_end   = Profiler::now();
+    Profiler::instance().record("present", present_start, present_end);
+
+    // The first result that is not a plain success is kept until the render thread takes it
+    vk::Result success = vk::Result::eSuccess;
+    if (result.code() != vk::Result::eSuccess)
+      this->result_.compare_exchange_strong(success, result.code(), std::memory_order_release);
+    this->latency_total_.fetch_add(present_end - request.frame_start, std::memory_order_relaxed);
+    this->latency_count_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t number = this->presented_.fetch_add(1, std::memory_order_release);
+    this->presented_.notify_one();
+
+    // The acquire follows this present on the same thread, so the swapchain is never used from two
+    // threads at once. The render thread waits for it instead of acquiring itself.
+    Acquired& acquired = this->acquired_[number % capacity_];
+    acquired           = { vk::Result::eNotReady, 0 };
+    if (request.acquire_semaphore)
+    {
+      int64_t acquire_start = Profiler::now();
+      Result<void> fence    = VULKAN_CALL(
+          this->device_.waitForFences(request.acquire_fence, VK_TRUE, UINT64_MAX));
+      acquired.result = fence.code();
+      if (fence)
+      {
+        Result<uint32_t> image = VULKAN_CALL(this->device_.acquireNextImageKHR(
+            request.swapchain, UINT64_MAX, request.acquire_semaphore));
+        acquired.result = image.code();
+        if (image)
+          acquired.image_index = image.value();
+      }
+      Profiler::instance().record("acquireNextImage", acquire_start, Profiler::now());
+    }
+    this->processed_.fetch_add(1, std::memory_order_release);
+    this->processed_.notify_one();
+  }
+}
+
+Presenter::~Presenter()
+{
+  // Every queued request was counted, the extra count finds the queue empty and stops the thread
+  this->request_count_.release();
+  this->thread_.join();
+}
@@ -0,0 +1,161 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+// Writes a zone or thread name as a JSON string
+void writeName(std::FILE* file, const char* name)
+{
+  std::fputc('"', file);
+  for (const char* c = name; *c; c++)
+  {
+    if (*c == '"' || *c == '\\')
+      std::fputc('\\', file);
+    std::fputc(*c, file);
+  }
+  std::fputc('"', file);
+}
+} // namespace
+
+void Profiler::Ring::push(const char* zone_name, int64_t begin, int64_t end)
+{
+  // Announce the slot before overwriting it, so that readers copying it can tell it changed
+  uint64_t index = this->written.load(std::memory_order_relaxed);
+  this->started.store(index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  Slot& slot = this->slots[index % ring_capacity_];
+  slot.name.store(zone_name, std::memory_order_relaxed);
+  slot.begin.store(begin, std::memory_order_relaxed);
+  slot.end.store(end, std::memory_order_relaxed);
+  this->written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::Ring::copy(int64_t first, int64_t last, std::vector<Zone>& zones) const
+{
+  uint64_t written = this->written.load(std::memory_order_acquire);
+  uint64_t oldest  = written > ring_capacity_ ? written - ring_capacity_ : 0;
+  size_t copied    = zones.size();
+  for (uint64_t index = oldest; index < written; index++)
+  {
+    const Slot& slot = this->slots[index % ring_capacity_];
+    zones.push_back({ slot.name.load(std::memory_order_relaxed),
+                      slot.begin.load(std::memory_order_relaxed),
+                      slot.end.load(std::memory_order_relaxed) });
+  }
+
+  // Slots the writer started overwriting while they were copied are dropped
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t started    = this->started.load(std::memory_order_relaxed);
+  uint64_t valid_from = started > ring_capacity_ ? started - ring_capacity_ : 0;
+  if (valid_from > oldest)
+  {
+    auto overwritten = static_cast<ptrdiff_t>(std::min(valid_from, written) - oldest);
+    zones.erase(zones.begin() + static_cast<ptrdiff_t>(copied),
+                zones.begin() + static_cast<ptrdiff_t>(copied) + overwritten);
+  }
+  zones.erase(std::remove_if(zones.begin() + static_cast<ptrdiff_t>(copied),
+                             zones.end(),
+                             [&](const Zone& zone) { return zone.end < first || zone.end > last; }),
+              zones.end());
+}
+
+Profiler::Profiler()
+{
+  this->gpu_ring_.index = 0;
+  this->gpu_ring_.name  = "GPU";
+}
+
+Profiler& Profiler::instance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Ring& Profiler::threadRing()
+{
+  thread_local Ring* thread_ring = nullptr;
+  if (thread_ring)
+    return *thread_ring;
+
+  // Register a ring for this thread, only the first zone of each thread takes the lock. Index 0
+  // is the GPU's.
+  std::lock_guard lock(this->rings_mutex_);
+  auto& ring  = this->rings_.emplace_back(std::make_unique<Ring>());
+  ring->index = static_cast<uint32_t>(this->rings_.size());
+  thread_ring = ring.get();
+  return *thread_ring;
+}
+
+void Profiler::setThreadName(const char* name)
+{
+  this->threadRing().name.store(name, std::memory_order_relaxed);
+}
+
+void Profiler::record(const char* name, int64_t begin, int64_t end)
+{
+  this->threadRing().push(name, begin, end);
+}
+
+void Profiler::recordGpu(const char* name, int64_t begin, int64_t end)
+{
+  this->gpu_ring_.push(name, begin, end);
+}
+
+void Profiler::writeTrace(const std::filesystem::path& file, int64_t first, int64_t last) const
+{
+  std::FILE* trace = std::fopen(file.string().c_str(), "w");
+  if (!trace)
+    throw std::runtime_error("Failed to open trace file");
+
+  // Times are written in microseconds from the start of the window
+  std::vector<Zone> zones;
+  bool first_event = true;
+  auto writeRing   = [&](const Ring& ring)
+  {
+    zones.clear();
+    ring.copy(first, last, zones);
+    std::fprintf(trace,
+                 "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                 "\"args\":{\"name\":",
+                 first_event ? "" : ",",
+                 ring.index);
+    first_event = false;
+    if (const char* name = ring.name.load(std::memory_order_relaxed))
+      writeName(trace, name);
+    else
+      std::fprintf(trace, "\"thread %u\"", ring.index);
+    std::fputs("}}", trace);
+    for (const Zone& zone : zones)
+    {
+      std::fputs(",\n{\"name\":", trace);
+      writeName(trace, zone.name);
+      std::fprintf(trace,
+                   ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                   ring.index,
+                   static_cast<double>(zone.begin - first) / 1000.0,
+                   static_cast<double>(zone.end - zone.begin) / 1000.0);
+    }
+  };
+
+  // Rings are never freed, the lock is only held to list them so threads can register meanwhile
+  std::vector<const Ring*> rings { &this->gpu_ring_ };
+  {
+    std::lock_guard lock(this->rings_mutex_);
+    for (const auto& ring : this->rings_)
+      rings.push_back(ring.get());
+  }
+
+  std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", trace);
+  for (const Ring* ring : rings)
+    writeRing(*ring);
+  std::fputs("\n]}\n", trace);
+
+  bool written = std::ferror(trace) == 0;
+  written      = std::fclose(trace) == 0 && written;
+  if (!written)
+    throw std::runtime_error("Failed to write trace file");
+}
@@ -0,0 +1,46 @@
+#include "RenderSnapshot.hpp"
+
+RenderSnapshotExchange::RenderSnapshotExchange()
+{
+  for (auto& snapshot : this->snapshots_)
+    static_cast<void>(this->free_.tryPush(&snapshot));
+}
+
+RenderSnapshot* RenderSnapshotExchange::acquireWrite()
+{
+  this->free_count_.acquire();
+  RenderSnapshot* snapshot = nullptr;
+  if (this->closed_.load(std::memory_order_acquire) || !this->free_.tryPop(snapshot))
+    return nullptr;
+  return snapshot;
+}
+
+void RenderSnapshotExchange::publish(RenderSnapshot* snapshot)
+{
+  // Never fails, there are only as many snapshots as the queue has room for
+  static_cast<void>(this->ready_.tryPush(snapshot));
+  this->ready_count_.release();
+}
+
+RenderSnapshot* RenderSnapshotExchange::acquireRead()
+{
+  this->ready_count_.acquire();
+  RenderSnapshot* snapshot = nullptr;
+  if (this->closed_.load(std::memory_order_acquire) || !this->ready_.tryPop(snapshot))
+    return nullptr;
+  return snapshot;
+}
+
+void RenderSnapshotExchange::release(RenderSnapshot* snapshot)
+{
+  static_cast<void>(this->free_.tryPush(snapshot));
+  this->free_count_.release();
+}
+
+void RenderSnapshotExchange::close()
+{
+  if (this->closed_.exchange(true, std::memory_order_acq_rel))
+    return;
+  this->free_count_.release();
+  this->ready_count_.release();
+}
@@ -0,0 +1,56 @@
+#include "FrameReplayer.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+// Usage: Vulkan-Replay [--device <index>] [--repeat <n>] [--validation] [--no-push-descriptors]
+//        <capture file>
+int main(int argc, char* argv[])
+{
+  ReplayOptions options;
+  for (int i = 1; i < argc; i++)
+  {
+    bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--device") == 0 && has_value)
+      options.device_index = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (std::strcmp(argv[i], "--repeat") == 0 && has_value)
+      options.repeat_count = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+    else if (std::strcmp(argv[i], "--validation") == 0)
+      options.validation = true;
+    else if (std::strcmp(argv[i], "--no-push-descriptors") == 0)
+      options.push_descriptors = false;
+    else
+      options.capture_file = argv[i];
+  }
+
+  if (options.capture_file.empty())
+  {
+    LOG_ERROR("No capture file given");
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    FrameReplayer replayer(options);
+    std::vector<ReplayFrameStats> stats = replayer.replay();
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+      LOG_INFO("Frame {}: recorded in {}ns on average, {}ns at best, against {}ns in the engine. "
+               "GPU time: {}ns, buffer uploads: {}ns",
+               i,
+               stats[i].record_time.count(),
+               stats[i].min_record_time.count(),
+               stats[i].captured_record_time.count(),
+               stats[i].gpu_time.count(),
+               stats[i].upload_time.count());
+    }
+  } catch (const std::exception& error)
+  {
+    LOG_ERROR("Replay failed: {}", error.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
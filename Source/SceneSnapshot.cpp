@@ -0,0 +1,75 @@
+#include "SceneSnapshot.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr char scene_magic[8] = "VKSCENE";
+} // namespace
+
+void writeSceneSnapshot(const fs::path& file,
+                        uint64_t simulation_frame,
+                        const std::vector<StringId>& names,
+                        const std::vector<SceneEntity>& entities,
+                        const std::vector<SceneSprite>& sprites)
+{
+  BlobBuilder blob;
+  size_t header = blob.allocate<SceneHeader>();
+  size_t root   = blob.allocate<SceneRoot>();
+  blob.link<SceneRoot>(header + offsetof(SceneHeader, root), root);
+  blob.at<SceneRoot>(root)->simulation_frame = simulation_frame;
+  blob.fill(root + offsetof(SceneRoot, names), names.data(), names.size());
+  blob.fill(root + offsetof(SceneRoot, entities), entities.data(), entities.size());
+  blob.fill(root + offsetof(SceneRoot, sprites), sprites.data(), sprites.size());
+
+  SceneHeader* scene_header = blob.at<SceneHeader>(header);
+  std::memcpy(scene_header->magic, scene_magic, sizeof(scene_magic));
+  scene_header->version    = SceneHeader::current_version_;
+  scene_header->byte_order = SceneHeader::byte_order_mark_;
+  scene_header->size       = blob.data().size();
+
+  fs::path temporary = file;
+  temporary += ".tmp";
+  {
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(blob.data().data()),
+                 static_cast<std::streamsize>(blob.data().size()));
+    if (!stream)
+      throw std::runtime_error("Failed to write scene " + temporary.string());
+  }
+  fs::rename(temporary, file);
+}
+
+SceneSnapshot::SceneSnapshot(const fs::path& file) : file_(file)
+{
+  const std::byte* begin = this->file_.data();
+  const std::byte* end   = begin + this->file_.size();
+  auto header            = reinterpret_cast<const SceneHeader*>(begin);
+  if (this->file_.size() < sizeof(SceneHeader) ||
+      std::memcmp(header->magic, scene_magic, sizeof(scene_magic)) != 0)
+    throw std::runtime_error(file.string() + " is not a scene file");
+  if (header->byte_order != SceneHeader::byte_order_mark_)
+    throw std::runtime_error(file.string() + " was written with the other byte order");
+  if (header->version != SceneHeader::current_version_)
+    throw std::runtime_error(file.string() + " has unsupported scene version " +
+                             std::to_string(header->version));
+  if (header->size != this->file_.size())
+    throw std::runtime_error(file.string() + " is truncated");
+
+  // Bounds checks are per array, so they cost nothing however many records there are
+  if (!header->root.within(begin, end))
+    throw std::runtime_error(file.string() + " has an invalid root");
+  this->root_ = header->root.get();
+  if (!this->root_->names.within(begin, end) || !this->root_->entities.within(begin, end) ||
+      !this->root_->sprites.within(begin, end))
+    throw std::runtime_error(file.string() + " has an array outside the file");
+}
+
+const SceneRoot& SceneSnapshot::root() const
+{
+  return *this->root_;
+}
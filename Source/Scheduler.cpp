@@ -0,0 +1,183 @@
+#include "Scheduler.hpp"
+
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+// Hands a coroutine its own handle without suspending it
+struct CurrentHandleAwaitable
+{
+  std::coroutine_handle<>* handle;
+
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  bool await_suspend(std::coroutine_handle<> awaiting) const noexcept
+  {
+    *this->handle = awaiting;
+    return false;
+  }
+
+  void await_resume() const noexcept { }
+};
+
+// Reads an entire file into memory
+std::vector<char> readWholeFile(const std::string& file_name)
+{
+  std::ifstream file(file_name, std::ios::ate | std::ios::binary);
+  if (!file.is_open())
+    throw std::runtime_error("Failed to open file " + file_name);
+  auto file_size = file.tellg();
+  std::vector<char> file_data(file_size);
+  file.seekg(0);
+  file.read(file_data.data(), file_size);
+  return file_data;
+}
+} // namespace
+
+Scheduler::Scheduler(uint32_t worker_count)
+{
+  for (uint32_t i = 0; i < worker_count; i++)
+    this->workers_.emplace_back(&Scheduler::workerLoop, this);
+  this->io_thread_ = std::thread(&Scheduler::ioLoop, this);
+}
+
+void Scheduler::enqueueWorker(std::coroutine_handle<> handle)
+{
+  // The queue only fills up under extreme load, wait for the workers to drain it
+  while (!this->worker_queue_.tryPush(handle))
+    std::this_thread::yield();
+  this->worker_signal_.release();
+}
+
+task_detail::DetachedTask Scheduler::runSpawned(Scheduler& scheduler, Task<void> task)
+{
+  std::coroutine_handle<> self;
+  co_await CurrentHandleAwaitable { &self };
+  {
+    std::lock_guard<std::mutex> lock(scheduler.spawned_mutex_);
+    scheduler.spawned_.insert(self.address());
+  }
+
+  try
+  {
+    co_await task;
+  } catch (const std::exception& error)
+  {
+    LOG_ERROR("Spawned task failed: {}", error.what());
+  }
+
+  std::lock_guard<std::mutex> lock(scheduler.spawned_mutex_);
+  scheduler.spawned_.erase(self.address());
+}
+
+void Scheduler::workerLoop()
+{
+  while (true)
+  {
+    this->worker_signal_.acquire();
+    if (!this->running_.load(std::memory_order_acquire))
+      return;
+
+    // Every release follows a push, but the pop fails while an element claimed before it is still
+    // being written. Keep trying, giving up the signal would strand the coroutine.
+    std::coroutine_handle<> handle;
+    while (!this->worker_queue_.tryPop(handle))
+      std::this_thread::yield();
+    handle.resume();
+  }
+}
+
+void Scheduler::ioLoop()
+{
+  while (true)
+  {
+    this->io_signal_.acquire();
+    if (!this->running_.load(std::memory_order_acquire))
+      return;
+
+    // A release can be seen before the push is fully linked, keep trying until it is
+    FileReadAwaitable* request;
+    while (!(request = this->io_queue_.pop()))
+      std::this_thread::yield();
+
+    try
+    {
+      request->data = readWholeFile(request->file_name);
+    } catch (...)
+    {
+      request->exception = std::current_exception();
+    }
+    // Continue the reader on a worker so the I/O thread is free for the next read
+    this->enqueueWorker(request->handle);
+  }
+}
+
+void Scheduler::spawn(Task<void> task)
+{
+  runSpawned(*this, std::move(task));
+}
+
+void Scheduler::pumpMainThread()
+{
+  PROFILE_ZONE("pumpMainThread");
+  // Collect newly queued coroutines
+  while (MainThreadAwaitable* awaitable = this->main_queue_.pop())
+    this->main_pending_.push_back(awaitable);
+
+  // Resume everything that is ready, coroutines resumed here may queue more work for later
+  std::vector<MainThreadAwaitable*> pending;
+  pending.swap(this->main_pending_);
+  for (MainThreadAwaitable* awaitable : pending)
+  {
+    if (awaitable->ready && !awaitable->ready(*awaitable))
+    {
+      this->main_pending_.push_back(awaitable);
+      continue;
+    }
+    awaitable->handle.resume();
+  }
+}
+
+size_t Scheduler::workerCount() const
+{
+  return this->workers_.size();
+}
+
+std::vector<std::thread::native_handle_type> Scheduler::workerHandles()
+{
+  std::vector<std::thread::native_handle_type> handles;
+  for (auto& worker : this->workers_)
+    handles.push_back(worker.native_handle());
+  return handles;
+}
+
+std::thread::native_handle_type Scheduler::ioThreadHandle()
+{
+  return this->io_thread_.native_handle();
+}
+
+Scheduler::~Scheduler()
+{
+  this->running_.store(false, std::memory_order_release);
+  this->worker_signal_.release(static_cast<std::ptrdiff_t>(this->workers_.size()));
+  this->io_signal_.release();
+  for (auto& worker : this->workers_)
+    worker.join();
+  this->io_thread_.join();
+
+  // The queues point into the frames of coroutines that are still waiting, empty them first
+  std::coroutine_handle<> handle;
+  while (this->worker_queue_.tryPop(handle)) { }
+  while (this->io_queue_.pop()) { }
+  while (this->main_queue_.pop()) { }
+  this->main_pending_.clear();
+  for (void* spawned : this->spawned_)
+    std::coroutine_handle<>::from_address(spawned).destroy();
+}
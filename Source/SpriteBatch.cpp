@@ -0,0 +1,153 @@
+#include "SpriteBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+SpriteAtlas::SpriteAtlas(uint32_t page_size) : page_size_(page_size) { }
+
+void SpriteAtlas::blit(Page& page,
+                       const AtlasRect& rect,
+                       uint32_t width,
+                       uint32_t height,
+                       const uint32_t* texels)
+{
+  // Texels in the padding repeat the nearest edge texel of the image
+  for (uint32_t y = 0; y < rect.height; y++)
+  {
+    uint32_t source_y = std::min(y - std::min(y, padding_), height - 1);
+    uint32_t* row     = page.texels.data() + size_t(rect.y + y) * this->page_size_ + rect.x;
+    for (uint32_t x = 0; x < rect.width; x++)
+    {
+      uint32_t source_x = std::min(x - std::min(x, padding_), width - 1);
+      row[x]            = texels[size_t(source_y) * width + source_x];
+    }
+  }
+}
+
+SpriteHandle SpriteAtlas::add(uint32_t width, uint32_t height, const uint32_t* texels)
+{
+  if (width == 0 || height == 0)
+    throw std::invalid_argument("Sprite images must not be empty");
+  uint32_t padded_width  = width + 2 * padding_;
+  uint32_t padded_height = height + 2 * padding_;
+  if (padded_width > this->page_size_ || padded_height > this->page_size_)
+    throw std::length_error("Sprite image is larger than an atlas page");
+
+  // First fit over the open pages, a fresh page always has room
+  std::optional<AtlasRect> rect;
+  uint32_t page_index = 0;
+  for (; page_index < this->pages_.size() && !rect; page_index++)
+    rect = this->pages_[page_index].packer.pack(padded_width, padded_height);
+  if (rect)
+  {
+    page_index--;
+  } else
+  {
+    this->pages_.push_back({ SkylinePacker(this->page_size_, this->page_size_),
+                             std::vector<uint32_t>(size_t(this->page_size_) * this->page_size_) });
+    rect = this->pages_.back().packer.pack(padded_width, padded_height);
+  }
+
+  Page& page = this->pages_[page_index];
+  this->blit(page, *rect, width, height, texels);
+
+  float texel_size = 1.0f / static_cast<float>(this->page_size_);
+  Sprite sprite;
+  sprite.page      = page_index;
+  sprite.uv_min[0] = static_cast<float>(rect->x + padding_) * texel_size;
+  sprite.uv_min[1] = static_cast<float>(rect->y + padding_) * texel_size;
+  sprite.uv_max[0] = static_cast<float>(rect->x + padding_ + width) * texel_size;
+  sprite.uv_max[1] = static_cast<float>(rect->y + padding_ + height) * texel_size;
+  sprite.width     = width;
+  sprite.height    = height;
+  return this->sprites_.insert(sprite);
+}
+
+const Sprite* SpriteAtlas::get(SpriteHandle handle) const
+{
+  return this->sprites_.get(handle);
+}
+
+uint32_t SpriteAtlas::pageSize() const
+{
+  return this->page_size_;
+}
+
+size_t SpriteAtlas::pageCount() const
+{
+  return this->pages_.size();
+}
+
+const std::vector<uint32_t>& SpriteAtlas::pageTexels(size_t page) const
+{
+  return this->pages_.at(page).texels;
+}
+
+size_t buildSpriteBatches(const SpriteAtlas& atlas,
+                          const std::vector<SpriteInstance>& instances,
+                          SpriteVertex* vertices,
+                          size_t max_quads,
+                          std::vector<SpriteBatch>& batches)
+{
+  // Counting sort by page, the first pass counts the quads of every page
+  batches.assign(atlas.pageCount(), {});
+  size_t quad_count = 0;
+  for (const auto& instance : instances)
+  {
+    const Sprite* sprite = atlas.get(instance.sprite);
+    if (!sprite || quad_count == max_quads)
+      continue;
+    batches[sprite->page].quad_count++;
+    quad_count++;
+  }
+
+  uint32_t first_quad = 0;
+  for (uint32_t page = 0; page < batches.size(); page++)
+  {
+    batches[page].page       = page;
+    batches[page].first_quad = first_quad;
+    first_quad += batches[page].quad_count;
+    batches[page].quad_count = 0;
+  }
+
+  // The second pass writes each quad into its page's range, skipping the same instances
+  size_t written = 0;
+  for (const auto& instance : instances)
+  {
+    const Sprite* sprite = atlas.get(instance.sprite);
+    if (!sprite || written == quad_count)
+      continue;
+    written++;
+
+    SpriteBatch& batch = batches[sprite->page];
+    SpriteVertex* quad = vertices + size_t(batch.first_quad + batch.quad_count++) * 4;
+
+    // Half extents of the quad along its rotated axes
+    float c      = std::cos(instance.rotation);
+    float s      = std::sin(instance.rotation);
+    float half_x = 0.5f * instance.size[0];
+    float half_y = 0.5f * instance.size[1];
+    float ax     = c * half_x;
+    float ay     = s * half_x;
+    float bx     = -s * half_y;
+    float by     = c * half_y;
+    float px     = instance.position[0];
+    float py     = instance.position[1];
+
+    quad[0] = { { px - ax - bx, py - ay - by }, { sprite->uv_min[0], sprite->uv_min[1] },
+                instance.color };
+    quad[1] = { { px + ax - bx, py + ay - by }, { sprite->uv_max[0], sprite->uv_min[1] },
+                instance.color };
+    quad[2] = { { px + ax + bx, py + ay + by }, { sprite->uv_max[0], sprite->uv_max[1] },
+                instance.color };
+    quad[3] = { { px - ax + bx, py - ay + by }, { sprite->uv_min[0], sprite->uv_max[1] },
+                instance.color };
+  }
+
+  batches.erase(std::remove_if(batches.begin(),
+                               batches.end(),
+                               [](const SpriteBatch& batch) { return batch.quad_count == 0; }),
+                batches.end());
+  return quad_count;
+}
@@ -0,0 +1,54 @@
+#include "StringId.hpp"
+
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+#ifndef NDEBUG
+struct Registry
+{
+  std::mutex mutex;
+  std::unordered_map<uint64_t, std::string> names;
+};
+
+Registry& registry()
+{
+  static Registry registry;
+  return registry;
+}
+#endif
+} // namespace
+
+void StringId::registerName(uint64_t value, std::string_view name)
+{
+#ifndef NDEBUG
+  Registry& names = registry();
+  std::lock_guard lock(names.mutex);
+  auto [it, inserted] = names.names.try_emplace(value, name);
+  if (!inserted && it->second != name)
+  {
+    throw std::logic_error("StringId collision between " + it->second + " and " +
+                           std::string(name));
+  }
+#else
+  static_cast<void>(value);
+  static_cast<void>(name);
+#endif
+}
+
+std::string StringId::name() const
+{
+#ifndef NDEBUG
+  Registry& names = registry();
+  std::lock_guard lock(names.mutex);
+  auto it = names.names.find(this->value_);
+  if (it != names.names.end())
+    return it->second;
+#endif
+  char hex[19];
+  std::snprintf(hex, sizeof(hex), "0x%016llx", static_cast<unsigned long long>(this->value_));
+  return hex;
+}
@@ -0,0 +1,89 @@
+#include "StutterMonitor.hpp"
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+StutterMonitor::StutterMonitor(std::string trace_prefix, float threshold) :
+  trace_prefix_(std::move(trace_prefix)),
+  threshold_(threshold)
+{
+  this->thread_ = std::thread(&StutterMonitor::process, this);
+}
+
+bool StutterMonitor::addFrame(uint64_t frame_number, int64_t begin, int64_t end)
+{
+  int64_t frame_time = end - begin;
+
+  // Spikes are only looked for once the history is full
+  bool spike = this->history_count_ == history_size_ && this->median_ > 0 &&
+               frame_time > static_cast<int64_t>(this->threshold_ * this->median_) &&
+               frame_time >= std::chrono::nanoseconds(min_spike_time_).count();
+
+  this->history_[this->history_next_] = frame_time;
+  this->history_next_                 = (this->history_next_ + 1) % history_size_;
+  this->history_count_                = std::min(this->history_count_ + 1, history_size_);
+
+  // The median moves slowly, it is refreshed every few frames rather than kept sorted
+  if (this->frames_to_median_-- == 0)
+  {
+    auto sorted     = this->sorted_.begin();
+    auto sorted_end = std::copy_n(this->history_.begin(), this->history_count_, sorted);
+    auto middle     = sorted + static_cast<ptrdiff_t>(this->history_count_ / 2);
+    std::nth_element(sorted, middle, sorted_end);
+    this->median_           = *middle;
+    this->frames_to_median_ = median_interval_ - 1;
+  }
+
+  // Traces are spaced at least a window apart so they do not overlap
+  if (!spike || this->trace_count_ == max_traces_ || end < this->next_trace_time_ ||
+      this->trace_pending_.load(std::memory_order_acquire))
+    return false;
+  this->spike_           = { frame_number, frame_time, this->median_, end };
+  this->next_trace_time_ = end + std::chrono::nanoseconds(window_).count();
+  this->trace_count_++;
+  this->trace_pending_.store(true, std::memory_order_relaxed);
+  this->signal_.release();
+  return true;
+}
+
+void StutterMonitor::process()
+{
+  while (true)
+  {
+    this->signal_.acquire();
+    if (!this->running_.load(std::memory_order_relaxed))
+      return;
+
+    // Let the frames in flight finish, so their zones and the spike's GPU zones are in the rings
+    std::this_thread::sleep_for(tail_);
+
+    const Spike& spike = this->spike_;
+    std::string file   = this->trace_prefix_ + "-" + std::to_string(spike.frame_number) + ".json";
+    try
+    {
+      Profiler::instance().writeTrace(file,
+                                      spike.end - std::chrono::nanoseconds(window_).count(),
+                                      spike.end + std::chrono::nanoseconds(tail_).count());
+      LOG_WARNING("Frame {} took {}ns, {} times the median of {}ns, trace written to {}",
+                  spike.frame_number,
+                  spike.frame_time,
+                  static_cast<double>(spike.frame_time) / static_cast<double>(spike.median),
+                  spike.median,
+                  file);
+    } catch (const std::exception& error)
+    {
+      LOG_ERROR("Failed to write stutter trace {}: {}", file, error.what());
+    }
+    this->trace_pending_.store(false, std::memory_order_release);
+  }
+}
+
+StutterMonitor::~StutterMonitor()
+{
+  this->running_ = false;
+  this->signal_.release();
+  this->thread_.join();
+}
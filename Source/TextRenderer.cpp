@@ -0,0 +1,219 @@
+#include "TextRenderer.hpp"
+
+#include "Msdf.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// Decodes the code point starting at offset and advances offset past it. Malformed sequences
+// decode to U+FFFD one byte at a time.
+uint32_t decodeUtf8(std::string_view text, size_t& offset)
+{
+  auto byte = static_cast<unsigned char>(text[offset++]);
+  if (byte < 0x80)
+    return byte;
+
+  size_t length;
+  uint32_t codepoint;
+  if ((byte & 0xE0) == 0xC0)
+  {
+    length    = 1;
+    codepoint = byte & 0x1F;
+  } else if ((byte & 0xF0) == 0xE0)
+  {
+    length    = 2;
+    codepoint = byte & 0x0F;
+  } else if ((byte & 0xF8) == 0xF0)
+  {
+    length    = 3;
+    codepoint = byte & 0x07;
+  } else
+  {
+    return 0xFFFD;
+  }
+
+  if (offset + length > text.size())
+    return 0xFFFD;
+  for (size_t i = 0; i < length; i++)
+  {
+    auto continuation = static_cast<unsigned char>(text[offset + i]);
+    if ((continuation & 0xC0) != 0x80)
+      return 0xFFFD;
+    codepoint = codepoint << 6 | (continuation & 0x3F);
+  }
+  offset += length;
+  return codepoint;
+}
+} // namespace
+
+TextRenderer::TextRenderer(Scheduler& scheduler,
+                           TrueTypeFont font,
+                           uint32_t page_size,
+                           uint32_t page_count,
+                           uint32_t max_uploads_per_frame) :
+  scheduler_(scheduler),
+  font_(std::move(font)),
+  cache_(page_size, cell_size_, page_count),
+  page_size_(page_size),
+  max_uploads_per_frame_(max_uploads_per_frame)
+{
+  float font_height = this->font_.ascender() - this->font_.descender();
+  if (font_height <= 0.0f)
+    font_height = this->font_.unitsPerEm();
+  this->field_scale_ = (cell_size_ - 2.0f * distance_range_) / font_height;
+}
+
+const TextRenderer::CodepointInfo& TextRenderer::codepointInfo(uint32_t codepoint)
+{
+  auto it = this->codepoints_.find(codepoint);
+  if (it != this->codepoints_.end())
+    return it->second;
+  uint32_t glyph = this->font_.glyphIndex(codepoint);
+  return this->codepoints_.emplace(codepoint, CodepointInfo { glyph, this->font_.metrics(glyph) })
+      .first->second;
+}
+
+Task<void> TextRenderer::generateGlyph(uint32_t glyph, GlyphMetrics metrics)
+{
+  co_await this->scheduler_.schedule();
+
+  // Place the glyph's left edge and the font's ascender one distance range inside the cell
+  MsdfTransform transform;
+  transform.scale    = this->field_scale_;
+  transform.offset_x = distance_range_ - metrics.x_min * this->field_scale_;
+  transform.offset_y = distance_range_ + this->font_.ascender() * this->field_scale_;
+  std::vector<uint32_t> texels = generateMsdf(this->font_.outline(glyph),
+                                              transform,
+                                              cell_size_,
+                                              cell_size_,
+                                              distance_range_);
+
+  co_await this->scheduler_.resumeOnMainThread();
+  this->generated_.push_back({ glyph, std::move(texels) });
+}
+
+void TextRenderer::beginFrame(uint64_t frame)
+{
+  this->frame_          = frame;
+  uint64_t evict_before = frame > 0 ? frame - 1 : 0;
+
+  size_t added = 0;
+  for (; added < this->generated_.size() && added < this->max_uploads_per_frame_; added++)
+  {
+    GeneratedGlyph& generated     = this->generated_[added];
+    std::optional<GlyphSlot> slot = this->cache_.insert(generated.glyph, frame, evict_before);
+    if (!slot)
+      break;
+    this->pending_.erase(generated.glyph);
+    this->uploads_.push_back({ slot->page, slot->x, slot->y, std::move(generated.texels) });
+  }
+  this->generated_.erase(this->generated_.begin(), this->generated_.begin() + added);
+  if (added > 0)
+    this->glyph_version_++;
+}
+
+float TextRenderer::drawText(std::string_view text,
+                             float x,
+                             float y,
+                             float size,
+                             uint32_t color,
+                             std::vector<GlyphQuad>& quads)
+{
+  float units_to_pixels  = size / this->font_.unitsPerEm();
+  float pixels_per_texel = units_to_pixels / this->field_scale_;
+  float padding          = distance_range_ / this->field_scale_;
+  float texel_size       = 1.0f / static_cast<float>(this->page_size_);
+
+  float pen_x    = x;
+  float baseline = y;
+  for (size_t offset = 0; offset < text.size();)
+  {
+    uint32_t codepoint = decodeUtf8(text, offset);
+    if (codepoint == '\n')
+    {
+      pen_x = x;
+      baseline += this->lineHeight(size);
+      continue;
+    }
+
+    const CodepointInfo& info   = this->codepointInfo(codepoint);
+    const GlyphMetrics& metrics = info.metrics;
+    if (metrics.x_max > metrics.x_min)
+    {
+      const GlyphSlot* slot = this->cache_.find(info.glyph, this->frame_);
+      if (slot)
+      {
+        // The cell holds the glyph's box plus the distance range, glyphs wider than a cell are cut
+        float width = std::min((metrics.x_max - metrics.x_min) * this->field_scale_ +
+                                   2.0f * distance_range_,
+                               static_cast<float>(cell_size_));
+        GlyphQuad quad;
+        quad.position[0] = pen_x + (metrics.x_min - padding) * units_to_pixels;
+        quad.position[1] = baseline - (this->font_.ascender() + padding) * units_to_pixels;
+        quad.position[2] = quad.position[0] + width * pixels_per_texel;
+        quad.position[3] = quad.position[1] + cell_size_ * pixels_per_texel;
+        quad.uv[0]       = slot->x * texel_size;
+        quad.uv[1]       = slot->y * texel_size;
+        quad.uv[2]       = (slot->x + width) * texel_size;
+        quad.uv[3]       = (slot->y + cell_size_) * texel_size;
+        quad.page        = slot->page;
+        quad.color       = color;
+        quads.push_back(quad);
+      } else if (this->pending_.insert(info.glyph).second)
+      {
+        this->scheduler_.spawn(this->generateGlyph(info.glyph, metrics));
+      }
+    }
+    pen_x += metrics.advance * units_to_pixels;
+  }
+  return pen_x;
+}
+
+float TextRenderer::lineHeight(float size) const
+{
+  return (this->font_.ascender() - this->font_.descender() + this->font_.lineGap()) * size /
+         this->font_.unitsPerEm();
+}
+
+void TextRenderer::takeUploads(std::vector<GlyphUpload>& uploads)
+{
+  // The caller's previous uploads are done with, their storage is reused next frame
+  uploads.clear();
+  uploads.swap(this->uploads_);
+}
+
+uint64_t TextRenderer::glyphVersion() const
+{
+  return this->glyph_version_;
+}
+
+size_t TextRenderer::cachedGlyphCount() const
+{
+  return this->cache_.size();
+}
+
+size_t TextRenderer::pendingGlyphCount() const
+{
+  return this->pending_.size();
+}
+
+size_t
+buildTextVertices(const std::vector<GlyphQuad>& quads, TextVertex* vertices, size_t max_quads)
+{
+  size_t count = std::min(quads.size(), max_quads);
+  for (size_t i = 0; i < count; i++)
+  {
+    const GlyphQuad& quad = quads[i];
+    TextVertex* vertex    = vertices + i * 4;
+    vertex[0] = { { quad.position[0], quad.position[1] }, { quad.uv[0], quad.uv[1] }, quad.color,
+                  quad.page };
+    vertex[1] = { { quad.position[2], quad.position[1] }, { quad.uv[2], quad.uv[1] }, quad.color,
+                  quad.page };
+    vertex[2] = { { quad.position[2], quad.position[3] }, { quad.uv[2], quad.uv[3] }, quad.color,
+                  quad.page };
+    vertex[3] = { { quad.position[0], quad.position[3] }, { quad.uv[0], quad.uv[3] }, quad.color,
+                  quad.page };
+  }
+  return count;
+}
@@ -0,0 +1,420 @@
+#include "TrueTypeFont.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+// Glyph point flags
+constexpr uint8_t on_curve_flag = 0x01;
+constexpr uint8_t x_short_flag  = 0x02;
+constexpr uint8_t y_short_flag  = 0x04;
+constexpr uint8_t repeat_flag   = 0x08;
+constexpr uint8_t x_same_flag   = 0x10;
+constexpr uint8_t y_same_flag   = 0x20;
+
+// Composite glyph component flags
+constexpr uint16_t args_are_words_flag  = 0x0001;
+constexpr uint16_t args_are_xy_flag     = 0x0002;
+constexpr uint16_t has_scale_flag       = 0x0008;
+constexpr uint16_t more_components_flag = 0x0020;
+constexpr uint16_t has_xy_scale_flag    = 0x0040;
+constexpr uint16_t has_two_by_two_flag  = 0x0080;
+
+// Composite glyphs nest rarely, deeper nesting is treated as a malformed font
+constexpr int max_composite_depth = 8;
+
+OutlinePoint transformPoint(const float transform[6], float x, float y)
+{
+  return { transform[0] * x + transform[2] * y + transform[4],
+           transform[1] * x + transform[3] * y + transform[5] };
+}
+
+OutlinePoint midpoint(OutlinePoint a, OutlinePoint b)
+{
+  return { 0.5f * (a.x + b.x), 0.5f * (a.y + b.y) };
+}
+} // namespace
+
+TrueTypeFont::TrueTypeFont(std::vector<uint8_t> data) : data_(std::move(data))
+{
+  // Only glyf outlines are supported, CFF based OpenType fonts start with OTTO
+  uint32_t version = this->readU32(0);
+  if (version != 0x00010000 && version != 0x74727565)
+    throw std::runtime_error("Not a TrueType font");
+
+  size_t head = this->findTable("head");
+  size_t hhea = this->findTable("hhea");
+  size_t maxp = this->findTable("maxp");
+  size_t cmap = this->findTable("cmap");
+  this->glyf_ = this->findTable("glyf");
+  this->loca_ = this->findTable("loca");
+  this->hmtx_ = this->findTable("hmtx");
+  if (!head || !hhea || !maxp || !cmap || !this->glyf_ || !this->loca_ || !this->hmtx_)
+    throw std::runtime_error("TrueType font is missing a required table");
+
+  this->units_per_em_  = this->readU16(head + 18);
+  this->long_loca_     = this->readI16(head + 50) != 0;
+  this->glyph_count_   = this->readU16(maxp + 4);
+  this->ascender_      = this->readI16(hhea + 4);
+  this->descender_     = this->readI16(hhea + 6);
+  this->line_gap_      = this->readI16(hhea + 8);
+  this->hmetric_count_ = this->readU16(hhea + 34);
+  if (this->units_per_em_ == 0 || this->hmetric_count_ == 0)
+    throw std::runtime_error("TrueType font has invalid metrics");
+
+  // Prefer the full Unicode mapping (format 12), then the Basic Multilingual Plane (format 4)
+  uint16_t subtable_count = this->readU16(cmap + 2);
+  for (uint16_t i = 0; i < subtable_count; i++)
+  {
+    size_t record     = cmap + 4 + i * 8;
+    uint16_t platform = this->readU16(record);
+    uint16_t encoding = this->readU16(record + 2);
+    size_t subtable   = cmap + this->readU32(record + 4);
+    uint16_t format   = this->readU16(subtable);
+    bool unicode      = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+    if (!unicode || (format != 4 && format != 12))
+      continue;
+    if (format == 12 || this->cmap_format_ == 0)
+    {
+      this->cmap_        = subtable;
+      this->cmap_format_ = format;
+    }
+  }
+  if (this->cmap_format_ == 0)
+    throw std::runtime_error("TrueType font has no Unicode character map");
+}
+
+uint16_t TrueTypeFont::readU16(size_t offset) const
+{
+  return static_cast<uint16_t>(this->readU8(offset) << 8 | this->readU8(offset + 1));
+}
+
+uint8_t TrueTypeFont::readU8(size_t offset) const
+{
+  if (offset >= this->data_.size())
+    throw std::runtime_error("TrueType font is truncated");
+  return this->data_[offset];
+}
+
+int16_t TrueTypeFont::readI16(size_t offset) const
+{
+  return static_cast<int16_t>(this->readU16(offset));
+}
+
+uint32_t TrueTypeFont::readU32(size_t offset) const
+{
+  return static_cast<uint32_t>(this->readU16(offset)) << 16 | this->readU16(offset + 2);
+}
+
+size_t TrueTypeFont::findTable(std::string_view tag) const
+{
+  uint16_t table_count = this->readU16(4);
+  for (uint16_t i = 0; i < table_count; i++)
+  {
+    size_t record = 12 + i * 16;
+    if (record + 16 > this->data_.size())
+      throw std::runtime_error("TrueType font is truncated");
+    if (std::equal(tag.begin(), tag.end(), this->data_.begin() + record))
+      return this->readU32(record + 8);
+  }
+  return 0;
+}
+
+std::pair<size_t, size_t> TrueTypeFont::glyphRange(uint32_t glyph) const
+{
+  if (glyph >= this->glyph_count_)
+    return { 0, 0 };
+  size_t start;
+  size_t end;
+  if (this->long_loca_)
+  {
+    start = this->readU32(this->loca_ + glyph * 4);
+    end   = this->readU32(this->loca_ + glyph * 4 + 4);
+  } else
+  {
+    start = this->readU16(this->loca_ + glyph * 2) * size_t(2);
+    end   = this->readU16(this->loca_ + glyph * 2 + 2) * size_t(2);
+  }
+  if (end < start)
+    throw std::runtime_error("TrueType font has an invalid glyph location");
+  return { this->glyf_ + start, this->glyf_ + end };
+}
+
+uint32_t TrueTypeFont::glyphIndex(uint32_t codepoint) const
+{
+  if (this->cmap_format_ == 12)
+  {
+    // Sorted groups of consecutive code points mapping to consecutive glyphs
+    uint32_t group_count = this->readU32(this->cmap_ + 12);
+    size_t low           = 0;
+    size_t high          = group_count;
+    while (low < high)
+    {
+      size_t middle  = (low + high) / 2;
+      size_t group   = this->cmap_ + 16 + middle * 12;
+      uint32_t first = this->readU32(group);
+      uint32_t last  = this->readU32(group + 4);
+      if (codepoint < first)
+        high = middle;
+      else if (codepoint > last)
+        low = middle + 1;
+      else
+        return this->readU32(group + 8) + (codepoint - first);
+    }
+    return 0;
+  }
+
+  // Format 4, segments of code points with either a delta or an offset into a glyph array
+  if (codepoint > 0xFFFF)
+    return 0;
+  uint16_t segment_count = this->readU16(this->cmap_ + 6) / 2;
+  size_t end_codes       = this->cmap_ + 14;
+  size_t start_codes     = end_codes + segment_count * 2 + 2;
+  size_t deltas          = start_codes + segment_count * 2;
+  size_t range_offsets   = deltas + segment_count * 2;
+  for (uint16_t i = 0; i < segment_count; i++)
+  {
+    if (codepoint > this->readU16(end_codes + i * 2))
+      continue;
+    uint16_t start = this->readU16(start_codes + i * 2);
+    if (codepoint < start)
+      return 0;
+    uint16_t delta        = this->readU16(deltas + i * 2);
+    uint16_t range_offset = this->readU16(range_offsets + i * 2);
+    if (range_offset == 0)
+      return static_cast<uint16_t>(codepoint + delta);
+    size_t glyph_offset = range_offsets + i * 2 + range_offset + (codepoint - start) * 2;
+    uint16_t glyph      = this->readU16(glyph_offset);
+    return glyph ? static_cast<uint16_t>(glyph + delta) : 0;
+  }
+  return 0;
+}
+
+GlyphMetrics TrueTypeFont::metrics(uint32_t glyph) const
+{
+  GlyphMetrics metrics = {};
+  uint32_t metric      = std::min<uint32_t>(glyph, this->hmetric_count_ - 1);
+  metrics.advance      = this->readU16(this->hmtx_ + metric * 4);
+
+  auto [start, end] = this->glyphRange(glyph);
+  if (start == end)
+    return metrics;
+  metrics.x_min = this->readI16(start + 2);
+  metrics.y_min = this->readI16(start + 4);
+  metrics.x_max = this->readI16(start + 6);
+  metrics.y_max = this->readI16(start + 8);
+  return metrics;
+}
+
+std::vector<OutlineContour> TrueTypeFont::outline(uint32_t glyph) const
+{
+  const float identity[6] = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+  std::vector<OutlineContour> contours;
+  this->appendOutline(glyph, identity, contours, 0);
+  return contours;
+}
+
+void TrueTypeFont::appendOutline(uint32_t glyph,
+                                 const float transform[6],
+                                 std::vector<OutlineContour>& contours,
+                                 int depth) const
+{
+  if (depth > max_composite_depth)
+    throw std::runtime_error("TrueType font nests composite glyphs too deeply");
+  auto [start, end] = this->glyphRange(glyph);
+  if (start == end)
+    return;
+
+  int16_t contour_count = this->readI16(start);
+  size_t offset         = start + 10;
+
+  // Composite glyph, the outlines of other glyphs placed with an offset and optional scale
+  if (contour_count < 0)
+  {
+    uint16_t flags;
+    do
+    {
+      flags              = this->readU16(offset);
+      uint32_t component = this->readU16(offset + 2);
+      offset += 4;
+      float dx = 0.0f;
+      float dy = 0.0f;
+      if (flags & args_are_words_flag)
+      {
+        dx = this->readI16(offset);
+        dy = this->readI16(offset + 2);
+        offset += 4;
+      } else
+      {
+        dx = static_cast<int8_t>(this->readU8(offset));
+        dy = static_cast<int8_t>(this->readU8(offset + 1));
+        offset += 2;
+      }
+      // Components aligned by matching points are placed without an offset
+      if (!(flags & args_are_xy_flag))
+        dx = dy = 0.0f;
+
+      // Scales are 2.14 fixed point
+      float matrix[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+      if (flags & has_scale_flag)
+      {
+        matrix[0] = matrix[3] = this->readI16(offset) / 16384.0f;
+        offset += 2;
+      } else if (flags & has_xy_scale_flag)
+      {
+        matrix[0] = this->readI16(offset) / 16384.0f;
+        matrix[3] = this->readI16(offset + 2) / 16384.0f;
+        offset += 4;
+      } else if (flags & has_two_by_two_flag)
+      {
+        for (int i = 0; i < 4; i++)
+          matrix[i] = this->readI16(offset + i * 2) / 16384.0f;
+        offset += 8;
+      }
+
+      // Concatenate the component transform with the parent's
+      float combined[6];
+      for (int column = 0; column < 2; column++)
+      {
+        combined[column * 2] = transform[0] * matrix[column * 2] +
+                               transform[2] * matrix[column * 2 + 1];
+        combined[column * 2 + 1] = transform[1] * matrix[column * 2] +
+                                   transform[3] * matrix[column * 2 + 1];
+      }
+      OutlinePoint origin = transformPoint(transform, dx, dy);
+      combined[4]         = origin.x;
+      combined[5]         = origin.y;
+      this->appendOutline(component, combined, contours, depth + 1);
+    } while (flags & more_components_flag);
+    return;
+  }
+
+  // Simple glyph, contour end points, instructions, then run length encoded flags and coordinates
+  std::vector<uint16_t> contour_ends(contour_count);
+  for (int16_t i = 0; i < contour_count; i++)
+    contour_ends[i] = this->readU16(offset + i * 2);
+  offset += contour_count * 2;
+  if (contour_count == 0)
+    return;
+  size_t point_count = contour_ends.back() + size_t(1);
+  offset += 2 + this->readU16(offset);
+
+  std::vector<uint8_t> flags(point_count);
+  for (size_t i = 0; i < point_count;)
+  {
+    uint8_t flag  = this->readU8(offset++);
+    size_t repeat = 1;
+    if (flag & repeat_flag)
+      repeat += this->readU8(offset++);
+    for (; repeat > 0 && i < point_count; repeat--)
+      flags[i++] = flag;
+  }
+
+  // Coordinates are deltas, short ones are a byte with the sign in the same or positive flag
+  auto read_coordinates = [&](uint8_t short_flag, uint8_t same_flag) {
+    std::vector<float> values(point_count);
+    int32_t value = 0;
+    for (size_t i = 0; i < point_count; i++)
+    {
+      if (flags[i] & short_flag)
+      {
+        int32_t delta = this->readU8(offset++);
+        value += (flags[i] & same_flag) ? delta : -delta;
+      } else if (!(flags[i] & same_flag))
+      {
+        value += this->readI16(offset);
+        offset += 2;
+      }
+      values[i] = static_cast<float>(value);
+    }
+    return values;
+  };
+  std::vector<float> xs = read_coordinates(x_short_flag, x_same_flag);
+  std::vector<float> ys = read_coordinates(y_short_flag, y_same_flag);
+
+  // Build edges, two consecutive off curve points imply an on curve point between them
+  struct ContourPoint
+  {
+    OutlinePoint point;
+    bool on_curve;
+  };
+  std::vector<ContourPoint> points;
+  size_t first = 0;
+  for (uint16_t contour_end : contour_ends)
+  {
+    size_t last = contour_end;
+    if (last < first || last >= point_count)
+      throw std::runtime_error("TrueType glyph has invalid contours");
+    points.clear();
+    for (size_t i = first; i <= last; i++)
+    {
+      bool on_curve = (flags[i] & on_curve_flag) != 0;
+      points.push_back({ transformPoint(transform, xs[i], ys[i]), on_curve });
+    }
+    first = last + 1;
+
+    // Rotate the contour to start on curve, adding the implied point if every point is off curve
+    auto start = std::find_if(points.begin(), points.end(), [](const ContourPoint& point) {
+      return point.on_curve;
+    });
+    if (start == points.end())
+      points.insert(points.begin(), { midpoint(points.back().point, points.front().point), true });
+    else
+      std::rotate(points.begin(), start, points.end());
+
+    OutlineContour contour;
+    OutlinePoint current = points.front().point;
+    OutlinePoint control {};
+    bool has_control = false;
+    for (size_t i = 1; i <= points.size(); i++)
+    {
+      const ContourPoint& next = points[i % points.size()];
+      if (next.on_curve)
+      {
+        if (has_control)
+          contour.push_back({ current, control, next.point, true });
+        else
+          contour.push_back({ current, current, next.point, false });
+        current     = next.point;
+        has_control = false;
+        continue;
+      }
+      if (has_control)
+      {
+        OutlinePoint implied = midpoint(control, next.point);
+        contour.push_back({ current, control, implied, true });
+        current = implied;
+      }
+      control     = next.point;
+      has_control = true;
+    }
+    if (contour.size() > 1)
+      contours.push_back(std::move(contour));
+  }
+}
+
+uint32_t TrueTypeFont::glyphCount() const
+{
+  return this->glyph_count_;
+}
+
+float TrueTypeFont::unitsPerEm() const
+{
+  return this->units_per_em_;
+}
+
+float TrueTypeFont::ascender() const
+{
+  return this->ascender_;
+}
+
+float TrueTypeFont::descender() const
+{
+  return this->descender_;
+}
+
+float TrueTypeFont::lineGap() const
+{
+  return this->line_gap_;
+}
@@ -0,0 +1,255 @@
+#include "UiLayer.hpp"
+
+#include <algorithm>
+
+bool UiRect::empty() const
+{
+  return this->x0 >= this->x1 || this->y0 >= this->y1;
+}
+
+bool UiRect::intersects(const UiRect& other) const
+{
+  return !this->empty() && !other.empty() && this->x0 < other.x1 && other.x0 < this->x1 &&
+         this->y0 < other.y1 && other.y0 < this->y1;
+}
+
+UiRect UiRect::united(const UiRect& other) const
+{
+  if (this->empty())
+    return other;
+  if (other.empty())
+    return *this;
+  return { std::min(this->x0, other.x0),
+           std::min(this->y0, other.y0),
+           std::max(this->x1, other.x1),
+           std::max(this->y1, other.y1) };
+}
+
+UiLayer::UiLayer(TextRenderer* text_renderer, SpriteHandle solid_sprite) :
+  text_renderer_(text_renderer),
+  solid_sprite_(solid_sprite)
+{
+  if (this->text_renderer_)
+    this->glyph_version_ = this->text_renderer_->glyphVersion();
+}
+
+UiWidgetHandle UiLayer::add(UiWidget widget)
+{
+  widget.dirty          = true;
+  UiWidgetHandle handle = this->widgets_.insert(std::move(widget));
+  this->order_.push_back(handle);
+  this->dirty_widgets_.push_back(handle);
+  return handle;
+}
+
+UiWidgetHandle UiLayer::addPanel(const UiRect& rect, uint32_t color)
+{
+  UiWidget widget;
+  widget.kind  = UiWidgetKind::Panel;
+  widget.rect  = rect;
+  widget.color = color;
+  return this->add(std::move(widget));
+}
+
+UiWidgetHandle
+UiLayer::addLabel(float x, float baseline, float size, uint32_t color, std::string_view text)
+{
+  UiWidget widget;
+  widget.kind      = UiWidgetKind::Label;
+  widget.rect      = { x, baseline, x, baseline };
+  widget.color     = color;
+  widget.text_size = size;
+  widget.text      = text;
+  return this->add(std::move(widget));
+}
+
+UiWidgetHandle
+UiLayer::addBar(const UiRect& rect, uint32_t background, uint32_t color, float value)
+{
+  UiWidget widget;
+  widget.kind       = UiWidgetKind::Bar;
+  widget.rect       = rect;
+  widget.color      = color;
+  widget.background = background;
+  widget.value      = std::clamp(value, 0.0f, 1.0f);
+  return this->add(std::move(widget));
+}
+
+void UiLayer::markDirty(UiWidgetHandle handle, UiWidget& widget)
+{
+  if (widget.dirty)
+    return;
+  widget.dirty = true;
+  this->dirty_widgets_.push_back(handle);
+}
+
+void UiLayer::setText(UiWidgetHandle handle, std::string_view text)
+{
+  UiWidget* widget = this->widgets_.get(handle);
+  if (!widget || widget->text == text)
+    return;
+  widget->text = text;
+  this->markDirty(handle, *widget);
+}
+
+void UiLayer::setValue(UiWidgetHandle handle, float value)
+{
+  UiWidget* widget = this->widgets_.get(handle);
+  value            = std::clamp(value, 0.0f, 1.0f);
+  if (!widget || widget->value == value)
+    return;
+  widget->value = value;
+  this->markDirty(handle, *widget);
+}
+
+void UiLayer::setColor(UiWidgetHandle handle, uint32_t color)
+{
+  UiWidget* widget = this->widgets_.get(handle);
+  if (!widget || widget->color == color)
+    return;
+  widget->color = color;
+  this->markDirty(handle, *widget);
+}
+
+void UiLayer::setVisible(UiWidgetHandle handle, bool visible)
+{
+  UiWidget* widget = this->widgets_.get(handle);
+  if (!widget || widget->visible == visible)
+    return;
+  widget->visible = visible;
+  this->markDirty(handle, *widget);
+}
+
+bool UiLayer::remove(UiWidgetHandle handle)
+{
+  UiWidget* widget = this->widgets_.get(handle);
+  if (!widget)
+    return false;
+
+  // What the widget covered is redrawn without it, a pending tessellation is simply dropped
+  this->dirty_region_ = this->dirty_region_.united(widget->bounds);
+  this->order_.erase(std::find(this->order_.begin(), this->order_.end(), handle));
+  auto dirty = std::find(this->dirty_widgets_.begin(), this->dirty_widgets_.end(), handle);
+  if (dirty != this->dirty_widgets_.end())
+    this->dirty_widgets_.erase(dirty);
+  return this->widgets_.erase(handle);
+}
+
+void UiLayer::invalidate()
+{
+  for (UiWidgetHandle handle : this->order_)
+    this->markDirty(handle, this->widgets_.at(handle));
+}
+
+void UiLayer::addRect(const UiRect& rect,
+                      uint32_t color,
+                      std::vector<SpriteInstance>& sprites) const
+{
+  if (rect.empty())
+    return;
+  sprites.push_back({ this->solid_sprite_,
+                      { (rect.x0 + rect.x1) * 0.5f, (rect.y0 + rect.y1) * 0.5f },
+                      { rect.x1 - rect.x0, rect.y1 - rect.y0 },
+                      0.0f,
+                      color });
+}
+
+void UiLayer::tessellate(UiWidget& widget)
+{
+  widget.sprites.clear();
+  widget.glyphs.clear();
+  widget.bounds = {};
+  if (!widget.visible)
+    return;
+
+  switch (widget.kind)
+  {
+  case UiWidgetKind::Panel:
+    this->addRect(widget.rect, widget.color, widget.sprites);
+    widget.bounds = widget.rect;
+    break;
+  case UiWidgetKind::Label:
+    // Bounds are those of the glyph quads, which include the distance field padding
+    if (this->text_renderer_)
+    {
+      this->text_renderer_->drawText(widget.text,
+                                     widget.rect.x0,
+                                     widget.rect.y0,
+                                     widget.text_size,
+                                     widget.color,
+                                     widget.glyphs);
+    }
+    for (const GlyphQuad& quad : widget.glyphs)
+    {
+      widget.bounds = widget.bounds.united(
+          { quad.position[0], quad.position[1], quad.position[2], quad.position[3] });
+    }
+    break;
+  case UiWidgetKind::Bar:
+  {
+    UiRect fill = widget.rect;
+    fill.x1     = widget.rect.x0 + (widget.rect.x1 - widget.rect.x0) * widget.value;
+    this->addRect(widget.rect, widget.background, widget.sprites);
+    this->addRect(fill, widget.color, widget.sprites);
+    widget.bounds = widget.rect;
+    break;
+  }
+  }
+  this->tessellation_count_++;
+}
+
+void UiLayer::update(UiUpdate& update)
+{
+  // Glyphs were added or evicted, labels laid out before may be missing glyphs or sample stale
+  // cells, so all of them are laid out again
+  if (this->text_renderer_ && this->text_renderer_->glyphVersion() != this->glyph_version_)
+  {
+    this->glyph_version_ = this->text_renderer_->glyphVersion();
+    for (UiWidgetHandle handle : this->order_)
+    {
+      UiWidget& widget = this->widgets_.at(handle);
+      if (widget.kind == UiWidgetKind::Label)
+        this->markDirty(handle, widget);
+    }
+  }
+
+  // A changed widget dirties what it covered before and what it covers now
+  UiRect region = this->dirty_region_;
+  for (UiWidgetHandle handle : this->dirty_widgets_)
+  {
+    UiWidget& widget = this->widgets_.at(handle);
+    region           = region.united(widget.bounds);
+    this->tessellate(widget);
+    region       = region.united(widget.bounds);
+    widget.dirty = false;
+  }
+  this->dirty_widgets_.clear();
+  this->dirty_region_ = {};
+
+  update.sprites.clear();
+  update.glyphs.clear();
+  update.dirty  = !region.empty();
+  update.region = region;
+  if (!update.dirty)
+    return;
+
+  // Everything overlapping the region is drawn again, the region clips it
+  for (UiWidgetHandle handle : this->order_)
+  {
+    const UiWidget& widget = this->widgets_.at(handle);
+    if (!widget.bounds.intersects(region))
+      continue;
+    update.sprites.insert(update.sprites.end(), widget.sprites.begin(), widget.sprites.end());
+    update.glyphs.insert(update.glyphs.end(), widget.glyphs.begin(), widget.glyphs.end());
+  }
+}
+
+size_t UiLayer::widgetCount() const
+{
+  return this->widgets_.size();
+}
+
+uint64_t UiLayer::tessellationCount() const
+{
+  return this->tessellation_count_;
+}
@@ -0,0 +1,113 @@
+#include "Wav.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+uint32_t readU16(const std::vector<char>& data, size_t offset)
+{
+  auto bytes = reinterpret_cast<const unsigned char*>(data.data()) + offset;
+  return bytes[0] | bytes[1] << 8;
+}
+
+uint32_t readU32(const std::vector<char>& data, size_t offset)
+{
+  auto bytes = reinterpret_cast<const unsigned char*>(data.data()) + offset;
+  return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+} // namespace
+
+WavFormat parseWav(const std::vector<char>& data)
+{
+  if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) != 0 ||
+      std::memcmp(data.data() + 8, "WAVE", 4) != 0)
+    throw std::runtime_error("Not a RIFF WAVE file");
+
+  // Chunks are word aligned, fmt must come before data
+  WavFormat format {};
+  bool has_format = false;
+  for (size_t offset = 12; offset + 8 <= data.size();)
+  {
+    uint32_t chunk_size = readU32(data, offset + 4);
+    size_t chunk_start  = offset + 8;
+    if (chunk_size > data.size() - chunk_start)
+      throw std::runtime_error("Truncated WAVE chunk");
+
+    if (std::memcmp(data.data() + offset, "fmt ", 4) == 0 && chunk_size >= 16)
+    {
+      // WAVE_FORMAT_EXTENSIBLE keeps the actual format in the first bytes of the sub format
+      uint32_t tag = readU16(data, chunk_start);
+      if (tag == 0xFFFE && chunk_size >= 26)
+        tag = readU16(data, chunk_start + 24);
+      format.channels        = readU16(data, chunk_start + 2);
+      format.sample_rate     = readU32(data, chunk_start + 4);
+      format.bits_per_sample = readU16(data, chunk_start + 14);
+      format.is_float        = tag == 3;
+      has_format             = true;
+      if ((tag != 1 && tag != 3) || format.channels == 0 || format.sample_rate == 0)
+        throw std::runtime_error("Unsupported WAVE format");
+      if (format.is_float ? format.bits_per_sample != 32
+                          : format.bits_per_sample != 8 && format.bits_per_sample != 16 &&
+                                format.bits_per_sample != 24)
+        throw std::runtime_error("Unsupported WAVE sample size");
+    } else if (std::memcmp(data.data() + offset, "data", 4) == 0)
+    {
+      if (!has_format)
+        throw std::runtime_error("WAVE data before its format");
+      format.data_offset = chunk_start;
+      format.frame_count = chunk_size / (format.channels * (format.bits_per_sample / 8));
+      return format;
+    }
+    offset = chunk_start + chunk_size + (chunk_size & 1);
+  }
+  throw std::runtime_error("WAVE file without data");
+}
+
+void decodeWav(const WavFormat& format,
+               const std::vector<char>& data,
+               uint64_t first_frame,
+               uint32_t count,
+               float* const* channels)
+{
+  uint32_t sample_size = format.bits_per_sample / 8;
+  uint32_t frame_size  = sample_size * format.channels;
+  uint32_t available =
+      first_frame < format.frame_count
+          ? static_cast<uint32_t>(std::min<uint64_t>(count, format.frame_count - first_frame))
+          : 0;
+  auto frames = reinterpret_cast<const unsigned char*>(data.data()) + format.data_offset +
+                first_frame * frame_size;
+
+  for (uint32_t channel = 0; channel < format.channels; channel++)
+  {
+    float* output               = channels[channel];
+    const unsigned char* sample = frames + channel * sample_size;
+    for (uint32_t i = 0; i < available; i++, sample += frame_size)
+    {
+      switch (format.bits_per_sample)
+      {
+      case 8:
+        output[i] = (sample[0] - 128) * (1.0f / 128.0f);
+        break;
+      case 16:
+        output[i] = static_cast<int16_t>(sample[0] | sample[1] << 8) * (1.0f / 32768.0f);
+        break;
+      case 24:
+      {
+        // Shift the sign bit into place, then back down
+        auto value = static_cast<int32_t>(static_cast<uint32_t>(sample[0]) << 8 |
+                                          static_cast<uint32_t>(sample[1]) << 16 |
+                                          static_cast<uint32_t>(sample[2]) << 24);
+        output[i]  = (value >> 8) * (1.0f / 8388608.0f);
+        break;
+      }
+      default:
+        std::memcpy(&output[i], sample, sizeof(float));
+        break;
+      }
+    }
+    std::fill(output + available, output + count, 0.0f);
+  }
+}
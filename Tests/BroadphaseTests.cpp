@@ -0,0 +1,148 @@
+#include "Broadphase.hpp"
+#include "Check.hpp"
+#include "Scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Compares the pairs Broadphase finds with an O(n^2) reference over random scenes that move
+// between searches, on the calling thread alone and with workers, and over edge cases.
+
+namespace
+{
+struct Bounds
+{
+  float min[2];
+  float max[2];
+};
+
+bool pairLess(const Broadphase::Pair& a, const Broadphase::Pair& b)
+{
+  return a.a != b.a ? a.a < b.a : a.b < b.b;
+}
+
+bool pairEqual(const Broadphase::Pair& a, const Broadphase::Pair& b)
+{
+  return a.a == b.a && a.b == b.b;
+}
+
+// Every pair of bodies whose bounds overlap or touch, a < b, in order
+std::vector<Broadphase::Pair> referencePairs(const std::vector<Bounds>& bodies)
+{
+  std::vector<Broadphase::Pair> pairs;
+  for (uint32_t a = 0; a < bodies.size(); a++)
+  {
+    for (uint32_t b = a + 1; b < bodies.size(); b++)
+    {
+      if (bodies[a].min[0] <= bodies[b].max[0] && bodies[b].min[0] <= bodies[a].max[0] &&
+          bodies[a].min[1] <= bodies[b].max[1] && bodies[b].min[1] <= bodies[a].max[1])
+        pairs.push_back({ a, b });
+    }
+  }
+  return pairs;
+}
+
+// Searches with the broadphase and checks the pairs against the reference
+void checkPairs(Broadphase& broadphase, Scheduler& scheduler, const std::vector<Bounds>& bodies)
+{
+  for (uint32_t body = 0; body < bodies.size(); body++)
+  {
+    const Bounds& bounds = bodies[body];
+    broadphase.setBounds(body, bounds.min[0], bounds.min[1], bounds.max[0], bounds.max[1]);
+  }
+  std::vector<Broadphase::Pair> pairs;
+  broadphase.findPairs(scheduler, pairs);
+  for (const Broadphase::Pair& pair : pairs)
+    CHECK(pair.a < pair.b);
+  std::sort(pairs.begin(), pairs.end(), pairLess);
+  std::vector<Broadphase::Pair> reference = referencePairs(bodies);
+  CHECK(std::equal(pairs.begin(), pairs.end(), reference.begin(), reference.end(), pairEqual));
+}
+
+// Bodies of random sizes scattered over a wide world, then moved a little for a few searches so
+// that the sweep order is repaired rather than rebuilt
+void testRandomScenes(Scheduler& scheduler)
+{
+  for (uint32_t count : { 1u, 10u, 1000u, 12000u })
+  {
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float world = std::sqrt(static_cast<float>(count)) * 20.0f;
+
+    std::vector<Bounds> bodies(count);
+    std::vector<float> centre_x(count);
+    std::vector<float> centre_y(count);
+    std::vector<float> extent(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      centre_x[i] = unit(random) * world;
+      centre_y[i] = unit(random) * world * 0.5f;
+      extent[i]   = 2.0f + unit(random) * 20.0f;
+    }
+
+    Broadphase broadphase;
+    broadphase.resize(count);
+    for (int search = 0; search < 3; search++)
+    {
+      for (uint32_t i = 0; i < count; i++)
+      {
+        centre_x[i] += unit(random) * 4.0f - 2.0f;
+        centre_y[i] += unit(random) * 4.0f - 2.0f;
+        bodies[i] = { { centre_x[i] - extent[i], centre_y[i] - extent[i] },
+                      { centre_x[i] + extent[i], centre_y[i] + extent[i] } };
+      }
+      checkPairs(broadphase, scheduler, bodies);
+    }
+  }
+}
+
+void testEdgeCases(Scheduler& scheduler)
+{
+  // Identical bounds, every body overlaps every other
+  {
+    std::vector<Bounds> bodies(100, { { 0.0f, 0.0f }, { 1.0f, 1.0f } });
+    Broadphase broadphase;
+    broadphase.resize(100);
+    checkPairs(broadphase, scheduler, bodies);
+  }
+
+  // Bodies in a row that touch their neighbours only at their edges
+  {
+    std::vector<Bounds> bodies;
+    for (uint32_t i = 0; i < 50; i++)
+    {
+      float x = static_cast<float>(i);
+      bodies.push_back({ { x, 0.0f }, { x + 1.0f, 1.0f } });
+    }
+    Broadphase broadphase;
+    broadphase.resize(50);
+    checkPairs(broadphase, scheduler, bodies);
+  }
+
+  // Bodies added without bounds overlap nothing, and removed bodies are no longer paired
+  {
+    Broadphase broadphase;
+    broadphase.resize(2);
+    broadphase.setBounds(0, 0.0f, 0.0f, 1.0f, 1.0f);
+    broadphase.setBounds(1, 0.5f, 0.5f, 1.5f, 1.5f);
+    broadphase.resize(4);
+    std::vector<Broadphase::Pair> pairs;
+    broadphase.findPairs(scheduler, pairs);
+    CHECK(pairs.size() == 1 && pairs[0].a == 0 && pairs[0].b == 1);
+
+    broadphase.resize(1);
+    broadphase.findPairs(scheduler, pairs);
+    CHECK(pairs.empty());
+  }
+}
+}
+
+int main()
+{
+  Scheduler scheduler(3);
+  testRandomScenes(scheduler);
+  testEdgeCases(scheduler);
+  return checkResult();
+}
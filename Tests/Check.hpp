@@ -0,0 +1,27 @@
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <cstdio>
+
+// Minimal checks for the engine's test executables. A failed CHECK prints its location and the
+// test carries on, main returns checkResult() so that ctest sees the failure.
+inline int check_failures = 0;
+
+#define CHECK(condition)                                                                           \
+  do                                                                                               \
+  {                                                                                                \
+    if (!(condition))                                                                              \
+    {                                                                                              \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);           \
+      check_failures++;                                                                            \
+    }                                                                                              \
+  } while (false)
+
+inline int checkResult()
+{
+  if (check_failures)
+    std::fprintf(stderr, "%d checks failed\n", check_failures);
+  return check_failures ? 1 : 0;
+}
+
+#endif
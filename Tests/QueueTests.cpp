@@ -0,0 +1,247 @@
+#include "Check.hpp"
+#include "MpmcQueue.hpp"
+#include "MpscQueue.hpp"
+#include "SpscQueue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Stress tests for the lock-free queues. They check ordering and that every element arrives
+// exactly once, and are meant to be run under ThreadSanitizer (ENGINE_SANITIZE_THREAD) as well.
+
+namespace
+{
+constexpr uint64_t element_count = 200000;
+constexpr uint64_t thread_count  = 4;
+
+// Values carry the producer in the upper half and a per-producer sequence number in the lower
+uint64_t encode(uint64_t producer, uint64_t sequence)
+{
+  return producer << 32 | sequence;
+}
+
+uint64_t producerOf(uint64_t value)
+{
+  return value >> 32;
+}
+
+uint64_t sequenceOf(uint64_t value)
+{
+  return value & 0xffffffff;
+}
+
+// Counts live instances to check that queues destroy the elements they still hold
+struct Counted
+{
+  static inline int live = 0;
+
+  Counted()
+  {
+    live++;
+  }
+
+  Counted(const Counted&)
+  {
+    live++;
+  }
+
+  Counted& operator=(const Counted&) = default;
+
+  ~Counted()
+  {
+    live--;
+  }
+};
+
+// Fills the ring, then keeps it full for many laps, one pop and one push at a time
+template <template <typename, size_t> typename Queue>
+void testWraparound()
+{
+  constexpr uint64_t capacity = 8;
+  Queue<uint64_t, capacity> queue;
+  uint64_t pushed = 0;
+  uint64_t popped = 0;
+  while (queue.tryPush(pushed))
+    pushed++;
+  CHECK(pushed == capacity);
+
+  for (int lap = 0; lap < 100; lap++)
+  {
+    for (uint64_t i = 0; i < capacity; i++)
+    {
+      uint64_t value = 0;
+      CHECK(queue.tryPop(value));
+      CHECK(value == popped);
+      popped++;
+      CHECK(queue.tryPush(pushed));
+      pushed++;
+      CHECK(!queue.tryPush(pushed));
+    }
+  }
+
+  uint64_t value = 0;
+  while (queue.tryPop(value))
+  {
+    CHECK(value == popped);
+    popped++;
+  }
+  CHECK(popped == pushed);
+}
+
+template <typename Queue>
+void testDestroysRemaining()
+{
+  {
+    Queue queue;
+    for (int i = 0; i < 3; i++)
+      CHECK(queue.tryPush(Counted()));
+    Counted value;
+    CHECK(queue.tryPop(value));
+  }
+  CHECK(Counted::live == 0);
+}
+
+void testSpscThreads()
+{
+  SpscQueue<uint64_t, 64> queue;
+  std::thread producer([&queue] {
+    for (uint64_t i = 0; i < element_count; i++)
+    {
+      while (!queue.tryPush(i))
+        std::this_thread::yield();
+    }
+  });
+
+  uint64_t expected = 0;
+  while (expected < element_count)
+  {
+    uint64_t value;
+    if (!queue.tryPop(value))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    CHECK(value == expected);
+    expected++;
+  }
+  producer.join();
+  CHECK(queue.sizeApprox() == 0);
+}
+
+void testMpmcThreads()
+{
+  constexpr uint64_t per_producer = element_count / thread_count;
+
+  MpmcQueue<uint64_t, 64> queue;
+  auto seen = std::make_unique<std::atomic<uint32_t>[]>(element_count);
+  std::atomic<uint64_t> popped { 0 };
+  std::atomic<int> order_errors { 0 };
+
+  std::vector<std::thread> threads;
+  for (uint64_t producer = 0; producer < thread_count; producer++)
+  {
+    threads.emplace_back([&queue, producer] {
+      for (uint64_t i = 0; i < per_producer; i++)
+      {
+        while (!queue.tryPush(encode(producer, i)))
+          std::this_thread::yield();
+      }
+    });
+  }
+  for (uint64_t consumer = 0; consumer < thread_count; consumer++)
+  {
+    threads.emplace_back([&] {
+      // The queue is FIFO, so one consumer sees the elements of each producer in order
+      std::vector<int64_t> last(thread_count, -1);
+      while (popped.load(std::memory_order_relaxed) < element_count)
+      {
+        uint64_t value;
+        if (!queue.tryPop(value))
+        {
+          std::this_thread::yield();
+          continue;
+        }
+        uint64_t producer = producerOf(value);
+        int64_t sequence  = static_cast<int64_t>(sequenceOf(value));
+        if (sequence <= last[producer])
+          order_errors.fetch_add(1, std::memory_order_relaxed);
+        last[producer] = sequence;
+        seen[producer * per_producer + sequenceOf(value)].fetch_add(1, std::memory_order_relaxed);
+        popped.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  CHECK(order_errors.load() == 0);
+  CHECK(popped.load() == element_count);
+  for (uint64_t i = 0; i < element_count; i++)
+    CHECK(seen[i].load() == 1);
+}
+
+struct Node : MpscNode
+{
+  uint64_t value = 0;
+};
+
+void testMpscThreads()
+{
+  constexpr uint64_t per_producer = element_count / thread_count;
+
+  MpscQueue<Node> queue;
+  std::vector<Node> nodes(element_count);
+  CHECK(queue.empty());
+
+  std::vector<std::thread> producers;
+  for (uint64_t producer = 0; producer < thread_count; producer++)
+  {
+    producers.emplace_back([&queue, &nodes, producer] {
+      for (uint64_t i = 0; i < per_producer; i++)
+      {
+        Node& node = nodes[producer * per_producer + i];
+        node.value = encode(producer, i);
+        queue.push(&node);
+      }
+    });
+  }
+
+  // Elements of each producer arrive in the order it pushed them
+  std::vector<uint64_t> next(thread_count, 0);
+  uint64_t popped = 0;
+  while (popped < element_count)
+  {
+    Node* node = queue.pop();
+    if (!node)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    uint64_t producer = producerOf(node->value);
+    CHECK(sequenceOf(node->value) == next[producer]);
+    next[producer]++;
+    popped++;
+  }
+  for (std::thread& producer : producers)
+    producer.join();
+
+  CHECK(queue.pop() == nullptr);
+  for (uint64_t producer = 0; producer < thread_count; producer++)
+    CHECK(next[producer] == per_producer);
+}
+}
+
+int main()
+{
+  testWraparound<SpscQueue>();
+  testWraparound<MpmcQueue>();
+  testDestroysRemaining<SpscQueue<Counted, 4>>();
+  testDestroysRemaining<MpmcQueue<Counted, 4>>();
+  testSpscThreads();
+  testMpmcThreads();
+  testMpscThreads();
+  return checkResult();
+}
@@ -0,0 +1,118 @@
+#include "Check.hpp"
+#include "SceneSnapshot.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+// Writes scene snapshots and maps them back, checking that the scene read is the one written and
+// that damaged files are rejected rather than read
+
+namespace fs = std::filesystem;
+
+namespace
+{
+template <typename T>
+bool sameRecords(const OffsetArray<T>& read, const std::vector<T>& written)
+{
+  if (read.size() != written.size())
+    return false;
+  return written.empty() ||
+         std::memcmp(read.begin(), written.data(), sizeof(T) * written.size()) == 0;
+}
+
+bool throwsOnLoad(const fs::path& file)
+{
+  try
+  {
+    SceneSnapshot snapshot(file);
+  } catch (const std::runtime_error&)
+  {
+    return true;
+  }
+  return false;
+}
+
+void testRoundTrip(const fs::path& file)
+{
+  std::vector<StringId> names = { StringId("triangle"), StringId("pipeline"), StringId("ball") };
+  std::vector<SceneEntity> entities;
+  for (uint32_t i = 0; i < 10; i++)
+  {
+    float f = static_cast<float>(i);
+    entities.push_back({ 0, 1, { f, -f }, 0.5f + f, 0.25f * f, -1.0f * f });
+  }
+  std::vector<SceneSprite> sprites;
+  for (uint32_t i = 0; i < 1000; i++)
+  {
+    float f = static_cast<float>(i);
+    sprites.push_back({ 2, { f, f * 2.0f }, { -f, 0.5f }, 16.0f, f * 0.01f, 1.0f, 0xff00ff00 + i });
+  }
+
+  writeSceneSnapshot(file, 1234, names, entities, sprites);
+  SceneSnapshot snapshot(file);
+  const SceneRoot& root = snapshot.root();
+  CHECK(root.simulation_frame == 1234);
+  CHECK(sameRecords(root.names, names));
+  CHECK(sameRecords(root.entities, entities));
+  CHECK(sameRecords(root.sprites, sprites));
+}
+
+void testEmptyScene(const fs::path& file)
+{
+  writeSceneSnapshot(file, 0, {}, {}, {});
+  SceneSnapshot snapshot(file);
+  CHECK(snapshot.root().simulation_frame == 0);
+  CHECK(snapshot.root().names.size() == 0);
+  CHECK(snapshot.root().entities.size() == 0);
+  CHECK(snapshot.root().sprites.size() == 0);
+}
+
+// Rewrites a valid scene file with one change and checks that loading it throws
+template <typename Damage>
+void checkRejected(const fs::path& file, Damage&& damage)
+{
+  std::vector<SceneSprite> sprites(4, SceneSprite {});
+  writeSceneSnapshot(file, 1, { StringId("ball") }, {}, sprites);
+  std::vector<char> bytes(fs::file_size(file));
+  std::ifstream(file, std::ios::binary)
+      .read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  damage(bytes);
+  std::ofstream(file, std::ios::binary | std::ios::trunc)
+      .write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  CHECK(throwsOnLoad(file));
+}
+
+void testDamagedFiles(const fs::path& file)
+{
+  checkRejected(file, [](std::vector<char>& bytes) { bytes[0] = 'X'; });
+  checkRejected(file, [](std::vector<char>& bytes) {
+    uint32_t version = SceneHeader::current_version_ + 1;
+    std::memcpy(bytes.data() + offsetof(SceneHeader, version), &version, sizeof(version));
+  });
+  checkRejected(file, [](std::vector<char>& bytes) { bytes.resize(bytes.size() - 8); });
+  checkRejected(file, [](std::vector<char>& bytes) { bytes.resize(sizeof(SceneHeader) / 2); });
+
+  // The sprite array claims more records than the file holds
+  checkRejected(file, [](std::vector<char>& bytes) {
+    SceneHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    size_t root   = offsetof(SceneHeader, root) + static_cast<size_t>(header.root.offset());
+    size_t count  = root + offsetof(SceneRoot, sprites) + offsetof(OffsetArray<SceneSprite>, count);
+    uint64_t huge = 1000000;
+    std::memcpy(bytes.data() + count, &huge, sizeof(huge));
+  });
+}
+}
+
+int main()
+{
+  fs::path file = fs::temp_directory_path() / "scene-snapshot-test.scene";
+  testRoundTrip(file);
+  testEmptyScene(file);
+  testDamagedFiles(file);
+  fs::remove(file);
+  return checkResult();
+}